@@ -32,6 +32,7 @@
 #include "wbl_comm.h"
 #include "tc_clientsocket.h"
 #include "monitor.pb.h"
+#include "sysmon.h"
 
 #include "nlbapi.h"
 
@@ -97,8 +98,12 @@ map<AttrKey, map<uint32_t, uint32_t> > attr_map; 	//key - time_t(minutes) - valu
 
 set<SetKey> set_attr_set;	//洢ϱMonitor_Set
 
+map<AttrKey, uint32_t> attr_id_map;	//serverID, ϱһκֻID
+uint32_t attr_id_epoch = 0;			//ID汾, serverIDؽջ
+
 timer t;	//schedule to run every second
 taf::TC_TCPClient client;	//client for agent-server communication
+CSysMon sysmon;		//ָɼ
 
 static long timevaldiff(struct timeval* end, struct timeval* start)
 {
@@ -109,6 +114,23 @@ static long timevaldiff(struct timeval* end, struct timeval* start)
 	 
 }
 
+//ָ갴Monitor_Setķʽǵǰ, ͬһֻǵһ(serverͬһӵֵۼӵ)
+static void SetSysAttr(const string& attrname, uint32_t value, time_t now)
+{
+	SetKey skey;
+	skey.ServiceName = LB_MONITOR_ID;
+	skey.AttrName = attrname;
+	skey.MinTime = now / 60;
+	if(!set_attr_set.insert(skey).second)
+		return;
+
+	AttrKey key;
+	key.ServiceName = LB_MONITOR_ID;
+	key.AttrName = attrname;
+	key.Type = 2;
+	attr_map[key][now / 60] = value;
+}
+
 static int CollectPkg()
 {
 	static char m[4096];
@@ -183,8 +205,16 @@ void SendPkg(time_t tnow)
 		msec::monitor::Attr* attr = req.add_attrs();
 		uint32_t begin = 0;
 		uint32_t end = 0;
-		attr->set_servicename(it->first.ServiceName);
-		attr->set_attrname(it->first.AttrName);
+		map<AttrKey, uint32_t>::iterator itid = attr_id_map.find(it->first);
+		if(itid != attr_id_map.end())
+		{
+			attr->set_attr_id(itid->second);
+		}
+		else
+		{
+			attr->set_servicename(it->first.ServiceName);
+			attr->set_attrname(it->first.AttrName);
+		}
 		begin = it->second.begin()->first;
 		end = it->second.rbegin()->first;
 		for(uint32_t i = begin; i <= end; i++)
@@ -201,6 +231,8 @@ void SendPkg(time_t tnow)
 //		printf("Attr:%s|%s|%lu|%u|%u\n",it->first.ServiceName.c_str(), it->first.AttrName.c_str(), it->second.size(), begin, end);
 	}
 
+	req.set_id_epoch(attr_id_epoch);
+
 	for(map<string, int>::iterator it = report_stats.begin(); it!= report_stats.end(); it++)
 	{
 		cout << "[" << t2s(tnow) << "] " << "[REPORT] " << it->first << "|" << it->second << endl;
@@ -218,9 +250,16 @@ void SendPkg(time_t tnow)
 	req_str.append(body);
 
 //	sendrecv
-	static char recvBuf[4096];
+	static char recvBuf[1024 * 1024];	//״ϱĻذȫID
 	size_t len = sizeof(recvBuf);
 	int ret = client.sendRecv(req_str.data(), req_str.size(), &recvBuf[0], len);
+	if(ret == 0 && len >= 4)
+	{
+		//ذһûȫʱʣಿ
+		size_t total = ntohl(*(uint32_t*)&recvBuf[0]);
+		if(total > len && total <= sizeof(recvBuf) && client.recvLength(&recvBuf[len], total - len) == 0)
+			len = total;
+	}
 #if 0	
 	if (ret != 0)
 	{
@@ -233,11 +272,30 @@ void SendPkg(time_t tnow)
 		msec::monitor::RespReport resp;
 		if(len > 4 && len == ntohl(recvlen) && resp.ParseFromArray( &recvBuf[4], len-4 ))
 		{			
+			if(resp.id_epoch() != attr_id_epoch)
+			{
+				attr_id_map.clear();
+				attr_id_epoch = resp.id_epoch();
+			}
 			//ɹ
 			if(resp.result() == 0)
 			{
 				last_send_time = tnow;
 				attr_map.clear();
+				for(int i = 0; i < resp.ids_size(); i++)
+				{
+					AttrKey key;
+					key.ServiceName = resp.ids(i).servicename();
+					key.AttrName = resp.ids(i).attrname();
+					key.Type = 0;
+					attr_id_map[key] = resp.ids(i).attr_id();
+				}
+			}
+			else if(resp.result() == 3)
+			{
+				//serverʶID, ´δر
+				cout << "[" << t2s(tnow) << "] [ERR] " << "Attr id expired|" << attr_id_map.size() << endl;
+				attr_id_map.clear();
 			}
 		}
 		else
@@ -257,6 +315,7 @@ void on_timer()
 	CollectPkg();
 	time_t now;
 	opt_time(&now);
+	sysmon.Collect(now);
 
 	if(stConfig.UseLB && now % 60 == 0)	//check ip:port every 60 seconds
 	{
@@ -364,6 +423,12 @@ static int Init(int argc, char *argv[])
 		return -1;
 	}
 
+	if(sysmon.Init(config, SetSysAttr))
+	{
+		printf("[ERR] sysmon init failed.\n");
+		return -1;
+	}
+
 	queue = mq_create(pstConfig->MmapFile.c_str(), pstConfig->ElementSize, pstConfig->ElementCount);
 	if(queue == NULL)
 	{
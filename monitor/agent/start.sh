@@ -30,11 +30,8 @@ else
         echo "Monitor agent started"
 fi
 
-if (( $(crontab -l | grep "sysmon.py" | wc -l) == 0 )); then
-    crontab -l > /tmp/crontab.sysmon
-    echo '' >> /tmp/crontab.sysmon
-    echo "## added system monitor report"  >> /tmp/crontab.sysmon
-    echo "* * * * * /msec/agent/monitor/sysmon.py >>/msec/agent/monitor/sysmon.log 2>&1 &" >>/tmp/crontab.sysmon
+## host metrics are collected by monitor_agent itself now, drop the old sysmon.py cron job
+if (( $(crontab -l | grep "sysmon.py" | wc -l) > 0 )); then
+    crontab -l | grep -v "sysmon.py" | grep -v "## added system monitor report" > /tmp/crontab.sysmon
     crontab /tmp/crontab.sysmon
-    crontab -l
 fi
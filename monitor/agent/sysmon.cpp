@@ -0,0 +1,490 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/statvfs.h>
+#include <sstream>
+
+#include "wbl_comm.h"
+#include "sysmon.h"
+
+using namespace std;
+
+//ȡһвβ'\0', û˷NULL
+static char* NextLine(char*& p)
+{
+	if ( *p == '\0' )
+		return NULL;
+
+	char* line = p;
+	char* end = strchr(p, '\n');
+	if ( end != NULL )
+	{
+		*end = '\0';
+		p = end + 1;
+	}
+	else
+	{
+		p += strlen(p);
+	}
+	return line;
+}
+
+//ֵ, 32λʱƼ, ʱ0
+static uint64_t Delta(uint64_t ddwCur, uint64_t ddwLast)
+{
+	if ( ddwCur >= ddwLast )
+		return ddwCur - ddwLast;
+	if ( ddwLast <= 0xFFFFFFFFULL )
+		return ddwCur + 0x100000000ULL - ddwLast;
+	return 0;
+}
+
+static void SplitList(const string& s, vector<string>& vec)
+{
+	istringstream is(s);
+	string item;
+	while ( is >> item )
+		vec.push_back(item);
+}
+
+CSysMon::CSysMon()
+	:m_bEnable(false), m_pSetFunc(NULL), m_vecBuf(64 * 1024), m_bHasDisk(false)
+{
+	static const SGroup arGroups[SM_MAX] = {
+		{"CpuInterval",       "stat",      -1, 0, 0},
+		{"MemInterval",       "meminfo",   -1, 0, 0},
+		{"LoadInterval",      "loadavg",   -1, 0, 0},
+		{"DiskUsageInterval", NULL,        -1, 0, 0},
+		{"DiskIOInterval",    "diskstats", -1, 0, 0},
+		{"NetInterval",       "net/dev",   -1, 0, 0},
+		{"SnmpInterval",      "net/snmp",  -1, 0, 0},
+	};
+	for ( int i = 0; i < SM_MAX; i++ )
+		m_arGroups[i] = arGroups[i];
+	memset(&m_stDisk, 0, sizeof(m_stDisk));
+}
+
+CSysMon::~CSysMon()
+{
+	for ( int i = 0; i < SM_MAX; i++ )
+	{
+		if ( m_arGroups[i].iFd >= 0 )
+			close(m_arGroups[i].iFd);
+	}
+}
+
+int CSysMon::Init(const wbl::CFileConfig& config, SETFUNC pSetFunc)
+{
+	m_pSetFunc = pSetFunc;
+	m_bEnable = (wbl::s2u(config.getvalue("sysmon\\Enable", "1"), 1) == 1);
+	if ( !m_bEnable )
+		return 0;
+
+	//ڲɼʱָؽ/proc
+	m_sProcRoot = config.getvalue("sysmon\\ProcRoot", "/proc");
+	for ( int i = 0; i < SM_MAX; i++ )
+	{
+		SGroup& stGroup = m_arGroups[i];
+		stGroup.dwInterval = wbl::s2u(config.getvalue(string("sysmon\\") + stGroup.pszName, "60"), 60);
+		if ( stGroup.dwInterval == 0 )
+			continue;
+		if ( stGroup.dwInterval < 60 )
+		{
+			printf("[ERR] sysmon %s must be 0 or at least 60|%u\n", stGroup.pszName, stGroup.dwInterval);
+			return -1;
+		}
+		if ( stGroup.pszProcFile == NULL )
+			continue;
+
+		string sPath = m_sProcRoot + "/" + stGroup.pszProcFile;
+		stGroup.iFd = open(sPath.c_str(), O_RDONLY);
+		if ( stGroup.iFd < 0 )
+		{
+			printf("[ERR] sysmon open %s failed|%s\n", sPath.c_str(), strerror(errno));
+			return -1;
+		}
+	}
+
+	SplitList(config.getvalue("sysmon\\HdList", "/"), m_vecHdList);
+
+	vector<string> vecTmp;
+	SplitList(config.getvalue("sysmon\\DiskDev", "vda1"), vecTmp);
+	m_setDiskDev.insert(vecTmp.begin(), vecTmp.end());
+
+	vecTmp.clear();
+	SplitList(config.getvalue("sysmon\\IfFilter", "lo docker0"), vecTmp);
+	m_setIfFilter.insert(vecTmp.begin(), vecTmp.end());
+	return 0;
+}
+
+void CSysMon::Collect(time_t now)
+{
+	if ( !m_bEnable )
+		return;
+
+	for ( int i = 0; i < SM_MAX; i++ )
+	{
+		SGroup& stGroup = m_arGroups[i];
+		if ( stGroup.dwInterval == 0 || (stGroup.tLast != 0 && now - stGroup.tLast < (time_t)stGroup.dwInterval) )
+			continue;
+
+		uint32_t dwSecs = (stGroup.tLast != 0 && now > stGroup.tLast) ? (uint32_t)(now - stGroup.tLast) : 0;
+		switch ( i )
+		{
+			case SM_CPU:
+				CollectCpu(now, dwSecs);
+				break;
+			case SM_MEM:
+				CollectMem(now);
+				break;
+			case SM_LOAD:
+				CollectLoad(now);
+				break;
+			case SM_DISK_USAGE:
+				CollectDiskUsage(now);
+				break;
+			case SM_DISK_IO:
+				CollectDiskIO(now, dwSecs);
+				break;
+			case SM_NET:
+				CollectNet(now, dwSecs);
+				break;
+			case SM_SNMP:
+				CollectSnmp(now, dwSecs);
+				break;
+		}
+		stGroup.tLast = now;
+	}
+}
+
+int CSysMon::ReadProc(SGroup& stGroup)
+{
+	if ( stGroup.iFd < 0 )
+		return -1;
+
+	//procļСȲ֪, ˾bufferŶ
+	size_t len = 0;
+	while ( true )
+	{
+		if ( m_vecBuf.size() - len < 4096 )
+			m_vecBuf.resize(m_vecBuf.size() * 2);
+
+		ssize_t n = pread(stGroup.iFd, &m_vecBuf[len], m_vecBuf.size() - len - 1, len);
+		if ( n < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			printf("[ERR] sysmon read %s failed|%s\n", stGroup.pszProcFile, strerror(errno));
+			return -1;
+		}
+		if ( n == 0 )
+			break;
+		len += n;
+	}
+	m_vecBuf[len] = '\0';
+	return (int)len;
+}
+
+void CSysMon::Set(const string& sAttr, uint64_t ddwValue, time_t now)
+{
+	if ( ddwValue > 0xFFFFFFFFULL )
+		ddwValue = 0xFFFFFFFFULL;
+	m_pSetFunc("sys." + sAttr, (uint32_t)ddwValue, now);
+}
+
+void CSysMon::CollectCpu(time_t now, uint32_t dwSecs)
+{
+	if ( ReadProc(m_arGroups[SM_CPU]) < 0 )
+		return;
+
+	char* p = &m_vecBuf[0];
+	char* line = NULL;
+	while ( (line = NextLine(p)) != NULL )
+	{
+		//cpuжǰ
+		if ( strncmp(line, "cpu", 3) != 0 )
+			break;
+
+		char szName[32];
+		unsigned long long v[7] = {0};
+		if ( sscanf(line, "%31s %llu %llu %llu %llu %llu %llu %llu", szName, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) < 5 )
+			continue;
+
+		SCpuStat stCur;
+		stCur.ddwIdle = v[3];
+		stCur.ddwTotal = v[0] + v[1] + v[2] + v[3] + v[4] + v[5] + v[6];
+
+		map<string, SCpuStat>::iterator it = m_mapCpu.find(szName);
+		if ( it != m_mapCpu.end() && dwSecs > 0 && stCur.ddwTotal > it->second.ddwTotal )
+		{
+			uint64_t ddwTotal = stCur.ddwTotal - it->second.ddwTotal;
+			uint64_t ddwIdle = Delta(stCur.ddwIdle, it->second.ddwIdle);
+			if ( ddwIdle > ddwTotal )
+				ddwIdle = ddwTotal;
+
+			string sAttr(szName);
+			for ( size_t i = 0; i < sAttr.size(); i++ )
+				sAttr[i] = toupper(sAttr[i]);
+			Set(sAttr + "_Used(%)", (ddwTotal - ddwIdle) * 100 / ddwTotal, now);
+		}
+		m_mapCpu[szName] = stCur;
+	}
+}
+
+void CSysMon::CollectMem(time_t now)
+{
+	if ( ReadProc(m_arGroups[SM_MEM]) < 0 )
+		return;
+
+	int64_t ddwTotal = 0, ddwFree = 0, ddwCached = 0, ddwDirty = 0, ddwMapped = 0;
+	bool bHasMapped = false;
+	char* p = &m_vecBuf[0];
+	char* line = NULL;
+	while ( (line = NextLine(p)) != NULL )
+	{
+		char* colon = strchr(line, ':');
+		if ( colon == NULL )
+			continue;
+		*colon = '\0';
+
+		int64_t ddwValue = strtoll(colon + 1, NULL, 10);
+		if ( strcmp(line, "MemTotal") == 0 )
+			ddwTotal = ddwValue;
+		else if ( strcmp(line, "MemFree") == 0 )
+			ddwFree = ddwValue;
+		else if ( strcmp(line, "Cached") == 0 )
+			ddwCached = ddwValue;
+		else if ( strcmp(line, "Dirty") == 0 )
+			ddwDirty = ddwValue;
+		else if ( strcmp(line, "Mapped") == 0 )
+		{
+			ddwMapped = ddwValue;
+			bHasMapped = true;
+		}
+	}
+	if ( ddwTotal == 0 )
+		return;
+
+	//ڴ水sysmon.py㷨:  + ɻյpage cache
+	int64_t ddwAvail = ddwFree;
+	if ( bHasMapped && ddwFree + ddwCached - ddwDirty - ddwMapped > 0 )
+		ddwAvail = ddwFree + ddwCached - ddwDirty - ddwMapped;
+	Set("Memory_Used(MB)", (ddwTotal - ddwAvail) / 1024, now);
+	Set("Memory_Free(MB)", ddwAvail / 1024, now);
+}
+
+void CSysMon::CollectLoad(time_t now)
+{
+	if ( ReadProc(m_arGroups[SM_LOAD]) < 0 )
+		return;
+
+	double load[3];
+	if ( sscanf(&m_vecBuf[0], "%lf %lf %lf", &load[0], &load[1], &load[2]) != 3 )
+		return;
+	Set("CPU_LoadAvg_1Min(*100)", (uint64_t)(load[0] * 100), now);
+	Set("CPU_LoadAvg_5Mins(*100)", (uint64_t)(load[1] * 100), now);
+	Set("CPU_LoadAvg_15Mins(*100)", (uint64_t)(load[2] * 100), now);
+}
+
+void CSysMon::CollectDiskUsage(time_t now)
+{
+	for ( size_t i = 0; i < m_vecHdList.size(); i++ )
+	{
+		struct statvfs st;
+		if ( statvfs(m_vecHdList[i].c_str(), &st) != 0 )
+			continue;
+
+		//dfUse%һ: /(+ͨû), ȡ
+		uint64_t ddwUsed = st.f_blocks - st.f_bfree;
+		uint64_t ddwAll = ddwUsed + st.f_bavail;
+		if ( ddwAll == 0 )
+			continue;
+		Set("DIR_" + m_vecHdList[i] + "_Used(%)", (ddwUsed * 100 + ddwAll - 1) / ddwAll, now);
+	}
+}
+
+void CSysMon::CollectDiskIO(time_t now, uint32_t dwSecs)
+{
+	if ( ReadProc(m_arGroups[SM_DISK_IO]) < 0 )
+		return;
+
+	SDiskStat stCur;
+	memset(&stCur, 0, sizeof(stCur));
+	bool bFound = false;
+	char* p = &m_vecBuf[0];
+	char* line = NULL;
+	while ( (line = NextLine(p)) != NULL )
+	{
+		char szName[64];
+		unsigned long long v[7];
+		if ( sscanf(line, "%*u %*u %63s %llu %*u %llu %llu %llu %*u %llu %llu %*u %llu",
+					szName, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) != 8 )
+			continue;
+		if ( m_setDiskDev.find(szName) == m_setDiskDev.end() )
+			continue;
+
+		stCur.ddwReadReq += v[0];
+		stCur.ddwReadSect += v[1];
+		stCur.ddwReadUse += v[2];
+		stCur.ddwWriteReq += v[3];
+		stCur.ddwWriteSect += v[4];
+		stCur.ddwWriteUse += v[5];
+		stCur.ddwIoUse += v[6];
+		bFound = true;
+	}
+	if ( !bFound )
+		return;
+
+	if ( m_bHasDisk && dwSecs > 0 )
+	{
+		uint64_t ddwReadReq = Delta(stCur.ddwReadReq, m_stDisk.ddwReadReq);
+		uint64_t ddwWriteReq = Delta(stCur.ddwWriteReq, m_stDisk.ddwWriteReq);
+		uint64_t ddwReq = ddwReadReq + ddwWriteReq;
+
+		//512ֽڼ
+		Set("IO_Read(KB/s)", Delta(stCur.ddwReadSect, m_stDisk.ddwReadSect) / 2 / dwSecs, now);
+		Set("IO_Write(KB/s)", Delta(stCur.ddwWriteSect, m_stDisk.ddwWriteSect) / 2 / dwSecs, now);
+		Set("IO_Read(Req/s)", ddwReadReq / dwSecs, now);
+		Set("IO_Write(Req/s)", ddwWriteReq / dwSecs, now);
+		if ( ddwReq > 0 )
+		{
+			uint64_t ddwWait = Delta(stCur.ddwReadUse, m_stDisk.ddwReadUse) + Delta(stCur.ddwWriteUse, m_stDisk.ddwWriteUse);
+			Set("IO_Avg_Wait(us)", ddwWait * 1000 / ddwReq, now);
+			Set("IO_Avg_SvcTime(us)", Delta(stCur.ddwIoUse, m_stDisk.ddwIoUse) * 1000 / ddwReq, now);
+		}
+	}
+	m_stDisk = stCur;
+	m_bHasDisk = true;
+}
+
+void CSysMon::CollectNet(time_t now, uint32_t dwSecs)
+{
+	if ( ReadProc(m_arGroups[SM_NET]) < 0 )
+		return;
+
+	char* p = &m_vecBuf[0];
+	char* line = NULL;
+	while ( (line = NextLine(p)) != NULL )
+	{
+		//ǰǱ, иʽΪ"  eth0: ֽ հ ... ֽ  ..."
+		char* colon = strchr(line, ':');
+		if ( colon == NULL )
+			continue;
+		*colon = '\0';
+		while ( *line == ' ' )
+			line++;
+		if ( m_setIfFilter.find(line) != m_setIfFilter.end() )
+			continue;
+
+		unsigned long long v[4];
+		if ( sscanf(colon + 1, "%llu %llu %*u %*u %*u %*u %*u %*u %llu %llu", &v[0], &v[1], &v[2], &v[3]) != 4 )
+			continue;
+
+		SNetStat stCur;
+		stCur.ddwInBytes = v[0];
+		stCur.ddwInPkts = v[1];
+		stCur.ddwOutBytes = v[2];
+		stCur.ddwOutPkts = v[3];
+
+		string sName(line);
+		map<string, SNetStat>::iterator it = m_mapNet.find(sName);
+		if ( it != m_mapNet.end() && dwSecs > 0 )
+		{
+			//ÿϱ, ɼ60ʱ
+			const SNetStat& stLast = it->second;
+			Set(sName + "_In(KB/m)", Delta(stCur.ddwInBytes, stLast.ddwInBytes) * 60 / dwSecs / 1024, now);
+			Set(sName + "_In(Pkt/m)", Delta(stCur.ddwInPkts, stLast.ddwInPkts) * 60 / dwSecs, now);
+			Set(sName + "_Out(KB/m)", Delta(stCur.ddwOutBytes, stLast.ddwOutBytes) * 60 / dwSecs / 1024, now);
+			Set(sName + "_Out(Pkt/m)", Delta(stCur.ddwOutPkts, stLast.ddwOutPkts) * 60 / dwSecs, now);
+		}
+		m_mapNet[sName] = stCur;
+	}
+}
+
+void CSysMon::CollectSnmp(time_t now, uint32_t dwSecs)
+{
+	if ( ReadProc(m_arGroups[SM_SNMP]) < 0 )
+		return;
+
+	//ÿЭ: "Tcp: ֶ...""Tcp: ֵ...", ֶӦ, ֶ˳
+	map<string, uint64_t> mapCur;
+	char* p = &m_vecBuf[0];
+	char* line = NULL;
+	char* head = NULL;
+	while ( (line = NextLine(p)) != NULL )
+	{
+		char* colon = strchr(line, ':');
+		if ( colon == NULL )
+			continue;
+		size_t nPrefix = colon - line;
+		if ( head == NULL || strncmp(head, line, nPrefix + 1) != 0 )
+		{
+			head = line;
+			continue;
+		}
+
+		string sPrefix(line, nPrefix);
+		if ( sPrefix == "Tcp" || sPrefix == "Udp" )
+		{
+			char* pszHeadSave = NULL;
+			char* pszValueSave = NULL;
+			char* pszName = strtok_r(head + nPrefix + 1, " ", &pszHeadSave);
+			char* pszValue = strtok_r(colon + 1, " ", &pszValueSave);
+			while ( pszName != NULL && pszValue != NULL )
+			{
+				mapCur[sPrefix + "." + pszName] = strtoull(pszValue, NULL, 10);
+				pszName = strtok_r(NULL, " ", &pszHeadSave);
+				pszValue = strtok_r(NULL, " ", &pszValueSave);
+			}
+		}
+		head = NULL;
+	}
+
+	static const struct {
+		const char* pszKey;
+		const char* pszAttr;
+	} arSnmp[] = {
+		{"Udp.OutDatagrams", "UDP_Sent(Pkt/m)"},
+		{"Udp.InDatagrams",  "UDP_Recv(Pkt/m)"},
+		{"Udp.InErrors",     "UDP_Errors(Pkt/m)"},
+		{"Udp.RcvbufErrors", "UDP_RecvbufError(Pkt/m)"},
+		{"Udp.SndbufErrors", "UDP_SndbufError(Pkt/m)"},
+		{"Tcp.InSegs",       "TCP_Recv(Pkt/m)"},
+		{"Tcp.OutSegs",      "TCP_Sent(Pkt/m)"},
+		{"Tcp.InErrs",       "TCP_Errors(Pkt/m)"},
+	};
+	if ( dwSecs > 0 )
+	{
+		for ( size_t i = 0; i < sizeof(arSnmp) / sizeof(arSnmp[0]); i++ )
+		{
+			map<string, uint64_t>::iterator itCur = mapCur.find(arSnmp[i].pszKey);
+			map<string, uint64_t>::iterator itLast = m_mapSnmp.find(arSnmp[i].pszKey);
+			if ( itCur != mapCur.end() && itLast != m_mapSnmp.end() )
+				Set(arSnmp[i].pszAttr, Delta(itCur->second, itLast->second) * 60 / dwSecs, now);
+		}
+	}
+	m_mapSnmp.swap(mapCur);
+}
@@ -0,0 +1,116 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#ifndef __MONITOR_SYSMON_H__
+#define __MONITOR_SYSMON_H__
+
+#include <stdint.h>
+#include <time.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "wbl_config_file.h"
+
+//ָɼ: agentֱӶ/proc, ԭsysmon.pyһ(sys.xxx)
+///procļһ, ÿβɼpreadͷض, forkӽ
+class CSysMon
+{
+public:
+	//ɼص: , ֵ, ɼʱ
+	typedef void (*SETFUNC)(const std::string&, uint32_t, time_t);
+
+	enum {
+		SM_CPU = 0,		// /proc/stat, CPUʹ
+		SM_MEM,			// /proc/meminfo
+		SM_LOAD,		// /proc/loadavg
+		SM_DISK_USAGE,	// statvfs, HdListиĿ¼ʹ
+		SM_DISK_IO,		// /proc/diskstats, DiskDevи豸֮
+		SM_NET,			// /proc/net/dev, 
+		SM_SNMP,		// /proc/net/snmp, TCP/UDPշ
+		SM_MAX,
+	};
+
+	CSysMon();
+	~CSysMon();
+
+	//<sysmon>, Enable=0ʱɼ; ָ()Ϊ0ʱɼָ
+	//Setֵserverͬһۼӵ, С60ʱʧ
+	int Init(const wbl::CFileConfig& config, SETFUNC pSetFunc);
+	//ʱ, ˼ָŲɼ
+	void Collect(time_t now);
+
+private:
+	struct SGroup {
+		const char* pszName;
+		const char* pszProcFile;	//ProcRoot·
+		int iFd;
+		uint32_t dwInterval;
+		time_t tLast;		//ϴβɼʱ, 0ʾûвɼ
+	};
+
+	struct SCpuStat {
+		uint64_t ddwIdle;
+		uint64_t ddwTotal;
+	};
+
+	struct SDiskStat {
+		uint64_t ddwReadReq, ddwReadSect, ddwReadUse;
+		uint64_t ddwWriteReq, ddwWriteSect, ddwWriteUse;
+		uint64_t ddwIoUse;
+	};
+
+	struct SNetStat {
+		uint64_t ddwInBytes, ddwInPkts;
+		uint64_t ddwOutBytes, ddwOutPkts;
+	};
+
+	//ļm_vecBuf, '\0'β; ʧܷ-1
+	int ReadProc(SGroup& stGroup);
+	void Set(const std::string& sAttr, uint64_t ddwValue, time_t now);
+
+	//dwSecsΪϴβɼ, ָһ(dwSecsΪ0)ֻ¼׼ֵ
+	void CollectCpu(time_t now, uint32_t dwSecs);
+	void CollectMem(time_t now);
+	void CollectLoad(time_t now);
+	void CollectDiskUsage(time_t now);
+	void CollectDiskIO(time_t now, uint32_t dwSecs);
+	void CollectNet(time_t now, uint32_t dwSecs);
+	void CollectSnmp(time_t now, uint32_t dwSecs);
+
+private:
+	bool m_bEnable;
+	SETFUNC m_pSetFunc;
+	SGroup m_arGroups[SM_MAX];
+	std::vector<char> m_vecBuf;
+
+	std::string m_sProcRoot;
+	std::vector<std::string> m_vecHdList;
+	std::set<std::string> m_setDiskDev;
+	std::set<std::string> m_setIfFilter;
+
+	std::map<std::string, SCpuStat> m_mapCpu;
+	SDiskStat m_stDisk;
+	bool m_bHasDisk;
+	std::map<std::string, SNetStat> m_mapNet;
+	std::map<std::string, uint64_t> m_mapSnmp;	//"Udp.InDatagrams" - value
+};
+
+#endif
@@ -0,0 +1,174 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+//CSysMon/proc: ProcRootָαprocļ, βɼ˶Ըָ
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "sysmon.h"
+
+using namespace std;
+
+#define TEST_PROC_ROOT	"./test_sysmon_proc"
+#define TEST_CONF		"./test_sysmon.conf"
+
+#define CHECK(exp) do { if(!(exp)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #exp); return 1; } } while(0)
+
+static map<string, uint32_t> values;
+
+static void OnSet(const string& attrname, uint32_t value, time_t now)
+{
+	values[attrname] = value;
+}
+
+static void WriteFile(const string& name, const string& data)
+{
+	ofstream out((string(TEST_PROC_ROOT) + "/" + name).c_str(), ios::out | ios::trunc);
+	out << data;
+}
+
+static void WriteConf(const string& cpu_interval)
+{
+	ofstream out(TEST_CONF, ios::out | ios::trunc);
+	out << "<sysmon>\n"
+		<< "Enable = 1\n"
+		<< "CpuInterval = " << cpu_interval << "\n"
+		<< "MemInterval = 60\n"
+		<< "LoadInterval = 60\n"
+		<< "DiskUsageInterval = 0\n"
+		<< "DiskIOInterval = 60\n"
+		<< "NetInterval = 120\n"
+		<< "SnmpInterval = 60\n"
+		<< "DiskDev = vda1\n"
+		<< "IfFilter = lo docker0\n"
+		<< "ProcRoot = " << TEST_PROC_ROOT << "\n"
+		<< "</sysmon>\n";
+}
+
+static const char* NET_HEAD =
+	"Inter-|   Receive                                                |  Transmit\n"
+	" face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n";
+
+static void WriteProc(int round)
+{
+	if(round == 0)
+	{
+		WriteFile("stat", "cpu  100 0 100 800 0 0 0\ncpu0 50 0 50 400 0 0 0\nintr 1 2 3\n");
+		WriteFile("diskstats", "   8 0 sda 1 0 1 1 1 0 1 1 0 1 1\n 253 1 vda1 100 0 2000 50 200 0 4000 150 0 300 450\n");
+		WriteFile("net/dev", string(NET_HEAD)
+			+ "    lo: 100 1 0 0 0 0 0 0 100 1 0 0 0 0 0 0\n"
+			+ "  eth0: 1048576 1000 0 0 0 0 0 0 2097152 2000 0 0 0 0 0 0\n");
+		WriteFile("net/snmp", "Tcp: RtoAlgorithm InSegs OutSegs InErrs\nTcp: 1 1000 2000 5\n"
+			"Udp: InDatagrams NoPorts InErrors OutDatagrams RcvbufErrors SndbufErrors\nUdp: 100 0 1 200 0 0\n");
+	}
+	else if(round == 1)
+	{
+		WriteFile("stat", "cpu  200 0 200 1600 0 0 0\ncpu0 150 0 50 800 0 0 0\nintr 1 2 3\n");
+		WriteFile("diskstats", "   8 0 sda 9 0 9 9 9 0 9 9 0 9 9\n 253 1 vda1 160 0 14000 110 260 0 16000 210 0 420 570\n");
+		WriteFile("net/snmp", "Tcp: RtoAlgorithm InSegs OutSegs InErrs\nTcp: 1 1600 2300 8\n"
+			"Udp: InDatagrams NoPorts InErrors OutDatagrams RcvbufErrors SndbufErrors\nUdp: 220 0 1 260 0 2\n");
+	}
+	else
+	{
+		WriteFile("net/dev", string(NET_HEAD)
+			+ "    lo: 900 9 0 0 0 0 0 0 900 9 0 0 0 0 0 0\n"
+			+ "  eth0: 3145728 1200 0 0 0 0 0 0 6291456 2400 0 0 0 0 0 0\n");
+	}
+	WriteFile("meminfo", "MemTotal:        8192000 kB\nMemFree:         1024000 kB\nCached:          2048000 kB\nDirty:              1024 kB\nMapped:             1024 kB\n");
+	WriteFile("loadavg", "0.50 1.25 2.00 1/100 1234\n");
+}
+
+int main()
+{
+	mkdir(TEST_PROC_ROOT, 0755);
+	mkdir(TEST_PROC_ROOT "/net", 0755);
+	WriteProc(0);
+
+	//С60ʱserverͬһӵĶֵۼ, InitֱӾܾ
+	{
+		wbl::CFileConfig config;
+		WriteConf("30");
+		config.Init(TEST_CONF);
+		CSysMon sysmon;
+		CHECK(sysmon.Init(config, OnSet) != 0);
+	}
+
+	wbl::CFileConfig config;
+	WriteConf("60");
+	config.Init(TEST_CONF);
+	CSysMon sysmon;
+	CHECK(sysmon.Init(config, OnSet) == 0);
+
+	//һβɼ: ֻǻ׼ֵ
+	time_t now = 1475251200;
+	sysmon.Collect(now);
+	CHECK(values.size() == 5);
+	CHECK(values["sys.Memory_Free(MB)"] == 2998);
+	CHECK(values["sys.Memory_Used(MB)"] == 5002);
+	CHECK(values["sys.CPU_LoadAvg_1Min(*100)"] == 50);
+	CHECK(values["sys.CPU_LoadAvg_5Mins(*100)"] == 125);
+	CHECK(values["sys.CPU_LoadAvg_15Mins(*100)"] == 200);
+
+	//ɼ
+	values.clear();
+	sysmon.Collect(now + 30);
+	CHECK(values.empty());
+
+	WriteProc(1);
+	sysmon.Collect(now + 60);
+	CHECK(values["sys.CPU_Used(%)"] == 20);
+	CHECK(values["sys.CPU0_Used(%)"] == 20);
+	CHECK(values["sys.IO_Read(KB/s)"] == 100);
+	CHECK(values["sys.IO_Write(KB/s)"] == 100);
+	CHECK(values["sys.IO_Read(Req/s)"] == 1);
+	CHECK(values["sys.IO_Write(Req/s)"] == 1);
+	CHECK(values["sys.IO_Avg_Wait(us)"] == 1000);
+	CHECK(values["sys.IO_Avg_SvcTime(us)"] == 1000);
+	CHECK(values["sys.TCP_Recv(Pkt/m)"] == 600);
+	CHECK(values["sys.TCP_Sent(Pkt/m)"] == 300);
+	CHECK(values["sys.TCP_Errors(Pkt/m)"] == 3);
+	CHECK(values["sys.UDP_Recv(Pkt/m)"] == 120);
+	CHECK(values["sys.UDP_Sent(Pkt/m)"] == 60);
+	CHECK(values["sys.UDP_SndbufError(Pkt/m)"] == 2);
+	CHECK(values.find("sys.eth0_In(KB/m)") == values.end());
+
+	//120, ÿ; lo
+	WriteProc(2);
+	values.clear();
+	sysmon.Collect(now + 120);
+	CHECK(values["sys.eth0_In(KB/m)"] == 1024);
+	CHECK(values["sys.eth0_In(Pkt/m)"] == 100);
+	CHECK(values["sys.eth0_Out(KB/m)"] == 2048);
+	CHECK(values["sys.eth0_Out(Pkt/m)"] == 200);
+	CHECK(values.find("sys.lo_In(KB/m)") == values.end());
+
+	const char* files[] = {"stat", "meminfo", "loadavg", "diskstats", "net/dev", "net/snmp"};
+	for(size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+		unlink((string(TEST_PROC_ROOT) + "/" + files[i]).c_str());
+	rmdir(TEST_PROC_ROOT "/net");
+	rmdir(TEST_PROC_ROOT);
+	unlink(TEST_CONF);
+	printf("test_sysmon ok\n");
+	return 0;
+}
@@ -32,6 +32,8 @@
 #include <vector>
 #include <stdio.h>
 #include <unistd.h>
+#include <stdlib.h>
+#include <pthread.h>
 
 #include "thread_pool.h"
 
@@ -169,8 +171,71 @@ void fff()
 	cout << "fff" << endl;
 }
 
+/** 吞吐测试: 多个生产者投递空任务, 比较默认无界队列与有界无锁队列
+ */
+static volatile long g_done = 0;
+
+void bench_task()
+{
+	__sync_fetch_and_add(&g_done, 1);
+}
+
+struct BenchProducer
+{
+	thread_pool *	tp;
+	long			count;
+};
+
+void * bench_producer(void * arg)
+{
+	BenchProducer * p = static_cast<BenchProducer *>(arg);
+	for (long i = 0; i < p->count; ++i)
+		p->tp->execute_fun(&bench_task);
+	return NULL;
+}
+
+void bench(int threads, int producers, long tasks, size_t capacity)
+{
+	thread_pool tp;
+	tp.set_queue_capacity(capacity);
+	tp.start(threads);
+	g_done = 0;
+
+	struct timeval begin, end;
+	gettimeofday(&begin, NULL);
+	std::vector<pthread_t> tids(producers);
+	BenchProducer bp;
+	bp.tp = &tp;
+	bp.count = tasks / producers;
+	for (int i = 0; i < producers; ++i)
+		pthread_create(&tids[i], NULL, &bench_producer, &bp);
+	for (int i = 0; i < producers; ++i)
+		pthread_join(tids[i], NULL);
+	long total = bp.count * producers;
+	while (g_done < total)
+		usleep(100);
+	gettimeofday(&end, NULL);
+
+	double cost = (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) / 1000000.0;
+	cout << "capacity: " << setw(8) << capacity
+		<< "\tworkers: " << threads << "\tproducers: " << producers
+		<< "\ttasks: " << total << "\tcost: " << cost << "s\t"
+		<< (long)(total / cost) << " tasks/s" << endl;
+	tp.stop();
+}
+
 int main(int argc, char * argv[]) 
 {
+	// test_thread_pool bench [workers] [producers] [tasks]
+	if (argc > 1 && std::string(argv[1]) == "bench") {
+		int threads = argc > 2 ? atoi(argv[2]) : 8;
+		int producers = argc > 3 ? atoi(argv[3]) : 4;
+		long tasks = argc > 4 ? atol(argv[4]) : 1000000;
+		bench(threads, producers, tasks, 0);
+		bench(threads, producers, tasks, 65536);
+		return 0;
+	}
+
 	Tester test;
 	test.run();
 	return 0;
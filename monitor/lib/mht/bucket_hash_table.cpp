@@ -0,0 +1,765 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/******************************************************************************
+
+  FILENAME:	bucket_hash_table.cpp
+
+  DESCRIPTION:	鿪ѰַHashʵ
+
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include "bucket_hash_table.h"
+#include "shm_adapter.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// free extent, stored in its first unit
+typedef struct
+{
+	ull64_t ddwUnitCnt;
+	ull64_t ddwNext;
+	ull64_t ddwPrev;
+} BhtFreeExt;
+
+#define BHT_ALIGN(n) (((n) + 63) & ~63ULL)
+
+// mix the user hash so that both the group index and the tag get well distributed bits
+static inline uint32_t BhtMix(uint32_t h)
+{
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+static inline uint8_t BhtTag(uint32_t h) { return (uint8_t)(h >> 25); }
+
+// bit i set if g[i]==b
+static inline uint32_t MatchByte(const uint8_t *g, uint8_t b)
+{
+#if defined(__SSE2__)
+	__m128i v = _mm_loadu_si128((const __m128i *)g);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)b)));
+#else
+	uint32_t m = 0;
+	for(int i = 0; i < BHT_GROUP_SIZE; i++)
+		if(g[i] == b) m |= 1u << i;
+	return m;
+#endif
+}
+
+// bit i set if g[i] is empty or deleted (high bit set)
+static inline uint32_t MatchFree(const uint8_t *g)
+{
+#if defined(__SSE2__)
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)g));
+#else
+	uint32_t m = 0;
+	for(int i = 0; i < BHT_GROUP_SIZE; i++)
+		if(g[i] & 0x80) m |= 1u << i;
+	return m;
+#endif
+}
+
+BucketHashTable::~BucketHashTable()
+{
+	if(pShmAdpt) delete pShmAdpt;
+}
+
+void BucketHashTable::Attach(void *pBuffer)
+{
+	header = (BhtHeader *)pBuffer;
+	ctrl = (uint8_t *)pBuffer + header->ddwCtrlOffset;
+	slots = (char *)pBuffer + header->ddwSlotOffset;
+	bitmap = (uint8_t *)pBuffer + header->ddwBitmapOffset;
+	units = (char *)pBuffer + header->ddwDataOffset;
+}
+
+int BucketHashTable::InitFromBuffer(void *pBuffer, ull64_t ddwBufferSize, uint8_t cMaxKeyLen, uint16_t wRowNum, uint32_t dwExpiryRatio, uint32_t dwIndexRatio, ull64_t ddwBlockSize, CalcHashKeyFunc HashFunc, bool bUseAccessSeq)
+{
+	if(pBuffer==NULL || ddwBufferSize<1024*1024*2 ||
+		cMaxKeyLen<1 || cMaxKeyLen>HASH_MAX_KEY_LENGTH ||
+		dwIndexRatio<1 || dwIndexRatio>1000 ||
+		ddwBlockSize<sizeof(BhtFreeExt) || ddwBlockSize>HASH_MAX_DATA_LENGTH)
+	{
+		strncpy(errmsg, "Bad argument", sizeof(errmsg));
+		return -1;
+	}
+
+	ull64_t ddwSlotSize = (sizeof(BhtSlot) + cMaxKeyLen + 7) & ~7ULL;
+	ull64_t ddwHeadSize = BHT_ALIGN(sizeof(BhtHeader));
+	ull64_t ddwAvail = ddwBufferSize - ddwHeadSize - 4*64;
+	// slot num = unit num * dwIndexRatio / 100, each slot also takes a ctrl byte, each unit a bit
+	ull64_t ddwUnitNum = ddwAvail * 800 / ((ddwSlotSize + 1) * dwIndexRatio * 8 + ddwBlockSize * 800 + 100);
+	ull64_t ddwGroupNum = ddwUnitNum * dwIndexRatio / 100 / BHT_GROUP_SIZE;
+	if(ddwGroupNum == 0 || ddwUnitNum == 0)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Buffer too small|%llu|%llu|%llu", ddwBufferSize, ddwSlotSize, ddwBlockSize);
+		return -2;
+	}
+
+	header = (BhtHeader *)pBuffer;
+	memset(header, 0, sizeof(*header));
+	header->ddwTotalShmSize = ddwBufferSize;
+	header->ddwGroupNum = ddwGroupNum;
+	header->ddwSlotSize = ddwSlotSize;
+	header->ddwMaxKeyLen = cMaxKeyLen;
+	header->ddwUnitSize = ddwBlockSize;
+	header->ddwCtrlOffset = ddwHeadSize;
+	header->ddwSlotOffset = BHT_ALIGN(header->ddwCtrlOffset + ddwGroupNum * BHT_GROUP_SIZE);
+	header->ddwBitmapOffset = BHT_ALIGN(header->ddwSlotOffset + ddwGroupNum * BHT_GROUP_SIZE * ddwSlotSize);
+	header->ddwDataOffset = BHT_ALIGN(header->ddwBitmapOffset + (ddwUnitNum + 7) / 8);
+	header->ddwUnitNum = (ddwBufferSize - header->ddwDataOffset) / ddwBlockSize;
+	if(header->ddwUnitNum > ddwUnitNum)
+		header->ddwUnitNum = ddwUnitNum;
+	header->dwExpiryRatio = dwExpiryRatio;
+	header->cUseAccessSeq = bUseAccessSeq;
+	for(int i = 0; i < BHT_FREE_LISTS; i++)
+		header->addwFreeHead[i] = BHT_NIL;
+
+	Attach(pBuffer);
+	memset(ctrl, BHT_CTRL_EMPTY, ddwGroupNum * BHT_GROUP_SIZE);
+	memset(slots, 0, ddwGroupNum * BHT_GROUP_SIZE * ddwSlotSize);
+	memset(bitmap, 0, (ddwUnitNum + 7) / 8);
+	header->ddwMagic = BHT_MAGIC;
+
+	if(HashFunc)
+		hashfunc = HashFunc;
+	else
+		hashfunc = DefaultHashFunc;
+	return 0;
+}
+
+int BucketHashTable::InitFromShm(ull64_t ddwShmKey, CalcHashKeyFunc HashFunc)
+{
+	if(pShmAdpt)
+		delete pShmAdpt;
+
+	pShmAdpt = new shm_adapter;
+	if(pShmAdpt==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Failed to create shm adaptor: Out of memory");
+		return -1;
+	}
+	if(pShmAdpt->open(ddwShmKey)==false)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Failed to open shm: %s", pShmAdpt->get_err_msg().c_str());
+		delete pShmAdpt; pShmAdpt = NULL;
+		return -100;
+	}
+
+	BhtHeader *pHeader = (BhtHeader *)pShmAdpt->get_shm();
+	if(pHeader==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Bug: shm open successfully but shm pointer is NULL");
+		delete pShmAdpt; pShmAdpt = NULL;
+		return -3;
+	}
+
+	if(pHeader->ddwTotalShmSize != pShmAdpt->get_size())
+	{
+		snprintf(errmsg, sizeof(errmsg), "Error: shm size %llu differs from size in header %llu", (ull64_t)pShmAdpt->get_size(), pHeader->ddwTotalShmSize);
+		delete pShmAdpt; pShmAdpt = NULL;
+		return -4;
+	}
+
+	// a MultiHashTable shm has the same leading size field, but not the magic
+	if(pHeader->ddwMagic != BHT_MAGIC)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Error: shm is not a BucketHashTable");
+		delete pShmAdpt; pShmAdpt = NULL;
+		return -5;
+	}
+
+	Attach(pHeader);
+	if(HashFunc)
+		hashfunc = HashFunc;
+	else
+		hashfunc = DefaultHashFunc;
+	return 0;
+}
+
+int BucketHashTable::CreateFromShm(const MhtInitParam &user_param)
+{
+	int iret;
+	MhtInitParam param = user_param;
+
+	if(param.ddwShmKey==0 || param.ddwBufferSize<sizeof(BhtHeader)+1024)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Bad argument, ShmKey and BufferSize must be given");
+		return -1;
+	}
+	if(param.cMaxKeyLen==0)   param.cMaxKeyLen = DEFAULT_MAX_KEY_LENGTH;
+	if(param.dwExpiryRatio == 0) param.dwExpiryRatio = DEFAULT_EXPIRY_RATIO;
+	if(param.dwIndexRatio==0) param.dwIndexRatio = DEFAULT_INDEX_RATIO;
+	if(param.ddwBlockSize==0) param.ddwBlockSize = DEFAULT_BLOCK_SIZE;
+
+	if((iret=InitFromShm(param.ddwShmKey, param.HashFunc))==0) // shm exists, check against given parameters
+	{
+		if(param.ddwBufferSize!=header->ddwTotalShmSize)
+		{
+			snprintf(errmsg, sizeof(errmsg), "Shm size mismatched: shm %llu, given %llu", header->ddwTotalShmSize, param.ddwBufferSize);
+			return -2;
+		}
+		if((int)param.cMaxKeyLen!=GetMaxKeyLen())
+		{
+			snprintf(errmsg, sizeof(errmsg), "Max key length mismatched: shm %d, given %d", GetMaxKeyLen(), (int)param.cMaxKeyLen);
+			return -3;
+		}
+		if(param.ddwBlockSize!=header->ddwUnitSize)
+		{
+			snprintf(errmsg, sizeof(errmsg), "Data unit size mismatched: shm %llu, given %llu", header->ddwUnitSize, param.ddwBlockSize);
+			return -5;
+		}
+		return 0;
+	}
+
+	if(iret && iret!=-100) // open existing shm failed
+	{
+		return -6;
+	}
+
+	pShmAdpt = new shm_adapter;
+	if(pShmAdpt==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Failed to create shm adaptor: Out of memory");
+		return -1;
+	}
+
+	bool ret = pShmAdpt->create(param.ddwShmKey, param.ddwBufferSize, param.bUseHugePage);
+	if(ret==false)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Failed to create shm: %s", pShmAdpt->get_err_msg().c_str());
+		delete pShmAdpt; pShmAdpt = NULL;
+		return -2;
+	}
+
+	void *pBuffer = pShmAdpt->get_shm();
+	if(pBuffer==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Bug: shm created successfully but shm pointer is NULL");
+		delete pShmAdpt; pShmAdpt = NULL;
+		return -3;
+	}
+
+	return InitFromBuffer(pBuffer, param.ddwBufferSize, param.cMaxKeyLen, param.wRowNum, param.dwExpiryRatio, param.dwIndexRatio, param.ddwBlockSize, param.HashFunc, param.bUseAccessSeq);
+}
+
+ull64_t BucketHashTable::Search(const void *pKey, int iKeyLen, uint32_t dwHashKey, ull64_t *pddwFree)
+{
+	uint8_t tag = BhtTag(dwHashKey);
+	ull64_t g = dwHashKey % header->ddwGroupNum;
+	ull64_t probe = header->ddwGroupNum < BHT_MAX_PROBE ? header->ddwGroupNum : BHT_MAX_PROBE;
+
+	if(pddwFree) *pddwFree = BHT_NIL;
+
+	for(ull64_t i = 0; i < probe; i++)
+	{
+		const uint8_t *gc = ctrl + g * BHT_GROUP_SIZE;
+		ull64_t base = g * BHT_GROUP_SIZE;
+		for(uint32_t m = MatchByte(gc, tag); m; m &= m - 1)
+		{
+			ull64_t idx = base + __builtin_ctz(m);
+			BhtSlot *s = SlotAt(idx);
+			if(s->cKeyLen == (ull64_t)iKeyLen && memcmp(s->acKey, pKey, iKeyLen) == 0)
+				return idx;
+		}
+		uint32_t free = MatchFree(gc);
+		if(pddwFree && *pddwFree == BHT_NIL && free)
+			*pddwFree = base + __builtin_ctz(free);
+		// the key would have been stored here if it existed
+		if(MatchByte(gc, BHT_CTRL_EMPTY))
+			break;
+		if(++g == header->ddwGroupNum)
+			g = 0;
+	}
+	return BHT_NIL;
+}
+
+ull64_t BucketHashTable::OldestOnPath(uint32_t dwHashKey)
+{
+	ull64_t g = dwHashKey % header->ddwGroupNum;
+	ull64_t probe = header->ddwGroupNum < BHT_MAX_PROBE ? header->ddwGroupNum : BHT_MAX_PROBE;
+	ull64_t oldest = BHT_NIL;
+	uint32_t oldesttime = (uint32_t)-1;
+
+	for(ull64_t i = 0; i < probe; i++)
+	{
+		ull64_t base = g * BHT_GROUP_SIZE;
+		for(uint32_t m = ~MatchFree(ctrl + base) & 0xFFFF; m; m &= m - 1)
+		{
+			ull64_t idx = base + __builtin_ctz(m);
+			if(oldest == BHT_NIL || SlotAt(idx)->dwAccessTime < oldesttime)
+			{
+				oldest = idx;
+				oldesttime = SlotAt(idx)->dwAccessTime;
+			}
+		}
+		if(++g == header->ddwGroupNum)
+			g = 0;
+	}
+	return oldest;
+}
+
+bool BucketHashTable::IsFreeMark(ull64_t ddwPos)
+{
+	return (bitmap[ddwPos >> 3] & (1 << (ddwPos & 7))) != 0;
+}
+
+void BucketHashTable::SetFreeMark(ull64_t ddwPos, bool bFree)
+{
+	if(bFree)
+		bitmap[ddwPos >> 3] |= (1 << (ddwPos & 7));
+	else
+		bitmap[ddwPos >> 3] &= ~(1 << (ddwPos & 7));
+}
+
+// the first and the last unit of a free extent are marked in the bitmap, the last one also keeps the unit count
+void BucketHashTable::PushFree(ull64_t ddwPos, ull64_t ddwUnitCnt)
+{
+	int list = ddwUnitCnt < BHT_FREE_LISTS ? (int)ddwUnitCnt : 0;
+	BhtFreeExt *ext = (BhtFreeExt *)UnitAt(ddwPos);
+	ext->ddwUnitCnt = ddwUnitCnt;
+	ext->ddwPrev = BHT_NIL;
+	ext->ddwNext = header->addwFreeHead[list];
+	if(ext->ddwNext != BHT_NIL)
+		((BhtFreeExt *)UnitAt(ext->ddwNext))->ddwPrev = ddwPos;
+	header->addwFreeHead[list] = ddwPos;
+	*(ull64_t *)UnitAt(ddwPos + ddwUnitCnt - 1) = ddwUnitCnt;
+	SetFreeMark(ddwPos, true);
+	SetFreeMark(ddwPos + ddwUnitCnt - 1, true);
+}
+
+void BucketHashTable::UnlinkFree(ull64_t ddwPos)
+{
+	BhtFreeExt *ext = (BhtFreeExt *)UnitAt(ddwPos);
+	int list = ext->ddwUnitCnt < BHT_FREE_LISTS ? (int)ext->ddwUnitCnt : 0;
+	if(ext->ddwPrev != BHT_NIL)
+		((BhtFreeExt *)UnitAt(ext->ddwPrev))->ddwNext = ext->ddwNext;
+	else
+		header->addwFreeHead[list] = ext->ddwNext;
+	if(ext->ddwNext != BHT_NIL)
+		((BhtFreeExt *)UnitAt(ext->ddwNext))->ddwPrev = ext->ddwPrev;
+	SetFreeMark(ddwPos, false);
+	SetFreeMark(ddwPos + ext->ddwUnitCnt - 1, false);
+}
+
+int BucketHashTable::AllocExtent(ull64_t ddwUnitCnt, ull64_t &ddwPos)
+{
+	ull64_t n = ddwUnitCnt;
+	ull64_t got = 0;
+
+	if(n < BHT_FREE_LISTS && header->addwFreeHead[n] != BHT_NIL)
+	{
+		ddwPos = header->addwFreeHead[n];
+		UnlinkFree(ddwPos);
+		got = n;
+	}
+	else if(header->ddwTopUnit + n <= header->ddwUnitNum)
+	{
+		ddwPos = header->ddwTopUnit;
+		header->ddwTopUnit += n;
+		got = n;
+	}
+	else
+	{
+		// split a larger extent
+		for(ull64_t k = n + 1; k < BHT_FREE_LISTS && got == 0; k++)
+		{
+			if(header->addwFreeHead[k] != BHT_NIL)
+				got = k;
+		}
+		if(got)
+			ddwPos = header->addwFreeHead[got];
+		// first fit in the list of large extents
+		for(ull64_t pos = header->addwFreeHead[0]; got == 0 && pos != BHT_NIL; pos = ((BhtFreeExt *)UnitAt(pos))->ddwNext)
+		{
+			if(((BhtFreeExt *)UnitAt(pos))->ddwUnitCnt >= n)
+			{
+				ddwPos = pos;
+				got = ((BhtFreeExt *)UnitAt(pos))->ddwUnitCnt;
+			}
+		}
+		if(got == 0)
+		{
+			snprintf(errmsg, sizeof(errmsg), "Error: no free extent of %llu units", n);
+			return -100;
+		}
+		UnlinkFree(ddwPos);
+		if(got > n)
+			PushFree(ddwPos + n, got - n);
+	}
+	header->ddwUsedUnit += n;
+	return 0;
+}
+
+// merge with the free neighbours, so that large extents can be found again
+void BucketHashTable::FreeExtent(ull64_t ddwPos, ull64_t ddwUnitCnt)
+{
+	if(ddwUnitCnt == 0)
+		return;
+	header->ddwUsedUnit -= ddwUnitCnt;
+	if(ddwPos > 0 && IsFreeMark(ddwPos - 1))
+	{
+		ull64_t prevcnt = *(ull64_t *)UnitAt(ddwPos - 1);
+		ddwPos -= prevcnt;
+		UnlinkFree(ddwPos);
+		ddwUnitCnt += prevcnt;
+	}
+	if(ddwPos + ddwUnitCnt < header->ddwTopUnit && IsFreeMark(ddwPos + ddwUnitCnt))
+	{
+		ull64_t nextcnt = ((BhtFreeExt *)UnitAt(ddwPos + ddwUnitCnt))->ddwUnitCnt;
+		UnlinkFree(ddwPos + ddwUnitCnt);
+		ddwUnitCnt += nextcnt;
+	}
+	if(ddwPos + ddwUnitCnt == header->ddwTopUnit)
+		header->ddwTopUnit = ddwPos;
+	else
+		PushFree(ddwPos, ddwUnitCnt);
+}
+
+void BucketHashTable::EraseSlot(ull64_t idx)
+{
+	BhtSlot *s = SlotAt(idx);
+	FreeExtent(s->ddwExtPos, UnitsOf(s->dwDataLen));
+	// a group with an empty slot ends probing, so the slot may go back to empty
+	ull64_t base = idx - idx % BHT_GROUP_SIZE;
+	ctrl[idx] = MatchByte(ctrl + base, BHT_CTRL_EMPTY) ? BHT_CTRL_EMPTY : BHT_CTRL_DELETED;
+	memset(s, 0, header->ddwSlotSize);
+	header->ddwUsedSlot --;
+}
+
+int BucketHashTable::EraseOldestOne(ull64_t ddwKeep)
+{
+	ull64_t ddwSlotNum = header->ddwGroupNum * BHT_GROUP_SIZE;
+	ull64_t oldest = BHT_NIL;
+	uint32_t oldesttime = (uint32_t)-1;
+
+	ull64_t it = header->ddwEraseIterator;
+	if(it>=ddwSlotNum)
+		it = 0;
+
+	for(int cnt = 0; cnt<BHT_EVICT_SAMPLE;)
+	{
+		if(it!=ddwKeep && !(ctrl[it] & 0x80))
+		{
+			if(oldest == BHT_NIL || SlotAt(it)->dwAccessTime < oldesttime)
+			{
+				oldesttime = SlotAt(it)->dwAccessTime;
+				oldest = it;
+			}
+			cnt ++;
+		}
+
+		it ++;
+		if(it>=ddwSlotNum)
+			it = 0;
+
+		if(it==header->ddwEraseIterator) // we have searched through the whole table
+		{
+			break;
+		}
+	}
+	header->ddwEraseIterator = it;
+
+	if(oldest != BHT_NIL)
+	{
+		EraseSlot(oldest);
+		return 0;
+	}
+	snprintf(errmsg, sizeof(errmsg), "Error: no more slot to be replaced");
+	return -7;
+}
+
+bool BucketHashTable::HasKey(const void *pKey, int iKeyLen)
+{
+	if(pKey==NULL || iKeyLen<=0 || header==NULL)
+	{
+		return false;
+	}
+	return Search(pKey, iKeyLen, BhtMix(hashfunc(pKey, iKeyLen))) != BHT_NIL;
+}
+
+int BucketHashTable::GetData(const void *pKey, int iKeyLen, char *sDataBuf, int &iDataLen, int* DataVer, bool bUpdateAccessTime, time_t *pdwLastAccessTime)
+{
+	if(pKey==NULL || iKeyLen<=0 || sDataBuf==NULL || iDataLen<1)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Bad argument");
+		return -1;
+	}
+	if(header==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Hash table is not initialized");
+		return -2;
+	}
+
+	ull64_t idx = Search(pKey, iKeyLen, BhtMix(hashfunc(pKey, iKeyLen)));
+	if(idx==BHT_NIL)
+	{
+		iDataLen = 0;
+		return 0;
+	}
+
+	BhtSlot *s = SlotAt(idx);
+	if(pdwLastAccessTime)
+		*pdwLastAccessTime = s->dwAccessTime;
+	if(DataVer)
+		*DataVer = (uint8_t)s->cDataVer;
+	if(bUpdateAccessTime)
+	{
+		if(header->cUseAccessSeq==0)
+			s->dwAccessTime = time(NULL);
+		else
+			__sync_fetch_and_add(&s->dwAccessSeq, 1);
+	}
+
+	if(s->dwDataLen > (uint32_t)iDataLen)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Buffer too small: %u > %d", s->dwDataLen, iDataLen);
+		return -4;
+	}
+	iDataLen = s->dwDataLen;
+	memcpy(sDataBuf, UnitAt(s->ddwExtPos), iDataLen);
+	return 0;
+}
+
+int BucketHashTable::SetData(const void *pKey, int iKeyLen, const char *sDataBuf, int iDataLen, int DataVer, bool bRemoveOldIfNoSpace)
+{
+	if(pKey==NULL || iKeyLen<=0 || sDataBuf==NULL || iDataLen<0 || iDataLen>HASH_MAX_DATA_LENGTH)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Bad argument");
+		return -1;
+	}
+	if(header==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Hash table is not initialized");
+		return -2;
+	}
+	if((ull64_t)iKeyLen > header->ddwMaxKeyLen)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Key too long: %d > %llu", iKeyLen, header->ddwMaxKeyLen);
+		return -1;
+	}
+
+	uint32_t dwHashKey = BhtMix(hashfunc(pKey, iKeyLen));
+	ull64_t ddwFree;
+	ull64_t idx = Search(pKey, iKeyLen, dwHashKey, &ddwFree);
+	BhtSlot *s = (idx==BHT_NIL) ? NULL : SlotAt(idx);
+
+	// a new key is taken as version 0, the same as an empty node of MultiHashTable
+	if(DataVer != -1 && (s ? (int)s->cDataVer : 0) != DataVer)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Error: Data collision.");
+		return -1000;	//data collision
+	}
+
+	// erase condition 1: if data used space exceeds the expiry ratio, erase the oldest ones
+	if(bRemoveOldIfNoSpace)
+	{
+		while(GetUsage() >= (int)header->dwExpiryRatio && header->ddwUsedSlot > 1)
+		{
+			if(EraseOldestOne(idx))
+				break;
+		}
+	}
+
+	if(s==NULL && ddwFree==BHT_NIL)
+	{
+		if(!bRemoveOldIfNoSpace)
+		{
+			snprintf(errmsg, sizeof(errmsg), "Error: Hash table out of space");
+			return -3;
+		}
+		// erase condition 2: no free slot on the probe path, take the oldest one
+		ddwFree = OldestOnPath(dwHashKey);
+		if(ddwFree==BHT_NIL)
+		{
+			snprintf(errmsg, sizeof(errmsg), "Bug: could not find an oldest slot for erasing.");
+			return -4;
+		}
+		EraseSlot(ddwFree);
+	}
+
+	// a value of the same unit count is overwritten in place
+	ull64_t ddwUnitCnt = UnitsOf(iDataLen);
+	ull64_t ddwPos = s ? s->ddwExtPos : 0;
+	if(s==NULL || UnitsOf(s->dwDataLen)!=ddwUnitCnt)
+	{
+		ddwPos = 0;
+		while(ddwUnitCnt && AllocExtent(ddwUnitCnt, ddwPos)!=0)
+		{
+			if(!bRemoveOldIfNoSpace)
+			{
+				snprintf(errmsg, sizeof(errmsg), "Error: data space out of space");
+				return -5;
+			}
+			// erase condition 3: when not enough data space, remove the oldest of the sampled slots
+			if(EraseOldestOne(idx))
+				return -6;
+		}
+		if(s)
+			FreeExtent(s->ddwExtPos, UnitsOf(s->dwDataLen));
+	}
+	memcpy(UnitAt(ddwPos), sDataBuf, iDataLen);
+
+	if(s==NULL)
+	{
+		idx = ddwFree;
+		s = SlotAt(idx);
+		s->cKeyLen = iKeyLen;
+		memcpy(s->acKey, pKey, iKeyLen);
+		s->cDataVer = 0;
+		ctrl[idx] = BhtTag(dwHashKey);
+		header->ddwUsedSlot ++;
+		if(header->cUseAccessSeq)
+			s->dwAccessSeq = 0;
+	}
+	s->ddwExtPos = ddwPos;
+	s->dwDataLen = iDataLen;
+	s->cDataVer++;	//Update Data Version
+	if(header->cUseAccessSeq==0)
+		s->dwAccessTime = time(NULL);
+	return 0;
+}
+
+int BucketHashTable::EraseData(const void *pKey, int iKeyLen)
+{
+	if(pKey==NULL || iKeyLen<=0)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Bad argument");
+		return -1;
+	}
+	if(header==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Hash table is not initialized");
+		return -2;
+	}
+
+	ull64_t idx = Search(pKey, iKeyLen, BhtMix(hashfunc(pKey, iKeyLen)));
+	if(idx!=BHT_NIL)
+		EraseSlot(idx);
+	return 0;
+}
+
+MhtIterator BucketHashTable::Next(MhtIterator it)
+{
+	if(header==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Hash table is not initialized");
+		return -1;
+	}
+
+	ull64_t ddwSlotNum = header->ddwGroupNum * BHT_GROUP_SIZE;
+	for(it++; it<ddwSlotNum; ++it)
+	{
+		if(!(ctrl[it] & 0x80))
+			return it;
+	}
+	return End();
+}
+
+int BucketHashTable::Get(MhtIterator it, MhtData &data, bool withdata)
+{
+	if(header==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Hash table is not initialized");
+		return -1;
+	}
+
+	BhtSlot *s = SlotAt(it);
+	data.klen = s->cKeyLen;
+	if(data.klen>HASH_MAX_KEY_LENGTH)
+		data.klen = HASH_MAX_KEY_LENGTH;
+	memcpy(data.key, s->acKey, data.klen);
+
+	data.access_time = s->dwAccessTime;
+
+	if(withdata)
+	{
+		if(s->dwDataLen > sizeof(data.data))
+		{
+			snprintf(errmsg, sizeof(errmsg), "Data too long: %u", s->dwDataLen);
+			return -2;
+		}
+		data.dlen = s->dwDataLen;
+		memcpy(data.data, UnitAt(s->ddwExtPos), data.dlen);
+	}
+
+	return 0;
+}
+
+int BucketHashTable::GetMaxKeyLen()
+{
+	if(header==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Hash table is not initialized");
+		return -1;
+	}
+	return (int)header->ddwMaxKeyLen;
+}
+
+int BucketHashTable::GetDataBlockSize()
+{
+	if(header==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Hash table is not initialized");
+		return -1;
+	}
+	return (int)header->ddwUnitSize;
+}
+
+int BucketHashTable::GetHashRowNum()
+{
+	if(header==NULL)
+	{
+		snprintf(errmsg, sizeof(errmsg), "Hash table is not initialized");
+		return -1;
+	}
+	return BHT_MAX_PROBE;
+}
+
+int BucketHashTable::PrintInfo(const string &prefix)
+{
+	if(header==NULL)
+	{
+		cout << prefix << "Hash table is not initialized" << endl;
+		return -1;
+	}
+	cout << prefix << "Bucket hash table info:" << endl;
+	cout << prefix << "    ddwTotalShmSize:   " << header->ddwTotalShmSize << endl;
+	cout << prefix << "    ddwGroupNum:       " << header->ddwGroupNum << endl;
+	cout << prefix << "    ddwSlotSize:       " << header->ddwSlotSize << endl;
+	cout << prefix << "    ddwUsedSlot:       " << header->ddwUsedSlot << endl;
+	cout << prefix << "    ddwUnitSize:       " << header->ddwUnitSize << endl;
+	cout << prefix << "    ddwUnitNum:        " << header->ddwUnitNum << endl;
+	cout << prefix << "    ddwUsedUnit:       " << header->ddwUsedUnit << endl;
+	cout << prefix << "    ddwTopUnit:        " << header->ddwTopUnit << endl;
+	cout << prefix << "    ddwEraseIterator:  " << header->ddwEraseIterator << endl;
+	return 0;
+}
@@ -0,0 +1,168 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/******************************************************************************
+
+  FILENAME:	bucket_hash_table.h
+
+  DESCRIPTION:	鿪ѰַHashÿ16ۣڿֽSSE2һαȽϣ
+  		keyڲУvalueextentУӿMultiHashTableͬ
+
+ ******************************************************************************/
+#ifndef __BUCKET_HASH_TABLE__
+#define __BUCKET_HASH_TABLE__
+
+#include <stdlib.h>
+#include "multi_hash_table.h"
+
+/*
+ * Buffer structure: BhtHeader + Ctrl[GroupNum*16] + Slot[GroupNum*16] + Bitmap[UnitNum/8] + Unit[UnitNum]
+ *   Ctrl:  one byte per slot, 0x00-0x7F: used (7 bits of the hash), BHT_CTRL_EMPTY, BHT_CTRL_DELETED
+ *   Slot:  access time, data length/version, extent position and the inline key
+ *   Bitmap: marks the first and the last unit of each free extent
+ *   Unit:  data space, a value takes ceil(len/UnitSize) contiguous units
+ * A key is probed in at most BHT_MAX_PROBE consecutive groups, the probe stops at
+ * the first group having an empty slot.
+ * Free extents are kept in lists by unit count and merged with free neighbours on release.
+ * A value of the same unit count is overwritten in place, which is the common case
+ * for fixed size values like the monitor DataShm.
+ */
+#define BHT_MAGIC              0x3130544842ULL	// "BHT01"
+#define BHT_GROUP_SIZE         16
+#define BHT_MAX_PROBE          16	// max groups probed for a key
+#define BHT_FREE_LISTS         64	// free extent lists indexed by unit count, [0] holds larger ones
+#define BHT_EVICT_SAMPLE       100	// used slots sampled when looking for the oldest one to erase
+#define BHT_NIL                ((ull64_t)-1)
+
+#define BHT_CTRL_EMPTY         0x80
+#define BHT_CTRL_DELETED       0xFE
+
+struct BhtSlot {
+	union {
+		uint32_t dwAccessTime;
+		volatile uint32_t dwAccessSeq;
+	};
+	uint32_t dwDataLen;
+	ull64_t ddwExtPos : 48; // first unit of the value extent
+	ull64_t cKeyLen   : 8;
+	ull64_t cDataVer  : 8;  // Use for data collision detection
+	uint8_t acKey[0];
+};
+
+typedef struct {
+	ull64_t ddwMagic;
+	ull64_t ddwTotalShmSize;
+	ull64_t ddwGroupNum;
+	ull64_t ddwSlotSize;
+	ull64_t ddwMaxKeyLen;
+	ull64_t ddwUnitSize;
+	ull64_t ddwUnitNum;
+	ull64_t ddwUsedUnit;
+	ull64_t ddwTopUnit;        // units from here on have never been allocated
+	ull64_t ddwUsedSlot;
+	ull64_t ddwEraseIterator;  // used to iterate through the slots for erasing old key
+	ull64_t ddwCtrlOffset;     // offsets from the start of the buffer
+	ull64_t ddwSlotOffset;
+	ull64_t ddwBitmapOffset;
+	ull64_t ddwDataOffset;
+	ull64_t addwFreeHead[BHT_FREE_LISTS];
+	uint32_t dwExpiryRatio;
+	uint8_t cUseAccessSeq; // 0: use access_time for auto erasing, 1: use access_seq
+	uint8_t acReserved[4096];
+} BhtHeader;
+
+class BucketHashTable
+{
+private:
+	BhtHeader *header;
+	uint8_t *ctrl;
+	char *slots;
+	uint8_t *bitmap;
+	char *units;
+	shm_adapter *pShmAdpt;
+	char errmsg[1024];
+	CalcHashKeyFunc hashfunc;
+
+private:
+	BhtSlot *SlotAt(ull64_t idx) { return (BhtSlot *)(slots + idx * header->ddwSlotSize); }
+	char *UnitAt(ull64_t pos) { return units + pos * header->ddwUnitSize; }
+	ull64_t UnitsOf(ull64_t len) { return (len + header->ddwUnitSize - 1) / header->ddwUnitSize; }
+	void Attach(void *pBuffer);
+
+	// Search and return the slot index of pKey, BHT_NIL if not found, optionally
+	//  pddwFree returns the first empty or deleted slot on the probe path
+	ull64_t Search(const void *pKey, int iKeyLen, uint32_t dwHashKey, ull64_t *pddwFree = NULL);
+	// the least recently accessed slot on pKey's probe path
+	ull64_t OldestOnPath(uint32_t dwHashKey);
+
+	// returns -100 when there is no extent large enough
+	int AllocExtent(ull64_t ddwUnitCnt, ull64_t &ddwPos);
+	void FreeExtent(ull64_t ddwPos, ull64_t ddwUnitCnt);
+	void PushFree(ull64_t ddwPos, ull64_t ddwUnitCnt);
+	void UnlinkFree(ull64_t ddwPos);
+	bool IsFreeMark(ull64_t ddwPos);
+	void SetFreeMark(ull64_t ddwPos, bool bFree);
+
+	void EraseSlot(ull64_t idx);
+	// sample BHT_EVICT_SAMPLE used slots from the erase iterator and erase the oldest, never ddwKeep
+	int EraseOldestOne(ull64_t ddwKeep);
+
+public:
+	BucketHashTable():header(NULL),ctrl(NULL),slots(NULL),bitmap(NULL),units(NULL),pShmAdpt(NULL),errmsg(),hashfunc(DefaultHashFunc) {}
+	~BucketHashTable();
+
+	// Same init methods and return values as MultiHashTable, wRowNum is not used
+	//     dwIndexRatio   -- slot num * 100 / data unit num
+	//     ddwBlockSize   -- data unit size, best set to the (fixed) value size
+	int InitFromBuffer(void *pBuffer, ull64_t ddwBufferSize, // required arguments
+			uint8_t cMaxKeyLen = DEFAULT_MAX_KEY_LENGTH,
+			uint16_t wRowNum = DEFAULT_ROW_NUM,
+			uint32_t dwExpiryRatio = DEFAULT_EXPIRY_RATIO,
+			uint32_t dwIndexRatio = DEFAULT_INDEX_RATIO,
+			ull64_t ddwBlockSize = DEFAULT_BLOCK_SIZE,
+			CalcHashKeyFunc HashFunc = NULL,
+			bool bUseAccessSeq = false);
+	int InitFromShm(ull64_t ddwShmKey, CalcHashKeyFunc HashFunc = NULL);
+	int CreateFromShm(const MhtInitParam &param);
+
+	bool HasKey(const void *pKey, int iKeyLen);
+	int GetData(const void *pKey, int iKeyLen, char *sDataBuf, int &iDataLen, int *DataVer = NULL, bool bUpdateAccessTime = true, time_t *pdwLastAccessTime = NULL);
+	int SetData(const void *pKey, int iKeyLen, const char *sDataBuf, int iDataLen, int DataVer = -1, bool bRemoveOldIfNoSpace = false);
+	int EraseData(const void *pKey, int iKeyLen);
+
+	int PeekData(const void *pKey, int iKeyLen, char *sDataBuf, int &iDataLen) { return GetData(pKey, iKeyLen, sDataBuf, iDataLen, NULL, false); }
+	int ForceSetData(const void *pKey, int iKeyLen, char *sDataBuf, int iDataLen) { return SetData(pKey, iKeyLen, sDataBuf, iDataLen, -1, true); }
+
+	// Iteration interfaces, the iterator is the slot index
+	MhtIterator Begin() { return Next(End()); }
+	MhtIterator End() { return (MhtIterator)-1; }
+	MhtIterator Next(MhtIterator it);
+	int Get(MhtIterator it, MhtData &data, bool withdata = true);
+
+	int GetMaxKeyLen();
+	int GetDataBlockSize();
+	int GetHashRowNum();
+	// 0~100, the data space in use
+	int GetUsage() { return header? (int)(header->ddwUsedUnit * 100 / header->ddwUnitNum) : 0; }
+	int PrintInfo(const string &prefix = "");
+
+	const char *GetErrorMsg() { return errmsg; }
+};
+
+#endif
@@ -18,12 +18,135 @@
 
 
 #include "multi_hash_table.h"
+#include "bucket_hash_table.h"
 #include <stdio.h>
 #include <string>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/time.h>
 
-int main()
+static long long NowUs()
 {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+// key/value like the monitor DataShm: dwAttrId + dwIP + dwDay -> 256 + 1440*4
+#define BENCH_VALUE_LEN (128*2 + 1440*4)
+
+static void BenchKey(int i, char key[12])
+{
+	uint32_t k[3] = { (uint32_t)(i % 2000 + 1), (uint32_t)(0x0a000000 + i / 2000), 20240101 };
+	memcpy(key, k, sizeof(k));
+}
+
+static void BenchReport(const char *name, const char *op, long long us, int n)
+{
+	printf("%-16s %-8s %10.0f ns/op %12.0f op/s\n", name, op, us * 1000.0 / n, n * 1000000.0 / (us ? us : 1));
+}
+
+template <class T>
+static int Bench(const char *name, T &t, int n)
+{
+	static char val[BENCH_VALUE_LEN];
+	static MhtData data;
+	char key[12];
+	int ret, len, ver, fail = 0;
+	int step = 7919;	// visit keys in a scattered order
+	while(n % step == 0) step += 2;
+
+	long long begin = NowUs();
+	for(int i = 0; i < n; i++)
+	{
+		BenchKey(i, key);
+		memcpy(val, &i, sizeof(i));
+		if(t.SetData(key, sizeof(key), val, sizeof(val), -1, true)) fail++;
+	}
+	BenchReport(name, "insert", NowUs() - begin, n);
+
+	begin = NowUs();
+	for(int i = 0, j = 0; i < n; i++, j = (j + step) % n)
+	{
+		BenchKey(j, key);
+		len = sizeof(val);
+		if(t.GetData(key, sizeof(key), val, len) || len != sizeof(val) || *(int*)val != j) fail++;
+	}
+	BenchReport(name, "get", NowUs() - begin, n);
+
+	// read-modify-write with version check, as CSetProcCenter::UpdateValueData does
+	begin = NowUs();
+	for(int i = 0, j = 0; i < n; i++, j = (j + step) % n)
+	{
+		BenchKey(j, key);
+		len = sizeof(val);
+		ver = 0;
+		ret = t.GetData(key, sizeof(key), val, len, &ver);
+		val[256 + i % 1440 * 4] ++;
+		if(ret || t.SetData(key, sizeof(key), val, sizeof(val), ver, true)) fail++;
+	}
+	BenchReport(name, "update", NowUs() - begin, n);
+
+	begin = NowUs();
+	int cnt = 0;
+	for(MhtIterator it = t.Begin(); it != t.End(); it = t.Next(it))
+	{
+		if(t.Get(it, data) == 0) cnt++;
+	}
+	BenchReport(name, "iterate", NowUs() - begin, cnt ? cnt : 1);
+
+	begin = NowUs();
+	for(int i = 0; i < n; i++)
+	{
+		BenchKey(i, key);
+		if(t.EraseData(key, sizeof(key))) fail++;
+	}
+	BenchReport(name, "erase", NowUs() - begin, n);
+
+	printf("%-16s %d keys, %d iterated, %d failed\n", name, n, cnt, fail);
+	return fail;
+}
+
+// test bench [key_num]: compare MultiHashTable and BucketHashTable with DataShm-like records
+static int RunBench(int n)
+{
+	ull64_t size = (ull64_t)n * (BENCH_VALUE_LEN + 8) * 3 / 2 + 16*1024*1024;
+	void *buf = calloc(1, size);
+	if(buf == NULL)
+	{
+		printf("no memory for %llu bytes\n", size);
+		return -1;
+	}
+
+	MultiHashTable mht;
+	int ret = mht.InitFromBuffer(buf, size, 12, DEFAULT_ROW_NUM, DEFAULT_EXPIRY_RATIO, 100, BENCH_VALUE_LEN + 8);
+	if(ret != 0)
+	{
+		printf("error init MultiHashTable|%d|%s\n", ret, mht.GetErrorMsg());
+		return ret;
+	}
+	Bench("MultiHashTable", mht, n);
+
+	memset(buf, 0, size);
+	BucketHashTable bht;
+	ret = bht.InitFromBuffer(buf, size, 12, DEFAULT_ROW_NUM, DEFAULT_EXPIRY_RATIO, 100, BENCH_VALUE_LEN);
+	if(ret != 0)
+	{
+		printf("error init BucketHashTable|%d|%s\n", ret, bht.GetErrorMsg());
+		return ret;
+	}
+	Bench("BucketHashTable", bht, n);
+
+	free(buf);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc > 1 && strcmp(argv[1], "bench") == 0)
+		return RunBench(argc > 2 ? atoi(argv[2]) : 20000);
+
 	MultiHashTable t;
 	MhtInitParam param;
 	memset((char*)&param, 0, sizeof(MhtInitParam));
@@ -28,6 +28,10 @@ CFIFOBuffer::CFIFOBuffer(void)
 ,m_iBufferLen(0)
 ,m_iHeadPos(0)
 ,m_iTailPos(0)
+,m_iReadPos(0)
+,m_iReserveHeadPos(0)
+,m_iReserveDataPos(0)
+,m_iReserveLen(-1)
 ,m_iCurDataLen(0)
 ,m_iResetCount(0)
 ,m_iReadCount(0)
@@ -44,6 +48,22 @@ void CFIFOBuffer::Reset()
 {
 	m_iHeadPos = 0;
 	m_iTailPos = 0;
+	m_iReadPos = 0;
+	m_iReserveLen = -1;
+	m_iCurDataLen = 0;
+	++m_iResetCount;
+}
+
+void CFIFOBuffer::ResetRead(const bool bPending, const int32_t iTailPos)
+{
+	if ( !bPending )
+	{
+		this->Reset();
+		return;
+	}
+
+	//m_iHeadPos, δͷŵRelease֮ǰᱻд˸
+	m_iReadPos = iTailPos;
 	m_iCurDataLen = 0;
 	++m_iResetCount;
 }
@@ -80,139 +100,146 @@ CFIFOBuffer::RETURN_TYPE CFIFOBuffer::ReadNext()
 {
 	CFIFOBuffer::RETURN_TYPE nRe = BUF_OK;
 
-	assert(m_iHeadPos>=0 && m_iHeadPos<=m_iBufferLen);
+	assert(m_iReadPos>=0 && m_iReadPos<=m_iBufferLen);
 	assert(m_iTailPos>=0 && m_iTailPos<=m_iBufferLen);
 
 	int32_t iTmpTailPos = m_iTailPos;
+	const bool bPending = (m_iHeadPos != m_iReadPos);
 
-	if (m_iHeadPos < iTmpTailPos)
+	if (m_iReadPos < iTmpTailPos)
 	{
 		//жݳȵĺϷ, Ƿ,
-		if (m_iHeadPos+HEAD_LEN > iTmpTailPos) 
+		if (m_iReadPos+HEAD_LEN > iTmpTailPos) 
 		{
 			//reset buffer
 			char szErrMsg[1024];
-			xsnprintf(szErrMsg, sizeof(szErrMsg),  "data error:(m_iHeadPos<%lu>+4 > dwTailPos<%lu>)(file:%s,line:%d)",m_iHeadPos,iTmpTailPos, __FILE__, __LINE__);
+			xsnprintf(szErrMsg, sizeof(szErrMsg),  "data error:(m_iReadPos<%lu>+4 > dwTailPos<%lu>)(file:%s,line:%d)",m_iReadPos,iTmpTailPos, __FILE__, __LINE__);
 			m_sErrMsg = szErrMsg;
 			assert(0);
-			this->Reset();
+			this->ResetRead(bPending, iTmpTailPos);
 			return BUF_ERR; 
 		}
 
 		//ȡݳϢ
-		m_iCurDataLen = *(int32_t *)(m_pszDataBuf+m_iHeadPos);
+		m_iCurDataLen = *(int32_t *)(m_pszDataBuf+m_iReadPos);
 
 		//жݳȵĺϷ, Ƿ,
-		if (m_iHeadPos+HEAD_LEN+m_iCurDataLen > iTmpTailPos)
+		if (m_iReadPos+HEAD_LEN+m_iCurDataLen > iTmpTailPos)
 		{
 			char szErrMsg[1024];
-			xsnprintf(szErrMsg, sizeof(szErrMsg),  "data error:(m_iHeadPos<%lu>+sizeof(SDataHead)<%u>+4 > dwTailPos<%lu>)(file:%s,line:%d).", m_iHeadPos, m_iCurDataLen, iTmpTailPos, __FILE__, __LINE__);
+			xsnprintf(szErrMsg, sizeof(szErrMsg),  "data error:(m_iReadPos<%lu>+sizeof(SDataHead)<%u>+4 > dwTailPos<%lu>)(file:%s,line:%d).", m_iReadPos, m_iCurDataLen, iTmpTailPos, __FILE__, __LINE__);
 			m_sErrMsg = szErrMsg;
 			assert(0);
-			this->Reset();
+			this->ResetRead(bPending, iTmpTailPos);
 			return BUF_ERR; 
 		}
 
 		//ȡϢ
-		m_iHeadPos+= HEAD_LEN;
+		m_iReadPos+= HEAD_LEN;
 	}
-	else if (m_iHeadPos > iTmpTailPos) 
+	else if (m_iReadPos > iTmpTailPos) 
 	{
-		if (m_iHeadPos+HEAD_LEN <= m_iBufferLen)
+		if (m_iReadPos+HEAD_LEN <= m_iBufferLen)
 		{
 			//ȡͷϢ
-			m_iCurDataLen = *(int32_t *)(m_pszDataBuf+m_iHeadPos);
-			if ( m_iCurDataLen + m_iHeadPos + HEAD_LEN > m_iBufferLen )
+			m_iCurDataLen = *(int32_t *)(m_pszDataBuf+m_iReadPos);
+			if ( m_iCurDataLen + m_iReadPos + HEAD_LEN > m_iBufferLen )
 //			if(EMPTY_DATA == stDataHead.ucDataType)
 			{//ѵbufferβ,ӿʼ
-				m_iHeadPos = 0;
+				m_iReadPos = 0;
 				//жݳȵĺϷ, Ƿ,
-				if (m_iHeadPos == iTmpTailPos)
+				if (m_iReadPos == iTmpTailPos)
 				{
 					char szErrMsg[1024];
-					xsnprintf(szErrMsg, sizeof(szErrMsg),  "data error:(m_iHeadPos<%d>+4 > dwTailPos<%d>)(file:%s,line:%d)",m_iHeadPos,iTmpTailPos, __FILE__, __LINE__);
+					xsnprintf(szErrMsg, sizeof(szErrMsg),  "data error:(m_iReadPos<%d>+4 > dwTailPos<%d>)(file:%s,line:%d)",m_iReadPos,iTmpTailPos, __FILE__, __LINE__);
 					m_sErrMsg = szErrMsg;
 					assert(0);
-					this->Reset();
+					this->ResetRead(bPending, iTmpTailPos);
 					return BUF_ERR;
 				}
-				else if (m_iHeadPos+HEAD_LEN > iTmpTailPos) 
+				else if (m_iReadPos+HEAD_LEN > iTmpTailPos) 
 				{
 					//reset buffer
 					char szErrMsg[1024];
-					xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:(m_iHeadPos<%d>+4 > dwTailPos<%d>)(file:%s,line:%d)",m_iHeadPos,iTmpTailPos, __FILE__, __LINE__);
+					xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:(m_iReadPos<%d>+4 > dwTailPos<%d>)(file:%s,line:%d)",m_iReadPos,iTmpTailPos, __FILE__, __LINE__);
 					m_sErrMsg = szErrMsg;
 					assert(0);
-					this->Reset();
+					this->ResetRead(bPending, iTmpTailPos);
 					return BUF_ERR;
 				}
 
 				//жݳȵĺϷ, Ƿ,
-				if (m_iHeadPos+m_iCurDataLen > iTmpTailPos)
+				if (m_iReadPos+m_iCurDataLen > iTmpTailPos)
 				{
 					char szErrMsg[1024];
-					xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:(m_iHeadPos<%lu>+DataLen<%u> > dwTailPos<%lu>)(file:%s,line:%d).",m_iHeadPos, m_iCurDataLen, iTmpTailPos, __FILE__, __LINE__);
+					xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:(m_iReadPos<%lu>+DataLen<%u> > dwTailPos<%lu>)(file:%s,line:%d).",m_iReadPos, m_iCurDataLen, iTmpTailPos, __FILE__, __LINE__);
 					m_sErrMsg = szErrMsg;
 					assert(0);
-					this->Reset();
+					this->ResetRead(bPending, iTmpTailPos);
 					return BUF_ERR;
 				}
 			}
 			else
 			{
 				//жݳȵĺϷ, Ƿ,
-				if (m_iHeadPos+HEAD_LEN+m_iCurDataLen > m_iBufferLen)
+				if (m_iReadPos+HEAD_LEN+m_iCurDataLen > m_iBufferLen)
 				{
 					char szErrMsg[1024];
-					xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:<dwTailPos=%d>(m_iHeadPos<%d>+4+wDataLen<%u> > m_iBufferLen<%lu>)(file:%s,line:%d).",iTmpTailPos, m_iHeadPos,m_iCurDataLen,m_iBufferLen, __FILE__, __LINE__);
+					xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:<dwTailPos=%d>(m_iReadPos<%d>+4+wDataLen<%u> > m_iBufferLen<%lu>)(file:%s,line:%d).",iTmpTailPos, m_iReadPos,m_iCurDataLen,m_iBufferLen, __FILE__, __LINE__);
 					m_sErrMsg = szErrMsg;
 					assert(0);
-					this->Reset();
+					this->ResetRead(bPending, iTmpTailPos);
 					return BUF_ERR;
 				}		
 
 				//ȡϢ
-				m_iHeadPos += HEAD_LEN ;
+				m_iReadPos += HEAD_LEN ;
 			}
 		}
 		else //ѵbufferβ,ӿʼ
 		{
-			m_iHeadPos = 0;
+			//ǰݶͷʱ, Ҳͬд, д˿ĿռƫС
+			const bool bReleased = (m_iHeadPos == m_iReadPos);
+			m_iReadPos = 0;
 			//жݳȵĺϷ, Ƿ,
-			if (m_iHeadPos == iTmpTailPos)
+			if (m_iReadPos == iTmpTailPos)
 			{
+				if ( bReleased )
+				{
+					m_iHeadPos = m_iReadPos;
+				}
 				return BUF_EMPTY;
 			}
-			else if (m_iHeadPos+HEAD_LEN > iTmpTailPos) 
+			else if (m_iReadPos+HEAD_LEN > iTmpTailPos) 
 			{
 				//reset buffer
 				char szErrMsg[1024];
-				xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:(m_iHeadPos<%lu>+4> dwTailPos<%lu>)(file:%s,line:%d)",m_iHeadPos, iTmpTailPos, __FILE__, __LINE__);
+				xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:(m_iReadPos<%lu>+4> dwTailPos<%lu>)(file:%s,line:%d)",m_iReadPos, iTmpTailPos, __FILE__, __LINE__);
 				m_sErrMsg = szErrMsg;
 				assert(0);
-				this->Reset();
+				this->ResetRead(bPending, iTmpTailPos);
 				return BUF_ERR;
 			}
 
 			//ȡͷϢ
-			m_iCurDataLen = *(int32_t *)(m_pszDataBuf+m_iHeadPos);
+			m_iCurDataLen = *(int32_t *)(m_pszDataBuf+m_iReadPos);
 
 			//жݳȵĺϷ, Ƿ,
-			if (m_iHeadPos+HEAD_LEN+m_iCurDataLen > iTmpTailPos)
+			if (m_iReadPos+HEAD_LEN+m_iCurDataLen > iTmpTailPos)
 			{
 				char szErrMsg[1024];
-				xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:(m_iHeadPos<%lu>+4+wDataLen<%u> > dwTailPos<%lu>)(file:%s,line:%d).",m_iHeadPos, m_iCurDataLen, iTmpTailPos, __FILE__, __LINE__);
+				xsnprintf(szErrMsg, sizeof(szErrMsg), "data error:(m_iReadPos<%lu>+4+wDataLen<%u> > dwTailPos<%lu>)(file:%s,line:%d).",m_iReadPos, m_iCurDataLen, iTmpTailPos, __FILE__, __LINE__);
 				m_sErrMsg = szErrMsg;
 				assert(0);
-				this->Reset();
+				this->ResetRead(bPending, iTmpTailPos);
 				return BUF_ERR;
 			}
 
 			//ȡϢ
-			m_iHeadPos += HEAD_LEN;
+			m_iReadPos += HEAD_LEN;
 		}
 	}
-	else//if (m_iHeadPos == dwTailPos)
+	else//if (m_iReadPos == dwTailPos)
 	{
 		//û
 		nRe = BUF_EMPTY;
@@ -506,9 +533,88 @@ CFIFOBuffer::RETURN_TYPE CFIFOBuffer::Write(const unsigned char* pszData1, const
 	return nRe;
 }
 
+unsigned char* CFIFOBuffer::Reserve(const int32_t iMaxLen)
+{
+	assert(m_iHeadPos>=0 && m_iHeadPos<=m_iBufferLen);
+	assert(m_iTailPos>=0 && m_iTailPos<=m_iBufferLen);
+
+	int32_t iTmpHeadPos = m_iHeadPos;
+
+	//Writeķùͬ, ֻȲдͷ
+	m_iReserveLen = -1;
+	if ( iMaxLen < 0 )
+	{
+		m_sErrMsg = "reserve len error.";
+		return NULL;
+	}
+
+	if (iTmpHeadPos <= m_iTailPos)
+	{
+		if (m_iTailPos+HEAD_LEN+iMaxLen <= m_iBufferLen)
+		{
+			m_iReserveHeadPos = m_iTailPos;
+			m_iReserveDataPos = m_iTailPos+HEAD_LEN;
+		}
+		else if (m_iTailPos+HEAD_LEN <= m_iBufferLen)
+		{
+			//ѵbufferβ,ֻܱͷ
+			if (iMaxLen >= iTmpHeadPos)
+			{
+				return NULL;
+			}
+			m_iReserveHeadPos = m_iTailPos;
+			m_iReserveDataPos = 0;
+		}
+		else
+		{
+			if (iMaxLen+HEAD_LEN >= iTmpHeadPos)
+			{
+				return NULL;
+			}
+			m_iReserveHeadPos = 0;
+			m_iReserveDataPos = HEAD_LEN;
+		}
+	}
+	else
+	{
+		if (m_iTailPos+HEAD_LEN+iMaxLen >= iTmpHeadPos)
+		{
+			return NULL;
+		}
+		m_iReserveHeadPos = m_iTailPos;
+		m_iReserveDataPos = m_iTailPos+HEAD_LEN;
+	}
+
+	m_iReserveLen = iMaxLen;
+	return m_pszDataBuf+m_iReserveDataPos;
+}
 
+CFIFOBuffer::RETURN_TYPE CFIFOBuffer::Commit(const int32_t iDataLen)
+{
+	if ( m_iReserveLen < 0 || iDataLen < 0 || iDataLen > m_iReserveLen )
+	{
+		char szErrMsg[1024];
+		xsnprintf(szErrMsg, sizeof(szErrMsg), "commit error:(iDataLen<%d>, m_iReserveLen<%d>)(file:%s,line:%d).", iDataLen, m_iReserveLen, __FILE__, __LINE__);
+		m_sErrMsg = szErrMsg;
+		m_iReserveLen = -1;
+		return BUF_ERR;
+	}
 
+	//Ԥʱͷβڿͷ, ʵʳβŵ:
+	//˰жǷ, ҪŲͷ
+	int32_t iDataPos = m_iReserveDataPos;
+	if ( iDataPos != m_iReserveHeadPos+HEAD_LEN && m_iReserveHeadPos+HEAD_LEN+iDataLen <= m_iBufferLen )
+	{
+		iDataPos = m_iReserveHeadPos+HEAD_LEN;
+		memmove(m_pszDataBuf+iDataPos, m_pszDataBuf+m_iReserveDataPos, iDataLen);
+	}
 
+	memcpy(m_pszDataBuf+m_iReserveHeadPos, &iDataLen, HEAD_LEN);
+	m_iTailPos = iDataPos+iDataLen;
+	m_iReserveLen = -1;
+	++m_iWriteCount;
+	return BUF_OK;
+}
 
 };
 
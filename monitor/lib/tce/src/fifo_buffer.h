@@ -66,10 +66,35 @@ public:
 	//		MoveNext();
 	//	}
 	//}
+	//MoveNext(false)ֻƶλ, Աbuffer(д˲Ḳ), Releaseһͷ,
+	//ڰѶһ(writev)
 	int32_t GetCurDataLen() const {		return m_iCurDataLen;	}
-	const unsigned char* GetCurData() const {	return (m_pszDataBuf+m_iHeadPos);	}
+	const unsigned char* GetCurData() const {	return (m_pszDataBuf+m_iReadPos);	}
 	RETURN_TYPE ReadNext();
-	void MoveNext()	{	m_iHeadPos += m_iCurDataLen;	}
+	void MoveNext(const bool bRelease=true)	{
+		m_iReadPos += m_iCurDataLen;
+		if ( bRelease )
+		{
+			Release();
+		}
+	}
+	void Release()	{	m_iHeadPos = m_iReadPos;	}
+	//////////////////////////////////////////////////////////////////////////
+
+	//////////////////////////////////////////////////////////////////////////
+	//㿽дֱӰдbufferУ
+	//{//for example
+	//	unsigned char* pszBuf = Reserve(iMaxLen);
+	//	if(NULL != pszBuf)
+	//	{
+	//		int32_t iLen = Serialize(pszBuf, iMaxLen);
+	//		Commit(iLen);
+	//	}
+	//}
+	//Reserveռ䲻NULL; CommitĳȲܴԤ; ReserveCommit֮䲻д
+	unsigned char* Reserve(const int32_t iMaxLen);
+	RETURN_TYPE Commit(const int32_t iDataLen);
+	void CancelReserve()	{	m_iReserveLen = -1;	}
 	//////////////////////////////////////////////////////////////////////////
 
 	RETURN_TYPE Write(const unsigned char* pszData1, const int32_t iDataSize1, const unsigned char* pszData2, const int32_t iDataSize2);
@@ -89,6 +114,8 @@ public:
 	size_t GetSize() const {	return (size_t)m_iBufferLen;	}
 private:
 	void Reset();	//
+	//ReadNextݴ: Ѷδͷŵ(Ŷӵwritev)ʱֻ, 
+	void ResetRead(const bool bPending, const int32_t iTailPos);
 private:
 	std::string m_sErrMsg;
 
@@ -97,6 +124,11 @@ private:
 
 	volatile int32_t m_iHeadPos;		//ѱݵͷλ
 	volatile int32_t m_iTailPos;   		//ѱݵβλ
+	int32_t m_iReadPos;					//λ, m_iHeadPos֮Ѷδͷŵ
+
+	int32_t m_iReserveHeadPos;			//Ԥͷλ
+	int32_t m_iReserveDataPos;			//Ԥλ
+	int32_t m_iReserveLen;				//Ԥ, -1ʾûԤ
 
 	int32_t m_iCurDataLen;		//ǰݳ
 
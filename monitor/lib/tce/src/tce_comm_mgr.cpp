@@ -255,6 +255,74 @@ bool CCommMgr::SetSvrSockManageType(const int32_t iCommID, const SOCKET_MANAGE_T
 }
 
 
+bool CCommMgr::SetSvrReactorNum(const int32_t iCommID, const size_t nReactorNum)
+{
+	bool bOk = false;
+
+	if ( iCommID <= 0 || MAX_COMM_SIZE <= iCommID )
+	{
+		tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "SetSvrReactorNum[comm=%d] commID overflow error.", iCommID);
+		CallBackErrFunc(1, m_szErrMsg);
+		return false;
+	}
+	SCommConfig* pstComm = m_arComms[iCommID];
+	if ( NULL != pstComm)
+	{
+		if ( !pstComm->bRun )
+		{
+			pstComm->nReactorNum = nReactorNum;
+			bOk = true;
+		}
+		else
+		{
+			tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "SetSvrReactorNum[comm=%d] running so that can't modify it.", iCommID);
+			CallBackErrFunc(1, m_szErrMsg);
+		}
+	}
+	else
+	{
+		tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "SetSvrReactorNum[comm=%d]can't find comm in no run list.", iCommID);
+		CallBackErrFunc(1, m_szErrMsg);
+	}
+
+	return bOk;
+}
+
+bool CCommMgr::SetSvrWorkerNum(const int32_t iCommID, const size_t nWorkerNum, const size_t nWorkerBufferSize)
+{
+	bool bOk = false;
+
+	if ( iCommID <= 0 || MAX_COMM_SIZE <= iCommID )
+	{
+		tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "SetSvrWorkerNum[comm=%d] commID overflow error.", iCommID);
+		CallBackErrFunc(1, m_szErrMsg);
+		return false;
+	}
+	SCommConfig* pstComm = m_arComms[iCommID];
+	if ( NULL != pstComm)
+	{
+		if ( !pstComm->bRun )
+		{
+			pstComm->nWorkerNum = nWorkerNum;
+			pstComm->nWorkerBufferSize = nWorkerBufferSize;
+			bOk = true;
+		}
+		else
+		{
+			tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "SetSvrWorkerNum[comm=%d] running so that can't modify it.", iCommID);
+			CallBackErrFunc(1, m_szErrMsg);
+		}
+	}
+	else
+	{
+		tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "SetSvrWorkerNum[comm=%d]can't find comm in no run list.", iCommID);
+		CallBackErrFunc(1, m_szErrMsg);
+	}
+
+	return bOk;
+}
+
+
 bool CCommMgr::SetSvrCallbackFunc(const int32_t iCommID, ONREADFUNC pOnReadFunc, ONCLOSEFUNC pOnCloseFunc, ONCONNECTFUNC pOnConnectFunc, ONERRORFUNC pOnErrorFunc)
 {
 	bool bOk = false;
@@ -443,7 +511,9 @@ bool CCommMgr::RunSvr(const int32_t iCommID)
 
 					if ( NULL != poSvr )
 					{
-						if ( poSvr->Init(iCommID, 
+						if ( poSvr->SetReactorNum(pstComm->nReactorNum)
+							&& poSvr->SetWorkerNum(pstComm->nWorkerNum, pstComm->nWorkerBufferSize)
+							&& poSvr->Init(iCommID, 
 											ntohl(inet_addr(pstComm->sIp.c_str())), 
 											pstComm->wPort, 
 											pstComm->nInBufferSize, 
@@ -595,7 +665,7 @@ bool CCommMgr::Write(SSession& stSession,const char* pszData1, const size_t nSiz
 	SCommConfig* pstComm = m_arComms[stSession.GetCommID()];
 	if ( NULL != pstComm && pstComm->bRun )
 	{
-		CFIFOBuffer* poOutBuffer = pstComm->poOutBuffer;
+		CFIFOBuffer* poOutBuffer = pstComm->poSvr->SelectOutBuffer(stSession);
 		if( poOutBuffer->GetSize() >= nSize1 + nSize2 + sizeof(stSession) )
 		{
 			CFIFOBuffer::RETURN_TYPE nRe = poOutBuffer->Write((char*)&stSession, sizeof(stSession), pszData1, nSize1, pszData2, nSize2);
@@ -619,6 +689,8 @@ bool CCommMgr::Write(SSession& stSession,const char* pszData1, const size_t nSiz
 			bOk = false;
 		}
 
+		if ( bOk )
+			pstComm->poSvr->NotifyOutBuffer(stSession);
 	}
 	else
 	{
@@ -643,7 +715,7 @@ bool CCommMgr::Write(SSession& stSession,const char* pszData, const size_t nSize
 	SCommConfig* pstComm = m_arComms[stSession.GetCommID()];
 	if ( NULL != pstComm && pstComm->bRun )
 	{
-		CFIFOBuffer* poOutBuffer = pstComm->poOutBuffer;
+		CFIFOBuffer* poOutBuffer = pstComm->poSvr->SelectOutBuffer(stSession);
 		if( poOutBuffer->GetSize()  >= nSize + sizeof(stSession) )
 		{
 			CFIFOBuffer::RETURN_TYPE nRe = poOutBuffer->Write((char*)&stSession, sizeof(stSession), pszData, nSize);
@@ -666,6 +738,8 @@ bool CCommMgr::Write(SSession& stSession,const char* pszData, const size_t nSize
 			CallBackErrFunc(1, m_szErrMsg);
 			bOk = false;
 		}
+		if ( bOk )
+			pstComm->poSvr->NotifyOutBuffer(stSession);
 	}
 	else
 	{
@@ -678,6 +752,135 @@ bool CCommMgr::Write(SSession& stSession,const char* pszData, const size_t nSize
 }
 
 
+bool CCommMgr::WriteByWorker(const size_t nWorker, SSession& stSession, const char* pszData, const size_t nSize)
+{
+	if ( stSession.GetCommID() <= 0 || MAX_COMM_SIZE <= stSession.GetCommID() )
+	{
+		return false;
+	}
+	SCommConfig* pstComm = m_arComms[stSession.GetCommID()];
+	if ( NULL == pstComm || !pstComm->bRun )
+	{
+		return false;
+	}
+
+	CFIFOBuffer* poOutBuffer = pstComm->poSvr->SelectWorkerBuffer(stSession, nWorker);
+	if ( NULL == poOutBuffer || poOutBuffer->GetSize() < nSize + sizeof(stSession) )
+	{
+		return false;
+	}
+
+	CFIFOBuffer::RETURN_TYPE nRe = poOutBuffer->Write((char*)&stSession, sizeof(stSession), pszData, nSize);
+	if ( CFIFOBuffer::BUF_FULL == nRe )
+	{
+		tce::xsleep(1);
+		nRe = poOutBuffer->Write((char*)&stSession, sizeof(stSession), pszData, nSize);
+	}
+	if ( CFIFOBuffer::BUF_OK != nRe )
+	{
+		return false;
+	}
+
+	pstComm->poSvr->NotifyOutBuffer(stSession);
+	return true;
+}
+
+char* CCommMgr::ReserveBuffer(CFIFOBuffer* poOutBuffer, SSession& stSession, const size_t nMaxSize)
+{
+	if ( NULL == poOutBuffer || poOutBuffer->GetSize() < nMaxSize + sizeof(stSession) )
+	{
+		return NULL;
+	}
+
+	unsigned char* pszBuf = poOutBuffer->Reserve(sizeof(stSession)+nMaxSize);
+	if ( NULL == pszBuf )
+	{
+		tce::xsleep(1);
+		pszBuf = poOutBuffer->Reserve(sizeof(stSession)+nMaxSize);
+	}
+	if ( NULL == pszBuf )
+	{
+		return NULL;
+	}
+
+	//sessionǰ, Writeĸʽһ
+	memcpy(pszBuf, &stSession, sizeof(stSession));
+	return reinterpret_cast<char*>(pszBuf+sizeof(stSession));
+}
+
+bool CCommMgr::CommitBuffer(SCommConfig* pstComm, CFIFOBuffer* poOutBuffer, SSession& stSession, const size_t nSize)
+{
+	if ( 0 == nSize )
+	{
+		poOutBuffer->CancelReserve();
+		return true;
+	}
+
+	CFIFOBuffer::RETURN_TYPE nRe = poOutBuffer->Commit(sizeof(stSession)+nSize);
+	if ( CFIFOBuffer::BUF_OK != nRe )
+	{
+		tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"CommitWrite[comm=%d,session=%llu]buffer commit error(%d):%s",stSession.GetCommID(), stSession.GetID(), nRe, poOutBuffer->GetErrMsg());
+		CallBackErrFunc(1, m_szErrMsg);
+		return false;
+	}
+
+	pstComm->poSvr->NotifyOutBuffer(stSession);
+	return true;
+}
+
+char* CCommMgr::ReserveWrite(SSession& stSession, const size_t nMaxSize)
+{
+	SCommConfig* pstComm = this->GetRunComm(stSession);
+	if ( NULL == pstComm )
+	{
+		tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"ReserveWrite[comm=%d,session=%llu]buffer write error: can't find buffer",stSession.GetCommID(), stSession.GetID());
+		CallBackErrFunc(1, m_szErrMsg);
+		return NULL;
+	}
+
+	CFIFOBuffer* poOutBuffer = pstComm->poSvr->SelectOutBuffer(stSession);
+	char* pszBuf = this->ReserveBuffer(poOutBuffer, stSession, nMaxSize);
+	if ( NULL == pszBuf )
+	{
+		tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"ReserveWrite[comm=%d,session=%llu]buffer<datasize=%d,buffersize=%d> reserve error: buffer full or data too large",stSession.GetCommID(), stSession.GetID(), nMaxSize, poOutBuffer->GetSize());
+		CallBackErrFunc(1, m_szErrMsg);
+	}
+	return pszBuf;
+}
+
+bool CCommMgr::CommitWrite(SSession& stSession, const size_t nSize)
+{
+	SCommConfig* pstComm = this->GetRunComm(stSession);
+	if ( NULL == pstComm )
+	{
+		tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"CommitWrite[comm=%d,session=%llu]buffer write error: can't find buffer",stSession.GetCommID(), stSession.GetID());
+		CallBackErrFunc(1, m_szErrMsg);
+		return false;
+	}
+	return this->CommitBuffer(pstComm, pstComm->poSvr->SelectOutBuffer(stSession), stSession, nSize);
+}
+
+char* CCommMgr::ReserveWriteByWorker(const size_t nWorker, SSession& stSession, const size_t nMaxSize)
+{
+	SCommConfig* pstComm = this->GetRunComm(stSession);
+	if ( NULL == pstComm )
+	{
+		return NULL;
+	}
+	return this->ReserveBuffer(pstComm->poSvr->SelectWorkerBuffer(stSession, nWorker), stSession, nMaxSize);
+}
+
+bool CCommMgr::CommitWriteByWorker(const size_t nWorker, SSession& stSession, const size_t nSize)
+{
+	SCommConfig* pstComm = this->GetRunComm(stSession);
+	CFIFOBuffer* poOutBuffer = NULL;
+	if ( NULL == pstComm || NULL == (poOutBuffer = pstComm->poSvr->SelectWorkerBuffer(stSession, nWorker)) )
+	{
+		return false;
+	}
+	return this->CommitBuffer(pstComm, poOutBuffer, stSession, nSize);
+}
+
 bool CCommMgr::WriteTo(const int32_t iCommID, const std::string& sIp, const uint16_t wPort, const unsigned char* pszData, const size_t nSize)
 {
 	SSession stSession;
@@ -707,7 +910,7 @@ bool CCommMgr::Close(SSession& stSession, const time_t nCloseWaitTime)
 	SCommConfig* pstComm = m_arComms[stSession.GetCommID()];
 	if ( NULL != pstComm && pstComm->bRun )
 	{
-		CFIFOBuffer* poOutBuffer = pstComm->poOutBuffer;
+		CFIFOBuffer* poOutBuffer = pstComm->poSvr->SelectOutBuffer(stSession);
 		CFIFOBuffer::RETURN_TYPE nRe = poOutBuffer->Write((char*)&stSession, sizeof(stSession));
 		while ( CFIFOBuffer::BUF_FULL == nRe )
 		{
@@ -721,6 +924,8 @@ bool CCommMgr::Close(SSession& stSession, const time_t nCloseWaitTime)
 			}
 			break;
 		}
+		if ( bOk )
+			pstComm->poSvr->NotifyOutBuffer(stSession);
 	}
 	else
 	{
@@ -761,7 +966,7 @@ bool CCommMgr::Connect(const int32_t iCommID, const uint32_t dwIp, const uint16_
 	SCommConfig* pstComm = m_arComms[stSession.GetCommID()];
 	if ( NULL != pstComm && pstComm->bRun )
 	{
-		CFIFOBuffer* poOutBuffer = pstComm->poOutBuffer;
+		CFIFOBuffer* poOutBuffer = pstComm->poSvr->SelectOutBuffer(stSession);
 		CFIFOBuffer::RETURN_TYPE nRe = poOutBuffer->Write((char*)&stSession, sizeof(stSession));
 		while ( CFIFOBuffer::BUF_FULL == nRe )
 		{
@@ -775,6 +980,8 @@ bool CCommMgr::Connect(const int32_t iCommID, const uint32_t dwIp, const uint16_
 			}	
 			break;	
 		}
+		if ( bOk )
+			pstComm->poSvr->NotifyOutBuffer(stSession);
 	}
 	else
 	{
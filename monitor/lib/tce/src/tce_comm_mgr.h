@@ -102,6 +102,9 @@ private:
 			,nCommType(CT_ERROR)
 			,nTcpDgramType(TDT_H2SHORTT3)
 			,nSockManageType(SMT_ARRAY)
+			,nReactorNum(0)
+			,nWorkerNum(0)
+			,nWorkerBufferSize(1024*1024)
 			,poInBuffer(NULL)
 			,poOutBuffer(NULL)
 			,poSvr(NULL)
@@ -127,6 +130,9 @@ private:
 		COMM_TYPE nCommType;
 		TCP_DGRAM_TYPE nTcpDgramType;
 		SOCKET_MANAGE_TYPE nSockManageType;
+		size_t nReactorNum;
+		size_t nWorkerNum;
+		size_t nWorkerBufferSize;
 		
 		CFIFOBuffer* poInBuffer;
 		CFIFOBuffer* poOutBuffer;
@@ -178,6 +184,12 @@ public:
 
 	bool SetSvrSockManageType(const int32_t iCommID, const SOCKET_MANAGE_TYPE nSockManageType=SMT_ARRAY);
 
+	//TCPIO߳, 0ΪԭеĵIO߳; >0ʱÿ̶߳epoll, acceptepoll
+	bool SetSvrReactorNum(const int32_t iCommID, const size_t nReactorNum=0);
+
+	//ذҵ߳, >0ʱÿҵ߳ڸIO߳жռķͶ, WriteByWorkerдʱ
+	bool SetSvrWorkerNum(const int32_t iCommID, const size_t nWorkerNum=0, const size_t nWorkerBufferSize=1024*1024);
+
 	bool SetSvrCallbackFunc(const int32_t iCommID, ONREADFUNC pOnReadFunc, ONCLOSEFUNC pOnCloseFunc=NULL, ONCONNECTFUNC pOnConnectFunc=NULL, ONERRORFUNC pOnErrorFunc=NULL);
 
 	bool SetTimerCallbackFunc(ONTIMERFUNC pOnTimerFunc);
@@ -232,6 +244,19 @@ public:
 	inline bool Write(SSession& stSession,const unsigned char* pszData, const size_t nSize)	{		return this->Write(stSession, (const char*)pszData, nSize);	}
 	inline bool Write(SSession& stSession, const std::string& sData){		return this->Write(stSession, sData.data(), sData.size());	}
 
+	//ҵ߳nWorkerдԼķͶ, ͬһnWorkerֻһ߳д
+	//falseʱδд(δҵ߳,Խ), ߿ɸüWrite
+	bool WriteByWorker(const size_t nWorker, SSession& stSession, const char* pszData, const size_t nSize);
+
+	//㿽д: ڷͶԤnMaxSizeֽ, ֱӰѻذлصĵַ, CommitWriteύʵʳ;
+	//ԤʧܷNULL. ReserveWriteCommitWrite֮ͬһͶвд(Writeһ߼)
+	//nSizeܴnMaxSize, nSizeΪ0ʱԤ
+	char* ReserveWrite(SSession& stSession, const size_t nMaxSize);
+	bool CommitWrite(SSession& stSession, const size_t nSize);
+	//ҵ̰߳汾, дnWorkerԼķͶ, ҪͬWriteByWorker; NULLʱ߿ɸüReserveWrite
+	char* ReserveWriteByWorker(const size_t nWorker, SSession& stSession, const size_t nMaxSize);
+	bool CommitWriteByWorker(const size_t nWorker, SSession& stSession, const size_t nSize);
+
 
 	bool WriteTo(const int32_t iCommID, const std::string& sIp, const uint16_t wPort, const unsigned char* pszData, const size_t nSize);
 	inline bool WriteTo(const int32_t iCommID, const std::string& sIp, const uint16_t wPort, const char* pszData, const size_t nSize){
@@ -262,6 +287,18 @@ private:
 
 	int32_t OnRead(SCommConfig& stCommConfig, SSession& stSession, const unsigned char* pszData, const size_t nSize);
 
+	inline SCommConfig* GetRunComm(SSession& stSession){
+		if ( stSession.GetCommID() <= 0 || MAX_COMM_SIZE <= stSession.GetCommID() )
+		{
+			return NULL;
+		}
+		SCommConfig* pstComm = m_arComms[stSession.GetCommID()];
+		return ( NULL != pstComm && pstComm->bRun ) ? pstComm : NULL;
+	}
+
+	char* ReserveBuffer(CFIFOBuffer* poOutBuffer, SSession& stSession, const size_t nMaxSize);
+	bool CommitBuffer(SCommConfig* pstComm, CFIFOBuffer* poOutBuffer, SSession& stSession, const size_t nSize);
+
 	inline void CallBackErrFunc(const int32_t iErrCode, const char* pszErrMsg){
 		if ( NULL != m_pOnErrorFunc )
 		{
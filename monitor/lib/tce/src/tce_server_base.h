@@ -142,6 +142,17 @@ public:
 	CFIFOBuffer* GetInBuffer() {	return m_poInBuffer;	}
 	CFIFOBuffer* GetOutBuffer() {	return m_poOutBuffer;	}
 
+	//IO߳(reactor), Init֮ǰ, 0ΪԭеĵIO̷߳ʽ
+	virtual bool SetReactorNum(const size_t nReactorNum){	return 0 == nReactorNum;	}
+	//IO߳ʱÿ߳жķͶ, session߳ѡ
+	virtual CFIFOBuffer* SelectOutBuffer(const SSession& stSession) {	return m_poOutBuffer;	}
+	//д뷢ͶкѶӦIO߳
+	virtual void NotifyOutBuffer(const SSession& stSession) {}
+	//ҵ̸߳ԶռķͶ(ߵ, д벻), Init֮ǰ
+	virtual bool SetWorkerNum(const size_t nWorkerNum, const size_t nWorkerBufferSize){	return 0 == nWorkerNum;	}
+	//߳nWorkersessionIO߳ϵķͶ, ûʱNULL
+	virtual CFIFOBuffer* SelectWorkerBuffer(const SSession& stSession, const size_t nWorker) {	return NULL;	}
+
 	int32_t GetId() const {	return m_iCommID; }
 	uint32_t GetIp() const {	return m_dwSvrIp;	}
 	const char* GetIpStr() const {	return InetNtoA(m_dwSvrIp).c_str();	}
@@ -43,6 +43,9 @@ enum KEY_TYPE{
 	KT_STRING_1024 = 1024,
 };
 
+//ӿÿkey
+static const size_t SHM_BATCH_SIZE = 16;
+
 
 template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
 class CHashMap;
@@ -503,6 +506,16 @@ public:
 	inline iterator begin() ;
 	size_t erase(const key_type& __key);
 	size_t erase(iterator __it);
+
+	//ӿ: ÿkeyֻתͼhashһ, ԤȡڵٱȽ, ökeycache miss;
+	//ⲿʱֻһ
+	//its[i]Ϊkeys[i]Ĳҽ, ҵĸ
+	inline size_t find_many(const key_type* keys, const size_t n, iterator* its);
+	//pbOkΪNULLʱÿǷɹ, سɹĸ
+	inline size_t insert_many(const value_type* objs, const size_t n, bool* pbOk=NULL);
+	//ɾĸ
+	inline size_t erase_many(const key_type* keys, const size_t n);
+
 	void clear();
 	inline size_t max_size() const {	return m_pstIndex->dwStepCount*m_pstIndex->dwStepSize;	}
 	inline size_t size() const {	return m_pstIndex->dwUsingSize;	}
@@ -518,6 +531,11 @@ public:
 
 private:
 	uint32_t _getHeadCRC();	
+	inline node_type* _find(const key_type& __key, const uint64_t ui64Hash) const;
+	//arNode[j]arKey[j]ڽڵ, ûΪNULL, mSHM_BATCH_SIZE
+	//arEmptyΪNULLʱ, ûҵkeyصһսڵ(insertõĽڵ), ûΪNULL
+	inline void _find_batch(const _Key* arKey, const uint64_t* arHash, const size_t m, node_type** arNode, node_type** arEmpty=NULL) const;
+	inline std::pair<iterator,bool> _insert(const value_type& __obj, const uint64_t ui64Hash);
 	bool IsPrime(const uint64_t dwValue)
 	{
 		uint64_t dwTmp = (uint64_t)sqrt(dwValue);
@@ -719,20 +737,61 @@ bool CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::init(const int32
 }
 
 template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
-typename CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::iterator CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::find(const key_type& __key)
+typename CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::node_type* CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::_find(const key_type& __key, const uint64_t ui64Hash) const
 {
-	node_type* _value = NULL;
+	const _Key key = __key;	//string͵keyֻתһ
 	for ( uint64_t i=0; i<m_pstIndex->dwStepCount; ++i )
 	{
-		uint64_t ui64StepPos = m_hashFun(__key) % m_pstIndex->arStepMod[i];	
+		uint64_t ui64StepPos = ui64Hash % m_pstIndex->arStepMod[i];	
 		node_type* tmp  = (node_type*)(m_pNodes+i*m_pstIndex->dwStepSize+ui64StepPos);
-		if ( tmp->ucFlag == 1 && m_equalFun(__key, tmp->first) )
+		if ( tmp->ucFlag == 1 && m_equalFun(key, tmp->first) )
+			return tmp;
+	}
+	return NULL;
+}
+
+template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
+void CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::_find_batch(const _Key* arKey, const uint64_t* arHash, const size_t m, node_type** arNode, node_type** arEmpty) const
+{
+	//״: ԤȡδҵkeyĽڵȽ
+	size_t arPending[SHM_BATCH_SIZE];
+	node_type* arProbe[SHM_BATCH_SIZE];
+	size_t nPending = m;
+	for ( size_t j=0; j<m; ++j )
+	{
+		arPending[j] = j;
+		arNode[j] = NULL;
+		if ( NULL != arEmpty )
+			arEmpty[j] = NULL;
+	}
+	for ( uint64_t i=0; i<m_pstIndex->dwStepCount && nPending>0; ++i )
+	{
+		for ( size_t k=0; k<nPending; ++k )
 		{
-			_value = tmp;
-			break;
+			arProbe[k] = (node_type*)(m_pNodes+i*m_pstIndex->dwStepSize+arHash[arPending[k]] % m_pstIndex->arStepMod[i]);
+			__builtin_prefetch(arProbe[k]);
 		}
+		size_t nLeft = 0;
+		for ( size_t k=0; k<nPending; ++k )
+		{
+			size_t j = arPending[k];
+			if ( arProbe[k]->ucFlag == 1 && m_equalFun(arKey[j], arProbe[k]->first) )
+			{
+				arNode[j] = arProbe[k];
+				continue;
+			}
+			if ( NULL != arEmpty && NULL == arEmpty[j] && arProbe[k]->ucFlag == 0 )
+				arEmpty[j] = arProbe[k];
+			arPending[nLeft++] = j;
+		}
+		nPending = nLeft;
 	}
-	return iterator(_value,m_pEndNode);
+}
+
+template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
+typename CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::iterator CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::find(const key_type& __key)
+{
+	return iterator(_find(__key, m_hashFun(__key)),m_pEndNode);
 }
 
 template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
@@ -866,15 +925,21 @@ template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, cl
 
 template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
 std::pair<typename CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::iterator,bool> CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::insert(const value_type& __obj)
+{
+	return _insert(__obj, m_hashFun(__obj.first));
+}
+
+template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
+std::pair<typename CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::iterator,bool> CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::_insert(const value_type& __obj, const uint64_t ui64Hash)
 {
 	std::pair<iterator, bool> pairResult;
 	pairResult.second = false;
-	iterator itFind = find(__obj.first);
-	if ( itFind != end() )
+	node_type* pFind = _find(__obj.first, ui64Hash);
+	if ( NULL != pFind )
 	{
 		pairResult.second = true;
-		itFind->second = __obj.second;
-		pairResult.first = itFind;
+		pFind->second = __obj.second;
+		pairResult.first = iterator(pFind,m_pEndNode);
 	}
 	else
 	{
@@ -882,7 +947,7 @@ std::pair<typename CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::it
 		node_type* pNewNode = NULL;
 		for ( uint64_t i=0; i<m_pstIndex->dwStepCount; ++i )
 		{
-			uint64_t ui64StepPos = m_hashFun(__obj.first) % m_pstIndex->arStepMod[i];	
+			uint64_t ui64StepPos = ui64Hash % m_pstIndex->arStepMod[i];	
 			pNewNode  = (node_type*)(m_pNodes+i*m_pstIndex->dwStepSize+ui64StepPos);
 			if ( pNewNode->ucFlag == 0 )
 			{
@@ -901,6 +966,100 @@ std::pair<typename CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::it
 	return pairResult;
 }
 
+template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
+size_t CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::find_many(const key_type* keys, const size_t n, iterator* its)
+{
+	size_t nFound = 0;
+	_Key arKey[SHM_BATCH_SIZE];
+	uint64_t arHash[SHM_BATCH_SIZE];
+	node_type* arNode[SHM_BATCH_SIZE];
+	for ( size_t b=0; b<n; b+=SHM_BATCH_SIZE )
+	{
+		size_t m = n-b < SHM_BATCH_SIZE ? n-b : SHM_BATCH_SIZE;
+		for ( size_t j=0; j<m; ++j )
+		{
+			arKey[j] = keys[b+j];
+			arHash[j] = m_hashFun(arKey[j]);
+		}
+		_find_batch(arKey, arHash, m, arNode);
+		for ( size_t j=0; j<m; ++j )
+		{
+			its[b+j] = iterator(arNode[j],m_pEndNode);
+			if ( NULL != arNode[j] )
+				++nFound;
+		}
+	}
+	return nFound;
+}
+
+template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
+size_t CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::insert_many(const value_type* objs, const size_t n, bool* pbOk)
+{
+	size_t nOk = 0;
+	_Key arKey[SHM_BATCH_SIZE];
+	uint64_t arHash[SHM_BATCH_SIZE];
+	node_type* arNode[SHM_BATCH_SIZE];
+	node_type* arEmpty[SHM_BATCH_SIZE];
+	for ( size_t b=0; b<n; b+=SHM_BATCH_SIZE )
+	{
+		size_t m = n-b < SHM_BATCH_SIZE ? n-b : SHM_BATCH_SIZE;
+		for ( size_t j=0; j<m; ++j )
+		{
+			arKey[j] = objs[b+j].first;
+			arHash[j] = m_hashFun(arKey[j]);
+		}
+		_find_batch(arKey, arHash, m, arNode, arEmpty);
+		for ( size_t j=0; j<m; ++j )
+		{
+			//벻ƶͷŽڵ: ѴڵֱӸ; ڵսڵԿֱʹ,
+			//ѱǰkeyռ(ظkey), ²Ҳ
+			bool bOk = true;
+			if ( NULL != arNode[j] )
+			{
+				arNode[j]->second = objs[b+j].second;
+			}
+			else if ( NULL != arEmpty[j] && arEmpty[j]->ucFlag == 0 )
+			{
+				arEmpty[j]->first = objs[b+j].first;
+				arEmpty[j]->second = objs[b+j].second;
+				arEmpty[j]->ucFlag = 1;
+				m_pstIndex->dwUsingSize++;
+			}
+			else
+			{
+				bOk = _insert(objs[b+j], arHash[j]).second;
+			}
+			if ( NULL != pbOk )
+				pbOk[b+j] = bOk;
+			if ( bOk )
+				++nOk;
+		}
+	}
+	return nOk;
+}
+
+template <class _Key, class _Tp, class _KeyType, class _Head, class _HashFcn, class _EqualKey>
+size_t CHashMap<_Key, _Tp, _KeyType, _Head, _HashFcn, _EqualKey>::erase_many(const key_type* keys, const size_t n)
+{
+	size_t nCount = 0;
+	_Key arKey[SHM_BATCH_SIZE];
+	uint64_t arHash[SHM_BATCH_SIZE];
+	node_type* arNode[SHM_BATCH_SIZE];
+	for ( size_t b=0; b<n; b+=SHM_BATCH_SIZE )
+	{
+		size_t m = n-b < SHM_BATCH_SIZE ? n-b : SHM_BATCH_SIZE;
+		for ( size_t j=0; j<m; ++j )
+		{
+			arKey[j] = keys[b+j];
+			arHash[j] = m_hashFun(arKey[j]);
+		}
+		_find_batch(arKey, arHash, m, arNode);
+		for ( size_t j=0; j<m; ++j )
+			nCount += erase(iterator(arNode[j],m_pEndNode));
+	}
+	return nCount;
+}
+
 
 
 };
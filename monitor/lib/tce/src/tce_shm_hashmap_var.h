@@ -599,7 +599,9 @@ public:
 
 private:
 	inline size_type _getHeadCRC();	
-	inline node_type* _new_node(const key_type& key);
+	inline node_type* _new_node(const key_type& key, const size_type nHash);
+	inline node_type* _find(const key_type& __key, const size_type nHash);
+	inline std::pair<iterator,bool> _insert(const key_type& key, const char* data, const size_type size, const size_type nHash);
 	inline bool _delete_node(node_type* pNode);
 
 	inline size_type _new_block(const char* pData, const size_type nSize);
@@ -951,20 +953,23 @@ bool CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::init(const size_type nShmKey
 }
 
 template <class _Key, class _KeyType, class _HashFcn, class _EqualKey>
-typename CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::iterator CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::find(const key_type& __key)
+typename CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::node_type* CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::_find(const key_type& __key, const size_type nHash)
 {
-	node_type* _value = NULL;
+	const _Key key = __key;	//string͵keyֻתһ
 	for ( size_type i=0; i<m_pHead->nStepCount; ++i )
 	{
-		size_type nStepPos = static_cast<size_type>(m_hashFun(__key) % m_pHead->arStepMod[i]);	
+		size_type nStepPos = nHash % m_pHead->arStepMod[i];	
 		node_type* tmp  = (node_type*)(m_pNodes+i*m_pHead->nStepSize+nStepPos);
-		if ( tmp->ucFlag == 1 && m_equalFun(__key, tmp->key) )
-		{
-			_value = tmp;
-			break;
-		}
+		if ( tmp->ucFlag == 1 && m_equalFun(key, tmp->key) )
+			return tmp;
 	}
-	return iterator(_value,m_pEndNode, this);
+	return NULL;
+}
+
+template <class _Key, class _KeyType, class _HashFcn, class _EqualKey>
+typename CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::iterator CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::find(const key_type& __key)
+{
+	return iterator(_find(__key, static_cast<size_type>(m_hashFun(__key))),m_pEndNode, this);
 }
 
 template <class _Key, class _KeyType, class _HashFcn, class _EqualKey>
@@ -1106,12 +1111,12 @@ template <class _Key, class _KeyType, class _HashFcn, class _EqualKey>
 
 
 template <class _Key, class _KeyType, class _HashFcn, class _EqualKey>
-typename CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::node_type* CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::_new_node(const key_type& key)
+typename CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::node_type* CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::_new_node(const key_type& key, const size_type nHash)
 {
 	node_type* pNewNode = NULL;
 	for ( size_type i=0; i<m_pHead->nStepCount; ++i )
 	{
-		size_type nStepPos = static_cast<size_type>(m_hashFun(key) % m_pHead->arStepMod[i]);	
+		size_type nStepPos = nHash % m_pHead->arStepMod[i];	
 		pNewNode  = (node_type*)(m_pNodes+i*m_pHead->nStepSize+nStepPos);
 		if ( pNewNode->ucFlag == 0 )
 		{
@@ -1143,10 +1148,16 @@ bool CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::_delete_node(node_type* pNod
 
 template <class _Key, class _KeyType, class _HashFcn, class _EqualKey>
 std::pair<typename CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::iterator,bool> CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::insert(const key_type& key, const char* data, const size_type size)
+{
+	return _insert(key, data, size, static_cast<size_type>(m_hashFun(key)));
+}
+
+template <class _Key, class _KeyType, class _HashFcn, class _EqualKey>
+std::pair<typename CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::iterator,bool> CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::_insert(const key_type& key, const char* data, const size_type size, const size_type nHash)
 {
 	std::pair<iterator, bool> pairResult;
 	pairResult.second = false;
-	iterator itFind = find(key);
+	iterator itFind(_find(key, nHash),m_pEndNode, this);
 	if ( itFind != end() )
 	{
 		pairResult.second = true;
@@ -1156,7 +1167,7 @@ std::pair<typename CHashMapVar<_Key,_KeyType,_HashFcn,_EqualKey>::iterator,bool>
 	else
 	{
 		//new node
-		node_type* pNewNode = _new_node(key);
+		node_type* pNewNode = _new_node(key, nHash);
 		if ( NULL != pNewNode  )
 		{
 			//new block and copy data
@@ -27,9 +27,13 @@
 #include "tce_server_base.h"
 #include "tce_session_manage.h"
 #include "tce_errcode.h"
+#include "tce_lock.h"
 #include <time.h>
 #include <linux/sockios.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
 #include <list>
+#include <vector>
 
 namespace tce{
 
@@ -66,6 +70,34 @@ class CTcpServer
 #endif
 	};
 
+	//socketڶreactorepollע, ʱֻһ
+	enum FD_EVENT_EXT{
+#if defined(EPOLLEXCLUSIVE) && !defined(WIN32)
+		FD_EXCLUSIVE_EVENT=EPOLLEXCLUSIVE,
+#else
+		FD_EXCLUSIVE_EVENT=0,
+#endif
+	};
+
+	enum{
+		MAX_REACTOR_NUM=64,
+		MAX_REACTOR_FD=500000,		//sessionMAX_SOCKETһ
+		REACTOR_WAIT_TIMEOUT=100,	//reactorʱepoll_waitĳʱ(ms)
+		MAX_WORKER_NUM=256,
+		SEND_IOV_NUM=64,			//writevһ෢͵İ
+		SEND_PKG_EXTRA=16,			//ʱϵİͷβĳ
+	};
+
+	//ͬһĻذܳһ, writevһη
+	struct SSendBatch{
+		SSendBatch():poSocket(NULL),pstSession(NULL),iIovCnt(0),nTmpUsed(0){}
+		CSocketSession* poSocket;
+		const SSession* pstSession;		//һsession, ָFIFOδͷŵ
+		int32_t iIovCnt;
+		size_t nTmpUsed;				//m_pSendTmpBufferĳ
+		struct iovec arIov[SEND_IOV_NUM];
+	};
+
 
 	template<int32_t v> 
 	struct Int2Type {
@@ -77,15 +109,27 @@ public:
 		:m_oListenThread(&ListenWorkThread)
 		,m_oReadWriteThread(&ReadWriteWorkThread)
 		,m_oThreadByAll(&WorkAllThread)
+		,m_oReactorThread(&ReactorWorkThread)
 		,m_bThreadRun(false)
 		,m_iListenFd(-1)
 		,m_iMaxFd(0)
 		,m_nSessionID(1)
+		,m_nSessionStep(1)
 		,m_pFDTmpBuffer(NULL)
 		,m_nFDTmpBufferSize(0)
 		,m_pSendTmpBuffer(NULL)
 		,m_nSendTmpBufferSize(0)
 		,m_bSleep(true)
+		,m_poParent(NULL)
+		,m_nReactorNum(0)
+		,m_nReactorIndex(0)
+		,m_nConnectIndex(0)
+		,m_pFdOwner(NULL)
+		,m_poInLock(NULL)
+		,m_iWakeFd(-1)
+		,m_iWaiting(0)
+		,m_nWorkerNum(0)
+		,m_nWorkerBufferSize(0)
 	{
 		m_dwCurTime = time(NULL);
 		m_nLastCheckClosingTime = m_dwCurTime;
@@ -102,11 +146,35 @@ public:
 		m_oListenThread.Stop();
 		m_oReadWriteThread.Stop();
 		m_oThreadByAll.Stop();
+		m_oReactorThread.Stop();
+		this->StopReactors();
+		this->DeleteReactors();
+
+		if ( NULL != m_poParent )
+		{
+			//socketbufferڸ
+			m_poInBuffer = NULL;
+			m_iListenFd = -1;
+		}
+		else
+		{
+			delete [] m_pFdOwner;
+			delete m_poInLock;
+		}
+		m_pFdOwner = NULL;
+		m_poInLock = NULL;
+
+		if ( m_iWakeFd != -1 )
+		{
+			tce::socket_close(m_iWakeFd);
+			m_iWakeFd = -1;
+		}
 
 		delete m_poInBuffer;
 		m_poInBuffer = NULL;
 		delete m_poOutBuffer;
 		m_poOutBuffer = NULL;
+		this->DeleteWorkerBuffers();
 		tce::socket_close(m_iListenFd);
 		m_iListenFd = -1;
 		
@@ -157,25 +225,35 @@ public:
 
 #endif
 
-		//ʼserversocket
-		if (!CreateListenSocket())
+		//reactorʹøļsocketbuffer
+		if ( NULL == m_poParent )
 		{
-			return false;
-		}
+			//ʼserversocket
+			if (!CreateListenSocket())
+			{
+				return false;
+			}
 
 
-		//buffer
-		if ( NULL != m_poInBuffer )  
-		{
-			delete m_poInBuffer;
-			m_poInBuffer = NULL;
-		}
+			//buffer
+			if ( NULL != m_poInBuffer )  
+			{
+				delete m_poInBuffer;
+				m_poInBuffer = NULL;
+			}
 
-		m_poInBuffer = new CFIFOBuffer;
-		if ( NULL == m_poInBuffer || !m_poInBuffer->Init(nInBufferSize) )
-		{
-			tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"init in buffer error: no enough memory.");
-			return false;
+			m_poInBuffer = new CFIFOBuffer;
+			if ( NULL == m_poInBuffer || !m_poInBuffer->Init(nInBufferSize) )
+			{
+				tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"init in buffer error: no enough memory.");
+				return false;
+			}
+
+			//reactorʱӺbufferreactor
+			if ( m_nReactorNum > 0 )
+			{
+				return this->InitReactors(nOutBufferSize, nMaxFdInSize, nMaxFdOutSize, nTotalMallocMem, nMallocItemSize, nMaxClient);
+			}
 		}
 
 		if ( NULL != m_poOutBuffer )
@@ -190,6 +268,11 @@ public:
 			return false;
 		}
 
+		if ( !this->InitWorkerBuffers() )
+		{
+			return false;
+		}
+
 		if ( !m_oSocketSessionMgr.Init(nMaxFdInSize,nMaxFdOutSize,nMaxClient,nTotalMallocMem,nMallocItemSize) )
 		{
 			tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"init client socket error: no enough memory.");
@@ -212,12 +295,21 @@ public:
 			return false;
 		}		
 
+		if ( NULL != m_poParent && !this->InitWakeFd() )
+		{
+			return false;
+		}
+
 		return true;
 	}
 
 	bool Start()
 	{
 		m_bThreadRun = true;
+		if ( !m_vecReactor.empty() )
+		{
+			return this->StartReactors();
+		}
 		return this->Start_imp(Int2Type<SessionManage::NEED_LOCK>());
 	}
 
@@ -226,9 +318,56 @@ public:
 		m_oListenThread.Stop();
 		m_oReadWriteThread.Stop();
 		m_oThreadByAll.Stop();
+		this->StopReactors();
+		return true;
+	}
+
+	//reactor: ÿreactor߳жepoll,Ӻbuffer, ͨepollaccept
+	//appдbuffereventfdѶӦreactor, reactorһbuffer
+	bool SetReactorNum(const size_t nReactorNum){
+		if ( nReactorNum > MAX_REACTOR_NUM || m_bThreadRun || !m_vecReactor.empty() )
+		{
+			tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"SetReactorNum<%zu> error: max=%d or server inited.", nReactorNum, (int32_t)MAX_REACTOR_NUM);
+			return false;
+		}
+		m_nReactorNum = nReactorNum;
 		return true;
 	}
 
+	CFIFOBuffer* SelectOutBuffer(const SSession& stSession){
+		if ( m_vecReactor.empty() )
+			return m_poOutBuffer;
+		return this->GetReactor(stSession)->m_poOutBuffer;
+	}
+
+	void NotifyOutBuffer(const SSession& stSession){
+		if ( m_vecReactor.empty() )
+			return ;
+
+		this->GetReactor(stSession)->WakeUp(false);
+		if ( DT_TCP_CONNECT == stSession.GetDataType() )
+			++m_nConnectIndex;
+	}
+
+	//̻߳ذ: ÿIO߳Ϊÿ߳׼һͶ, ̸߳д, ͬһд
+	bool SetWorkerNum(const size_t nWorkerNum, const size_t nWorkerBufferSize){
+		if ( nWorkerNum > MAX_WORKER_NUM || m_bThreadRun || !m_vecReactor.empty() )
+		{
+			tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"SetWorkerNum<%zu> error: max=%d or server inited.", nWorkerNum, (int32_t)MAX_WORKER_NUM);
+			return false;
+		}
+		m_nWorkerNum = nWorkerBufferSize > 0 ? nWorkerNum : 0;
+		m_nWorkerBufferSize = nWorkerBufferSize;
+		return true;
+	}
+
+	CFIFOBuffer* SelectWorkerBuffer(const SSession& stSession, const size_t nWorker){
+		this_type* poSvr = m_vecReactor.empty() ? this : this->GetReactor(stSession);
+		if ( nWorker >= poSvr->m_vecWorkerBuffer.size() )
+			return NULL;
+		return poSvr->m_vecWorkerBuffer[nWorker];
+	}
+
 
 private:
 
@@ -244,8 +383,194 @@ private:
 		return true;
 	}
 
+	bool InitReactors(const size_t nOutBufferSize,
+		const size_t nMaxFdInSize,
+		const size_t nMaxFdOutSize,
+		const size_t nTotalMallocMem,
+		const size_t nMallocItemSize,
+		const size_t nMaxClient)
+	{
+		//reactoraccept, socketҪ
+		tce::socket_setNBlock(m_iListenFd);
+
+		if ( NULL == m_pFdOwner )
+			m_pFdOwner = new uint8_t[MAX_REACTOR_FD];
+		memset(m_pFdOwner, 0, MAX_REACTOR_FD);
+
+		if ( NULL == m_poInLock )
+			m_poInLock = new CMutex;
+
+		this->DeleteReactors();
+		for ( size_t i=0; i<m_nReactorNum; ++i )
+		{
+			this_type* poReactor = new this_type;
+			poReactor->m_poParent = this;
+			poReactor->m_nReactorNum = m_nReactorNum;
+			poReactor->m_nReactorIndex = i;
+			poReactor->m_iListenFd = m_iListenFd;
+			poReactor->m_poInBuffer = m_poInBuffer;
+			poReactor->m_poInLock = m_poInLock;
+			poReactor->m_pFdOwner = m_pFdOwner;
+			//session idreactor, ֤ȫΨһ
+			poReactor->m_nSessionID = i+1;
+			poReactor->m_nSessionStep = m_nReactorNum;
+			poReactor->m_nWorkerNum = m_nWorkerNum;
+			poReactor->m_nWorkerBufferSize = m_nWorkerBufferSize;
+			m_vecReactor.push_back(poReactor);
+
+			//ڴذreactor
+			if ( !poReactor->Init(m_iCommID, m_dwSvrIp, m_wSvrPort, 0, nOutBufferSize,
+				nMaxFdInSize, nMaxFdOutSize, nTotalMallocMem/m_nReactorNum, nMallocItemSize,
+				(nMaxClient+m_nReactorNum-1)/m_nReactorNum, m_nOverTime, m_nDelayStartTime) )
+			{
+				tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"init reactor<%zu> error:%s", i, poReactor->GetErrMsg());
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool InitWorkerBuffers(){
+		this->DeleteWorkerBuffers();
+		for ( size_t i=0; i<m_nWorkerNum; ++i )
+		{
+			CFIFOBuffer* poBuffer = new CFIFOBuffer;
+			if ( NULL == poBuffer || !poBuffer->Init(m_nWorkerBufferSize) )
+			{
+				delete poBuffer;
+				tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"init worker<%zu> buffer error: no enough memory.", i);
+				return false;
+			}
+			m_vecWorkerBuffer.push_back(poBuffer);
+		}
+		return true;
+	}
+
+	void DeleteWorkerBuffers(){
+		for ( size_t i=0; i<m_vecWorkerBuffer.size(); ++i )
+		{
+			delete m_vecWorkerBuffer[i];
+		}
+		m_vecWorkerBuffer.clear();
+	}
+
+	bool InitWakeFd(){
+		if ( m_iWakeFd != -1 )
+			tce::socket_close(m_iWakeFd);
+
+		m_iWakeFd = eventfd(0, EFD_NONBLOCK);
+		if ( m_iWakeFd < 0 )
+		{
+			tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"[error] eventfd error:%s, %s,%d", strerror(errno), __FILE__, __LINE__);
+			return false;
+		}
+
+		SetFdEvent(m_iWakeFd, FD_CTL_ADD, FD_READ_EVENT | FD_ERROR_EVENT);
+		return true;
+	}
+
+	bool StartReactors(){
+		for ( size_t i=0; i<m_vecReactor.size(); ++i )
+		{
+			m_vecReactor[i]->m_bThreadRun = true;
+			if ( !m_vecReactor[i]->m_oReactorThread.Start(m_vecReactor[i]) )
+			{
+				tce::xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"start reactor<%zu> thread error.", i);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void StopReactors(){
+		for ( size_t i=0; i<m_vecReactor.size(); ++i )
+		{
+			m_vecReactor[i]->m_bThreadRun = false;
+			m_vecReactor[i]->WakeUp(true);
+			m_vecReactor[i]->m_oReactorThread.Stop();
+		}
+	}
+
+	void DeleteReactors(){
+		for ( size_t i=0; i<m_vecReactor.size(); ++i )
+		{
+			delete m_vecReactor[i];
+		}
+		m_vecReactor.clear();
+	}
 
+	//ӵָreactor, ఴfdҵreactor
+	inline this_type* GetReactor(const SSession& stSession){
+		size_t nIndex = 0;
+		if ( DT_TCP_CONNECT == stSession.GetDataType() )
+			nIndex = m_nConnectIndex % m_vecReactor.size();
+		else if ( stSession.GetFD() >= 0 && stSession.GetFD() < MAX_REACTOR_FD )
+			nIndex = m_pFdOwner[stSession.GetFD()];
+		return m_vecReactor[nIndex];
+	}
+
+	//reactorepoll_waitʱҪ, ͬһεȴֻдһeventfd
+	inline void WakeUp(const bool bForce){
+		__sync_synchronize();
+		if ( bForce || __sync_bool_compare_and_swap(&m_iWaiting, 1, 0) )
+		{
+			uint64_t nValue = 1;
+			if ( write(m_iWakeFd, &nValue, sizeof(nValue)) < 0 && EAGAIN != errno )
+			{
+				printf("[error] eventfd write fd=%d error:%s.\n", m_iWakeFd, strerror(errno));
+			}
+		}
+	}
+
+	inline void OnWakeUp(){
+		uint64_t nValue = 0;
+		while ( read(m_iWakeFd, &nValue, sizeof(nValue)) > 0 );
+	}
+
+	inline void SetFdOwner(const SOCKET iFd){
+		if ( NULL != m_pFdOwner && iFd >= 0 && iFd < MAX_REACTOR_FD )
+			m_pFdOwner[iFd] = (uint8_t)m_nReactorIndex;
+	}
+
+	inline uint64_t NewSessionID(){
+		m_nSessionID += m_nSessionStep;
+		return m_nSessionID;
+	}
+
+	//reactorbuffer, дʱ; IO߳ʱ
+	inline CFIFOBuffer::RETURN_TYPE WriteInBuffer(const char* pszData1, const int32_t iDataSize1){
+		if ( NULL == m_poInLock )
+			return m_poInBuffer->Write(pszData1, iDataSize1);
+
+		m_poInLock->Lock();
+		CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write(pszData1, iDataSize1);
+		m_poInLock->Unlock();
+		return nRe;
+	}
+	inline CFIFOBuffer::RETURN_TYPE WriteInBuffer(const char* pszData1, const int32_t iDataSize1, const char* pszData2, const int32_t iDataSize2){
+		if ( NULL == m_poInLock )
+			return m_poInBuffer->Write(pszData1, iDataSize1, pszData2, iDataSize2);
+
+		m_poInLock->Lock();
+		CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write(pszData1, iDataSize1, pszData2, iDataSize2);
+		m_poInLock->Unlock();
+		return nRe;
+	}
+
+
+	//buffer͸̵߳ķͶδ
 	bool WriteProcess(){
+		bool bOk = this->WriteBuffer(m_poOutBuffer);
+		for ( size_t i=0; i<m_vecWorkerBuffer.size(); ++i )
+		{
+			if ( !this->WriteBuffer(m_vecWorkerBuffer[i]) )
+				bOk = false;
+		}
+		return bOk;
+	}
+
+	bool WriteBuffer(CFIFOBuffer* poOutBuffer){
 		SSession* pstSession = NULL;
 		int32_t iReadCnt = 0;
 		int32_t iDataCnt = 0;
@@ -253,6 +578,7 @@ private:
 		int32_t iClosintCnt = 0;
 		int32_t iConnectCnt = 0;
 		int64_t iDataSize = 0;
+		SSendBatch stBatch;
 		// int32_t nDataUseTime = 0;
 		// int32_t nCloseUseTime = 0;
 		//time_t nStartTime = GetTickCount();
@@ -266,44 +592,58 @@ private:
 				break;			
 			}
 			
-			CFIFOBuffer::RETURN_TYPE nRe = m_poOutBuffer->ReadNext();
+			CFIFOBuffer::RETURN_TYPE nRe = poOutBuffer->ReadNext();
 			if ( CFIFOBuffer::BUF_OK == nRe )
 			{
 				m_bSleep = false;
 
-				if ( m_poOutBuffer->GetCurDataLen() >= (int32_t)sizeof(SSession) )
+				if ( poOutBuffer->GetCurDataLen() >= (int32_t)sizeof(SSession) )
 				{
-					pstSession = (SSession*)m_poOutBuffer->GetCurData();
+					pstSession = (SSession*)poOutBuffer->GetCurData();
 
 					switch(pstSession->GetDataType())
 					{
 						case DT_TCP_DATA:
 							{
 								++iDataCnt;
-								iDataSize += m_poOutBuffer->GetCurDataLen()-sizeof(SSession);
+								iDataSize += poOutBuffer->GetCurDataLen()-sizeof(SSession);
 								assert(pstSession->GetFD() >= 0);
 								CSocketSession* poSocket = GetSocketSession(pstSession->GetFD());
 								if ( NULL != poSocket && poSocket->GetSessionID() == pstSession->GetID() )
 								{
-									size_t nSendDataSize = m_nSendTmpBufferSize;
-									const char* pszSendData = ParsePkg::MakeSendPkg(m_pSendTmpBuffer, nSendDataSize, reinterpret_cast<const char*>(m_poOutBuffer->GetCurData()+sizeof(SSession)), m_poOutBuffer->GetCurDataLen()-sizeof(SSession));
+									//ӡiovecռ䲻ʱȷǰһ
+									const size_t nDataSize = poOutBuffer->GetCurDataLen()-sizeof(SSession);
+									if ( poSocket != stBatch.poSocket || stBatch.iIovCnt >= SEND_IOV_NUM
+										|| stBatch.nTmpUsed + nDataSize + SEND_PKG_EXTRA > m_nSendTmpBufferSize )
+									{
+										this->FlushBatch(poOutBuffer, stBatch);
+									}
+
+									size_t nSendDataSize = m_nSendTmpBufferSize - stBatch.nTmpUsed;
+									const char* pszSendData = ParsePkg::MakeSendPkg(m_pSendTmpBuffer+stBatch.nTmpUsed, nSendDataSize, reinterpret_cast<const char*>(poOutBuffer->GetCurData()+sizeof(SSession)), nDataSize);
 									if ( NULL != pszSendData )
 									{
 										assert(nSendDataSize > 0);
-										if ( !Write(poSocket, *pstSession, pszSendData, nSendDataSize) )
+										//͸ЭֱָFIFOе, ҪЭռm_pSendTmpBufferеһ
+										if ( pszSendData == m_pSendTmpBuffer+stBatch.nTmpUsed )
 										{
-											this->Close(poSocket);
+											stBatch.nTmpUsed += nSendDataSize;
 										}
+										stBatch.poSocket = poSocket;
+										stBatch.pstSession = pstSession;
+										stBatch.arIov[stBatch.iIovCnt].iov_base = const_cast<char*>(pszSendData);
+										stBatch.arIov[stBatch.iIovCnt].iov_len = nSendDataSize;
+										++stBatch.iIovCnt;
 									}
 									else
 									{
-										xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "WriteProcess: data<%lu> length large than buffer<%lu>, can't make send data.", m_poOutBuffer->GetCurDataLen()-sizeof(SSession), m_nFDTmpBufferSize);
+										xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "WriteProcess: data<%lu> length large than buffer<%lu>, can't make send data.", poOutBuffer->GetCurDataLen()-sizeof(SSession), m_nFDTmpBufferSize);
 										DoError(*pstSession, TEC_PARAM_ERROR, m_szErrMsg);
 									}
 								}
 								else
 								{
-									xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "WriteProcess<comm=%d,id=%ld>: send data error:can't find socket(fd=%d,datasize=%zd).", m_iCommID, pstSession->GetID(), pstSession->GetFD(), m_poOutBuffer->GetCurDataLen()-sizeof(SSession));
+									xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "WriteProcess<comm=%d,id=%ld>: send data error:can't find socket(fd=%d,datasize=%zd).", m_iCommID, pstSession->GetID(), pstSession->GetFD(), poOutBuffer->GetCurDataLen()-sizeof(SSession));
 									DoError(*pstSession, TEC_SOCKET_SEND_ERROR, m_szErrMsg);
 									//printf("tcp_data error:can't find socket(fd=%d)\n", pstSession->GetFD());
 								}
@@ -311,7 +651,7 @@ private:
 							break;
 						case DT_TCP_CLOSE:
 							{
-								
+								this->FlushBatch(poOutBuffer, stBatch);
 								CSocketSession* poSocket = GetSocketSession(pstSession->GetFD());
 								if ( NULL != poSocket && poSocket->GetSessionID() == pstSession->GetID() && CSocketSession::SST_ESTABLISHED == poSocket->GetStatus())
 								{
@@ -332,6 +672,7 @@ private:
 							}
 							break;
 						case DT_TCP_CONNECT:
+							this->FlushBatch(poOutBuffer, stBatch);
 							++iConnectCnt;
 							if ( !Connect(*pstSession) )
 							{
@@ -348,11 +689,12 @@ private:
 				}
 				else
 				{
-					xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "WriteProcess<session_size=%d,data_size=%d> error: data too small.", sizeof(SSession), m_poOutBuffer->GetCurDataLen());
+					xsnprintf(m_szErrMsg, sizeof(m_szErrMsg), "WriteProcess<session_size=%d,data_size=%d> error: data too small.", sizeof(SSession), poOutBuffer->GetCurDataLen());
 					DoError(*pstSession, TEC_SYSTEM_ERROR, m_szErrMsg);
 				}
 
-				m_poOutBuffer->MoveNext();
+				//δİʱҪFIFO, ͷ
+				poOutBuffer->MoveNext(0 == stBatch.iIovCnt);
 			}
 			else if ( CFIFOBuffer::BUF_EMPTY == nRe )
 			{
@@ -360,15 +702,113 @@ private:
 			}
 			else
 			{
-				xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"WriteProcess read buf error:%s",m_poOutBuffer->GetErrMsg());
+				xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"WriteProcess read buf error:%s",poOutBuffer->GetErrMsg());
 				DoError(*pstSession, TEC_SYSTEM_ERROR, m_szErrMsg);
 			}
 		}
+		this->FlushBatch(poOutBuffer, stBatch);
 //		if ( nTmp > 0 )
 //		printf("read buffer size=%d.\n", nTmp);
 
 		return true;
 	}
+
+	//µһͷFIFOжӦ
+	void FlushBatch(CFIFOBuffer* poOutBuffer, SSendBatch& stBatch){
+		if ( stBatch.iIovCnt > 0 )
+		{
+			if ( !this->WriteV(stBatch.poSocket, *stBatch.pstSession, stBatch.arIov, stBatch.iIovCnt) )
+			{
+				this->Close(stBatch.poSocket);
+			}
+			stBatch.poSocket = NULL;
+			stBatch.pstSession = NULL;
+			stBatch.iIovCnt = 0;
+			stBatch.nTmpUsed = 0;
+			poOutBuffer->Release();
+		}
+	}
+
+	//ͬWrite, һηͶ
+	bool WriteV(CSocketSession* poSocket, const SSession& stSession, struct iovec* pIov, const int32_t iIovCnt)
+	{
+		if ( 1 == iIovCnt )
+		{
+			return this->Write(poSocket, stSession, reinterpret_cast<const char*>(pIov[0].iov_base), pIov[0].iov_len);
+		}
+
+		SOCKET iFd = poSocket->GetFD();
+		if ( CSocketSession::SST_ESTABLISHED != poSocket->GetStatus() )
+		{
+			xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"WriteV error: socket(%d) status(%d) is close or closing.", iFd, poSocket->GetStatus());
+			DoError(poSocket, TEC_SOCKET_SEND_ERROR, m_szErrMsg);
+			return true;
+		}
+
+		poSocket->SetLastAccessTime(m_dwCurTime);
+		poSocket->SetParam(stSession.GetParam1(), stSession.GetParam2());
+
+		//ӵķͻﻹʱȷ, ׷ӵ
+		size_t nSendBufDataSize = poSocket->GetOutBuffer().Size();
+		if ( nSendBufDataSize > 0 )
+		{
+			int32_t n = ::send(iFd, GetBufferDataPtr(poSocket->GetOutBuffer()), nSendBufDataSize, 0);
+			if ( n > 0 )
+			{
+				poSocket->GetOutBuffer().Erase(n);
+				nSendBufDataSize -= n;
+			}
+			else if (errno != EAGAIN)
+			{
+				return false;
+			}
+		}
+
+		size_t nSent = 0;
+		if ( 0 == nSendBufDataSize )
+		{
+			ssize_t n = ::writev(iFd, pIov, iIovCnt);
+			if ( n > 0 )
+			{
+				nSent = n;
+			}
+			else if ( errno != EAGAIN )
+			{
+				xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"WriteV: send data error:errno=%d,error=%s", errno, strerror(errno));
+				DoError(poSocket, TEC_SOCKET_SEND_ERROR, m_szErrMsg);
+				return false;
+			}
+		}
+
+		//ûĲַŵӵķͻ, ȿд¼ٷ
+		bool bLeft = false;
+		for ( int32_t i=0; i<iIovCnt; ++i )
+		{
+			size_t nLen = pIov[i].iov_len;
+			if ( nSent >= nLen )
+			{
+				nSent -= nLen;
+				continue;
+			}
+
+			const char* pszData = reinterpret_cast<const char*>(pIov[i].iov_base)+nSent;
+			nLen -= nSent;
+			nSent = 0;
+			if ( !poSocket->GetOutBuffer().Append(pszData, nLen) )
+			{
+				xsnprintf(m_szErrMsg, sizeof(m_szErrMsg),"WriteV<fd=%d,socket_allow_max_size=%lu, curdatasize=%lu,appendsize=%lu>: append error(%d).", iFd, poSocket->GetOutBuffer().MaxSize(), poSocket->GetOutBuffer().Size(), nLen, poSocket->GetOutBuffer().GetErrCode());
+				DoError(poSocket, TEC_SOCKET_BUFFER_FULL, m_szErrMsg);
+				return false;
+			}
+			bLeft = true;
+		}
+
+		if ( bLeft )
+			SetFdEvent(iFd, FD_CTL_MOD, FD_WRITE_EVENT | FD_READ_EVENT | FD_ERROR_EVENT);
+		else
+			SetFdEvent(iFd, FD_CTL_MOD, FD_READ_EVENT | FD_ERROR_EVENT);
+		return true;
+	}
 	
 	bool Write(CSocketSession* poSocket, const SSession& stSession, const char* pszData, const size_t nDataSize)
 	{
@@ -645,13 +1085,13 @@ private:
 						stSession.SetSocketCreateTime(poSocket->GetCreateTime());
 						stSession.SetSocketStartReadTime(poSocket->GetStartReadTime());
 
-						CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession), pstRealPkgData, nRealPkgLen);
+						CFIFOBuffer::RETURN_TYPE nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession), pstRealPkgData, nRealPkgLen);
 						while ( nRe !=  CFIFOBuffer::BUF_OK )
 						{
 							if ( CFIFOBuffer::BUF_FULL == nRe )
 							{
 								tce::xsleep(1);
-								nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession), pstRealPkgData, nRealPkgLen);
+								nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession), pstRealPkgData, nRealPkgLen);
 							}
 							else
 							{
@@ -694,13 +1134,13 @@ private:
 							stSession.SetSocketStartReadTime(poSocket->GetStartReadTime());
 
 							const char* pInBufferData = GetBufferDataPtr(poSocket->GetInBuffer());
-							CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession), pInBufferData, poSocket->GetInBuffer().Size());
+							CFIFOBuffer::RETURN_TYPE nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession), pInBufferData, poSocket->GetInBuffer().Size());
 							while ( nRe !=  CFIFOBuffer::BUF_OK )
 							{
 								if ( CFIFOBuffer::BUF_FULL == nRe )
 								{
 									tce::xsleep(1);
-									nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession), pInBufferData, poSocket->GetInBuffer().Size());
+									nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession), pInBufferData, poSocket->GetInBuffer().Size());
 								}
 								else
 								{
@@ -811,13 +1251,13 @@ private:
 		stSession.SetSocketCreateTime(poSocket->GetCreateTime());
 		stSession.SetSocketStartReadTime(poSocket->GetStartReadTime());
 
-		CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession));
+		CFIFOBuffer::RETURN_TYPE nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession));
 		while ( nRe !=  CFIFOBuffer::BUF_OK )
 		{
 			if ( CFIFOBuffer::BUF_FULL == nRe )
 			{
 				xsleep(1);
-				nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession));
+				nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession));
 			}
 			else
 			{
@@ -850,9 +1290,10 @@ private:
 				if ( NULL != poSocket)
 				{
 					poSocket->SetFD(iFd);
+					this->SetFdOwner(iFd);
 					poSocket->SetReqeustFlag(false);
 					poSocket->SetAddr(stSession.GetPeerAddr());
-					poSocket->SetSessionID(++m_nSessionID);
+					poSocket->SetSessionID(this->NewSessionID());
 					poSocket->SetStatus(CSocketSession::SST_CONNECTTING);
 					poSocket->SetLastAccessTime(m_dwCurTime);
 					poSocket->SetCreateTime(m_dwCurTime);
@@ -886,9 +1327,10 @@ private:
 					if ( NULL != poSocket)
 					{
 						poSocket->SetFD(iFd);
+						this->SetFdOwner(iFd);
 						poSocket->SetReqeustFlag(false);
 						poSocket->SetAddr(stSession.GetPeerAddr());
-						poSocket->SetSessionID(++m_nSessionID);
+						poSocket->SetSessionID(this->NewSessionID());
 						poSocket->SetStatus(CSocketSession::SST_CONNECTTING);
 						poSocket->SetLastAccessTime(m_dwCurTime);
 						poSocket->SetCreateTime(m_dwCurTime);
@@ -940,13 +1382,13 @@ private:
 		poSocket->SetStatus(CSocketSession::SST_ESTABLISHED);
 		poSocket->SetOverTime(m_nOverTime);
 
-		CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession));
+		CFIFOBuffer::RETURN_TYPE nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession));
 		while ( nRe !=  CFIFOBuffer::BUF_OK )
 		{
 			if ( CFIFOBuffer::BUF_FULL == nRe )
 			{
 				xsleep(1);
-				nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession));
+				nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession));
 			}
 			else
 			{
@@ -971,13 +1413,13 @@ private:
 
 		poSocket->SetStatus(CSocketSession::SST_CONNECT_ERR);
 
-		CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession));
+		CFIFOBuffer::RETURN_TYPE nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession));
 		while ( nRe !=  CFIFOBuffer::BUF_OK )
 		{
 			if ( CFIFOBuffer::BUF_FULL == nRe )
 			{
 				xsleep(1);
-				nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession));
+				nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession));
 			}
 			else
 			{
@@ -998,13 +1440,13 @@ private:
 		stSession.SetID(0);
 		stSession.SetBeginTime(tce::GetTickCount());
 
-		CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession));
+		CFIFOBuffer::RETURN_TYPE nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession));
 		while ( nRe !=  CFIFOBuffer::BUF_OK )
 		{
 			if ( CFIFOBuffer::BUF_FULL == nRe )
 			{
 				xsleep(1);
-				nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession));
+				nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession));
 			}
 			else
 			{
@@ -1121,6 +1563,16 @@ private:
 		return 0;
 	}
 
+	static int32_t ReactorWorkThread(void* pParam){
+		this_type* pThis = (this_type*)pParam;
+		if ( NULL != pThis )
+		{
+			pThis->ReactorProcess();
+
+		}
+		return 0;
+	}
+
 	int32_t AllProcess(){
 
 		tce::xsleep(m_nDelayStartTime * 1000);
@@ -1152,6 +1604,50 @@ private:
 
 	}
 
+	//reactor߳: ʱepoll_wait, Ӻbufferݶepoll¼
+	int32_t ReactorProcess(){
+
+		tce::xsleep(m_nDelayStartTime * 1000);
+
+		// add listen socket to epoll
+		SetFdEvent(m_iListenFd, FD_CTL_ADD, FD_READ_EVENT | FD_ERROR_EVENT | FD_EXCLUSIVE_EVENT);
+
+		while ( m_bThreadRun )
+		{
+			m_dwCurTime = time(NULL);
+			m_bSleep = true;
+
+			if (!this->WriteProcess()) 
+			{
+				printf("WriteProcess error:%s", m_szErrMsg);
+			}
+
+			//bufferѿ: ȵǼǵȴټһ, ©Ǽǰд
+			int32_t iTimeout = 0;
+			if ( m_bSleep )
+			{
+				m_iWaiting = 1;
+				__sync_synchronize();
+				this->WriteProcess();
+				if ( m_bSleep )
+					iTimeout = REACTOR_WAIT_TIMEOUT;
+				else
+					m_iWaiting = 0;
+			}
+
+			if (!this->FdWaitByAccept(iTimeout))
+			{
+				printf("EPoll Wait error:%s", m_szErrMsg);
+			}
+			m_iWaiting = 0;
+
+			this->CheckOvertime();
+		}
+
+		SetFdEvent(m_iListenFd, FD_CTL_DEL, FD_READ_EVENT | FD_ERROR_EVENT);
+		return 0;
+	}
+
 	int32_t ListenProcess(){
 
 		tce::xsleep(m_nDelayStartTime * 1000);
@@ -1213,9 +1709,10 @@ private:
 		{
 			//poSocket->Reset();
 			poSocket->SetFD(iFd);
+			this->SetFdOwner(iFd);
 			poSocket->SetReqeustFlag(true);
 			poSocket->SetAddr(addr);
-			poSocket->SetSessionID(++m_nSessionID);
+			poSocket->SetSessionID(this->NewSessionID());
 			poSocket->SetStatus(CSocketSession::SST_ESTABLISHED);
 			poSocket->SetLastAccessTime(m_dwCurTime);
 			poSocket->SetCreateTime(m_dwCurTime);
@@ -1262,7 +1759,7 @@ private:
 	}
 
 
-	bool FdWaitByAccept(){
+	bool FdWaitByAccept(const int32_t iTimeout=EPOLL_WAIT_TIMEOUT){
 
 #ifdef WIN32
 		struct timeval TimeVal;
@@ -1320,7 +1817,7 @@ private:
 		}
 
 #else
-		int32_t nfds=epoll_wait(m_iEpollFd, m_pEpollEvents, EPOLL_EVENT_COUNT, EPOLL_WAIT_TIMEOUT);
+		int32_t nfds=epoll_wait(m_iEpollFd, m_pEpollEvents, EPOLL_EVENT_COUNT, iTimeout);
 		if (nfds>0)
 		{
 			m_bSleep = false;
@@ -1335,6 +1832,10 @@ private:
 //						printf("Accept=%d\n", nfds);
 						this->Accept();
 					}
+					else if ( ev.data.fd == m_iWakeFd )
+					{
+						this->OnWakeUp();
+					}
 					else
 					{
 //						printf("Read=%d\n", nfds);
@@ -1674,6 +2175,7 @@ private:
 	THREAD m_oListenThread;
 	THREAD m_oReadWriteThread;
 	THREAD m_oThreadByAll;
+	THREAD m_oReactorThread;
 	
 	void DoError(CSocketSession* poSocket, const int32_t iErrCode, const char* pszErrMsg){
 		SSession stSession;
@@ -1706,13 +2208,13 @@ private:
 		szData[nCopySize+4] = 0;
 		stSession.SetDataType(DT_ERROR);
 		
-		CFIFOBuffer::RETURN_TYPE nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession), szData, nCopySize+5);
+		CFIFOBuffer::RETURN_TYPE nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession), szData, nCopySize+5);
 		while ( nRe !=  CFIFOBuffer::BUF_OK )
 		{
 			if ( CFIFOBuffer::BUF_FULL == nRe )
 			{
 				xsleep(1);
-				nRe = m_poInBuffer->Write((char*)&stSession, sizeof(SSession), szData, nCopySize+4);
+				nRe = this->WriteInBuffer((char*)&stSession, sizeof(SSession), szData, nCopySize+4);
 			}
 			else
 			{
@@ -1759,6 +2261,7 @@ private:
 	SOCKET m_iMaxFd;
 
 	uint64_t m_nSessionID;
+	uint64_t m_nSessionStep;
 
 #ifdef WIN32
 	fd_set m_Rfds, m_Wfds, m_Efds;
@@ -1776,6 +2279,22 @@ private:
 	bool  m_bSleep;
 
 	std::list<int32_t> m_listClosingFds;
+
+	//reactor
+	std::vector<this_type*> m_vecReactor;	//reactor, ֻڸ
+	this_type* m_poParent;				//reactorĸ
+	size_t m_nReactorNum;
+	size_t m_nReactorIndex;
+	size_t m_nConnectIndex;				//ʱѡreactor
+	uint8_t* m_pFdOwner;				//fdreactor, , reactor
+	CMutex* m_poInLock;					//reactorдbufferʱ
+	int32_t m_iWakeFd;					//eventfd, bufferʱreactor
+	volatile int32_t m_iWaiting;		//reactorǷepoll_wait
+
+	//̶߳ռķͶ
+	size_t m_nWorkerNum;
+	size_t m_nWorkerBufferSize;
+	std::vector<CFIFOBuffer*> m_vecWorkerBuffer;
 };
 
 
@@ -507,6 +507,7 @@ time_t GetDateTime(const std::string &sDateTime)
 	{
 		return 0;
 	}
+	stDateTime.tm_isdst = -1;
 
 	return mktime(&stDateTime);
 }
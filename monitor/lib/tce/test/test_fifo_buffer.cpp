@@ -0,0 +1,166 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License"); 
+ * you may not use this file except in compliance with the License. You may 
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the 
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "fifo_buffer.h"
+
+using namespace std;
+
+#define CHECK(exp) do { if(!(exp)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #exp); return 1; } } while(0)
+
+static string MakeData(const int32_t iLen, const char cSeed)
+{
+	string sData(iLen, '\0');
+	for ( int32_t i=0; i<iLen; ++i )
+		sData[i] = (char)(cSeed + i);
+	return sData;
+}
+
+static bool ReadEqual(tce::CFIFOBuffer& oBuf, const string& sExpect)
+{
+	string sData;
+	return oBuf.Read(sData) == tce::CFIFOBuffer::BUF_OK && sData == sExpect;
+}
+
+//Reserve at the buffer end keeps the head there and puts the data at 0;
+//Commit moves a short message back behind the head, a long one stays at 0
+static int TestCommitWrap()
+{
+	tce::CFIFOBuffer oBuf;
+	CHECK(oBuf.Init(10*1024));
+	const int32_t iSize = (int32_t)oBuf.GetSize();
+
+	//tail = iSize-50
+	string sFill = MakeData(iSize-50-4, 'f');
+	CHECK(oBuf.Write(sFill) == tce::CFIFOBuffer::BUF_OK);
+	CHECK(ReadEqual(oBuf, sFill));
+
+	unsigned char* pszBuf = oBuf.Reserve(200);
+	CHECK(pszBuf != NULL);
+	string sShort = MakeData(20, 's');
+	memcpy(pszBuf, sShort.data(), sShort.size());
+	CHECK(oBuf.Commit(sShort.size()) == tce::CFIFOBuffer::BUF_OK);
+
+	pszBuf = oBuf.Reserve(200);
+	CHECK(pszBuf != NULL);
+	string sLong = MakeData(100, 'l');
+	memcpy(pszBuf, sLong.data(), sLong.size());
+	CHECK(oBuf.Commit(sLong.size()) == tce::CFIFOBuffer::BUF_OK);
+
+	CHECK(ReadEqual(oBuf, sShort));
+	CHECK(ReadEqual(oBuf, sLong));
+	string sData;
+	CHECK(oBuf.Read(sData) == tce::CFIFOBuffer::BUF_EMPTY);
+	return 0;
+}
+
+//commit less than reserved, then write and read in order
+static int TestPartialCommit()
+{
+	tce::CFIFOBuffer oBuf;
+	CHECK(oBuf.Init(10*1024));
+
+	CHECK(oBuf.Commit(1) == tce::CFIFOBuffer::BUF_ERR);
+	unsigned char* pszBuf = oBuf.Reserve(1000);
+	CHECK(pszBuf != NULL);
+	CHECK(oBuf.Commit(1001) == tce::CFIFOBuffer::BUF_ERR);
+
+	pszBuf = oBuf.Reserve(1000);
+	CHECK(pszBuf != NULL);
+	string sFirst = MakeData(10, 'a');
+	memcpy(pszBuf, sFirst.data(), sFirst.size());
+	CHECK(oBuf.Commit(sFirst.size()) == tce::CFIFOBuffer::BUF_OK);
+	CHECK(oBuf.Commit(0) == tce::CFIFOBuffer::BUF_ERR);
+
+	pszBuf = oBuf.Reserve(1000);
+	CHECK(pszBuf != NULL);
+	CHECK(oBuf.Commit(0) == tce::CFIFOBuffer::BUF_OK);
+
+	string sSecond = MakeData(30, 'b');
+	CHECK(oBuf.Write(sSecond) == tce::CFIFOBuffer::BUF_OK);
+
+	CHECK(ReadEqual(oBuf, sFirst));
+	CHECK(ReadEqual(oBuf, ""));
+	CHECK(ReadEqual(oBuf, sSecond));
+
+	//no room: reserve fails and nothing is committed
+	CHECK(oBuf.Reserve((int32_t)oBuf.GetSize()) == NULL);
+	CHECK(oBuf.Commit(0) == tce::CFIFOBuffer::BUF_ERR);
+	return 0;
+}
+
+//a data error while earlier messages are read but not released (queued for writev)
+//must not hand their memory back to the writer
+static int TestDataErrorPending()
+{
+	tce::CFIFOBuffer oBuf;
+	CHECK(oBuf.Init(10*1024));
+
+	string sPending = MakeData(100, 'p');
+	CHECK(oBuf.Write(sPending) == tce::CFIFOBuffer::BUF_OK);
+	CHECK(oBuf.ReadNext() == tce::CFIFOBuffer::BUF_OK);
+	const unsigned char* pszPending = oBuf.GetCurData();
+	CHECK(oBuf.GetCurDataLen() == (int32_t)sPending.size());
+	oBuf.MoveNext(false);
+
+	//corrupt the length of the next message
+	unsigned char* pszBuf = oBuf.Reserve(10);
+	CHECK(pszBuf != NULL);
+	CHECK(oBuf.Commit(10) == tce::CFIFOBuffer::BUF_OK);
+	int32_t iBadLen = 100000;
+	memcpy(pszBuf-sizeof(int32_t), &iBadLen, sizeof(int32_t));
+	CHECK(oBuf.ReadNext() == tce::CFIFOBuffer::BUF_ERR);
+
+	//fill the buffer: the pending message must stay intact
+	string sFill = MakeData(1000, 'w');
+	int32_t iWritten = 0;
+	while ( oBuf.Write(sFill) == tce::CFIFOBuffer::BUF_OK )
+		++iWritten;
+	CHECK(iWritten > 0);
+	CHECK(memcmp(pszPending, sPending.data(), sPending.size()) == 0);
+
+	//the bad message is skipped, later ones are read after release
+	oBuf.Release();
+	for ( int32_t i=0; i<iWritten; ++i )
+		CHECK(ReadEqual(oBuf, sFill));
+	string sData;
+	CHECK(oBuf.Read(sData) == tce::CFIFOBuffer::BUF_EMPTY);
+
+	//without pending data the buffer is cleared as before
+	pszBuf = oBuf.Reserve(10);
+	CHECK(pszBuf != NULL);
+	CHECK(oBuf.Commit(10) == tce::CFIFOBuffer::BUF_OK);
+	memcpy(pszBuf-sizeof(int32_t), &iBadLen, sizeof(int32_t));
+	CHECK(oBuf.ReadNext() == tce::CFIFOBuffer::BUF_ERR);
+	CHECK(oBuf.Read(sData) == tce::CFIFOBuffer::BUF_EMPTY);
+	CHECK(oBuf.Write(sFill) == tce::CFIFOBuffer::BUF_OK);
+	CHECK(ReadEqual(oBuf, sFill));
+	return 0;
+}
+
+int main()
+{
+	if ( TestCommitWrap() != 0 || TestPartialCommit() != 0 || TestDataErrorPending() != 0 )
+		return 1;
+
+	printf("test_fifo_buffer ok\n");
+	return 0;
+}
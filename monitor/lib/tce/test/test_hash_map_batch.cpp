@@ -0,0 +1,156 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/shm.h>
+#include "tce.h"
+
+using namespace std;
+
+struct SValue;
+typedef tce::shm::CHashMap<unsigned long, SValue> SHMHASHMAP;
+typedef tce::shm::CHashMap<std::string, SValue, tce::Int2Type<tce::shm::KT_STRING_32> > STR_SHMHASHMAP;
+
+#pragma pack(1)
+struct SValue
+{
+	unsigned long key;
+	char szData[56];
+};
+#pragma pack()
+
+static unsigned long NowUs()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec*1000000UL + tv.tv_usec;
+}
+
+static void Report(const char* pszName, const size_t n, const unsigned long dwSingleUs, const unsigned long dwBatchUs, const size_t nSingle, const size_t nBatch)
+{
+	printf("%-16s single %6lu ns/op  batch %6lu ns/op  (%.2fx)  ok %lu/%lu\n", pszName,
+		dwSingleUs*1000/n, dwBatchUs*1000/n, dwBatchUs ? (double)dwSingleUs/dwBatchUs : 0.0,
+		(unsigned long)nSingle, (unsigned long)nBatch);
+}
+
+template <class HASHMAP>
+void BenchHashMap(const char* pszName, HASHMAP& hashmap, const std::vector<typename HASHMAP::value_type>& vecObjs)
+{
+	typedef typename HASHMAP::key_type key_type;
+	const size_t n = vecObjs.size();
+	std::vector<key_type> vecKeys;
+	for ( size_t i=0; i<n; ++i )
+		vecKeys.push_back(vecObjs[i].first);
+	std::vector<typename HASHMAP::iterator> vecIts(n);
+	size_t nSingle = 0, nBatch = 0;
+
+	cout << "****" << pszName << "**** n=" << n << "; maxsize=" << hashmap.max_size() << endl;
+	hashmap.clear();
+	unsigned long dwBegin = NowUs();
+	for ( size_t i=0; i<n; ++i )
+		nSingle += hashmap.insert(vecObjs[i]).second ? 1 : 0;
+	unsigned long dwSingle = NowUs()-dwBegin;
+	hashmap.clear();
+	dwBegin = NowUs();
+	nBatch = hashmap.insert_many(&vecObjs[0], n);
+	Report("insert", n, dwSingle, NowUs()-dwBegin, nSingle, nBatch);
+
+	nSingle = 0;
+	dwBegin = NowUs();
+	for ( size_t i=0; i<n; ++i )
+		nSingle += hashmap.find(vecKeys[i]) != hashmap.end() ? 1 : 0;
+	dwSingle = NowUs()-dwBegin;
+	dwBegin = NowUs();
+	nBatch = hashmap.find_many(&vecKeys[0], n, &vecIts[0]);
+	Report("find", n, dwSingle, NowUs()-dwBegin, nSingle, nBatch);
+
+	size_t nBad = 0;
+	for ( size_t i=0; i<n; ++i )
+	{
+		if ( vecIts[i] == hashmap.end() || memcmp(&vecIts[i]->second, &vecObjs[i].second, sizeof(SValue)) != 0 )
+			++nBad;
+	}
+	if ( nBad > 0 )
+		cout << "find_many mismatch: " << nBad << endl;
+
+	dwBegin = NowUs();
+	nSingle = 0;
+	for ( size_t i=0; i<n; ++i )
+		nSingle += hashmap.erase(vecKeys[i]);
+	dwSingle = NowUs()-dwBegin;
+	hashmap.insert_many(&vecObjs[0], n);
+	dwBegin = NowUs();
+	nBatch = hashmap.erase_many(&vecKeys[0], n);
+	Report("erase", n, dwSingle, NowUs()-dwBegin, nSingle, nBatch);
+	cout << "size after erase=" << hashmap.size() << endl;
+}
+
+static void RemoveShm(const int iKey)
+{
+	int iShmID = shmget(iKey, 0, 0666);
+	if ( iShmID >= 0 )
+		shmctl(iShmID, IPC_RMID, NULL);
+}
+
+//usage: test_hash_map_batch [n]
+//shm keys 1236~1237 are used and removed before exit
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	srand(1);
+	//segments left by a run with another n have the wrong size
+	RemoveShm(1236);
+	RemoveShm(1237);
+
+	SHMHASHMAP hashmap;
+	if ( !hashmap.init(1236, (n*2+1024)*sizeof(SHMHASHMAP::node_type)) )
+	{
+		cout << "hashmap.init error=" << hashmap.err_msg() << endl;
+		return -1;
+	}
+	std::vector<SHMHASHMAP::value_type> vecObjs;
+	for ( size_t i=0; i<n; ++i )
+	{
+		SValue stValue;
+		memset(&stValue, 0, sizeof(stValue));
+		stValue.key = (unsigned long)rand()*RAND_MAX+rand();
+		snprintf(stValue.szData, sizeof(stValue.szData), "value-%lu", stValue.key);
+		vecObjs.push_back(SHMHASHMAP::value_type(stValue.key, stValue));
+	}
+	BenchHashMap("CHashMap<unsigned long>", hashmap, vecObjs);
+	RemoveShm(1236);
+
+	STR_SHMHASHMAP strHashmap;
+	if ( !strHashmap.init(1237, (n*2+1024)*sizeof(STR_SHMHASHMAP::node_type)) )
+	{
+		cout << "hashmap.init error=" << strHashmap.err_msg() << endl;
+		return -1;
+	}
+	std::vector<STR_SHMHASHMAP::value_type> vecStrObjs;
+	for ( size_t i=0; i<n; ++i )
+		vecStrObjs.push_back(STR_SHMHASHMAP::value_type(vecObjs[i].second.szData, vecObjs[i].second));
+	BenchHashMap("CHashMap<string>", strHashmap, vecStrObjs);
+	RemoveShm(1237);
+
+	return 0;
+}
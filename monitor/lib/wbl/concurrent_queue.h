@@ -178,6 +178,133 @@ public:
 			op(v);
 	}
 };
+
+/** 有界无锁多生产者多消费者队列
+ *  定长环形数组, 每个槽位带序号, 生产者和消费者各自CAS推进位置, 不分配节点
+ *  容量向上取整为2的幂, 满时push返回false, 由调用者决定等待还是转入无界队列
+ */
+template < typename T >
+class bounded_concurrent_queue
+{
+public:
+	typedef size_t			 						size_type;
+	typedef T										value_type;
+private:
+	struct cell
+	{
+		volatile size_type	seq;
+		value_type			data;
+	};
+
+	// x86为TSO, 发布槽位时只需编译器屏障; 其它平台用全屏障
+	static inline void release_barrier()
+	{
+#if defined(__x86_64) || defined(__i386)
+		__asm__ __volatile__ ("" ::: "memory");
+#else
+		__sync_synchronize();
+#endif
+	}
+
+	cell *				_buf;
+	size_type			_mask;
+	char				_pad0[64];
+	volatile size_type	_enq;	/// 生产位置
+	char				_pad1[64];
+	volatile size_type	_deq;	/// 消费位置
+	char				_pad2[64];
+
+	bounded_concurrent_queue(const bounded_concurrent_queue&);
+	bounded_concurrent_queue& operator=(const bounded_concurrent_queue&);
+public:
+	explicit bounded_concurrent_queue(size_type capacity)
+		: _enq(0)
+		, _deq(0)
+	{
+		size_type n = 2;
+		while (n < capacity)
+			n <<= 1;
+		_buf = new cell[n];
+		_mask = n - 1;
+		for (size_type i = 0; i < n; ++i)
+			_buf[i].seq = i;
+	}
+
+	~bounded_concurrent_queue()
+	{
+		delete [] _buf;
+	}
+
+	bool push(const value_type& v)
+	{
+		cell * c;
+		size_type pos = _enq;
+		for (; ;) {
+			c = &_buf[pos & _mask];
+			size_type seq = c->seq;
+			long dif = (long) seq - (long) pos;
+			if (dif == 0) {
+				if (__sync_bool_compare_and_swap(&_enq, pos, pos + 1))
+					break;
+			} else if (dif < 0) {
+				return false;	// 满
+			}
+			pos = _enq;
+		}
+		c->data = v;
+		release_barrier();
+		c->seq = pos + 1;
+		return true;
+	}
+
+	bool pop(value_type& v)
+	{
+		cell * c;
+		size_type pos = _deq;
+		for (; ;) {
+			c = &_buf[pos & _mask];
+			size_type seq = c->seq;
+			long dif = (long) seq - (long) (pos + 1);
+			if (dif == 0) {
+				if (__sync_bool_compare_and_swap(&_deq, pos, pos + 1))
+					break;
+			} else if (dif < 0) {
+				return false;	// 空
+			}
+			pos = _deq;
+		}
+		v = c->data;
+		release_barrier();
+		c->seq = pos + _mask + 1;
+		return true;
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	/// 近似长度, 并发时仅供参考
+	size_type size() const
+	{
+		size_type e = _enq;
+		size_type d = _deq;
+		return e > d ? e - d : 0;
+	}
+
+	size_type capacity() const
+	{
+		return _mask + 1;
+	}
+
+	template < typename Op >
+	void clear(Op op)
+	{
+		value_type v;
+		while(pop(v))
+			op(v);
+	}
+};
 }
 
 #endif
@@ -32,9 +32,11 @@ namespace wbl
 using namespace thread_pool_detail;
 
 pthread_key_t	thread_pool::_tkey;
+static pthread_once_t	_tkey_once = PTHREAD_ONCE_INIT;
 
 thread_pool::thread_pool(int thread_count)
-	: _stop_all(false)
+	: _ring(NULL)
+	, _stop_all(false)
 	, _init(NULL)
 	, _barrier(NULL)
 {
@@ -42,7 +44,8 @@ thread_pool::thread_pool(int thread_count)
 }
 
 thread_pool::thread_pool()
-	: _stop_all(false)
+	: _ring(NULL)
+	, _stop_all(false)
 	, _init(NULL)
 	, _barrier(NULL)
 {}
@@ -50,6 +53,7 @@ thread_pool::thread_pool()
 thread_pool::~thread_pool()
 {
 	stop();
+	delete _ring;
 }
 /*
 namespace
@@ -97,13 +101,12 @@ extern "C"
 		thread_info * ti = p->first;
 		delete p;
 		tp->on_thread_init(ti);
-		thread_pool::QueueT& bq = tp->_queue;
 		//set_state_op sop(&ti->status, eRunning);
 		while(!tp->_stop_all){
 			runnable * r = NULL;
 			//*
 			ti->status = eWaiting;
-			if (bq.pop(r)) {
+			if (tp->pop_task(r)) {
 				std::auto_ptr<runnable> p(r);
 				try{
 					ti->status = eRunning;
@@ -154,20 +157,36 @@ thread_data * thread_pool::get_thread_data()
 	return ti->data;
 }
 
+int thread_pool::get_thread_index()
+{
+	::pthread_once(&_tkey_once, create_thread_key);
+	thread_info * ti = static_cast<thread_info*>(pthread_getspecific(_tkey));
+	return ti ? ti->index : -1;
+}
+
+bool thread_pool::set_queue_capacity(size_type capacity)
+{
+	if(_tid.size() > 0)
+		return false;
+	delete _ring;
+	_ring = capacity > 0 ? new RingT(capacity) : NULL;
+	return true;
+}
+
 bool thread_pool::start_impl(int thread_count, runnable * init)
 {
 	if(_tid.size() > 0)
 		return false;
 	_init = init;
 
-	static pthread_once_t once = PTHREAD_ONCE_INIT;
-	::pthread_once(&once, create_thread_key);
+	::pthread_once(&_tkey_once, create_thread_key);
 
 	bool result = true;
 	typedef std::pair<thread_info*, thread_pool*>	PairT;
 	_stop_all = false;
 	_tid.resize(thread_count);
 	for(VIT i = _tid.begin(); i != _tid.end(); ++i){
+		i->index = i - _tid.begin();
 		PairT * p = new PairT(&*i, this);
 		if(::pthread_create(&i->id, 0, &thread_pool_proc, p) != 0){
 			_tid.resize(i - _tid.begin());
@@ -183,6 +202,8 @@ bool thread_pool::start_impl(int thread_count, runnable * init)
 void thread_pool::stop(bool force)
 {
 	_queue.clear(checked_delete());
+	if (_ring)
+		_ring->clear(checked_delete());
 	_stop_all = true;
 	for (VIT i = _tid.begin(); i != _tid.end(); ++i)
 		_sem.Post();
@@ -233,7 +254,7 @@ void thread_pool::wait()
 bool thread_pool::wait(int timeout)
 {
 	int lc = timeout * 1000 / 10000;
-	for(; (!_queue.empty() || get_active_thread_count() > 0) && lc > 0; --lc)
+	for(; (get_queue_length() > 0 || get_active_thread_count() > 0) && lc > 0; --lc)
 		usleep(10000);
 	return lc > 0;
 }
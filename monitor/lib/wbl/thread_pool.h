@@ -108,9 +108,10 @@ namespace thread_pool_detail
 		volatile int	status;		///< thread status, one of eRunning, eWaiting, eStoped
 		thread_data *	data;		///< thread private data
 		bool			own_data;	///< own the thread data?
+		int				index;		///< thread index in pool, [0, thread_count)
 
 		thread_info()
-			: id(0), status(eRunning), data(0), own_data(false)
+			: id(0), status(eRunning), data(0), own_data(false), index(-1)
 		{}
 	};
 
@@ -127,11 +128,13 @@ class thread_pool : public wbl::executor
 	typedef thread_pool_detail::thread_info	thread_info;
 	//typedef blocking_queue<runnable *>		QueueT;
 	typedef concurrent_queue<runnable *>		QueueT;
+	typedef bounded_concurrent_queue<runnable *>	RingT;
 
 	typedef std::vector<thread_info>::iterator	VIT;
 	typedef std::vector<thread_info>::const_iterator	CVIT;
 
 	QueueT						_queue;		///< task queue
+	RingT *						_ring;		///< bounded task queue, optional, overflow goes to _queue
 	Semaphore					_sem;		///< for queue block
 	std::vector<thread_info>	_tid;		///< thread info
 	volatile bool				_stop_all;	///< stop all thread flag
@@ -150,7 +153,8 @@ public:
 	 */
 	template < typename Op >
 	thread_pool(int thread_count, Op initOp)
-		: _stop_all(false)
+		: _ring(NULL)
+		, _stop_all(false)
 		, _init(NULL)
 		, _barrier(NULL)
 	{
@@ -182,6 +186,18 @@ public:
 		return static_cast<T*>(get_thread_data());
 	}
 
+	/** get index of current thread in its pool
+	 *  \return	[0, thread_count) in pool thread, -1 otherwise
+	 */
+	static int get_thread_index();
+
+	/** use a bounded lock-free ring as task queue, must be called before start
+	 *  tasks go to the unbounded queue only when the ring is full
+	 *  \param capacity	ring capacity, round up to power of 2; 0 to disable
+	 *  \return success?
+	 */
+	bool set_queue_capacity(size_type capacity);
+
 	/** start the thread pool
 	 *  \param thread_count	thread count
 	 *  \param initOp	initializer
@@ -228,14 +244,15 @@ public:
 	/// get waiting queue's length
 	size_type get_queue_length() const
 	{
-		return _queue.size();
+		return _queue.size() + (_ring ? _ring->size() : 0);
 	}
 
 	/// execute a task
 	void execute(runnable * r)
 	{
 		//_queue.push_b(r);
-		_queue.push(r);
+		if (_ring == NULL || !_ring->push(r))
+			_queue.push(r);
 		_sem.Post();
 	}
 
@@ -253,6 +270,12 @@ public:
 private:
 	bool start_impl(int thread_count, runnable * init = NULL);
 	size_type count(int status) const;
+	bool pop_task(runnable *& r)
+	{
+		if (_ring != NULL && _ring->pop(r))
+			return true;
+		return _queue.pop(r);
+	}
 	void on_thread_init(thread_info * ti);
 	friend void * thread_pool_detail::thread_pool_proc(void* pPara);
 	friend void thread_pool_detail::create_thread_key();
@@ -0,0 +1,334 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License"); 
+ * you may not use this file except in compliance with the License. You may 
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the 
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+
+#include "alarm_sink.h"
+#include "log_def.h"
+#include <sstream>
+#include <set>
+#include <errno.h>
+
+#define ALARM_DEDUP_TIME		60			//дͬһ澯60ڲд
+#define ALARM_SINK_POLL			100			//д̼߳(ms)
+#define ALARM_SINK_MAX_PENDING	100000		//д澯, 
+
+static const char* AlarmTypeName(uint32_t Type)
+{
+	switch(Type)
+	{
+		case AT_MAX: return "Max";
+		case AT_MIN: return "Min";
+		case AT_DIFF: return "Diff";
+		case AT_DIFFP: return "DiffP";
+		default: return "Unknown";
+	}
+}
+
+CMySqlAlarmBackend::CMySqlAlarmBackend(const string& Host, const string& User, const string& Password, uint16_t Port, const string& DBName, size_t RowsPerSql)
+	: rows_per_sql(RowsPerSql > 0 ? RowsPerSql : 1)
+{
+	mysql.Init(Host, User, Password, Port);
+	mysql.use(DBName);
+}
+
+bool CMySqlAlarmBackend::Write(const vector<AlarmRecord>& Records, vector<AlarmRecord>& Failed, string& err)
+{
+	bool ok = true;
+	for(size_t begin = 0; begin < Records.size(); begin += rows_per_sql)
+	{
+		size_t end = begin + rows_per_sql < Records.size() ? begin + rows_per_sql : Records.size();
+		std::ostringstream str;
+		str << "insert into alarm(id, servicename, attrname, createtime, alarmtime, alarm_type, current_num, alarm_num) values ";
+		for(size_t i = begin; i < end; ++i)
+		{
+			const AlarmRecord& r = Records[i];
+			if(i != begin)
+				str << ",";
+			str << "(0, '" << mysql.escape_string(r.ServiceName) << "', '"
+				<< mysql.escape_string(r.AttrName)
+				<< "', NOW(), FROM_UNIXTIME(" << r.AlarmTime << "), " << r.Type << ", "
+				<< r.Value << ", "
+				<< r.Threshold << ")";
+		}
+		try{
+			mysql.query(str.str());
+		}
+		catch(std::runtime_error& e)
+		{
+			err = e.what();
+			ok = false;
+			Failed.insert(Failed.end(), Records.begin() + begin, Records.begin() + end);
+		}
+	}
+	return ok;
+}
+
+CFileAlarmBackend::CFileAlarmBackend(const string& Path)
+	: path(Path)
+	, fp(NULL)
+{
+	fp = fopen(path.c_str(), "a");
+}
+
+CFileAlarmBackend::~CFileAlarmBackend()
+{
+	if(fp != NULL)
+		fclose(fp);
+}
+
+bool CFileAlarmBackend::Write(const vector<AlarmRecord>& Records, vector<AlarmRecord>& Failed, string& err)
+{
+	if(fp == NULL && (fp = fopen(path.c_str(), "a")) == NULL)
+	{
+		err = path + ": " + strerror(errno);
+		Failed.insert(Failed.end(), Records.begin(), Records.end());
+		return false;
+	}
+
+	//alarmtime|type|servicename|attrname|value|threshold|count
+	for(size_t i = 0; i < Records.size(); ++i)
+	{
+		const AlarmRecord& r = Records[i];
+		time_t t = r.AlarmTime;
+		struct tm timeinfo;
+		char szTime[32];
+		localtime_r(&t, &timeinfo);
+		strftime(szTime, sizeof(szTime), "%Y-%m-%d %H:%M:%S", &timeinfo);
+		fprintf(fp, "%s|%u|%s|%s|%u|%u|%u\n", szTime, r.Type, r.ServiceName.c_str(), r.AttrName.c_str(), r.Value, r.Threshold, r.Count);
+	}
+	if(fflush(fp) != 0)
+	{
+		err = path + ": " + strerror(errno);
+		fclose(fp);
+		fp = NULL;
+		Failed.insert(Failed.end(), Records.begin(), Records.end());
+		return false;
+	}
+	return true;
+}
+
+CAlarmSink::CAlarmSink(void)
+	: backend(NULL)
+	, batch_size(200)
+	, flush_interval(1000)
+	, writer_thread(&WriterProc)
+	, run_writer(false)
+{}
+
+CAlarmSink::~CAlarmSink(void)
+{
+	Stop();
+	delete backend;
+}
+
+bool CAlarmSink::Init(CAlarmBackend* Backend, size_t BatchSize, uint32_t FlushInterval)
+{
+	if(Backend == NULL || backend != NULL)
+		return false;
+
+	backend = Backend;
+	batch_size = BatchSize > 0 ? BatchSize : 1;
+	flush_interval = FlushInterval;
+	run_writer = true;
+	if(!writer_thread.Start(this))
+	{
+		run_writer = false;
+		return false;
+	}
+	msg_log.Write("[Alarm]Init|%s|%lu|%u", backend->Name(), batch_size, flush_interval);
+	return true;
+}
+
+void CAlarmSink::Stop()
+{
+	run_writer = false;
+	writer_thread.Stop();
+}
+
+void CAlarmSink::Add(const string& ServiceName, const string& AttrName, uint32_t AlarmTime, uint32_t Type, uint32_t Value, uint32_t Threshold)
+{
+	if(backend == NULL)
+		return;
+
+	AlarmKey key;
+	key.ServiceName = ServiceName;
+	key.AttrName = AttrName;
+	key.AlarmTime = AlarmTime;
+	key.Type = Type;
+
+	tce::CAutoLock lock(lock_pending);
+	map<AlarmKey, size_t>::iterator it = pending_index.find(key);
+	if(it != pending_index.end())
+	{
+		AlarmRecord& r = pending[it->second];
+		r.Value = Value;
+		r.Threshold = Threshold;
+		++r.Count;
+		return;
+	}
+
+	if(pending.size() >= ALARM_SINK_MAX_PENDING)
+	{
+		err_log.Write("[Alarm]Pending full|%s|%s|%u|%s|%u|%u", ServiceName.c_str(), AttrName.c_str(), AlarmTime, AlarmTypeName(Type), Value, Threshold);
+		return;
+	}
+
+	pending_index[key] = pending.size();
+	pending.push_back(AlarmRecord());
+	AlarmRecord& r = pending.back();
+	r.ServiceName = ServiceName;
+	r.AttrName = AttrName;
+	r.AlarmTime = AlarmTime;
+	r.Type = Type;
+	r.Value = Value;
+	r.Threshold = Threshold;
+	r.Count = 1;
+}
+
+size_t CAlarmSink::GetPendingSize() const
+{
+	tce::CAutoLock lock(lock_pending);
+	return pending.size();
+}
+
+int32_t CAlarmSink::WriterProc(void* pParam)
+{
+	CAlarmSink* poThis = (CAlarmSink*)pParam;
+	if ( NULL != poThis )
+	{
+		tce::CTimeCost tc;
+		while(poThis->run_writer)
+		{
+			tce::xsleep(ALARM_SINK_POLL);
+			if(poThis->GetPendingSize() >= poThis->batch_size || (uint32_t)tc.value() >= poThis->flush_interval)
+			{
+				poThis->Flush();
+				tc.reset();
+			}
+		}
+		poThis->Flush();	//˳ǰд
+	}
+	return 0;
+}
+
+void CAlarmSink::Flush()
+{
+	vector<AlarmRecord> records;
+	{
+		tce::CAutoLock lock(lock_pending);
+		records.swap(pending);
+		pending_index.clear();
+	}
+
+	time_t now = time(NULL);
+	for(map<AlarmKey, time_t>::iterator it = written.begin(); it != written.end(); )
+	{
+		if(it->second + ALARM_DEDUP_TIME <= now)
+			written.erase(it++);
+		else
+			++it;
+	}
+
+	//ȥдͬһ澯
+	vector<AlarmRecord> todo;
+	todo.reserve(records.size());
+	for(size_t i = 0; i < records.size(); ++i)
+	{
+		AlarmKey key;
+		key.ServiceName = records[i].ServiceName;
+		key.AttrName = records[i].AttrName;
+		key.AlarmTime = records[i].AlarmTime;
+		key.Type = records[i].Type;
+		if(written.insert(std::make_pair(key, now)).second)
+			todo.push_back(records[i]);
+	}
+	if(todo.empty())
+		return;
+
+	tce::CTimeCost tc;
+	string err;
+	vector<AlarmRecord> failed;
+	bool ok = backend->Write(todo, failed, err);
+
+	std::set<AlarmKey> failed_keys;
+	for(size_t i = 0; i < failed.size(); ++i)
+	{
+		AlarmKey key;
+		key.ServiceName = failed[i].ServiceName;
+		key.AttrName = failed[i].AttrName;
+		key.AlarmTime = failed[i].AlarmTime;
+		key.Type = failed[i].Type;
+		failed_keys.insert(key);
+	}
+	for(size_t i = 0; i < todo.size(); ++i)
+	{
+		const AlarmRecord& r = todo[i];
+		AlarmKey key;
+		key.ServiceName = r.ServiceName;
+		key.AttrName = r.AttrName;
+		key.AlarmTime = r.AlarmTime;
+		key.Type = r.Type;
+		if(failed_keys.find(key) == failed_keys.end())
+			msg_log.Write("[Alarm]%s|%s|%s|%u|%u|%u|%u", AlarmTypeName(r.Type), r.ServiceName.c_str(), r.AttrName.c_str(), r.AlarmTime/60, r.Value, r.Threshold, r.Count);
+		else
+			err_log.Write("[Alarm]%s|ERR|%s|%s|%u|%u|%u|%u", AlarmTypeName(r.Type), r.ServiceName.c_str(), r.AttrName.c_str(), r.AlarmTime/60, r.Value, r.Threshold, r.Count);
+	}
+	if(ok)
+	{
+		msg_log.Write("[Alarm]Flush|%s|%lu|%lu|%lu", backend->Name(), records.size(), todo.size(), tc.value());
+		return;
+	}
+
+	//дȥؼ¼, ֻûдȥ
+	err_log.Write("[Alarm]Flush|ERR|%s|%lu|%lu|%s", backend->Name(), todo.size(), failed.size(), err.c_str());
+	Requeue(failed);
+}
+
+//дʧܵĸ澯ȥؼ¼, Żشдһ
+void CAlarmSink::Requeue(const vector<AlarmRecord>& Records)
+{
+	tce::CAutoLock lock(lock_pending);
+	for(size_t i = 0; i < Records.size(); ++i)
+	{
+		const AlarmRecord& r = Records[i];
+		AlarmKey key;
+		key.ServiceName = r.ServiceName;
+		key.AttrName = r.AttrName;
+		key.AlarmTime = r.AlarmTime;
+		key.Type = r.Type;
+		written.erase(key);
+
+		//ڼͶͬһ澯: µֵ, ϲ
+		map<AlarmKey, size_t>::iterator it = pending_index.find(key);
+		if(it != pending_index.end())
+		{
+			pending[it->second].Count += r.Count;
+			continue;
+		}
+
+		if(pending.size() >= ALARM_SINK_MAX_PENDING)
+		{
+			err_log.Write("[Alarm]Pending full|%s|%s|%u|%s|%u|%u", r.ServiceName.c_str(), r.AttrName.c_str(), r.AlarmTime, AlarmTypeName(r.Type), r.Value, r.Threshold);
+			continue;
+		}
+
+		pending_index[key] = pending.size();
+		pending.push_back(r);
+	}
+}
@@ -0,0 +1,164 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License"); 
+ * you may not use this file except in compliance with the License. You may 
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the 
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  alarm_sink.h
+ *
+ *    Description:  澯: жֻ߳Ͷ, д̺߳ϲȥغд
+ *
+ *        Version:  1.0
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *        Company:  Tencent
+ *
+ * =====================================================================================
+ */
+#ifndef __ALARM_SINK_H__
+#define __ALARM_SINK_H__
+
+#include "tce.h"
+#include "tce_singleton.h"
+#include "tce_thread.h"
+#include "tce_lock.h"
+#include "mysql_wrapper.h"
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+#include <string>
+
+enum ALARM_TYPE {
+	AT_MAX = 1,
+	AT_MIN = 2,
+	AT_DIFF = 3,
+	AT_DIFFP = 4,
+};
+
+class AlarmRecord {
+public:
+	string ServiceName;
+	string AttrName;
+	uint32_t AlarmTime;		//澯ķ, unixʱ
+	uint32_t Type;			//ALARM_TYPE
+	uint32_t Value;			//ǰֵ
+	uint32_t Threshold;		//澯ֵ
+	uint32_t Count;			//ϲĴ
+};
+
+//ͬһ澯: ++
+class AlarmKey {
+public:
+	string ServiceName;
+	string AttrName;
+	uint32_t AlarmTime;
+	uint32_t Type;
+	bool operator < ( const AlarmKey &rhs ) const
+	{
+		if(AlarmTime != rhs.AlarmTime)
+			return AlarmTime < rhs.AlarmTime;
+		if(Type != rhs.Type)
+			return Type < rhs.Type;
+		return ( ServiceName == rhs.ServiceName ? (AttrName < rhs.AttrName) : ( ServiceName < rhs.ServiceName ) );
+	}
+};
+
+//غ, ֻд߳е
+class CAlarmBackend {
+public:
+	virtual ~CAlarmBackend() {}
+	virtual const char* Name() const = 0;
+	//д, дʧܵķfalse, дerrûдȥĸ澯׷ӵFailed;
+	//дĲܳFailed, ʱظд
+	virtual bool Write(const vector<AlarmRecord>& Records, vector<AlarmRecord>& Failed, string& err) = 0;
+};
+
+//д澯DBalarm, кϳһinsert
+class CMySqlAlarmBackend : public CAlarmBackend {
+public:
+	//ʧʱ׳monitor::mysql_execfail
+	CMySqlAlarmBackend(const string& Host, const string& User, const string& Password, uint16_t Port, const string& DBName, size_t RowsPerSql = 200);
+	const char* Name() const { return "mysql"; }
+	//ÿinsertύ, ֻʧܵinsertĸ澯Failed
+	bool Write(const vector<AlarmRecord>& Records, vector<AlarmRecord>& Failed, string& err);
+private:
+	monitor::CMySql mysql;
+	size_t rows_per_sql;
+};
+
+//׷дļ, ÿ澯һ, DBͲ
+class CFileAlarmBackend : public CAlarmBackend {
+public:
+	explicit CFileAlarmBackend(const string& Path);
+	~CFileAlarmBackend();
+	const char* Name() const { return "file"; }
+	bool Write(const vector<AlarmRecord>& Records, vector<AlarmRecord>& Failed, string& err);
+private:
+	string path;
+	FILE* fp;
+};
+
+class CAlarmSink
+	: tce::CNonCopyAble
+{
+public:
+	DECLARE_SINGLETON_CLASS(CAlarmSink);
+
+public:
+	~CAlarmSink(void);
+
+	//Backendsinkͷ; BatchSizeFlushIntervalдһ
+	bool Init(CAlarmBackend* Backend, size_t BatchSize = 200, uint32_t FlushInterval = 1000);
+	//ֹͣд߳, δдĸ澯дٷ
+	void Stop();
+
+	//Ͷݸ澯; δдǰͬһ澯ϲΪһ, µֵ;
+	//дͬһ澯һʱڲظд
+	void Add(const string& ServiceName, const string& AttrName, uint32_t AlarmTime, uint32_t Type, uint32_t Value, uint32_t Threshold);
+
+	size_t GetPendingSize() const;
+
+	//дһд澯, ֻûдȥķŻشд; д̶߳ڵ
+	void Flush();
+
+private:
+	CAlarmSink(void);
+
+	static int32_t WriterProc(void* pParam);
+	void Requeue(const vector<AlarmRecord>& Records);
+
+	CAlarmBackend* backend;
+	size_t batch_size;
+	uint32_t flush_interval;
+
+	mutable tce::CMutex lock_pending;
+	vector<AlarmRecord> pending;
+	map<AlarmKey, size_t> pending_index;	//value: pendingе±
+
+	map<AlarmKey, time_t> written;			//дĸ澯, ֻд̷߳
+
+	typedef int32_t (* THREADFUNC)(void *);
+	typedef tce::CThread<THREADFUNC> THREAD;
+	THREAD writer_thread;
+	volatile bool run_writer;
+};
+
+#endif
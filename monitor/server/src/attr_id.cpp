@@ -0,0 +1,265 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#include "attr_id.h"
+
+#include "log_def.h"
+#include "proc_def.h"
+#include <unistd.h>
+
+static inline string AttrIdName(const string& ServiceName, const string& AttrName)
+{
+	string name(ServiceName);
+	name.append(1u, 0x3).append(AttrName);
+	return name;
+}
+
+CAttrIdMgr::CAttrIdMgr()
+	: id_names(1)
+	, epoch(0)
+	, next_id(1)
+{}
+
+bool CAttrIdMgr::Init()
+{
+	tce::CTimeCost tc;
+	tce::WriteLocker wl(lock);
+	name_map.clear();
+	id_names.assign(1, string());
+
+	char data[512];
+	int data_len = sizeof(data);
+	string hkey(ATTR_ID_HEAD_KEY);
+	int ret = ServiceShm.GetNode(hkey, data, data_len);
+	if(ret != 0)
+	{
+		err_log.Write("[AttrId]GetNode head failed!|%d|%s", ret, ServiceShm.GetErrorMsg());
+		return false;
+	}
+	bool has_head = (data_len == 2 * sizeof(uint32_t));
+	if(has_head)
+	{
+		memcpy(&epoch, data, sizeof(uint32_t));
+		memcpy(&next_id, data + sizeof(uint32_t), sizeof(uint32_t));
+	}
+
+	MhtData* mdata = new MhtData();
+	//ServiceShmеIDڵ
+	for(MhtIterator it = ServiceShm.ht.Begin(); it != ServiceShm.ht.End(); it = ServiceShm.ht.Next(it))
+	{
+		if(ServiceShm.ht.Get(it, *mdata) != 0)
+			break;
+		if(mdata->klen != 8 || memcmp(mdata->key, ATTR_ID_NODE_PREFIX.data(), 4) != 0)
+			continue;
+		uint32_t id = 0;
+		memcpy(&id, mdata->key + 4, sizeof(uint32_t));
+		Register(id, string((char*)mdata->data, mdata->dlen));
+	}
+
+	//DataShmIDڵ㶪ʧĲ, ɸʽkeyռǨ
+	std::vector<string> old_keys;
+	int recovered = 0;
+	for(MhtIterator it = DataShm.ht.Begin(); it != DataShm.ht.End(); it = DataShm.ht.Next(it))
+	{
+		if(DataShm.ht.Get(it, *mdata, false) != 0)
+			break;
+		if(mdata->klen == 20 || mdata->klen == 24)
+		{
+			old_keys.push_back(string((char*)mdata->key, mdata->klen));
+			continue;
+		}
+		if(mdata->klen != 8 && mdata->klen != 12)
+			continue;
+		uint32_t id = 0;
+		memcpy(&id, mdata->key, sizeof(uint32_t));
+		if(id < id_names.size() && !id_names[id].empty())
+			continue;
+		if(DataShm.ht.Get(it, *mdata) != 0 || mdata->dlen != value_fixed_len)
+			continue;
+		string name(AttrIdName(string((char*)&mdata->data[0], strnlen((char*)&mdata->data[0], 128)),
+			string((char*)&mdata->data[128], strnlen((char*)&mdata->data[128], 128))));
+		Register(id, name);
+		string key(ATTR_ID_NODE_PREFIX);
+		key.append((char*)&id, sizeof(uint32_t));
+		ServiceShm.SetNode(key, name);
+		++recovered;
+	}
+	delete mdata;
+
+	if(!has_head)
+	{
+		epoch = (uint32_t)(time(NULL) ^ (getpid() << 16));
+		if(epoch == 0)
+			epoch = 1;
+	}
+	if(next_id < id_names.size())
+		next_id = id_names.size();
+	if(!SaveHead())
+		return false;
+
+	Migrate(old_keys);
+	msg_log.Write("[AttrId]Init OK|%u|%u|%lu|%d|%lu|%lu", epoch, next_id, name_map.size(), recovered, old_keys.size(), tc.value());
+	return true;
+}
+
+//ɸʽ: MD5(svc + 0x03 + attr) + [ dwIP ] + dwDay, ȡvalue
+void CAttrIdMgr::Migrate(const std::vector<string>& OldKeys)
+{
+	char data[value_fixed_len];
+	int migrated = 0;
+	for(size_t i = 0; i < OldKeys.size(); i++)
+	{
+		string oldkey(OldKeys[i]);
+		int data_len = sizeof(data);
+		int ret = DataShm.GetNode(oldkey, data, data_len);
+		if(ret == 0 && data_len == value_fixed_len)
+		{
+			data[127] = data[255] = 0;
+			uint32_t id = InternLocked(AttrIdName(&data[0], &data[128]));
+			uint32_t ip = 0;
+			uint32_t day = 0;
+			if(oldkey.size() == 24)
+				memcpy(&ip, oldkey.data() + 16, sizeof(uint32_t));
+			memcpy(&day, oldkey.data() + oldkey.size() - 4, sizeof(uint32_t));
+			string newkey(DataKey(id, ip, day));
+			if(id != ATTR_ID_NONE && !DataShm.HasKey(newkey) && DataShm.SetNode(newkey, data, value_fixed_len, -1) == 0)
+				++migrated;
+		}
+		DataShm.EraseNode(oldkey);
+	}
+	if(!OldKeys.empty())
+		msg_log.Write("[AttrId]Migrate OK|%lu|%d", OldKeys.size(), migrated);
+}
+
+void CAttrIdMgr::Register(uint32_t Id, const string& Name)
+{
+	if(Id == ATTR_ID_NONE || Name.empty())
+		return;
+	if(Id >= id_names.size())
+		id_names.resize(Id + 1);
+	id_names[Id] = Name;
+	name_map[Name] = Id;
+}
+
+bool CAttrIdMgr::SaveHead()
+{
+	uint32_t head[2] = { epoch, next_id };
+	string hkey(ATTR_ID_HEAD_KEY);
+	int ret = ServiceShm.SetNode(hkey, (char*)head, sizeof(head), -1);
+	if(ret != 0)
+	{
+		err_log.Write("[AttrId]SetNode head failed!|%d|%s", ret, ServiceShm.GetErrorMsg());
+		return false;
+	}
+	return true;
+}
+
+int CAttrIdMgr::Repair()
+{
+	tce::ReadLocker rl(lock);
+	int repaired = 0;
+	string hkey(ATTR_ID_HEAD_KEY);
+	if(!ServiceShm.HasKey(hkey))
+	{
+		uint32_t head[2] = { epoch, next_id };
+		if(ServiceShm.SetNode(hkey, (char*)head, sizeof(head), -1) == 0)
+			++repaired;
+	}
+	for(uint32_t id = 1; id < id_names.size(); id++)
+	{
+		if(id_names[id].empty())
+			continue;
+		string key(ATTR_ID_NODE_PREFIX);
+		key.append((char*)&id, sizeof(uint32_t));
+		if(ServiceShm.HasKey(key))
+			continue;
+		string name(id_names[id]);
+		int ret = ServiceShm.SetNode(key, name);
+		if(ret != 0)
+		{
+			err_log.Write("[AttrId]Repair failed!|%u|%d|%s", id, ret, ServiceShm.GetErrorMsg());
+			break;
+		}
+		++repaired;
+	}
+	if(repaired > 0)
+		msg_log.Write("[AttrId]Repair OK|%d", repaired);
+	return repaired;
+}
+
+uint32_t CAttrIdMgr::InternLocked(const string& Name)
+{
+	std::tr1::unordered_map<string, uint32_t>::const_iterator it = name_map.find(Name);
+	if(it != name_map.end())
+		return it->second;
+
+	uint32_t id = next_id;
+	string key(ATTR_ID_NODE_PREFIX);
+	key.append((char*)&id, sizeof(uint32_t));
+	string name(Name);
+	int ret = ServiceShm.SetNode(key, name);
+	if(ret != 0)
+	{
+		err_log.Write("[AttrId]SetNode failed!|%u|%d|%s", id, ret, ServiceShm.GetErrorMsg());
+		return ATTR_ID_NONE;
+	}
+	++next_id;
+	if(!SaveHead())
+	{
+		--next_id;
+		return ATTR_ID_NONE;
+	}
+	Register(id, Name);
+	return id;
+}
+
+uint32_t CAttrIdMgr::Intern(const string& ServiceName, const string& AttrName)
+{
+	string name(AttrIdName(ServiceName, AttrName));
+	{
+		tce::ReadLocker rl(lock);
+		std::tr1::unordered_map<string, uint32_t>::const_iterator it = name_map.find(name);
+		if(it != name_map.end())
+			return it->second;
+	}
+	tce::WriteLocker wl(lock);
+	return InternLocked(name);
+}
+
+uint32_t CAttrIdMgr::Find(const string& ServiceName, const string& AttrName) const
+{
+	string name(AttrIdName(ServiceName, AttrName));
+	tce::ReadLocker rl(lock);
+	std::tr1::unordered_map<string, uint32_t>::const_iterator it = name_map.find(name);
+	return it == name_map.end() ? ATTR_ID_NONE : it->second;
+}
+
+bool CAttrIdMgr::GetName(uint32_t Id, string& ServiceName, string& AttrName) const
+{
+	tce::ReadLocker rl(lock);
+	if(Id == ATTR_ID_NONE || Id >= id_names.size() || id_names[Id].empty())
+		return false;
+	const string& name = id_names[Id];
+	size_t pos = name.find((char)0x3);
+	if(pos == string::npos)
+		return false;
+	ServiceName.assign(name, 0, pos);
+	AttrName.assign(name, pos + 1, string::npos);
+	return true;
+}
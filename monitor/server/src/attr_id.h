@@ -0,0 +1,107 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  attr_id.h
+ *
+ *    Description:  (service, attr)32λIDӳ, DataShmkeyIDMD5
+ *
+ *        Version:  1.0
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *        Company:  Tencent
+ *
+ * =====================================================================================
+ */
+#ifndef __ATTR_ID_H__
+#define __ATTR_ID_H__
+
+#include "tce.h"
+#include "tce_singleton.h"
+#include "tce_lock.h"
+#include "shm_mgr.h"
+
+#include <vector>
+#include <string>
+#include <tr1/unordered_map>
+
+extern CShmMgr ServiceShm;
+extern CShmMgr DataShm;
+
+/*
+ * IDServiceShm:
+ *   ͷ     ATTR_ID_HEAD_KEY       -> dwEpoch + dwNextId
+ *   IDڵ   ATTR_ID_NODE_PREFIX + dwId -> svc + 0x03 + attr
+ * DataShmvalueԱ, IDڵ㶪ʧʱDataShm
+ * ͷʧʱepoch, agentID֮
+ * ServiceShmʱڵᱻ̭, ڴΪ׼, Repairд
+ */
+#define ATTR_ID_HEAD_KEY		string("\0AIDHDR", 7)
+#define ATTR_ID_NODE_PREFIX		string("\0AID", 4)
+#define ATTR_ID_NONE			0		//ID1ʼ
+
+class CAttrIdMgr
+	: tce::CNonCopyAble
+{
+public:
+	DECLARE_SINGLETON_CLASS(CAttrIdMgr);
+	~CAttrIdMgr() {}
+
+public:
+	//ID, ȱʧID, ѾɵMD5ʽDataShmǨΪIDʽ
+	bool Init();
+
+	//ȡID, ûʱ; ʧܷATTR_ID_NONE
+	uint32_t Intern(const string& ServiceName, const string& AttrName);
+	//ֻ鲻
+	uint32_t Find(const string& ServiceName, const string& AttrName) const;
+	bool GetName(uint32_t Id, string& ServiceName, string& AttrName) const;
+	uint32_t GetEpoch() const { return epoch; }
+	//ѱ̭ıͷIDڵдServiceShm, дصĸ
+	int Repair();
+
+	//KeyFormat: dwAttrId + [ dwIP ] + dwDay
+	static inline string DataKey(uint32_t Id, uint32_t IP, uint32_t Day)
+	{
+		string key((char*)&Id, sizeof(uint32_t));
+		if(IP != 0)
+			key.append((char*)&IP, sizeof(uint32_t));
+		key.append((char*)&Day, sizeof(uint32_t));
+		return key;
+	}
+
+private:
+	CAttrIdMgr();
+
+	void Register(uint32_t Id, const string& Name);
+	uint32_t InternLocked(const string& Name);
+	bool SaveHead();
+	void Migrate(const std::vector<string>& OldKeys);
+
+	mutable tce::ReadWriteLocker lock;
+	std::tr1::unordered_map<string, uint32_t> name_map;	//key: svc + 0x03 + attr
+	std::vector<string> id_names;						//ID
+	uint32_t epoch;
+	uint32_t next_id;
+};
+
+#endif
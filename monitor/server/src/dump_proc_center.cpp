@@ -25,33 +25,81 @@
 #include "monitor.pb.h"
 #include "data.pb.h"
 #include "set_proc_center.h"
+#include "attr_id.h"
 #include <fstream>
+#include <sys/stat.h>
 
 CDumpProcCenter::CDumpProcCenter()
 	: m_oTraverseThread(&TraverseThread),
 	m_bTraverseProcessRun(false),
-	m_bDumpOn(false)
+	m_bDumpOn(false),
+	m_bTrackDirty(false),
+	m_bDeltaReady(false),
+	m_dwDeltaInterval(0),
+	m_dwCompactRatio(50),
+	m_dwGen(0)
 {}
 
 CDumpProcCenter::~CDumpProcCenter() 
 {}
 
-bool CDumpProcCenter::Init(const string& sDumpPath)
+bool CDumpProcCenter::Init(const string& sDumpPath, uint32_t dwDeltaInterval, uint32_t dwCompactRatio)
 {
 	m_sDumpPath = sDumpPath;
+	m_sDeltaPath = sDumpPath + DUMP_DELTA_SUFFIX;
+	m_dwDeltaInterval = dwDeltaInterval;
+	m_dwCompactRatio = dwCompactRatio;
+	m_dwGen = ReadGen(m_sDumpPath);	//ɸʽû, Ϊ0
 	return true;
 }
 
-//Dumpļеݵڴ
+uint32_t CDumpProcCenter::ReadGen(const string& sPath)
+{
+	ifstream fin(sPath.c_str(), ios::in);
+	string line;
+	if (!fin || !getline(fin, line) || line.compare(0, strlen(DUMP_GEN_HEAD), DUMP_GEN_HEAD) != 0)
+		return 0;
+	return strtoul(line.c_str() + strlen(DUMP_GEN_HEAD), NULL, 10);
+}
+
+off_t CDumpProcCenter::FileSize(const string& sPath)
+{
+	struct stat st;
+	if (stat(sPath.c_str(), &st) != 0)
+		return 0;
+	return st.st_size;
+}
+
+//Dumpļеݵڴ, ȫ֮طͬ
 int CDumpProcCenter::LoadData()
 {
-	string sLoadPath = m_sDumpPath;
-	if (access(sLoadPath.c_str(), R_OK) != 0)
+	if (access(m_sDumpPath.c_str(), R_OK) != 0)
 	{
-		err_log << "No dump data file exist:  " << sLoadPath << endl;
+		err_log << "No dump data file exist:  " << m_sDumpPath << endl;
 		return 0;
 	}
 
+	int count = LoadFile(m_sDumpPath, false);
+	if (count < 0)
+		return -1;
+
+	int delta_count = 0;
+	if (access(m_sDeltaPath.c_str(), R_OK) == 0)
+		delta_count = LoadFile(m_sDeltaPath, true);
+
+	if (count > 0 || delta_count > 0)
+	{
+		msg_log.Write("[Dump]Load OK|%u|%d|%d", m_dwGen, count, delta_count);
+	}
+	else
+	{
+		err_log.Write("[Dump]No data loaded!");
+	}
+	return 0;
+}
+
+int CDumpProcCenter::LoadFile(const string& sLoadPath, bool bDelta)
+{
 	ifstream fin(sLoadPath.c_str(), ios::in);
 	if (!fin)
 	{
@@ -67,12 +115,31 @@ int CDumpProcCenter::LoadData()
 	string attrname;
 	int value_size = 1440;
 	uint32_t value_array[1440];
+	char data[value_fixed_len];
 
 	msec::monitor::ReqReport req;
 	int ret = 0;
 	int count = 0;
+	bool first = true;
 	while (getline(fin, line))
 	{
+		if (first)
+		{
+			first = false;
+			if (line.compare(0, strlen(DUMP_GEN_HEAD), DUMP_GEN_HEAD) == 0)
+			{
+				uint32_t gen = strtoul(line.c_str() + strlen(DUMP_GEN_HEAD), NULL, 10);
+				if (bDelta && gen != m_dwGen)	//ȫд, 
+				{
+					msg_log.Write("[Dump]Skip stale delta|%u|%u", gen, m_dwGen);
+					break;
+				}
+				continue;
+			}
+			if (bDelta)		//
+				break;
+		}
+
 		stringstream sstream;
 		
 		ip = ReadEscapedString(line);
@@ -89,13 +156,9 @@ int CDumpProcCenter::LoadData()
 
 		int i = 0;
 		int got = 0;
-
-		req.Clear();
-		msec::monitor::Attr* attr = req.add_attrs();
 		for (i=0; i<value_size; ++i)
 		{
 			sstream >> value_array[i];
-			attr->add_values(value_array[i]);
 			if (sstream.fail())
 				break;
 			++got;
@@ -104,6 +167,32 @@ int CDumpProcCenter::LoadData()
 		if (got != value_size)
 			continue;
 
+		//ļǽڵֵ, дۼ, ۵ڴеĲ(ͬһڵпֶܳ)
+		uint32_t attr_id = CAttrIdMgr::GetInstance().Find(svcname, attrname);
+		if (attr_id != ATTR_ID_NONE)
+		{
+			int data_len = sizeof(data);
+			string key(CAttrIdMgr::DataKey(attr_id, tce::InetAtoN(ip), day));
+			if (DataShm.GetNode(key, data, data_len) == 0
+				&& data_len == value_fixed_len)
+			{
+				uint32_t* cur = (uint32_t*)&data[256];
+				for (i=0; i<value_size; ++i)
+					value_array[i] -= cur[i];
+			}
+		}
+
+		req.Clear();
+		msec::monitor::Attr* attr = req.add_attrs();
+		bool changed = false;
+		for (i=0; i<value_size; ++i)
+		{
+			attr->add_values(value_array[i]);
+			changed = changed || value_array[i] != 0;
+		}
+		if (!changed)
+			continue;
+
 		string sTime = tce::ToStr(day) + "000000";
 		time_t tBeginTime = tce::GetDateTime(sTime);
 		attr->set_servicename(svcname);
@@ -123,21 +212,31 @@ int CDumpProcCenter::LoadData()
 		}
 	}
 	fin.close();
+	return count;
+}
 
-	if (count > 0)
-	{
-		msg_log.Write("[Dump]Load OK|%u", count);
-	}
-	else
+bool CDumpProcCenter::Start()
+{
+	if (m_dwDeltaInterval > 0)
 	{
-		err_log.Write("[Dump]No data loaded!");
+		//ǰδд޸޴ӵ֪, һȫ, ֻ֮д
+		m_bTrackDirty = true;
+		m_bDumpOn = true;
 	}
-	return 0;
+	m_oTraverseThread.Start(this);
+	return true;
 }
 
-bool CDumpProcCenter::Start()
+bool CDumpProcCenter::Stop()
 {
-	m_oTraverseThread.Start(this);
+	m_bTraverseProcessRun = false;
+	m_oTraverseThread.Stop();
+	//˳ǰʣ޸д
+	if (m_bTrackDirty)
+	{
+		DeltaProcess();
+		m_bTrackDirty = false;
+	}
 	return true;
 }
 
@@ -147,13 +246,33 @@ int32_t CDumpProcCenter::TraverseThread(void* pParam)
 	if ( NULL != poThis )
 	{
 	       poThis->m_bTraverseProcessRun = true;
+		time_t last_delta = time(NULL);
+		time_t retry_at = 0;	//ȫʧܺʱ, 0ʾҪ
+		uint32_t retry_interval = poThis->m_dwDeltaInterval > 0 ? poThis->m_dwDeltaInterval : DUMP_RETRY_INTERVAL;
 		while (poThis->m_bTraverseProcessRun)
 		{
-			if (poThis->m_bDumpOn)
+			bool full_ok = false;
+			if (poThis->m_bDumpOn || (retry_at != 0 && time(NULL) >= retry_at))
 			{
 				msg_log.Write("[Dump]Dump Begins.");
-				poThis->TraverseProcess();
 				poThis->m_bDumpOn = false;
+				if (poThis->TraverseProcess() == 0)
+				{
+					retry_at = 0;
+					full_ok = true;
+					last_delta = time(NULL);
+				}
+				else if (poThis->m_bTraverseProcessRun)
+				{
+					err_log.Write("[Dump]Full dump failed, retry in %u seconds", retry_interval);
+					retry_at = time(NULL) + retry_interval;
+				}
+			}
+			//ȫʧʱԭеȻЧ, ճд
+			if (!full_ok && poThis->m_dwDeltaInterval > 0 && time(NULL) - last_delta >= (time_t)poThis->m_dwDeltaInterval)
+			{
+				poThis->DeltaProcess();
+				last_delta = time(NULL);
 			}
 			tce::xsleep(1000);
 		}
@@ -162,20 +281,95 @@ int32_t CDumpProcCenter::TraverseThread(void* pParam)
 	return 0;
 }
 
+void CDumpProcCenter::WriteLine(ostream& out, uint32_t dwIP, uint32_t dwDay, const char* pData)
+{
+	string svcname(pData, strnlen(pData, 128));
+	string attrname(pData + 128, strnlen(pData + 128, 128));
+
+	EscapeForBlank(svcname);
+	EscapeForBlank(attrname);
+	out << tce::InetNtoA(dwIP) << " " 
+		<< dwDay << " "
+		<< svcname << " " 
+		<< attrname;
+
+	const char* ptr = pData + 256;
+	for (int i=0; i< 1440; ++i)
+	{
+		out << " " << *(uint32_t*)(ptr+i*4);
+	}
+	out << endl;
+}
+
+void CDumpProcCenter::TakeDirty(std::vector<string>& vKeys)
+{
+	for (int i = 0; i < DUMP_DIRTY_SHARDS; ++i)
+	{
+		std::tr1::unordered_set<string> keys;
+		{
+			tce::CAutoLock lock(m_astDirty[i].lock);
+			keys.swap(m_astDirty[i].keys);
+		}
+		vKeys.insert(vKeys.end(), keys.begin(), keys.end());
+	}
+}
+
+//dumpʧʱȡkeyŻ, һȫ
+void CDumpProcCenter::PutDirty(const std::vector<string>& vKeys)
+{
+	for (size_t i = 0; i < vKeys.size(); ++i)
+	{
+		SDirtyShard& shard = m_astDirty[(uint8_t)vKeys[i][0] % DUMP_DIRTY_SHARDS];
+		tce::CAutoLock lock(shard.lock);
+		shard.keys.insert(vKeys[i]);
+	}
+}
+
+bool CDumpProcCenter::ResetDelta()
+{
+	ofstream fout(m_sDeltaPath.c_str(), ios::out | ios::trunc);
+	if (!fout)
+	{
+		err_log << "Open file failed: " << m_sDeltaPath << endl;
+		m_bDeltaReady = false;
+		return false;
+	}
+	fout << DUMP_GEN_HEAD << m_dwGen << endl;
+	fout.close();
+	m_bDeltaReady = !fout.fail();
+	return m_bDeltaReady;
+}
+
+//ȫdump, ͬʱΪcompaction
 int32_t CDumpProcCenter::TraverseProcess()
 {
 	int ret = 0;
 	uint32_t numeric_ip;
 	uint32_t day;
 	int dump_cnt = 0;
+	uint32_t gen = m_dwGen + 1;
+	tce::CTimeCost tc;
+
+	//˺޸ļһ, ֮ǰ޸ɱȡ
+	//ʧʱԭеȫȻЧ, ȡkeyŻ, ճ
+	bool delta_ready = m_bDeltaReady;
+	std::vector<string> taken;
+	if (m_bTrackDirty)
+	{
+		m_bDeltaReady = false;
+		TakeDirty(taken);
+	}
 
 	string sDumpPathNew = m_sDumpPath + ".new";
 	ofstream fout(sDumpPathNew.c_str(), ios::out);
 	if (!fout)
 	{
-		err_log << "Open file failed: " << m_sDumpPath << endl;
+		err_log << "Open file failed: " << sDumpPathNew << endl;
+		PutDirty(taken);
+		m_bDeltaReady = delta_ready;
 		return -1;
 	}
+	fout << DUMP_GEN_HEAD << gen << endl;
 
 	MhtIterator it;
 	MhtData* data = new MhtData();
@@ -194,34 +388,19 @@ int32_t CDumpProcCenter::TraverseProcess()
 			break;
 		}
 
-		//KeyFormat: MD5(svc + 0x03 + attr) + [ dwIP ] + dwDay
-		//MD5 length: 16 byte
+		//KeyFormat: dwAttrId + [ dwIP ] + dwDay
+		//dwAttrId: 4 byte
 		//dwIP: 	   4 byte
 		//dwDay:  4byte
-		if (data->klen != 24)  //ûIPĹ˵
+		if (data->klen != 12)  //ûIPĹ˵
 			continue;
 
-		memcpy(&numeric_ip, data->key + 16, sizeof(numeric_ip));
-		memcpy(&day, data->key + 20, sizeof(day));
+		memcpy(&numeric_ip, data->key + 4, sizeof(numeric_ip));
+		memcpy(&day, data->key + 8, sizeof(day));
 
 		if(data->dlen == value_fixed_len)
 		{		
-			string svcname = (char*)&data->data[0];
-			string attrname = (char*)&data->data[128];
-
-			EscapeForBlank(svcname);
-			EscapeForBlank(attrname);
-			fout << tce::InetNtoA(numeric_ip) << " " 
-				<< day << " "
-				<< svcname << " " 
-				<< attrname;
-
-			char* ptr = (char*)&data->data[256];
-			for (int i=0; i< 1440; ++i)
-			{
-				fout << " " << *(uint32_t*)(ptr+i*4);
-			}
-			fout << endl;
+			WriteLine(fout, numeric_ip, day, (char*)&data->data[0]);
 
 			++dump_cnt;
 			if (dump_cnt % 10000 == 0)   tce::xsleep(500);
@@ -230,7 +409,75 @@ int32_t CDumpProcCenter::TraverseProcess()
 	delete data;
 
 	fout.close();
-	rename(sDumpPathNew.c_str(), m_sDumpPath.c_str()); //Rename dump file
+	//;˳дʧʱԭеȫ
+	if (!m_bTraverseProcessRun || ret != 0 || fout.fail()
+		|| rename(sDumpPathNew.c_str(), m_sDumpPath.c_str()) != 0)
+	{
+		err_log << "Write file failed: " << sDumpPathNew << endl;
+		unlink(sDumpPathNew.c_str());
+		PutDirty(taken);
+		m_bDeltaReady = delta_ready;
+		return -1;
+	}
+	m_dwGen = gen;
+	msg_log.Write("[Dump]Full dump OK|%u|%d|%lu", gen, dump_cnt, tc.value());
+	//ȫѻ, ؽʧʱֻһȫ
+	if (m_dwDeltaInterval > 0 && !ResetDelta())
+		return -1;
+	return 0;
+}
+
+//ֻд޸Ĺipڵ, I/O޸
+int32_t CDumpProcCenter::DeltaProcess()
+{
+	if (!m_bDeltaReady)
+		return 0;
+
+	std::vector<string> keys;
+	TakeDirty(keys);
+	if (keys.empty())
+		return 0;
+
+	tce::CTimeCost tc;
+	ofstream fout(m_sDeltaPath.c_str(), ios::out | ios::app);
+	if (!fout)
+	{
+		err_log << "Open file failed: " << m_sDeltaPath << endl;
+		PutDirty(keys);
+		m_bDumpOn = true;	//ļ, ȫ
+		return -1;
+	}
+
+	uint32_t numeric_ip;
+	uint32_t day;
+	int dump_cnt = 0;
+	char data[value_fixed_len];
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		int data_len = sizeof(data);
+		int ret = DataShm.GetNode(keys[i], data, data_len);
+		if (ret != 0 || data_len != value_fixed_len)	//ѱ̭
+			continue;
+
+		memcpy(&numeric_ip, keys[i].data() + 4, sizeof(numeric_ip));
+		memcpy(&day, keys[i].data() + 8, sizeof(day));
+		WriteLine(fout, numeric_ip, day, data);
+		++dump_cnt;
+	}
+	fout.close();
+	if (fout.fail())
+	{
+		err_log << "Write file failed: " << m_sDeltaPath << endl;
+		PutDirty(keys);
+		m_bDumpOn = true;
+		return -1;
+	}
+
+	//ʱдȫ, Ƽʱطŵ
+	off_t delta_size = FileSize(m_sDeltaPath);
+	if (delta_size > FileSize(m_sDumpPath) / 100 * m_dwCompactRatio)
+		m_bDumpOn = true;
+	msg_log.Write("[Dump]Delta OK|%u|%lu|%d|%ld|%lu", m_dwGen, keys.size(), dump_cnt, (long)delta_size, tc.value());
 	return 0;
 }
 
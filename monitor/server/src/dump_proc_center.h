@@ -23,13 +23,29 @@
 #include "tce.h"
 #include "tce_singleton.h"
 #include "tce_thread.h"
+#include "tce_lock.h"
 #include "monitor.pb.h"
 #include "data.pb.h"
 #include "shm_mgr.h"
 
+#include <vector>
+#include <tr1/unordered_set>
+
 extern CShmMgr ServiceShm;
 extern CShmMgr DataShm;
 
+/*
+ * dumpļ:
+ *   ȫ  m_sDumpPath          SIGUSR1ʱд(compaction)
+ *     m_sDumpPath.delta    ÿdwDeltaInterval׷ӱ޸Ĺipڵ()
+ * ļж"#gen N", ʱֻطȫͬ
+ * һǽڵֵ, طʱڴеֵд, ȫͼ֮
+ */
+#define DUMP_GEN_HEAD		"#gen "
+#define DUMP_DELTA_SUFFIX	".delta"
+#define DUMP_DIRTY_SHARDS	16
+#define DUMP_RETRY_INTERVAL	60		//ȫʧܺԼ(), ʱȡ
+
 class CDumpProcCenter
 	: tce::CNonCopyAble
 {
@@ -38,16 +54,23 @@ public:
 
 public:
 	~CDumpProcCenter();
-	bool Init(const string& sDumpPath);
+	//dwDeltaIntervalΪ0ʱdump; dwCompactRatio: ļȫİٷֱʱдȫ
+	bool Init(const string& sDumpPath, uint32_t dwDeltaInterval = 0, uint32_t dwCompactRatio = 50);
 	bool Start();
-	bool Stop(){
-		m_bTraverseProcessRun = false;
-		m_oTraverseThread.Stop();
-		return true;
-	}
+	bool Stop();
 
 	void SetDumpOn() { m_bDumpOn = true; }
 
+	//ipάȵDataShmڵ㱻޸, һdumpʱд; ֻStart֮¼
+	void MarkDirty(const string& Key)
+	{
+		if (!m_bTrackDirty || Key.size() != 12)
+			return;
+		SDirtyShard& shard = m_astDirty[(uint8_t)Key[0] % DUMP_DIRTY_SHARDS];	//ֽΪIDλ
+		tce::CAutoLock lock(shard.lock);
+		shard.keys.insert(Key);
+	}
+
 	int LoadData();
 
 private:
@@ -55,6 +78,14 @@ private:
 	
 	static int32_t TraverseThread(void* pParam);
 	int32_t TraverseProcess();
+	int32_t DeltaProcess();
+	int LoadFile(const string& sPath, bool bDelta);
+	void WriteLine(ostream& out, uint32_t dwIP, uint32_t dwDay, const char* pData);
+	bool ResetDelta();
+	void TakeDirty(std::vector<string>& vKeys);
+	void PutDirty(const std::vector<string>& vKeys);
+	static uint32_t ReadGen(const string& sPath);
+	static off_t FileSize(const string& sPath);
 
 	string ReadEscapedString(string& str);
 	void EscapeForBlank(string& str);
@@ -66,8 +97,21 @@ private:
 	THREAD m_oTraverseThread;
 
 	volatile bool m_bTraverseProcessRun;
-	bool  m_bDumpOn;
+	volatile bool m_bDumpOn;
+	volatile bool m_bTrackDirty;
+	bool m_bDeltaReady;				//ļѰǰؽ
 	string m_sDumpPath;
+	string m_sDeltaPath;
+	uint32_t m_dwDeltaInterval;
+	uint32_t m_dwCompactRatio;
+	uint32_t m_dwGen;				//ȫļĴ
+
+	struct SDirtyShard
+	{
+		tce::CMutex lock;
+		std::tr1::unordered_set<string> keys;
+	};
+	SDirtyShard m_astDirty[DUMP_DIRTY_SHARDS];
 };
 
 #endif
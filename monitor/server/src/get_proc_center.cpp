@@ -19,6 +19,8 @@
 
 #include "get_proc_center.h"
 #include "judge_proc_center.h"
+#include "shm_index.h"
+#include "attr_id.h"
 
 #include "log_def.h"
 #include "proc_def.h"
@@ -48,6 +50,7 @@ bool CGetProcCenter::Init(void)
 {
 	//̳߳ش
 	try{
+		m_pool.set_queue_capacity(stConfig.dwThreadQueueSize);
 		m_pool.start(stConfig.dwThreadPoolSize, GetPoolInit);
 	}catch(std::runtime_error& e)
 	{
@@ -59,16 +62,35 @@ bool CGetProcCenter::Init(void)
 
 int CGetProcCenter::SendRespPkg(tce::SSession& stSession, msec::monitor::RespMonitor& Pkg)
 {
-	string sData;
-	if ( !Pkg.SerializeToString(&sData) )
+	//ֱлͶԤĿռ, ʡмstringĿ
+	if ( !Pkg.IsInitialized() )
 	{
-		err_log << "[Get]Failed to serialize to string!" << endl;
+		err_log << "[Get]Failed to serialize pkg!" << endl;
 		return -2;
 	}
+	const int iSize = Pkg.ByteSize();
 	
+	//߳дԼĻذ, ʱ˻ؼд
+	int iWorker = wbl::thread_pool::get_thread_index();
+	if ( iWorker >= 0 )
+	{
+		char* pBuf = tce::CCommMgr::GetInstance().ReserveWriteByWorker(iWorker, stSession, iSize);
+		if ( NULL != pBuf )
+		{
+			Pkg.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(pBuf));
+			if ( tce::CCommMgr::GetInstance().CommitWriteByWorker(iWorker, stSession, iSize) )
+				return 0;
+		}
+	}
+
 	{
 		tce::CAutoLock lock(lock_write);
-		if ( !tce::CCommMgr::GetInstance().Write(stSession, sData.data(), sData.size()) )
+		char* pBuf = tce::CCommMgr::GetInstance().ReserveWrite(stSession, iSize);
+		if ( NULL != pBuf )
+		{
+			Pkg.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(pBuf));
+		}
+		if ( NULL == pBuf || !tce::CCommMgr::GetInstance().CommitWrite(stSession, iSize) )
 		{
 			err_log.Write("[Get]Send pkg back failed! ip: %s, port: %u", stSession.GetIPByStr().c_str(), stSession.GetPort());
 			return -2;
@@ -94,12 +116,12 @@ int CGetProcCenter::GetValueData(const string& servicename, const string& attrna
 		}
 	}
 	
-	string key(servicename); 
-	key.append(1u,0x3).append(attrname);
-	string skey(tce::TC_MD5::md5bin(key));	//md5 + dayvalue
-	if(!ip.empty())
-		skey.append((char*)&numeric_ip, sizeof(uint32_t));
-	skey.append((char*)&day, sizeof(uint32_t));
+	uint32_t attr_id = CAttrIdMgr::GetInstance().Find(servicename, attrname);
+	if(attr_id == ATTR_ID_NONE)
+	{
+		return -3;
+	}
+	string skey(CAttrIdMgr::DataKey(attr_id, numeric_ip, day));
 
 	int ret = DataShm.GetNode(skey, &data[0], data_len);
 	if(ret != 0)
@@ -112,12 +134,6 @@ int CGetProcCenter::GetValueData(const string& servicename, const string& attrna
 	
 	if(data_len == value_fixed_len)
 	{
-		if(strcmp(&data[0], servicename.c_str()) || strcmp(&data[128],attrname.c_str()))
-		{				
-			err_log.Write("[Get]Key not match|%s|%s|%s|%s|%s|%u", &data[0], &data[128],
-				servicename.c_str(), attrname.c_str(), ip.c_str(), day);
-			return -4;
-		}
 		memcpy(valuedata, &data[256], 1440*4);
 	}
 	else
@@ -134,80 +150,35 @@ int CGetProcCenter::ProcService(tce::SSession& stSession, std::tr1::shared_ptr<m
 	int result = 100;
 	ostringstream str;
 	msec::monitor::RespMonitor resp;
-	char data[128 * 1024];
-	int data_len = sizeof(data);
 	
 	str << "Service|" << Pkg->service().servicename();
-	string skey = tce::TC_MD5::md5bin(Pkg->service().servicename());
 	msec::monitor::RespService* service = resp.mutable_service();
 	//ȡϱ
 	CJudgeProcCenter::GetInstance().ProcServiceAlarmAttr(service, Pkg->service().servicename());
 	str<< service->alarmattrs_size() << "|";
 
 	
-	int ret = ServiceShm.GetNode(skey, &data[0], data_len);
-	if( ret != 0)
-	{
-		err_log.Write("[Get]GetNode ServiceShm failed!|%s|%d|%s", Pkg->service().servicename().c_str(), ret, ServiceShm.GetErrorMsg());
+	//밴Ĺ˶ȡ
+	vector<uint32_t> days(Pkg->service().days().begin(), Pkg->service().days().end());
+	vector<string> attrs;
+	vector<uint32_t> ips;
+	int ret = CShmIndex::GetInstance().GetService(Pkg->service().servicename(), days, attrs, ips);
+	if( ret < 0)
+	{
+		err_log.Write("[Get]GetService from index failed!|%s|%d", Pkg->service().servicename().c_str(), ret);
 		result = 101;
 	}
 	else
 	{
-		msec::monitor::data::ServiceData servicedata;		//Service - 
-		if(data_len > 0)
+		for(size_t i = 0; i < attrs.size(); i++)
 		{
-			if(!servicedata.ParseFromArray(data, data_len))
-			{
-				err_log.Write("[Get]Parse from ServiceShm failed!|%s", Pkg->service().servicename().c_str());
-				result = 102;
-			}
-			else
-			{
-				//ٴμǷһ
-				if(servicedata.servicename() != Pkg->service().servicename())
-				{
-					err_log.Write("[Get]ServiceShm key not match!|%s|%s", Pkg->service().servicename().c_str(), servicedata.servicename().c_str());
-					result = 102;
-				}
-				else
-				{
-					for(int i = 0; i < servicedata.attrs_size(); i++)
-					{
-						bool Add = true;
-						if(Pkg->service().days_size() > 0)
-						{
-							Add = false;
-							string key(Pkg->service().servicename()); 
-							key.append(1u,0x3).append(servicedata.attrs(i).name());
-							string skey(tce::TC_MD5::md5bin(key));	//md5 + dayvalue
-							skey.append(4u,0);	//ӿλ
-							for(int j = 0; j < Pkg->service().days_size(); j++)
-							{
-								uint32_t day = Pkg->service().days(j);
-								skey.replace(skey.end()-4, skey.end(), (char*)&day, sizeof(uint32_t));
-								if(DataShm.HasKey(skey))
-								{
-									Add = true;
-									break;
-								}
-							}
-						}
-						if(Add)	
-							service->add_attrnames(servicedata.attrs(i).name());
-					}
-					for(int i = 0; i < servicedata.ips_size(); i++)
-					{
-						service->add_ips(tce::InetNtoA(servicedata.ips(i).ip()));
-					}
-					
-					result = 0;
-				}
-			}
+			service->add_attrnames(attrs[i]);
 		}
-		else
+		for(size_t i = 0; i < ips.size(); i++)
 		{
-			result = 0;
+			service->add_ips(tce::InetNtoA(ips[i]));
 		}
+		result = 0;
 	}
 
 	resp.set_result(result);
@@ -291,8 +262,6 @@ int CGetProcCenter::ProcIP(tce::SSession& stSession, std::tr1::shared_ptr<msec::
 	int result = 100;
 	ostringstream str;
 	msec::monitor::RespMonitor resp;
-	char data[128 * 1024];
-	int data_len = sizeof(data);
 
 	str << "IP|";
 	
@@ -305,65 +274,30 @@ int CGetProcCenter::ProcIP(tce::SSession& stSession, std::tr1::shared_ptr<msec::
 	else
 	{
 		str << Pkg->ip().ip() << "|";
-		string key( (char*)&ip, sizeof(uint32_t));			
-		int ret = ServiceShm.GetNode(key, &data[0], data_len);
-		if( ret != 0)
+		vector<uint32_t> days(Pkg->ip().days().begin(), Pkg->ip().days().end());
+		vector<pair<string, vector<string> > > services;
+		int ret = CShmIndex::GetInstance().GetIP(ip, days, services);
+		if( ret < 0)
 		{
-			err_log.Write("[Get]GetNode ServiceShm failed!|%s|%d|%s", Pkg->ip().ip().c_str(), ret, ServiceShm.GetErrorMsg());
+			err_log.Write("[Get]GetIP from index failed!|%s|%d", Pkg->ip().ip().c_str(), ret);
 			result = 102;
 		}
 		else
 		{
-			
-			msec::monitor::data::IPData ipdata; 	//IP - 
-			if(data_len > 0)
+			result = 0;
+			if(!services.empty())
 			{
-				if(!ipdata.ParseFromArray(data, data_len))
+				msec::monitor::RespIP* respip = resp.mutable_ip();
+				for(size_t i = 0; i < services.size(); i++)
 				{
-					err_log.Write("[Get]Parse from ServiceShm failed!|%s", Pkg->ip().ip().c_str());
-					result = 103;
-				}
-				else
-				{
-					result = 0;
-					msec::monitor::RespIP* respip = resp.mutable_ip();
-					for(int i = 0; i < ipdata.services_size(); i++)
+					msec::monitor::IPData* data = respip->add_data();
+					data->set_servicename(services[i].first);
+					for(size_t j = 0; j < services[i].second.size(); j++)
 					{
-						msec::monitor::IPData* data = respip->add_data();
-						data->set_servicename(ipdata.services(i).servicename());
-						for(int j = 0; j < ipdata.services(i).attrs_size(); j++)
-						{
-							bool Add = true;
-							if(Pkg->ip().days_size() > 0)
-							{
-								Add = false;
-								string key(ipdata.services(i).servicename()); 
-								key.append(1u,0x3).append(ipdata.services(i).attrs(j).name());
-								
-								string skey(tce::TC_MD5::md5bin(key));	//md5 + dayvalue
-								skey.append((char*)&ip, sizeof(uint32_t));
-								skey.append(4u,0);	//ӿλ
-								for(int k 	= 0; k < Pkg->ip().days_size(); k++)
-								{
-									uint32_t day = Pkg->ip().days(k);
-									skey.replace(skey.end()-4, skey.end(), (char*)&day, sizeof(uint32_t));
-									if(DataShm.HasKey(skey))
-									{
-										Add = true;
-										break;
-									}
-								}
-							}
-							if(Add)
-								data->add_attrnames(ipdata.services(i).attrs(j).name());
-						}
-					}						
+						data->add_attrnames(services[i].second[j]);
+					}
 				}
 			}
-			else
-			{
-				result = 0;
-			}
 		}
 	}
 
@@ -632,16 +566,22 @@ int CGetProcCenter::ProcTreeList(tce::SSession& stSession, std::tr1::shared_ptr<
 
 	msec::monitor::RespTreeList* resptreelist = resp.mutable_treelist();
  	tce::ReadLocker rl(lock_treelist);
-	set<string> keys;
-	ServiceShm.GetKeys(keys);
-	for(set<string>::iterator it = keys.begin(); it != keys.end(); it++)	
+	vector<string> services;
+	if(CShmIndex::GetInstance().GetServiceList(services) != 0)
+	{
+		//бڵ㱻̭ʱ˻ڴеkey
+		set<string> keys;
+		ServiceShm.GetKeys(keys);
+		services.assign(keys.begin(), keys.end());
+	}
+	for(size_t i = 0; i < services.size(); i++)
 	{
 		msec::monitor::TreeListInfo* info = resptreelist->add_infos();
-		info->set_servicename(*it);
+		info->set_servicename(services[i]);
 	}	
 
 	resp.set_result(result);
-	msg_log.Write("[Get]TreeList|%d|%d|%lu", keys.size(), result, tc.value());
+	msg_log.Write("[Get]TreeList|%d|%d|%lu", services.size(), result, tc.value());
 
 	return SendRespPkg(stSession, resp);
 }
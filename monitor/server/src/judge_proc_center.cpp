@@ -18,6 +18,8 @@
 
 
 #include "judge_proc_center.h"
+#include "alarm_sink.h"
+#include "attr_id.h"
 #include "get_proc_center.h"
 #include "log_def.h"
 #include "proc_def.h"
@@ -29,14 +31,19 @@
  
 CJudgeProcCenter::CJudgeProcCenter(void)
 	:alarm_attrs(new map<string, set<AttrKey> >),
+	judge_attr_num(0),
+	judge_index(new JudgeIndex),
 	judge_thread(&Judge),
 	run_judge(false)
-{}
+{
+	memset(judge_attrs, 0, sizeof(judge_attrs));
+}
 
 void CJudgeProcCenter::Stop()
 {
 	run_judge=false;
 	judge_thread.Stop();
+	CAlarmSink::GetInstance().Stop();
 }
 
 bool CJudgeProcCenter::Init(void)
@@ -46,6 +53,19 @@ bool CJudgeProcCenter::Init(void)
 		mysql_alarm.Init(stConfig.sAlarmDBHost, stConfig.sAlarmDBUser, stConfig.sAlarmDBPassword, stConfig.wAlarmDBPort);
 		mysql_alarm.use(stConfig.sAlarmDBName);
 		CheckAlarm();	//ȡһ
+
+		//澯дӺ߳, ж
+		CAlarmBackend* backend = NULL;
+		if(stConfig.sAlarmSinkType == "file")
+			backend = new CFileAlarmBackend(stConfig.sAlarmSinkFile);
+		else
+			backend = new CMySqlAlarmBackend(stConfig.sAlarmDBHost, stConfig.sAlarmDBUser, stConfig.sAlarmDBPassword, stConfig.wAlarmDBPort, stConfig.sAlarmDBName, stConfig.dwAlarmBatchSize);
+		if(!CAlarmSink::GetInstance().Init(backend, stConfig.dwAlarmBatchSize, stConfig.dwAlarmFlushInterval))
+		{
+			cout << "AlarmSink init failed." << endl;
+			err_log << "AlarmSink init failed." << endl;
+			return false;
+		}
 	}
 	catch(exception& e)
 	{
@@ -86,6 +106,7 @@ void CJudgeProcCenter::CheckAlarm()
 			}
 			}
 		alarm_attrs = attrs;
+		CompileRules(*attrs);
 		if(flag)
 			msg_log.Write("[Judge]Check OK|%u|%u", attrs->size(), updatetime);
 	}
@@ -95,6 +116,114 @@ void CJudgeProcCenter::CheckAlarm()
 	}
 }
 
+//Ϊı, ֻjudge߳(ʱ)
+void CJudgeProcCenter::CompileRules(const map<string, set<AttrKey> >& attrs)
+{
+	JudgeIndex* index = judge_index;
+	JudgeIndex* newindex = NULL;
+	vector<char> enabled(judge_attr_num, 0);
+
+	for(map<string, set<AttrKey> >::const_iterator it = attrs.begin(); it != attrs.end(); ++it)
+	{
+		for(set<AttrKey>::const_iterator itattr = it->second.begin(); itattr != it->second.end(); ++itattr)
+		{
+			uint32_t attr_id = CAttrIdMgr::GetInstance().Intern(itattr->ServiceName, itattr->AttrName);
+			if(attr_id == ATTR_ID_NONE)
+			{
+				err_log.Write("[Judge]Attr id failed|%s|%s", itattr->ServiceName.c_str(), itattr->AttrName.c_str());
+				continue;
+			}
+
+			const JudgeIndex* cur = newindex ? newindex : index;
+			JudgeIndex::const_iterator itindex = cur->find(attr_id);
+			uint32_t handle = 0;
+			if(itindex != cur->end())
+			{
+				handle = itindex->second;
+			}
+			else
+			{
+				if(judge_attr_num >= MAX_JUDGE_ATTR_BLOCK * JUDGE_ATTR_BLOCK_SIZE)
+				{
+					err_log.Write("[Judge]Attr full|%s|%s|%u", itattr->ServiceName.c_str(), itattr->AttrName.c_str(), judge_attr_num);
+					continue;
+				}
+				handle = judge_attr_num;
+				if(judge_attrs[handle / JUDGE_ATTR_BLOCK_SIZE] == NULL)
+					judge_attrs[handle / JUDGE_ATTR_BLOCK_SIZE] = new JudgeAttr[JUDGE_ATTR_BLOCK_SIZE];
+				JudgeAttr& attr = GetJudgeAttr(handle);
+				attr.ServiceName = itattr->ServiceName;
+				attr.AttrName = itattr->AttrName;
+				++judge_attr_num;
+				enabled.push_back(0);
+
+				if(newindex == NULL)
+					newindex = new JudgeIndex(*index);
+				(*newindex)[attr_id] = handle;
+			}
+
+			JudgeAttr& attr = GetJudgeAttr(handle);
+			attr.Max = itattr->Max;
+			attr.Min = itattr->Min;
+			attr.Diff = itattr->Diff;
+			attr.DiffP = itattr->DiffP;
+			enabled[handle] = 1;
+		}
+	}
+
+	//ɾĹ0, 
+	for(uint32_t i = 0; i < judge_attr_num; ++i)
+	{
+		if(!enabled[i])
+		{
+			JudgeAttr& attr = GetJudgeAttr(i);
+			attr.Max = attr.Min = attr.Diff = attr.DiffP = 0;
+		}
+	}
+
+	time_t now = time(NULL);
+	if(newindex != NULL)
+	{
+		__sync_synchronize();
+		judge_index = newindex;
+		retired_index.push_back(std::make_pair(now, index));
+		msg_log.Write("[Judge]Index|%u|%u", newindex->size(), judge_attr_num);
+	}
+	//ϱֻ߳ڲʱʹ, 滻һӺͷ
+	while(!retired_index.empty() && retired_index.front().first + 60 < now)
+	{
+		delete retired_index.front().second;
+		retired_index.pop_front();
+	}
+}
+
+uint32_t CJudgeProcCenter::DayNum(uint32_t Date)
+{
+	int y = Date / 10000;
+	uint32_t m = (Date % 10000) / 100;
+	uint32_t d = Date % 100;
+	y -= m <= 2;
+	uint32_t era = y / 400;
+	uint32_t yoe = y - era * 400;
+	uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe;
+}
+
+uint32_t CJudgeProcCenter::DayDate(uint32_t Num)
+{
+	uint32_t era = Num / 146097;
+	uint32_t doe = Num - era * 146097;
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint32_t y = yoe + era * 400;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+	uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+	uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+	y += m <= 2;
+	return y * 10000 + m * 100 + d;
+}
+
 uint32_t CJudgeProcCenter::getMinTime(uint32_t date, uint32_t min)
 {
 	if(date <= 20100000 || min >= 1440)
@@ -175,29 +304,34 @@ bool CJudgeProcCenter::CheckSetAlarmAttr(const string& ServiceName, const string
 	return true;
 }
 
+int32_t CJudgeProcCenter::FindJudgeAttr(uint32_t AttrId) const
+{
+	const JudgeIndex* index = judge_index;
+	JudgeIndex::const_iterator it = index->find(AttrId);
+	if(it == index->end())
+		return -1;
+	return (int32_t)it->second;
+}
+
 //dateʹyyyymmddʽ
-void CJudgeProcCenter::AddJudge(const string& ServiceName, const string& AttrName, uint32_t Date, uint32_t Minute, uint32_t Value)	
+void CJudgeProcCenter::AddJudge(int32_t Handle, uint32_t Date, uint32_t Minute)
 {
+	if(Handle < 0 || Date <= 20100000 || Minute >= 1440)
+		return;
 
-	JudgeKey judgekey;
-	judgekey.Key.ServiceName = ServiceName;
-	judgekey.Key.AttrName = AttrName;
-	map<string, set<AttrKey> >::iterator it = alarm_attrs->find(judgekey.Key.ServiceName);
-	if(it != alarm_attrs->end())
+	JudgeAttr& attr = GetJudgeAttr(Handle);
+	uint32_t slot = DayNum(Date) & 1;
+	uint32_t old = attr.Date[slot];
+	if(old != Date)
 	{
-		if(it->second.find(judgekey.Key) != it->second.end())
-		{
-			judgekey.Date = Date;
-			judgekey.Minute = Minute;
-			judgekey.MinTime = getMinTime(Date, Minute);
-			if(judgekey.MinTime != 0)
-			{
-				tce::CAutoLock lock(lock_judge);
-				judge_map[judgekey] = Value;
-			}
-			msg_log.Write("[Judge]Add|%s|%s|%u|%u|%u", ServiceName.c_str(), AttrName.c_str(), Date, Minute, Value);
-		}
+		if(old > Date)
+			return;		//Ȳڵ, ж
+		//λµһ, ǰλͼѱjudge߳ȡ
+		__sync_bool_compare_and_swap(&attr.Date[slot], old, Date);
+		if(attr.Date[slot] != Date)
+			return;
 	}
+	__sync_fetch_and_or(&attr.Dirty[slot][Minute >> 5], 1u << (Minute & 31));
 }
 
 //̣̱߳߳
@@ -213,131 +347,160 @@ int32_t CJudgeProcCenter::Judge(void* pParam)
 		{
 			Now = time(NULL);
 			uint32_t CurSec = Now % 60;
-			map<JudgeKey, uint32_t> JudgeSlice;
 			if(CurMin != Now/60 && CurSec > 35)	//ÿֻһΣ35Ϊmagic number
 			{
 				CurMin = Now/60;
 				poThis->CheckAlarm();
-				tce::CAutoLock lock(poThis->lock_judge);		//ȡݺͼ
-				map<JudgeKey, uint32_t>::iterator it;
-				for(it = poThis->judge_map.begin(); it != poThis->judge_map.end(); it++)
-				{
-					if(it->first.MinTime >= CurMin)
-						break;
-				}
-				if(it != poThis->judge_map.begin())
-				{
-					//insert, erase [first, last)
-					JudgeSlice.insert(poThis->judge_map.begin(),it);
-					poThis->judge_map.erase(poThis->judge_map.begin(),it);
-				}
+				tce::CTimeCost tc;
+				uint32_t days = poThis->JudgeAll();
+				msg_log.Write("[Judge]Calc|%u|%u|%u|%lu", CurMin, poThis->judge_attr_num, days, tc.value());
 			}
 
-			//
-			for(map<JudgeKey, uint32_t>::iterator it = JudgeSlice.begin(); it != JudgeSlice.end(); it++)
-			{
-				const JudgeKey& key = it->first;
-				map<string, set<AttrKey> >::iterator itattrmap = poThis->alarm_attrs->find(key.Key.ServiceName);
-				if(itattrmap != poThis->alarm_attrs->end())
-				{
-					set<AttrKey>::iterator itattr = itattrmap->second.find(key.Key);
-					if(itattr != itattrmap->second.end())
-					{
-						msg_log.Write("[Judge]Calc|%s|%s|%u|%u|%u", key.Key.ServiceName.c_str(), key.Key.AttrName.c_str(), CurMin, key.MinTime, it->second);
-						poThis->JudgeMax(key, it->second, itattr->Max);
-						poThis->JudgeMin(key, it->second, itattr->Min);
-						poThis->JudgeDiff(key, it->second, itattr->Diff, itattr->DiffP);
-					}
-				}
-			}
 			if(CurSec == 0)
-				msg_log.Write("[Judge]Size|%u|%u|%u", poThis->judge_map.size(), poThis->month_map.size(), poThis->mem_judge_map.size());
+				msg_log.Write("[Judge]Size|%u|%u", poThis->judge_attr_num, poThis->month_map.size());
 		    sleep(1);
 		}
 	}
 	return 0;
 }
 
-void CJudgeProcCenter::JudgeMax(const JudgeKey& Key, uint32_t Value, uint32_t Max)
+//ȡѽӵĸ±, ж, жϵ
+uint32_t CJudgeProcCenter::JudgeAll()
 {
-	if(Max != 0 && Value >= Max)
+	time_t Now = time(NULL);
+	struct tm timeinfo;
+	localtime_r( &Now, &timeinfo );
+	uint32_t Today = (timeinfo.tm_year+1900) * 10000 + (timeinfo.tm_mon + 1) * 100 + timeinfo.tm_mday;
+	uint32_t CurMinute = timeinfo.tm_hour * 60 + timeinfo.tm_min;
+
+	uint32_t days = 0;
+	uint32_t Minutes[JUDGE_MASK_WORDS];
+	for(uint32_t h = 0; h < judge_attr_num; ++h)
 	{
-		std::ostringstream str;
-		str << "insert into alarm(id, servicename, attrname, createtime, alarmtime, alarm_type, current_num, alarm_num) values (0, '"
-			<< mysql_alarm.escape_string(Key.Key.ServiceName) << "', '"
-			<< mysql_alarm.escape_string(Key.Key.AttrName) 
- 			<< "', NOW(), FROM_UNIXTIME(" << Key.MinTime*60 << "), 1, "	//type =1, max
- 			<< Value << ", "
- 			<< Max << ")";
-		try{
-			const monitor::MySqlData& data = mysql_alarm.query(str.str());
-			if(data.auto_id() != 0)
+		JudgeAttr& attr = GetJudgeAttr(h);
+		for(int slot = 0; slot < 2; ++slot)
+		{
+			uint32_t Date = attr.Date[slot];
+			if(Date == 0 || Date > Today)
+				continue;
+
+			//ֻжѾķ
+			uint32_t Limit = Date < Today ? 1440 : CurMinute;
+			bool Found = false;
+			for(uint32_t w = 0; w < JUDGE_MASK_WORDS; ++w)
 			{
-				msg_log.Write("[Judge]Alarm|Max|%s|%s|%u|%u|%u", Key.Key.ServiceName.c_str(), Key.Key.AttrName.c_str(), Key.MinTime, Value, Max);
+				uint32_t Mask = 0;
+				if(Limit >= (w + 1) * 32)
+					Mask = 0xffffffff;
+				else if(Limit > w * 32)
+					Mask = (1u << (Limit - w * 32)) - 1;
+
+				Minutes[w] = 0;
+				if(Mask & attr.Dirty[slot][w])
+				{
+					Minutes[w] = __sync_fetch_and_and(&attr.Dirty[slot][w], ~Mask) & Mask;
+					Found = Found || Minutes[w] != 0;
+				}
+			}
+
+			if(Found && (attr.Max != 0 || attr.Min != 0 || attr.Diff != 0 || attr.DiffP != 0))
+			{
+				JudgeDay(attr, Date, Minutes);
+				++days;
 			}
-		}
-		catch(std::runtime_error& e)
-		{
-			err_log.Write("[Judge]Alarm|Max|ERR|%s|%s|%u|%u|%u|%s", Key.Key.ServiceName.c_str(), Key.Key.AttrName.c_str(), Key.MinTime, Value, Max, e.what());
 		}
 	}
+	return days;
 }
 
-void CJudgeProcCenter::JudgeMin(const JudgeKey& Key, uint32_t Value, uint32_t Min)
+//һ1440ֵһȡ, 32һαȽֵ, иµķ
+uint32_t CJudgeProcCenter::JudgeDay(JudgeAttr& Attr, uint32_t Date, const uint32_t* Minutes)
 {
-	if(Min != 0 && Value <= Min)
+	uint32_t Values[1440];
+	int ret = CGetProcCenter::GetInstance().GetValueData(Attr.ServiceName, Attr.AttrName, "", Date, (char*)Values);
+	if(ret != 0)
+		return 0;
+
+	bool Diff = (Attr.Diff != 0 || Attr.DiffP != 0);
+	if(Diff)
 	{
-		std::ostringstream str;
-		str << "insert into alarm(id, servicename, attrname, createtime, alarmtime, alarm_type, current_num, alarm_num) values (0, '"
-			<< mysql_alarm.escape_string(Key.Key.ServiceName) << "', '"
-			<< mysql_alarm.escape_string(Key.Key.AttrName) 
- 			<< "', NOW(), FROM_UNIXTIME(" << Key.MinTime*60 << "), 2, "	//type = 2, min
- 			<< Value << ", "
- 			<< Min << ")";
-		try{
-			const monitor::MySqlData& data = mysql_alarm.query(str.str());
-			if(data.auto_id() != 0)
-			{
-				msg_log.Write("[Judge]Alarm|Min|%s|%s|%u|%u|%u", Key.Key.ServiceName.c_str(), Key.Key.AttrName.c_str(), Key.MinTime, Value, Min);
-			}
-		}
-		catch(std::runtime_error& e)
+		uint32_t PreDate = DayDate(DayNum(Date) - 1);
+		if(Attr.PreDate != PreDate)
 		{
-			err_log.Write("[Judge]Alarm|Min|ERR|%s|%s|%u|%u|%u|%s", Key.Key.ServiceName.c_str(), Key.Key.AttrName.c_str(), Key.MinTime, Value, Min, e.what());
+			char data[1440*4];
+			Attr.PreDate = PreDate;
+			ret = CGetProcCenter::GetInstance().GetValueData(Attr.ServiceName, Attr.AttrName, "", PreDate, data);
+			msg_log.Write("[Judge]MemAdd|%s|%s|%u|%u", Attr.ServiceName.c_str(), Attr.AttrName.c_str(), Date, PreDate);
+			if(ret != 0)
+				Attr.PreData.clear();	//Ϊ
+			else
+				Attr.PreData.assign(data, 1440*4);
 		}
+		Diff = !Attr.PreData.empty();
 	}
-}
 
-void CJudgeProcCenter::JudgeDiff(const JudgeKey& Key, uint32_t Value, uint32_t Diff, uint32_t DiffP)
-{
-	if(Diff != 0)
+	uint32_t alarms = 0;
+	JudgeKey key;
+	key.Key.ServiceName = Attr.ServiceName;
+	key.Key.AttrName = Attr.AttrName;
+	key.Date = Date;
+	for(uint32_t w = 0; w < JUDGE_MASK_WORDS; ++w)
 	{
-		JudgeKey preKey = Key;
-		preKey.MinTime -= 1440+Key.Minute;	//һ
+		if(Minutes[w] == 0)
+			continue;
 
-		map<JudgeKey, string>::iterator it = mem_judge_map.find(preKey);
-		if(it == mem_judge_map.end())
+		const uint32_t* v = &Values[w * 32];
+		uint32_t MaxHit = 0;
+		uint32_t MinHit = 0;
+		for(uint32_t k = 0; k < 32; ++k)
 		{
-			static char data[1440*4];
-			int ret = CGetProcCenter::GetInstance().GetValueData(preKey.Key.ServiceName, preKey.Key.AttrName, "", getDay(preKey.MinTime * 60), data);
-			msg_log.Write("[Judge]MemAdd|%u|%u|%u", Key.Date, preKey.MinTime, getDay(preKey.MinTime * 60));
-			if( ret != 0)
-				mem_judge_map[preKey] = "";	//Ϊ
-			else
-			{
-				string s(data, 1440*4);
-				mem_judge_map[preKey] =s;
-				JudgeDiffCalc(Key, Value, s, Diff, DiffP);
-			}
+			MaxHit |= (uint32_t)(v[k] >= Attr.Max) << k;
+			MinHit |= (uint32_t)(v[k] <= Attr.Min) << k;
 		}
-		else
+		MaxHit = Attr.Max != 0 ? MaxHit & Minutes[w] : 0;
+		MinHit = Attr.Min != 0 ? MinHit & Minutes[w] : 0;
+		uint32_t DiffHit = Diff ? Minutes[w] : 0;
+
+		uint32_t Todo = MaxHit | MinHit | DiffHit;
+		while(Todo != 0)
 		{
-			JudgeDiffCalc(Key, Value, it->second, Diff, DiffP);
+			uint32_t k = __builtin_ctz(Todo);
+			uint32_t bit = 1u << k;
+			Todo &= Todo - 1;
+
+			key.Minute = w * 32 + k;
+			key.MinTime = getMinTime(Date, key.Minute);
+			if(key.MinTime == 0)
+				continue;
+			if(MaxHit & bit)
+				JudgeMax(key, v[k], Attr.Max);
+			if(MinHit & bit)
+				JudgeMin(key, v[k], Attr.Min);
+			if(DiffHit & bit)
+				JudgeDiffCalc(key, v[k], Attr.PreData, Attr.Diff, Attr.DiffP);
+			++alarms;
 		}
 	}
+	return alarms;
+}
+
+void CJudgeProcCenter::JudgeMax(const JudgeKey& Key, uint32_t Value, uint32_t Max)
+{
+	if(Max != 0 && Value >= Max)
+	{
+		CAlarmSink::GetInstance().Add(Key.Key.ServiceName, Key.Key.AttrName, Key.MinTime*60, AT_MAX, Value, Max);
+	}
+}
+
+void CJudgeProcCenter::JudgeMin(const JudgeKey& Key, uint32_t Value, uint32_t Min)
+{
+	if(Min != 0 && Value <= Min)
+	{
+		CAlarmSink::GetInstance().Add(Key.Key.ServiceName, Key.Key.AttrName, Key.MinTime*60, AT_MIN, Value, Min);
+	}
 }
 
-void CJudgeProcCenter::JudgeDiffCalc(const JudgeKey& Key, uint32_t Value, string& preData, uint32_t Diff, uint32_t DiffP)
+void CJudgeProcCenter::JudgeDiffCalc(const JudgeKey& Key, uint32_t Value, const string& preData, uint32_t Diff, uint32_t DiffP)
 {
 	if(preData.size() == 0)
 		return;		//ȽΪյļ
@@ -347,50 +510,15 @@ void CJudgeProcCenter::JudgeDiffCalc(const JudgeKey& Key, uint32_t Value, string
 		uint32_t Wave = abs((int)Value - (int)preValue);
 		if( Wave >= Diff )
 		{
-			std::ostringstream str;
-			str << "insert into alarm(id, servicename, attrname, createtime, alarmtime, alarm_type, current_num, alarm_num) values (0, '"
-				<< mysql_alarm.escape_string(Key.Key.ServiceName) << "', '"
-				<< mysql_alarm.escape_string(Key.Key.AttrName) 
-					<< "', NOW(), FROM_UNIXTIME(" << Key.MinTime*60 << "), 3, "	//type = 3, diff
-					<< Value << ", "
-					<< Diff << ")";
-			try{
-				const monitor::MySqlData& data = mysql_alarm.query(str.str());
-				if(data.auto_id() != 0)
-				{
-					msg_log.Write("[Judge]Alarm|Diff|%s|%s|%u|%u|%u|%u|%u|%u", Key.Key.ServiceName.c_str(), Key.Key.AttrName.c_str(), Key.Date, Key.Minute, Value, preValue, Wave, Diff);
-				}
-			}
-			catch(std::runtime_error& e)
-			{
-				err_log.Write("[Judge]Alarm|Diff|ERR|%s|%s|%u|%u|%u|%u|%u|%u|%s", Key.Key.ServiceName.c_str(), Key.Key.AttrName.c_str(), Key.Date, Key.Minute, Value, preValue, Wave, Diff, e.what());
-			}
+			CAlarmSink::GetInstance().Add(Key.Key.ServiceName, Key.Key.AttrName, Key.MinTime*60, AT_DIFF, Value, Diff);
 		}
 	}
-	if(DiffP != 0)
+	if(DiffP != 0 && preValue != 0 && Value != 0)	//һΪ0ʱ޷
 	{
 		uint32_t Wave = abs((int)Value - (int)preValue) * 100 / ( preValue > Value ? Value : preValue );
 		if( Wave >= DiffP )
 		{
-			std::ostringstream str;
-			str << "insert into alarm(id, servicename, attrname, createtime, alarmtime, alarm_type, current_num, alarm_num) values (0, '"
-				<< mysql_alarm.escape_string(Key.Key.ServiceName) << "', '"
-				<< mysql_alarm.escape_string(Key.Key.AttrName) 
-					<< "', NOW(), FROM_UNIXTIME(" << Key.MinTime*60 << "), 4, "	//type = 4, diffp
-					<< Value << ", "
-					<< DiffP << ")";
-			try{
-				const monitor::MySqlData& data = mysql_alarm.query(str.str());
-				if(data.auto_id() != 0)
-				{
-					msg_log.Write("[Judge]Alarm|DiffP|%s|%s|%u|%u|%u|%u|%u|%u", Key.Key.ServiceName.c_str(), Key.Key.AttrName.c_str(), Key.Date, Key.Minute, Value, preValue, Wave, DiffP);
-				}
-			}
-			catch(std::runtime_error& e)
-			{
-				err_log.Write("[Judge]Alarm|DiffP|ERR|%s|%s|%u|%u|%u|%u|%u|%u|%s", Key.Key.ServiceName.c_str(), Key.Key.AttrName.c_str(), Key.Date, Key.Minute, Value, preValue, DiffP, e.what());
-			}
+			CAlarmSink::GetInstance().Add(Key.Key.ServiceName, Key.Key.AttrName, Key.MinTime*60, AT_DIFFP, Value, DiffP);
 		}
 	}
-	
 }
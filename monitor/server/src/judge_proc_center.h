@@ -42,6 +42,7 @@
 #include "tce_lock.h"
 
 #include <set>
+#include <list>
 #include <tr1/memory>
 
 #include "monitor.pb.h"
@@ -72,6 +73,33 @@ public:
 	}
 };
 
+#define JUDGE_ATTR_BLOCK_SIZE	1024
+#define MAX_JUDGE_ATTR_BLOCK	256		//256*1024澯
+#define JUDGE_MASK_WORDS		45		//1440ӵλͼ
+
+//澯: һ䲻ٻ, DBˢ, ɾĹ0
+//ϱֻDirtyλͼϱиµķ, ÿjudge߳ͳһж
+class JudgeAttr {
+public:
+	JudgeAttr() : Max(0), Min(0), Diff(0), DiffP(0), PreDate(0)
+	{
+		memset((void*)Date, 0, sizeof(Date));
+		memset((void*)Dirty, 0, sizeof(Dirty));
+	}
+	string ServiceName;
+	string AttrName;
+	uint32_t Max;
+	uint32_t Min;
+	uint32_t Diff;
+	uint32_t DiffP;
+	volatile uint32_t Date[2];							//ż, ڵyyyymmdd
+	volatile uint32_t Dirty[2][JUDGE_MASK_WORDS];		//ڴжϵķ
+	uint32_t PreDate;		//ǰһݵĻ, ֻjudge̷߳
+	string PreData;
+};
+
+typedef map<uint32_t, uint32_t> JudgeIndex;	//key: ID, value: 澯Ծ
+
 
 class CJudgeProcCenter
 	: tce::CNonCopyAble
@@ -86,28 +114,42 @@ public:
 	uint32_t getMinTime(uint32_t date, uint32_t min);
 	uint32_t getDay(time_t Time);
 	
-	void AddJudge(const string& ServiceName, const string& AttrName, uint32_t Date, uint32_t Minute, uint32_t Value);	
+	//ȡ澯Ծ, ûи澯ʱ-1; 
+	int32_t FindJudgeAttr(uint32_t AttrId) const;
+	//ĳĳӵи; , ڴ
+	void AddJudge(int32_t Handle, uint32_t Date, uint32_t Minute);
 	static int32_t Judge(void* pParam);
 	void JudgeMax(const JudgeKey& Key, uint32_t Value, uint32_t Max);
 	void JudgeMin(const JudgeKey& Key, uint32_t Value, uint32_t Min);
-	void JudgeDiff(const JudgeKey& Key, uint32_t Value, uint32_t Diff, uint32_t DiffP);
-	void JudgeDiffCalc(const JudgeKey& Key, uint32_t Value, string& preData, uint32_t Diff, uint32_t DiffP);
+	void JudgeDiffCalc(const JudgeKey& Key, uint32_t Value, const string& preData, uint32_t Diff, uint32_t DiffP);
 	void Stop();
 
 	void ProcServiceAlarmAttr(msec::monitor::RespService* service, const string& ServicNeame);
 	bool CheckSetAlarmAttr(const string& ServiceName, const string& AttrName);
 
+	static uint32_t DayNum(uint32_t Date);		//yyyymmddתΪ
+	static uint32_t DayDate(uint32_t Num);		//תΪyyyymmdd
+
 private:
 	CJudgeProcCenter(void);
+
+	void CompileRules(const map<string, set<AttrKey> >& attrs);
+	uint32_t JudgeAll();
+	uint32_t JudgeDay(JudgeAttr& Attr, uint32_t Date, const uint32_t* Minutes);
+	inline JudgeAttr& GetJudgeAttr(uint32_t Handle) const
+	{
+		return judge_attrs[Handle / JUDGE_ATTR_BLOCK_SIZE][Handle % JUDGE_ATTR_BLOCK_SIZE];
+	}
 	
 	monitor::CMySql mysql_alarm;
 	std::tr1::shared_ptr<map<string, set<AttrKey> > > alarm_attrs;
-	mutable tce::CMutex lock_judge;
-	map<JudgeKey, uint32_t> judge_map;
 	mutable tce::ReadWriteLocker lock_month;
 	map<uint32_t, uint32_t> month_map;	//key: month like 201604, value: actual minute
 
-	map<JudgeKey, string> mem_judge_map;	//data in mem
+	JudgeAttr* judge_attrs[MAX_JUDGE_ATTR_BLOCK];
+	uint32_t judge_attr_num;
+	JudgeIndex* volatile judge_index;						//ֻ, ʱ滻
+	std::list<std::pair<time_t, JudgeIndex*> > retired_index;	//滻, ӳͷ
 
 	typedef int32_t (* THREADFUNC)(void *);
 	typedef tce::CThread<THREADFUNC> THREAD;	
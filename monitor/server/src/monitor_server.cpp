@@ -37,6 +37,8 @@
 #include "get_proc_center.h"
 #include "judge_proc_center.h"
 #include "dump_proc_center.h"
+#include "shm_index.h"
+#include "attr_id.h"
 #include "proc_def.h"
 
 #include <iostream>
@@ -70,6 +72,7 @@ bool InitConfig(SConfig& stConfig)
 	oCfg.GetValue("sys", "MaxOpenFile", stConfig.dwMaxOpenFile, MAX_OPEN_FILE);
 	oCfg.GetValue("sys", "MaxCoreFile", stConfig.dwMaxCoreFile, MAX_CORE_FILE);
 	oCfg.GetValue("sys", "ThreadPoolSize", stConfig.dwThreadPoolSize, 32);
+	oCfg.GetValue("sys", "ThreadQueueSize", stConfig.dwThreadQueueSize, 65536);
 
 	// 信号量信息
 	oCfg.GetValue("sem", "key", stConfig.dwSemKey, 0x30083);
@@ -82,7 +85,8 @@ bool InitConfig(SConfig& stConfig)
 	unsigned long memory = tce::getSystemMemory();
 
 	if(stConfig.wMemoryPercentage == 0)
-	{		if(memory < 1900000000)
+	{
+		if(memory < 1900000000)
 		{
 			cout << "Current machine memory is smaller than 2GB." << endl;
 			return false;
@@ -126,9 +130,12 @@ bool InitConfig(SConfig& stConfig)
 		
 	}
 	oCfg.GetValue("shm", "dump_path", stConfig.sDumpPath, "../data/dump");
+	oCfg.GetValue("shm", "dump_delta_interval", stConfig.dwDumpDeltaInterval, 60);
+	oCfg.GetValue("shm", "dump_compact_ratio", stConfig.dwDumpCompactRatio, 50);
 
 	printf("[shm info]:\n");
 	printf("\tservice: key: %#x, size: %lu\n\tdata: key: %#x, size: %lu\n", stConfig.dwServiceShmKey, stConfig.ddwServiceShmSize, stConfig.dwDataShmKey, stConfig.ddwDataShmSize);
+	printf("\tdump: delta interval: %u s, compact ratio: %u%%\n", stConfig.dwDumpDeltaInterval, stConfig.dwDumpCompactRatio);
 
 	// 定时器设置 
 	oCfg.GetValue("timer", "to_check_signal", stConfig.dwCheckSignalInterval, 500);
@@ -203,12 +210,16 @@ bool InitConfig(SConfig& stConfig)
 	oCfg.GetValue("tcp_svr", "over_time", stConfig.dwTcpOverTime, 300);
 	oCfg.GetValue("tcp_svr", "in_buf_size", stConfig.dwTcpInBufSize, 50*1024*1024);
 	oCfg.GetValue("tcp_svr", "out_buf_size", stConfig.dwTcpOutBufSize, 50*1024*1024);
+	oCfg.GetValue("tcp_svr", "reactor_num", stConfig.dwTcpReactorNum, 0);
+	oCfg.GetValue("tcp_svr", "worker_buf_size", stConfig.dwTcpWorkerBufSize, 1024*1024);
 
 	printf("[TCP Server]\n");
 	printf("\tIP: %s, Port: %u|%u.\n", stConfig.sTcpIp.c_str(), stConfig.wSetTcpPort, stConfig.wGetTcpPort);
 	printf("\tMaxClient: %u.\n", stConfig.dwTcpMaxClient);
 	printf("\tTiemout: %u s.\n", stConfig.dwTcpOverTime);
 	printf("\tBuffer size: In=%u|Out=%u.\n", stConfig.dwTcpInBufSize, stConfig.dwTcpOutBufSize);
+	printf("\tReactor: %u.\n", stConfig.dwTcpReactorNum);
+	printf("\tWorker buffer size: %u.\n", stConfig.dwTcpWorkerBufSize);
 
 
 	//告警DB	
@@ -220,10 +231,15 @@ bool InitConfig(SConfig& stConfig)
 	oCfg.GetValue("alarm", "DBName", stConfig.sAlarmDBName, "alarm_db");
 	oCfg.GetValue("alarm", "CheckInterval", stConfig.dwCheckAlarmDBInterval, 60);	//1分钟检测1次
 	oCfg.GetValue("alarm", "MaxAlarmNumPerService", stConfig.wMaxAlarmNumPerService, 5);	//每个业务默认最多设置5个告警
+	oCfg.GetValue("alarm", "SinkType", stConfig.sAlarmSinkType, "mysql");	//告警写入DB, file为写本地文件
+	oCfg.GetValue("alarm", "SinkFile", stConfig.sAlarmSinkFile, "../log/alarm.log");
+	oCfg.GetValue("alarm", "BatchSize", stConfig.dwAlarmBatchSize, 200);
+	oCfg.GetValue("alarm", "FlushInterval", stConfig.dwAlarmFlushInterval, 1000);
 	
 	// DB配置信息 
 	printf("[Database]: \n");
 	printf("\tAlarmDB Info: %s@%s:%u#%s\n", stConfig.sAlarmDBUser.c_str(), stConfig.sAlarmDBHost.c_str(), stConfig.wAlarmDBPort, stConfig.sAlarmDBName.c_str());
+	printf("\tAlarm Sink: %s|%u|%u ms\n", stConfig.sAlarmSinkType.c_str(), stConfig.dwAlarmBatchSize, stConfig.dwAlarmFlushInterval);
 	if (stConfig.bDaemon) 
 	{
 		cout << "Server starts as a daemon." << endl;
@@ -255,7 +271,7 @@ bool InitShm(SConfig& stConfig)
 	
 	MhtInitParam param_data;
 	memset((char*)&param_data, 0, sizeof(MhtInitParam));
-	param_data.cMaxKeyLen = 24;
+	param_data.cMaxKeyLen = 24;	//存dwAttrId + [ dwIP ] + dwDay, 与旧的MD5格式保持一致才能挂上旧的共享内存做迁移
 	param_data.ddwShmKey = stConfig.dwDataShmKey;
 	param_data.ddwBufferSize = stConfig.ddwDataShmSize;
 	param_data.dwIndexRatio = 100;
@@ -269,7 +285,21 @@ bool InitShm(SConfig& stConfig)
 	}
 	if (created)	load_dump = true;
 
-	CDumpProcCenter::GetInstance().Init(stConfig.sDumpPath);
+	//属性ID表先于索引加载, 旧格式的DataShm在这里迁移
+	if(!CAttrIdMgr::GetInstance().Init())
+	{
+		printf("error loading attr id table\n");
+		return false;
+	}
+
+	//索引不存在时按DataShm重建, 加载dump时由写入流程补齐
+	if(!CShmIndex::GetInstance().Init())
+	{
+		printf("error building service index\n");
+		return false;
+	}
+
+	CDumpProcCenter::GetInstance().Init(stConfig.sDumpPath, stConfig.dwDumpDeltaInterval, stConfig.dwDumpCompactRatio);
 	if (load_dump)
 	{
 		msg_log << "Need to load dump data." << endl;
@@ -406,6 +436,10 @@ int main(int argc, char* argv[])
 
 	// socket内存管理方式
 	tce::CCommMgr::GetInstance().SetSvrSockManageType(iSetTcpID, tce::CCommMgr::SMT_ARRAY);
+	// 网络IO线程数
+	tce::CCommMgr::GetInstance().SetSvrReactorNum(iSetTcpID, stConfig.dwTcpReactorNum);
+	// 处理线程回包队列
+	tce::CCommMgr::GetInstance().SetSvrWorkerNum(iSetTcpID, stConfig.dwThreadPoolSize, stConfig.dwTcpWorkerBufSize);
 	// 设置TCP分包方式
 	tce::CCommMgr::GetInstance().SetSvrDgramType(iSetTcpID, tce::CCommMgr::TDT_LONGLEN_INCLUDE_ITSELF);
 	// 设置网络事件回调函数 
@@ -435,6 +469,10 @@ int main(int argc, char* argv[])
 
 	// socket内存管理方式
 	tce::CCommMgr::GetInstance().SetSvrSockManageType(iGetTcpID, tce::CCommMgr::SMT_ARRAY);
+	// 网络IO线程数
+	tce::CCommMgr::GetInstance().SetSvrReactorNum(iGetTcpID, stConfig.dwTcpReactorNum);
+	// 处理线程回包队列
+	tce::CCommMgr::GetInstance().SetSvrWorkerNum(iGetTcpID, stConfig.dwThreadPoolSize, stConfig.dwTcpWorkerBufSize);
 	// 设置TCP分包方式
 	tce::CCommMgr::GetInstance().SetSvrDgramType(iGetTcpID, tce::CCommMgr::TDT_LONGLEN_INCLUDE_ITSELF);
 	// 设置网络事件回调函数 
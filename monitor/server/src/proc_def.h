@@ -42,6 +42,7 @@ struct SConfig
 	uint32_t dwMaxCoreFile;
 	string sLocalIP;	//յصϱʹøIP
 	uint32_t dwThreadPoolSize;
+	uint32_t dwThreadQueueSize;	//̳߳нг, 0Ϊֻ޽
 
 	// ־Ϣ
 	string sLogPath;
@@ -68,6 +69,8 @@ struct SConfig
 	uint32_t dwTcpOutBufSize;                   /* С */
 	uint32_t dwTcpMaxClient;                    /* û */
 	uint32_t dwTcpOverTime;                     /* ͬͻͨŲĳʱʱ */
+	uint32_t dwTcpReactorNum;                   /* IO߳, 0ΪIO߳ */
+	uint32_t dwTcpWorkerBufSize;                /* ÿ̶߳ռĻذС, 0Ϊʹ */
 
 	//澯DBϢȡ
 	bool bAlarm;
@@ -78,6 +81,10 @@ struct SConfig
 	string sAlarmDBName;
 	uint32_t dwCheckAlarmDBInterval;
 	uint16_t wMaxAlarmNumPerService;
+	string sAlarmSinkType;			//澯д뷽ʽ: mysqlfile
+	string sAlarmSinkFile;			//fileʽļ·
+	uint32_t dwAlarmBatchSize;		//ÿдĸ澯
+	uint32_t dwAlarmFlushInterval;	//澯д(ms)
 	
 	// ʱ
 	uint32_t dwCheckSignalInterval;
@@ -87,6 +94,8 @@ struct SConfig
 	string sCfgFile;
 	bool bDaemon;
 	string sDumpPath;
+	uint32_t dwDumpDeltaInterval;	//dump(s), 0Ϊֻȫ
+	uint32_t dwDumpCompactRatio;	//ȫİٷֱʱдȫ
 };
 
 // һЩͨö
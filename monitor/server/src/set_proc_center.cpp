@@ -20,6 +20,9 @@
 #include "set_proc_center.h"
 #include "get_proc_center.h"
 #include "judge_proc_center.h"
+#include "shm_index.h"
+#include "attr_id.h"
+#include "dump_proc_center.h"
 #include "log_def.h"
 #include "proc_def.h"
 #include "signal_handler.h"
@@ -32,6 +35,7 @@ void Quit(int iSignal, void *pInfo)
 	msg_log.Write("[Set]Receive signal(%u), program quiting...", iSignal);
 	CGetProcCenter::GetInstance().Wait();
 	CSetProcCenter::GetInstance().Wait();
+	CShmIndex::GetInstance().Flush();	//д߳ͣ, µд
 	tce::CCommMgr::GetInstance().Stop();
 	CJudgeProcCenter::GetInstance().Stop();
 }
@@ -50,11 +54,14 @@ bool CSetProcCenter::Init(void)
 	// öʱ
 	tce::CCommMgr::GetInstance().SetTimer(TT_CHECK_SIGNAL, stConfig.dwCheckSignalInterval);
 	tce::CCommMgr::GetInstance().SetTimer(TT_PRINT_SHM_INFO, 10000);	
+	tce::CCommMgr::GetInstance().SetTimer(TT_REPAIR_ATTR_ID, 60000);
+	tce::CCommMgr::GetInstance().SetTimer(TT_FLUSH_INDEX, 1000);
 
 	// źŴ
 	CSigHandler::GetInstance().SetSigHander(SIGTERM, Quit);
 
 	//̳߳ش
+	m_pool.set_queue_capacity(stConfig.dwThreadQueueSize);
 	m_pool.start(stConfig.dwThreadPoolSize, SetPoolInit);
 
 	return true;
@@ -72,6 +79,12 @@ void CSetProcCenter::OnTimer(const int iId)
 		case TT_PRINT_SHM_INFO:
 			PrintShmInfo();
 			break;
+		case TT_REPAIR_ATTR_ID:
+			CAttrIdMgr::GetInstance().Repair();
+			break;
+		case TT_FLUSH_INDEX:
+			CShmIndex::GetInstance().Flush();
+			break;
 		default:
 			err_log.Write("[Set]Undefined timer type(%u)", iId);
 			break;
@@ -83,22 +96,37 @@ void CSetProcCenter::PrintShmInfo()
 	DataShm.PrintInfo("DATA");
 	ServiceShm.PrintInfo("SERVICE");
 }
-int CSetProcCenter::SendRespPkg(tce::SSession& stSession, uint32_t ret)
+int CSetProcCenter::SendRespPkg(tce::SSession& stSession, msec::monitor::RespReport& Pkg)
 {
-	msec::monitor::RespReport Pkg;
-	Pkg.set_result(ret);
-
-	string sData;
-	if ( !Pkg.SerializeToString(&sData) )
+	//ֱлͶԤĿռ, ʡмstringĿ
+	if ( !Pkg.IsInitialized() )
 	{
-		err_log << "[Set]Failed to serialize to string!" << endl;
+		err_log << "[Set]Failed to serialize pkg!" << endl;
 		return -2;
 	}
+	const int iSize = Pkg.ByteSize();
+
+	//߳дԼĻذ, ʱ˻ؼд
+	int iWorker = wbl::thread_pool::get_thread_index();
+	if ( iWorker >= 0 )
+	{
+		char* pBuf = tce::CCommMgr::GetInstance().ReserveWriteByWorker(iWorker, stSession, iSize);
+		if ( NULL != pBuf )
+		{
+			Pkg.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(pBuf));
+			if ( tce::CCommMgr::GetInstance().CommitWriteByWorker(iWorker, stSession, iSize) )
+				return 0;
+		}
+	}
 
 	{
-		
 		tce::CAutoLock lock(lock_write);
-		if ( !tce::CCommMgr::GetInstance().Write(stSession, sData.data(), sData.size()) )
+		char* pBuf = tce::CCommMgr::GetInstance().ReserveWrite(stSession, iSize);
+		if ( NULL != pBuf )
+		{
+			Pkg.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(pBuf));
+		}
+		if ( NULL == pBuf || !tce::CCommMgr::GetInstance().CommitWrite(stSession, iSize) )
 		{
 			err_log.Write("[Set]Send pkg back failed! ip: %s, port: %u", stSession.GetIPByStr().c_str(), stSession.GetPort());
 			return -2;
@@ -108,7 +136,7 @@ int CSetProcCenter::SendRespPkg(tce::SSession& stSession, uint32_t ret)
 	return 0;
 }
 
-int CSetProcCenter::UpdateValueData(const msec::monitor::Attr& attr, const string& ip, int day, int begin, int end, int index, bool needjudge)	//from begin minute to end minute
+int CSetProcCenter::UpdateValueData(const msec::monitor::Attr& attr, uint32_t attr_id, const string& ip, int day, int begin, int end, int index, bool needjudge)	//from begin minute to end minute
 {
 	char data[value_fixed_len];
 
@@ -129,13 +157,18 @@ int CSetProcCenter::UpdateValueData(const msec::monitor::Attr& attr, const strin
 			return -1;
 	}
 
-	//KeyFormat: MD5(svc + 0x03 + attr) + [ dwIP ] + dwDay
-	string key(attr.servicename());
-	key.append(1u,0x3).append(attr.attrname());
-	string skey(tce::TC_MD5::md5bin(key));	//md5 + dayvalue
-	if(!ip.empty())
-		skey.append((char*)&numeric_ip, sizeof(uint32_t));
-	skey.append((char*)&day, sizeof(uint32_t));
+	if(attr_id == ATTR_ID_NONE)
+	{
+			err_log.Write("[Set]UpdateValueData attr id error|%s|%s", attr.servicename().c_str(), attr.attrname().c_str());
+			return -1;
+	}
+
+	//KeyFormat: dwAttrId + [ dwIP ] + dwDay, IDΨһ, Ҫȶvalueе
+	string skey(CAttrIdMgr::DataKey(attr_id, numeric_ip, day));
+
+	int32_t judge_handle = -1;
+	if(needjudge && ip.empty())	//ȫͼжǷҪת澯
+		judge_handle = CJudgeProcCenter::GetInstance().FindJudgeAttr(attr_id);
 	
 	int retry = 0;
 	while(retry < 3)
@@ -149,22 +182,14 @@ int CSetProcCenter::UpdateValueData(const msec::monitor::Attr& attr, const strin
 			return -2;
 		}
 		//ݽṹⲻpb
-		if(data_len != value_fixed_len)	//ֱӳʼ
+		//дvalue, dumpIDʧʱָ
+		bool created = (data_len != value_fixed_len);
+		if(created)	//ֱӳʼ
 		{
 			memset(data, 0, value_fixed_len);
 			strcpy(data, attr.servicename().c_str());
 			strcpy(&data[128], attr.attrname().c_str());
 		}
-		else
-		{
-			
-			if(strcmp(attr.servicename().c_str(), &data[0]) || strcmp(attr.attrname().c_str(), &data[128]))
-			{				
-				err_log.Write("[Set]Key not match|%s|%s|%s|%s|%s|%u", data, &data[128],
-					attr.servicename().c_str(), attr.attrname().c_str(), ip.c_str(), day);
-				return -4;
-			}
-		}
 
 		//޸values
 		char* ptr = &data[256];
@@ -173,9 +198,9 @@ int CSetProcCenter::UpdateValueData(const msec::monitor::Attr& attr, const strin
 	//		int num = *(uint32_t*)(ptr+j*4);
 			*(uint32_t*)(ptr+j*4) += attr.values(j-begin+index);
 
-			if(needjudge && ip.empty())	//ȫͼжǷҪת澯
+			if(judge_handle >= 0)
 			{
-				CJudgeProcCenter::GetInstance().AddJudge(attr.servicename(), attr.attrname(), day, j, *(uint32_t*)(ptr+j*4));
+				CJudgeProcCenter::GetInstance().AddJudge(judge_handle, day, j);
 			}
 		}
 		//д빲ڴ(valueֱӶΪ256+1440*4)
@@ -194,6 +219,12 @@ int CSetProcCenter::UpdateValueData(const msec::monitor::Attr& attr, const strin
 		else
 		{
 	//		msg_log.Write("[Set]Value Write OK|%s|%s|%s|%u", attr.servicename().c_str(), attr.attrname().c_str(), ip.c_str(), day);
+			//µһ, ͬ
+			if(created)
+				CShmIndex::GetInstance().AddAttrDay(attr.servicename(), attr.attrname(), numeric_ip, day);
+			//ipڵdump, ȫͼipڵܵõ
+			if(numeric_ip != 0)
+				CDumpProcCenter::GetInstance().MarkDirty(skey);
 			break;
 		}
 	}
@@ -230,11 +261,13 @@ int CSetProcCenter::Process(tce::SSession& stSession, std::tr1::shared_ptr<msec:
 	{
 		srcip = stConfig.sLocalIP;
 	}
-	int ret = ProcessReq(*Pkg.get(), srcip);
-	return SendRespPkg(stSession, ret);
+	msec::monitor::RespReport resp;
+	int ret = ProcessReq(*Pkg.get(), srcip, true, &resp);
+	resp.set_result(ret);
+	return SendRespPkg(stSession, resp);
 }
 
-int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, bool timecheck)
+int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, bool timecheck, msec::monitor::RespReport* resp)
 {
 	uint32_t ip = tce::InetAtoN(srcip);
 	tce::CTimeCost tc;
@@ -243,6 +276,37 @@ int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, boo
 
 	bool judge_check = (stConfig.bAlarm || timecheck);	//ֻҪκһΪtruejudge߼
 
+	//IDԻ, ƵȡIDظagent
+	//IDһʱܾ, agentIDر
+	CAttrIdMgr& idmgr = CAttrIdMgr::GetInstance();
+	vector<uint32_t> attr_ids(Pkg.attrs_size(), ATTR_ID_NONE);
+	for(int i = 0; i < Pkg.attrs_size(); i++)
+	{
+		msec::monitor::Attr* attr = Pkg.mutable_attrs(i);
+		if(attr->attr_id() != ATTR_ID_NONE)
+		{
+			if(Pkg.id_epoch() != idmgr.GetEpoch() || !idmgr.GetName(attr->attr_id(), *attr->mutable_servicename(), *attr->mutable_attrname()))
+			{
+				err_log.Write("[Set]Unknown attr id|%s|%u|%u|%u", srcip.c_str(), Pkg.id_epoch(), idmgr.GetEpoch(), attr->attr_id());
+				return 3;
+			}
+			attr_ids[i] = attr->attr_id();
+		}
+		else if(attr->servicename().size() <= 127 && attr->attrname().size() <= 127)
+		{
+			attr_ids[i] = idmgr.Intern(attr->servicename(), attr->attrname());
+			if(resp != NULL && attr_ids[i] != ATTR_ID_NONE)
+			{
+				msec::monitor::AttrId* id = resp->add_ids();
+				id->set_servicename(attr->servicename());
+				id->set_attrname(attr->attrname());
+				id->set_attr_id(attr_ids[i]);
+			}
+		}
+	}
+	if(resp != NULL)
+		resp->set_id_epoch(idmgr.GetEpoch());
+
 	//ȲIP
 	string key( (char*)&ip, sizeof(uint32_t));
 	int ret = ServiceShm.GetNode(key, &data[0], data_len);
@@ -304,8 +368,8 @@ int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, boo
 		if(Pkg.attrs(i).servicename() != "RESERVED.monitor")
 		{
 			service_attr_req[Pkg.attrs(i).servicename()].insert(Pkg.attrs(i).attrname());
-			UpdateValueData(Pkg.attrs(i), "", day, ta_begin_min, ta_end_min, 0, judge_check);	//view
-			UpdateValueData(Pkg.attrs(i), srcip, day, ta_begin_min, ta_end_min, 0, judge_check);	//ip
+			UpdateValueData(Pkg.attrs(i), attr_ids[i], "", day, ta_begin_min, ta_end_min, 0, judge_check);	//view
+			UpdateValueData(Pkg.attrs(i), attr_ids[i], srcip, day, ta_begin_min, ta_end_min, 0, judge_check);	//ip
 		}
 		else
 		{
@@ -315,8 +379,9 @@ int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, boo
 			{
 				attr.set_servicename(it->first);
 				service_attr_req[attr.servicename()].insert(attr.attrname());
-				UpdateValueData(attr, "", day, ta_begin_min, ta_end_min, 0, judge_check);	//view
-				UpdateValueData(attr, srcip, day, ta_begin_min, ta_end_min, 0, judge_check);	//ip
+				uint32_t attr_id = idmgr.Intern(attr.servicename(), attr.attrname());
+				UpdateValueData(attr, attr_id, "", day, ta_begin_min, ta_end_min, 0, judge_check);	//view
+				UpdateValueData(attr, attr_id, srcip, day, ta_begin_min, ta_end_min, 0, judge_check);	//ip
 			}			
 		}
 		
@@ -329,8 +394,8 @@ int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, boo
 			day = ta_begin.GetDayValue();
 			if(Pkg.attrs(i).servicename() != "RESERVED.monitor")
 			{
-				UpdateValueData(Pkg.attrs(i), "", day, ta_begin_min, ta_end_min, index, judge_check);	//view
-				UpdateValueData(Pkg.attrs(i), srcip, day, ta_begin_min, ta_end_min, index, judge_check);	//ip
+				UpdateValueData(Pkg.attrs(i), attr_ids[i], "", day, ta_begin_min, ta_end_min, index, judge_check);	//view
+				UpdateValueData(Pkg.attrs(i), attr_ids[i], srcip, day, ta_begin_min, ta_end_min, index, judge_check);	//ip
 			}
 			else
 			{
@@ -339,8 +404,9 @@ int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, boo
 				for(map<string, set<string> >::iterator it = service_attr_ipmem.begin(); it != service_attr_ipmem.end(); it++)
 				{
 					attr.set_servicename(it->first);
-					UpdateValueData(attr, "", day, ta_begin_min, ta_end_min, index, judge_check);	//view
-					UpdateValueData(attr, srcip, day, ta_begin_min, ta_end_min, index, judge_check);	//ip
+					uint32_t attr_id = idmgr.Intern(attr.servicename(), attr.attrname());
+					UpdateValueData(attr, attr_id, "", day, ta_begin_min, ta_end_min, index, judge_check);	//view
+					UpdateValueData(attr, attr_id, srcip, day, ta_begin_min, ta_end_min, index, judge_check);	//ip
 				}			
 			}
 //			UpdateValueData(Pkg.attrs(i), "", day, ta_begin_min, ta_end_min, index);	//view
@@ -383,7 +449,7 @@ int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, boo
 		string out;
 		if ( !ipdata_new.SerializeToString(&out) )
 		{
-			err_log << "[Set]Failed to serialize to string!|" << srcip << endl;			
+			err_log << "[Set]Failed to serialize pkg!|" << srcip << endl;			
 		}
 		else
 		{
@@ -460,7 +526,7 @@ int CSetProcCenter::ProcessReq(msec::monitor::ReqReport& Pkg, string& srcip, boo
 			string out;
 			if ( !servicedata_new.SerializeToString(&out) )
 			{
-				err_log << "[Set]Failed to serialize to string!|" << it->first << endl;			
+				err_log << "[Set]Failed to serialize pkg!|" << it->first << endl;			
 			}
 			else
 			{
@@ -52,9 +52,9 @@ public:
 	
 	void PrintShmInfo();
 	int Process(tce::SSession& stSession, std::tr1::shared_ptr<msec::monitor::ReqReport> Pkg);
-	int ProcessReq(msec::monitor::ReqReport&  pkg, string& srcip, bool timecheck=true);
-	int SendRespPkg(tce::SSession& stSession, uint32_t ret);
-	int UpdateValueData(const msec::monitor::Attr& attr, const string& ip, int day, int begin, int end, int index, bool needjudge);
+	int ProcessReq(msec::monitor::ReqReport&  pkg, string& srcip, bool timecheck=true, msec::monitor::RespReport* resp=NULL);
+	int SendRespPkg(tce::SSession& stSession, msec::monitor::RespReport& Pkg);
+	int UpdateValueData(const msec::monitor::Attr& attr, uint32_t attr_id, const string& ip, int day, int begin, int end, int index, bool needjudge);
 
 	void Wait() {m_pool.wait();};
 private:
@@ -62,6 +62,8 @@ private:
 	{
 		TT_CHECK_SIGNAL = 1,
 		TT_PRINT_SHM_INFO = 2,
+		TT_REPAIR_ATTR_ID = 3,
+		TT_FLUSH_INDEX = 4,
 	};
 
 private:
@@ -0,0 +1,703 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#include "shm_index.h"
+#include "judge_proc_center.h"
+#include "attr_id.h"
+
+#include "log_def.h"
+#include "proc_def.h"
+
+#define INDEX_HEAD_LEN		12
+#define INDEX_REC_HEAD_LEN	13
+#define INDEX_MAX_NAME_LEN	255		//¼Ƴֻռ1ֽ, Ʋ
+
+//UpdateNodeķ
+enum INDEX_UPDATE {
+	IU_NONE = 0,		//ޱ仯ֻ
+	IU_NEW_REC = 1,		//˼¼IP
+	IU_NEW_NODE = 2,	//½˽ڵ
+};
+
+struct IndexBuf
+{
+	char* Data;
+	IndexBuf() : Data(new char[SHM_INDEX_MAX_LEN]) {}
+	~IndexBuf() { delete [] Data; }
+};
+
+struct IndexRec
+{
+	uint32_t LastDay;
+	uint64_t DayBits;
+	uint8_t NameLen;
+	const char* Name;
+};
+
+static inline uint32_t GetU32(const char* p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t GetU64(const char* p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+//ȡOffļ¼, һƫ, Խ緵0
+static size_t NextRec(const char* Data, size_t Len, size_t Off, IndexRec& Rec)
+{
+	if(Off + INDEX_REC_HEAD_LEN > Len)
+		return 0;
+	Rec.LastDay = GetU32(Data + Off);
+	Rec.DayBits = GetU64(Data + Off + 4);
+	Rec.NameLen = (uint8_t)Data[Off + 12];
+	Rec.Name = Data + Off + INDEX_REC_HEAD_LEN;
+	if(Off + INDEX_REC_HEAD_LEN + Rec.NameLen > Len)
+		return 0;
+	return Off + INDEX_REC_HEAD_LEN + Rec.NameLen;
+}
+
+//ڵͷ, صһ¼ƫ, ʧܷ0
+static size_t ParseHead(const char* Data, size_t Len, uint32_t Magic, uint32_t& IPNum, uint32_t& RecNum)
+{
+	if(Len < INDEX_HEAD_LEN || GetU32(Data) != Magic)
+		return 0;
+	IPNum = GetU32(Data + 4);
+	RecNum = GetU32(Data + 8);
+	if(IPNum > Len / 4 || INDEX_HEAD_LEN + IPNum * 4 > Len)
+		return 0;
+	return INDEX_HEAD_LEN + IPNum * 4;
+}
+
+static inline int CompareName(const char* Name, uint8_t NameLen, const string& Rhs)
+{
+	int ret = memcmp(Name, Rhs.data(), std::min((size_t)NameLen, Rhs.size()));
+	if(ret != 0)
+		return ret;
+	return (int)NameLen - (int)Rhs.size();
+}
+
+//λͼĳ, LastDayµʹλͼ
+static void SetDay(uint32_t& LastDay, uint64_t& DayBits, uint32_t Day)
+{
+	if(LastDay == 0 || Day > LastDay)
+	{
+		uint32_t shift = LastDay == 0 ? SHM_INDEX_DAYS : Day - LastDay;
+		DayBits = shift >= SHM_INDEX_DAYS ? 0 : DayBits << shift;
+		LastDay = Day;
+	}
+	if(LastDay - Day < SHM_INDEX_DAYS)
+		DayBits |= 1ULL << (LastDay - Day);
+}
+
+//һλͼе첢
+static void MergeDays(uint32_t& LastDay, uint64_t& DayBits, uint32_t SrcLastDay, uint64_t SrcDayBits)
+{
+	for(uint32_t k = 0; k < SHM_INDEX_DAYS && k < SrcLastDay; k++)
+	{
+		if((SrcDayBits >> k) & 1)
+			SetDay(LastDay, DayBits, SrcLastDay - k);
+	}
+}
+
+//1, 0, -1λͼΧ
+static int HasDay(uint32_t LastDay, uint64_t DayBits, uint32_t Day)
+{
+	if(LastDay == 0 || Day > LastDay)
+		return 0;
+	if(LastDay - Day >= SHM_INDEX_DAYS)
+		return -1;
+	return (DayBits >> (LastDay - Day)) & 1;
+}
+
+//DaysһλͼDataShm
+static bool MatchDays(const IndexRec& Rec, const string& ServiceName, const string& AttrName, uint32_t IP, const std::vector<uint32_t>& Dates, const std::vector<uint32_t>& Days)
+{
+	for(size_t i = 0; i < Days.size(); i++)
+	{
+		int has = HasDay(Rec.LastDay, Rec.DayBits, Days[i]);
+		if(has == 1)
+			return true;
+		if(has == -1)
+		{
+			uint32_t id = CAttrIdMgr::GetInstance().Find(ServiceName, AttrName);
+			if(id == ATTR_ID_NONE)
+				return false;
+			string skey(CAttrIdMgr::DataKey(id, IP, Dates[i]));
+			if(DataShm.HasKey(skey))
+				return true;
+		}
+	}
+	return false;
+}
+
+static inline void AppendRec(string& Out, const char* Name, size_t NameLen, uint32_t LastDay, uint64_t DayBits)
+{
+	Out.append((char*)&LastDay, sizeof(uint32_t));
+	Out.append((char*)&DayBits, sizeof(uint64_t));
+	Out.append(1u, (char)NameLen);
+	Out.append(Name, NameLen);
+}
+
+static void EncodeNode(const IndexNode& Node, string& Out)
+{
+	uint32_t head[3] = { Node.Magic, (uint32_t)Node.IPs.size(), (uint32_t)Node.Recs.size() };
+	Out.assign((char*)head, sizeof(head));
+	for(std::set<uint32_t>::const_iterator it = Node.IPs.begin(); it != Node.IPs.end(); it++)
+	{
+		Out.append((char*)&*it, sizeof(uint32_t));
+	}
+	for(std::map<string, std::pair<uint32_t, uint64_t> >::const_iterator it = Node.Recs.begin(); it != Node.Recs.end(); it++)
+	{
+		AppendRec(Out, it->first.data(), it->first.size(), it->second.first, it->second.second);
+	}
+}
+
+static inline string ServiceIndexKey(const string& ServiceName)
+{
+	string key(ServiceName);
+	key.append(1u, 0x4);
+	return tce::TC_MD5::md5bin(key);
+}
+
+static inline string IPIndexKey(uint32_t IP)
+{
+	string key((char*)&IP, sizeof(uint32_t));
+	key.append(1u, 0x4);
+	return key;
+}
+
+CShmIndex::CShmIndex()
+	: pending_num(0)
+	, rebuild_interval(SHM_INDEX_REBUILD_INTERVAL)
+	, last_rebuild(0)
+{}
+
+bool CShmIndex::Init(uint32_t RebuildInterval)
+{
+	rebuild_interval = RebuildInterval;
+
+	IndexBuf buf;
+	int len = SHM_INDEX_MAX_LEN;
+	string key(SHM_INDEX_LIST_KEY);
+	int ret = ServiceShm.GetNode(key, buf.Data, len);
+	if(ret != 0)
+	{
+		err_log.Write("[Index]GetNode list failed!|%d|%s", ret, ServiceShm.GetErrorMsg());
+		return false;
+	}
+	if(len > 0)
+		return true;
+
+	//ɰ汾Ĺڴ̭, DataShmؽ
+	return Rebuild();
+}
+
+bool CShmIndex::IsIndexNode(const char* Data, int Len)
+{
+	if(Len < INDEX_HEAD_LEN)
+		return false;
+	uint32_t magic = GetU32(Data);
+	return magic == SHM_INDEX_MAGIC_SERVICE || magic == SHM_INDEX_MAGIC_IP || magic == SHM_INDEX_MAGIC_LIST;
+}
+
+bool CShmIndex::Rebuild()
+{
+	tce::CAutoLock lock(lock_update);
+	return DoRebuild();
+}
+
+bool CShmIndex::DoRebuild()
+{
+	tce::CTimeCost tc;
+	//DataShmȫ, ϲĸ²Ҫ
+	pending.clear();
+	pending_num = 0;
+
+	std::map<string, IndexNode> nodes;
+	IndexNode& list = nodes[SHM_INDEX_LIST_KEY];
+	list.Magic = SHM_INDEX_MAGIC_LIST;
+
+	MhtData* data = new MhtData();
+	int count = 0;
+	for(MhtIterator it = DataShm.ht.Begin(); it != DataShm.ht.End(); it = DataShm.ht.Next(it))
+	{
+		if(DataShm.GetData(it, *data) != 0)
+			break;
+		//KeyFormat: dwAttrId + [ dwIP ] + dwDay
+		if((data->klen != 8 && data->klen != 12) || data->dlen != value_fixed_len)
+			continue;
+
+		string svcname((char*)&data->data[0], strnlen((char*)&data->data[0], 128));
+		string attrname((char*)&data->data[128], strnlen((char*)&data->data[128], 128));
+		uint32_t ip = 0;
+		uint32_t date = 0;
+		if(data->klen == 12)
+			memcpy(&ip, data->key + 4, sizeof(uint32_t));
+		memcpy(&date, data->key + data->klen - 4, sizeof(uint32_t));
+		uint32_t day = CJudgeProcCenter::DayNum(date);
+
+		IndexNode& service = nodes[ServiceIndexKey(svcname)];
+		service.Magic = SHM_INDEX_MAGIC_SERVICE;
+		list.Recs.insert(std::make_pair(svcname, std::make_pair(0u, 0ULL)));
+		if(ip == 0)
+		{
+			std::pair<uint32_t, uint64_t>& days = service.Recs[attrname];
+			SetDay(days.first, days.second, day);
+		}
+		else
+		{
+			service.IPs.insert(ip);
+			string name(svcname);
+			name.append(1u, 0x3).append(attrname);
+			if(name.size() > INDEX_MAX_NAME_LEN)
+			{
+				err_log.Write("[Index]Name too long!|%s|%s|%lu", svcname.c_str(), attrname.c_str(), name.size());
+				continue;
+			}
+			IndexNode& ipnode = nodes[IPIndexKey(ip)];
+			ipnode.Magic = SHM_INDEX_MAGIC_IP;
+			list.IPs.insert(ip);
+			std::pair<uint32_t, uint64_t>& days = ipnode.Recs[name];
+			SetDay(days.first, days.second, day);
+		}
+		++count;
+	}
+	delete data;
+
+	string out;
+	for(std::map<string, IndexNode>::iterator it = nodes.begin(); it != nodes.end(); it++)
+	{
+		EncodeNode(it->second, out);
+		if(out.size() > SHM_INDEX_MAX_LEN)
+		{
+			err_log.Write("[Index]Node too large!|%s|%lu", tce::HexShow(it->first.data(), it->first.size()).c_str(), out.size());
+			continue;
+		}
+		string key(it->first);
+		int ret = ServiceShm.SetNode(key, out);
+		if(ret != 0)
+		{
+			err_log.Write("[Index]SetNode failed!|%d|%s", ret, ServiceShm.GetErrorMsg());
+			return false;
+		}
+	}
+	msg_log.Write("[Index]Rebuild OK|%d|%lu|%lu", count, nodes.size(), tc.value());
+	return true;
+}
+
+bool CShmIndex::TryRebuild(const char* Reason)
+{
+	time_t now = time(NULL);
+	if(last_rebuild != 0 && now < last_rebuild + (time_t)rebuild_interval)
+	{
+		err_log.Write("[Index]Rebuild skipped|%s|%ld", Reason, (long)(now - last_rebuild));
+		return false;
+	}
+	last_rebuild = now;
+	err_log.Write("[Index]Rebuild|%s", Reason);
+	return DoRebuild();
+}
+
+//UpdateеIPͼ¼鲢ڵ, ߶, һ; ڵʱ½ڵд
+int CShmIndex::MergeNode(const string& Key, const IndexNode& Update, size_t& Added)
+{
+	Added = 0;
+	IndexBuf buf;
+	int len = SHM_INDEX_MAX_LEN;
+	string key(Key);
+	int ret = ServiceShm.GetNode(key, buf.Data, len);
+	if(ret != 0)
+	{
+		err_log.Write("[Index]GetNode failed!|%s|%d|%s", tce::HexShow(Key.data(), Key.size()).c_str(), ret, ServiceShm.GetErrorMsg());
+		return -1;
+	}
+
+	uint32_t ipnum = 0;
+	uint32_t recnum = 0;
+	size_t off = 0;
+	int result = IU_NONE;
+	if(len > 0)
+	{
+		off = ParseHead(buf.Data, len, Update.Magic, ipnum, recnum);
+		//, 𻵵Ľڵ㶪д
+		IndexRec rec;
+		size_t pos = off;
+		for(uint32_t i = 0; off != 0 && i < recnum; i++)
+		{
+			pos = NextRec(buf.Data, len, pos, rec);
+			if(pos == 0)
+				off = 0;
+		}
+		if(off == 0)
+			err_log.Write("[Index]Bad node, reset|%s|%d", tce::HexShow(Key.data(), Key.size()).c_str(), len);
+	}
+	if(off == 0)
+	{
+		ipnum = recnum = 0;
+		len = 0;
+		result = IU_NEW_NODE;
+	}
+
+	bool changed = (result != IU_NONE);
+	string out(INDEX_HEAD_LEN, 0);
+	out.reserve(len + Update.IPs.size() * sizeof(uint32_t) + Update.Recs.size() * (INDEX_REC_HEAD_LEN + 32));
+
+	uint32_t outipnum = 0;
+	std::set<uint32_t>::const_iterator ipit = Update.IPs.begin();
+	for(uint32_t i = 0; i < ipnum; i++)
+	{
+		uint32_t ip = GetU32(buf.Data + INDEX_HEAD_LEN + i * 4);
+		for(; ipit != Update.IPs.end() && *ipit < ip; ++ipit, ++outipnum, ++Added)
+			out.append((char*)&*ipit, sizeof(uint32_t));
+		if(ipit != Update.IPs.end() && *ipit == ip)
+			++ipit;
+		out.append((char*)&ip, sizeof(uint32_t));
+		++outipnum;
+	}
+	for(; ipit != Update.IPs.end(); ++ipit, ++outipnum, ++Added)
+		out.append((char*)&*ipit, sizeof(uint32_t));
+
+	uint32_t outrecnum = 0;
+	std::map<string, std::pair<uint32_t, uint64_t> >::const_iterator it = Update.Recs.begin();
+	IndexRec rec;
+	size_t pos = off;
+	for(uint32_t i = 0; i < recnum; i++)
+	{
+		pos = NextRec(buf.Data, len, pos, rec);
+		int cmp = 1;
+		for(; it != Update.Recs.end() && (cmp = CompareName(rec.Name, rec.NameLen, it->first)) > 0; ++it, ++outrecnum, ++Added)
+			AppendRec(out, it->first.data(), it->first.size(), it->second.first, it->second.second);
+		uint32_t lastday = rec.LastDay;
+		uint64_t daybits = rec.DayBits;
+		if(it != Update.Recs.end() && cmp == 0)
+		{
+			MergeDays(lastday, daybits, it->second.first, it->second.second);
+			if(lastday != rec.LastDay || daybits != rec.DayBits)
+				changed = true;
+			++it;
+		}
+		AppendRec(out, rec.Name, rec.NameLen, lastday, daybits);
+		++outrecnum;
+	}
+	for(; it != Update.Recs.end(); ++it, ++outrecnum, ++Added)
+		AppendRec(out, it->first.data(), it->first.size(), it->second.first, it->second.second);
+
+	if(Added > 0)
+		result |= IU_NEW_REC;
+	else if(!changed)
+		return IU_NONE;
+
+	if(out.size() > SHM_INDEX_MAX_LEN)
+	{
+		err_log.Write("[Index]Node too large!|%s|%lu", tce::HexShow(Key.data(), Key.size()).c_str(), out.size());
+		return -2;
+	}
+	uint32_t head[3] = { Update.Magic, outipnum, outrecnum };
+	out.replace(0, sizeof(head), (char*)head, sizeof(head));
+	ret = ServiceShm.SetNode(key, out);
+	if(ret != 0)
+	{
+		err_log.Write("[Index]SetNode failed!|%s|%d|%s", tce::HexShow(Key.data(), Key.size()).c_str(), ret, ServiceShm.GetErrorMsg());
+		return -3;
+	}
+	return result;
+}
+
+void CShmIndex::AddAttrDay(const string& ServiceName, const string& AttrName, uint32_t IP, uint32_t Date)
+{
+	uint32_t day = CJudgeProcCenter::DayNum(Date);
+	string skey(ServiceIndexKey(ServiceName));
+
+	tce::CAutoLock lock(lock_update);
+	IndexNode& service = pending[skey];
+	service.Magic = SHM_INDEX_MAGIC_SERVICE;
+	service.Name = ServiceName;
+	if(IP == 0)
+	{
+		std::pair<uint32_t, uint64_t>& days = service.Recs[AttrName];
+		SetDay(days.first, days.second, day);
+	}
+	else
+	{
+		service.IPs.insert(IP);
+		string name(ServiceName);
+		name.append(1u, 0x3).append(AttrName);
+		if(name.size() > INDEX_MAX_NAME_LEN)
+		{
+			err_log.Write("[Index]Name too long!|%s|%s|%lu", ServiceName.c_str(), AttrName.c_str(), name.size());
+		}
+		else
+		{
+			IndexNode& ipnode = pending[IPIndexKey(IP)];
+			ipnode.Magic = SHM_INDEX_MAGIC_IP;
+			ipnode.IP = IP;
+			std::pair<uint32_t, uint64_t>& days = ipnode.Recs[name];
+			SetDay(days.first, days.second, day);
+		}
+	}
+	//ʱÿԶ½DataShmڵ, ڵϲ, ÿдһڵ
+	if(++pending_num >= SHM_INDEX_FLUSH_NUM)
+		DoFlush();
+}
+
+void CShmIndex::Flush()
+{
+	tce::CAutoLock lock(lock_update);
+	DoFlush();
+}
+
+void CShmIndex::DoFlush()
+{
+	if(pending.empty())
+		return;
+
+	tce::CTimeCost tc;
+	std::map<string, IndexNode> nodes;
+	nodes.swap(pending);
+	size_t num = pending_num;
+	pending_num = 0;
+
+	//½serviceIPڵб
+	IndexNode list;
+	list.Magic = SHM_INDEX_MAGIC_LIST;
+	for(std::map<string, IndexNode>::iterator it = nodes.begin(); it != nodes.end(); it++)
+	{
+		size_t added = 0;
+		int ret = MergeNode(it->first, it->second, added);
+		if(ret <= 0 || !(ret & IU_NEW_NODE))
+			continue;
+		if(it->second.Magic == SHM_INDEX_MAGIC_SERVICE)
+			list.Recs.insert(std::make_pair(it->second.Name, std::make_pair(0u, 0ULL)));
+		else
+			list.IPs.insert(it->second.IP);
+	}
+
+	if(!list.Recs.empty() || !list.IPs.empty())
+	{
+		size_t added = 0;
+		int ret = MergeNode(SHM_INDEX_LIST_KEY, list, added);
+		//б½, ½Ľڵб: ڵ㱻̭, ԭеļ¼Ѷʧ
+		if(ret >= 0 && ((ret & IU_NEW_NODE) || added < list.Recs.size() + list.IPs.size()))
+		{
+			TryRebuild("node evicted");
+			return;
+		}
+	}
+	msg_log.Write("[Index]Flush|%lu|%lu|%lu", num, nodes.size(), tc.value());
+}
+
+bool CShmIndex::RebuildIfEvicted(const string& ServiceName, uint32_t IP)
+{
+	tce::CAutoLock lock(lock_update);
+	IndexBuf buf;
+	int len = SHM_INDEX_MAX_LEN;
+	string key(SHM_INDEX_LIST_KEY);
+	int ret = ServiceShm.GetNode(key, buf.Data, len);
+	if(ret != 0)
+	{
+		err_log.Write("[Index]GetNode list failed!|%d|%s", ret, ServiceShm.GetErrorMsg());
+		return false;
+	}
+	//бڵInitʱѽ
+	if(len == 0)
+		return TryRebuild("list evicted");
+
+	uint32_t ipnum = 0;
+	uint32_t recnum = 0;
+	size_t pos = ParseHead(buf.Data, len, SHM_INDEX_MAGIC_LIST, ipnum, recnum);
+	if(pos == 0)
+		return false;
+	if(IP != 0)
+	{
+		for(uint32_t i = 0; i < ipnum; i++)
+		{
+			if(GetU32(buf.Data + INDEX_HEAD_LEN + i * 4) == IP)
+				return TryRebuild("ip node evicted");
+		}
+		return false;
+	}
+
+	IndexRec rec;
+	for(uint32_t i = 0; i < recnum; i++)
+	{
+		pos = NextRec(buf.Data, len, pos, rec);
+		if(pos == 0)
+			break;
+		if(CompareName(rec.Name, rec.NameLen, ServiceName) == 0)
+			return TryRebuild("service node evicted");
+	}
+	return false;
+}
+
+int CShmIndex::GetService(const string& ServiceName, const std::vector<uint32_t>& Days, std::vector<string>& Attrs, std::vector<uint32_t>& IPs)
+{
+	Flush();
+
+	IndexBuf buf;
+	int len = SHM_INDEX_MAX_LEN;
+	string key(ServiceIndexKey(ServiceName));
+	int ret = ServiceShm.GetNode(key, buf.Data, len);
+	if(ret == 0 && len == 0 && RebuildIfEvicted(ServiceName, 0))
+	{
+		len = SHM_INDEX_MAX_LEN;
+		ret = ServiceShm.GetNode(key, buf.Data, len);
+	}
+	if(ret != 0)
+	{
+		err_log.Write("[Index]GetNode service failed!|%s|%d|%s", ServiceName.c_str(), ret, ServiceShm.GetErrorMsg());
+		return -1;
+	}
+	if(len == 0)
+		return 1;
+
+	uint32_t ipnum = 0;
+	uint32_t recnum = 0;
+	size_t pos = ParseHead(buf.Data, len, SHM_INDEX_MAGIC_SERVICE, ipnum, recnum);
+	if(pos == 0)
+	{
+		err_log.Write("[Index]Bad service node!|%s|%d", ServiceName.c_str(), len);
+		return -2;
+	}
+
+	std::vector<uint32_t> days(Days.size());
+	for(size_t i = 0; i < Days.size(); i++)
+		days[i] = CJudgeProcCenter::DayNum(Days[i]);
+
+	IPs.reserve(ipnum);
+	for(uint32_t i = 0; i < ipnum; i++)
+		IPs.push_back(GetU32(buf.Data + INDEX_HEAD_LEN + i * 4));
+
+	Attrs.reserve(recnum);
+	IndexRec rec;
+	for(uint32_t i = 0; i < recnum; i++)
+	{
+		pos = NextRec(buf.Data, len, pos, rec);
+		if(pos == 0)
+			break;
+		string attrname(rec.Name, rec.NameLen);
+		if(!Days.empty() && !MatchDays(rec, ServiceName, attrname, 0, Days, days))
+			continue;
+		Attrs.push_back(attrname);
+	}
+	return 0;
+}
+
+int CShmIndex::GetIP(uint32_t IP, const std::vector<uint32_t>& Days, std::vector<std::pair<string, std::vector<string> > >& Services)
+{
+	Flush();
+
+	IndexBuf buf;
+	int len = SHM_INDEX_MAX_LEN;
+	string key(IPIndexKey(IP));
+	int ret = ServiceShm.GetNode(key, buf.Data, len);
+	if(ret == 0 && len == 0 && RebuildIfEvicted("", IP))
+	{
+		len = SHM_INDEX_MAX_LEN;
+		ret = ServiceShm.GetNode(key, buf.Data, len);
+	}
+	if(ret != 0)
+	{
+		err_log.Write("[Index]GetNode ip failed!|%s|%d|%s", tce::InetNtoA(IP).c_str(), ret, ServiceShm.GetErrorMsg());
+		return -1;
+	}
+	if(len == 0)
+		return 1;
+
+	uint32_t ipnum = 0;
+	uint32_t recnum = 0;
+	size_t pos = ParseHead(buf.Data, len, SHM_INDEX_MAGIC_IP, ipnum, recnum);
+	if(pos == 0)
+	{
+		err_log.Write("[Index]Bad ip node!|%s|%d", tce::InetNtoA(IP).c_str(), len);
+		return -2;
+	}
+
+	std::vector<uint32_t> days(Days.size());
+	for(size_t i = 0; i < Days.size(); i++)
+		days[i] = CJudgeProcCenter::DayNum(Days[i]);
+
+	//¼svc + 0x03 + attr, ͬһservice
+	IndexRec rec;
+	for(uint32_t i = 0; i < recnum; i++)
+	{
+		pos = NextRec(buf.Data, len, pos, rec);
+		if(pos == 0)
+			break;
+		const char* sep = (const char*)memchr(rec.Name, 0x3, rec.NameLen);
+		if(sep == NULL)
+			continue;
+		string svcname(rec.Name, sep - rec.Name);
+		string attrname(sep + 1, rec.Name + rec.NameLen);
+		if(!Days.empty() && !MatchDays(rec, svcname, attrname, IP, Days, days))
+			continue;
+		//ֻƥԵservice
+		if(Services.empty() || Services.back().first != svcname)
+			Services.push_back(std::make_pair(svcname, std::vector<string>()));
+		Services.back().second.push_back(attrname);
+	}
+	return 0;
+}
+
+int CShmIndex::GetServiceList(std::vector<string>& Services)
+{
+	Flush();
+
+	IndexBuf buf;
+	int len = SHM_INDEX_MAX_LEN;
+	string key(SHM_INDEX_LIST_KEY);
+	int ret = ServiceShm.GetNode(key, buf.Data, len);
+	if(ret == 0 && len == 0 && RebuildIfEvicted("", 0))
+	{
+		len = SHM_INDEX_MAX_LEN;
+		ret = ServiceShm.GetNode(key, buf.Data, len);
+	}
+	if(ret != 0)
+	{
+		err_log.Write("[Index]GetNode list failed!|%d|%s", ret, ServiceShm.GetErrorMsg());
+		return -1;
+	}
+	if(len == 0)
+		return 1;
+
+	uint32_t ipnum = 0;
+	uint32_t recnum = 0;
+	size_t pos = ParseHead(buf.Data, len, SHM_INDEX_MAGIC_LIST, ipnum, recnum);
+	if(pos == 0)
+	{
+		err_log.Write("[Index]Bad list node!|%d", len);
+		return -2;
+	}
+
+	Services.reserve(recnum);
+	IndexRec rec;
+	for(uint32_t i = 0; i < recnum; i++)
+	{
+		pos = NextRec(buf.Data, len, pos, rec);
+		if(pos == 0)
+			break;
+		Services.push_back(string(rec.Name, rec.NameLen));
+	}
+	return 0;
+}
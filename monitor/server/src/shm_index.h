@@ -0,0 +1,131 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  shm_index.h
+ *
+ *    Description:  ServiceShmеĶ, ѯʱٽpbҲ̽DataShm
+ *
+ *        Version:  1.0
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *        Company:  Tencent
+ *
+ * =====================================================================================
+ */
+#ifndef __SHM_INDEX_H__
+#define __SHM_INDEX_H__
+
+#include "tce.h"
+#include "tce_singleton.h"
+#include "tce_lock.h"
+#include "shm_mgr.h"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+
+extern CShmMgr ServiceShm;
+extern CShmMgr DataShm;
+
+/*
+ * ڵԭеpbڵͬServiceShm, keyȼ׺:
+ *   service  MD5(svc + 0x04)      -> ͷ + IPб + Լ¼(attr)
+ *   IP       dwIP + 0x04          -> ͷ + Լ¼(svc + 0x03 + attr)
+ *   serviceб  SHM_INDEX_LIST_KEY   -> ͷ + IPIP + ¼(svc), 
+ * ڵʽ:
+ *   ͷ: dwMagic + dwIPNum + dwRecNum
+ *   IP: dwIP * dwIPNum, 
+ *   ¼: dwLastDay + ddwDayBits + cNameLen + Name, Name
+ * λͼ: dwLastDayΪݵһ(), ddwDayBitskλӦdwLastDay-k
+ * ڵڵһܱServiceShm̭: бжڵ㲻ڼΪ̭, DataShmؽ
+ */
+#define SHM_INDEX_MAGIC_SERVICE		0x53445800	//ֽΪ0, ᱻpb
+#define SHM_INDEX_MAGIC_IP			0x49445800
+#define SHM_INDEX_MAGIC_LIST		0x4C445800
+#define SHM_INDEX_LIST_KEY			string("\0IDXSVC", 7)
+#define SHM_INDEX_DAYS				64			//λͼǵ, زDataShm
+#define SHM_INDEX_MAX_LEN			(512*1024)
+#define SHM_INDEX_FLUSH_NUM			10000		//ϲĸ´ﵽʱд
+#define SHM_INDEX_REBUILD_INTERVAL	600			//ֽڵ㱻̭ؽС()
+
+//ڵ, ؽʹϲĸ
+struct IndexNode
+{
+	uint32_t Magic;
+	string Name;			//serviceڵservice, дб
+	uint32_t IP;			//IPڵIP, дб
+	std::set<uint32_t> IPs;
+	std::map<string, std::pair<uint32_t, uint64_t> > Recs;
+	IndexNode() : Magic(0), IP(0) {}
+};
+
+class CShmIndex
+	: tce::CNonCopyAble
+{
+public:
+	DECLARE_SINGLETON_CLASS(CShmIndex);
+	~CShmIndex() {}
+
+public:
+	//serviceбڵ㲻ʱDataShmȫؽ
+	//RebuildInterval: ֽڵ㱻̭ؽС()
+	bool Init(uint32_t RebuildInterval = SHM_INDEX_REBUILD_INTERVAL);
+
+	//DataShm½ĳĳĽڵ, IPΪ0ʾȫͼ; ֻд̵߳
+	//ȼϲĸ, Flushڵһζд
+	void AddAttrDay(const string& ServiceName, const string& AttrName, uint32_t IP, uint32_t Date);
+	//ѴϲĸдServiceShm; ʱ˳ǰÿβѯǰ
+	void Flush();
+
+	//Daysǿʱֻһݵ; 0ɹ, 1
+	int GetService(const string& ServiceName, const std::vector<uint32_t>& Days, std::vector<string>& Attrs, std::vector<uint32_t>& IPs);
+	//ServicesÿΪservice
+	int GetIP(uint32_t IP, const std::vector<uint32_t>& Days, std::vector<std::pair<string, std::vector<string> > >& Services);
+	//
+	int GetServiceList(std::vector<string>& Services);
+
+	//Ƿڵ, ServiceShmʱ
+	static bool IsIndexNode(const char* Data, int Len);
+
+private:
+	CShmIndex();
+
+	bool Rebuild();
+	//ѯĽڵ㲻ڶбиservice(IPΪ0)IP, ˵̭, ؽ󷵻true
+	bool RebuildIfEvicted(const string& ServiceName, uint32_t IP);
+	//µ÷lock_update
+	bool DoRebuild();
+	//ϴ̭ؽrebuild_intervalؽ, ڴСʱڷȫɨ
+	bool TryRebuild(const char* Reason);
+	void DoFlush();
+	int MergeNode(const string& Key, const IndexNode& Update, size_t& Added);
+
+	mutable tce::CMutex lock_update;	//ϲĸ¼ڵĶд
+	std::map<string, IndexNode> pending;	//key: ڵkey
+	size_t pending_num;
+	uint32_t rebuild_interval;
+	time_t last_rebuild;
+};
+
+#endif
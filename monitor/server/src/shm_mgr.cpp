@@ -19,6 +19,7 @@
 
 #include "shm_mgr.h"
 #include "data.pb.h"
+#include "shm_index.h"
 
 int CShmMgr::Init(MhtInitParam& param, bool getkey, bool&  created)
 {
@@ -57,6 +58,12 @@ int CShmMgr::SetNode(string& key, string& data)
 	return ht.SetData(key.data(), key.size(), data.data(), data.size(), -1, true);
 }
 
+int CShmMgr::EraseNode(string& key)
+{
+	tce::WriteLocker wl(locker);
+	return ht.EraseData(key.data(), key.size());
+}
+
 int CShmMgr::GetData(MhtIterator it, MhtData& data)
 {
 	tce::ReadLocker rl(locker);
@@ -93,7 +100,7 @@ bool CShmMgr::GetAllServiceKeys()
 		{
 			return false;
 		}
-		if(data->klen == 16 && data->dlen > 0) {
+		if(data->klen == 16 && data->dlen > 0 && !CShmIndex::IsIndexNode((char*)data->data, data->dlen)) {
 			msec::monitor::data::ServiceData servicedata;		//Service - 
 
 			if(servicedata.ParseFromArray(data->data, data->dlen))
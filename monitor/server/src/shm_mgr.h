@@ -21,11 +21,20 @@
 #define __SHM_MGR_H__
 
 #include "multi_hash_table.h"
+#include "bucket_hash_table.h"
 #include "tce_lock.h"
 #include <set> 
 
 const static size_t value_fixed_len = 128*2 + 1440*4;
 
+//ʱSHM_BUCKET_HASH÷鿪ѰַBucketHashTable,
+//ߵĹڴʽ, лǰdumpɾɵĹڴ
+#ifdef SHM_BUCKET_HASH
+typedef BucketHashTable ShmHashTable;
+#else
+typedef MultiHashTable ShmHashTable;
+#endif
+
 class CShmMgr
 {
 public:
@@ -35,6 +44,7 @@ public:
 	int SetNode(string& key, string& data);
 	int SetNode(string& key, const char* data, size_t size, int version);
 	int	SetServiceNode(const string& real_key, string& index_key, string& data);
+	int EraseNode(string& key);
 	void GetKeys(std::set<string>& keys_);
 	int GetData(MhtIterator it, MhtData& data);
 	int KeysSize() { return keys.size(); };
@@ -45,10 +55,12 @@ public:
 private:
 	bool GetAllServiceKeys();
 	mutable tce::ReadWriteLocker locker;
-	MultiHashTable ht;
+	ShmHashTable ht;
 	std::set<string> keys;
 
 	friend class CDumpProcCenter;
+	friend class CShmIndex;
+	friend class CAttrIdMgr;
 };
 
 #endif
@@ -0,0 +1,142 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License"); 
+ * you may not use this file except in compliance with the License. You may 
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the 
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+//澯صдʧ: дʧܵĸ澯ܱȥ̵, һҪд
+#include <stdio.h>
+#include <set>
+#include "alarm_sink.h"
+#include "log_def.h"
+
+tce::CFileLog msg_log;
+tce::CFileLog err_log;
+
+#define CHECK(exp) do { if(!(exp)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #exp); return 1; } } while(0)
+
+//chunkһд, ͬCMySqlAlarmBackendķinsert; fail_chunkдʧ
+class CFailBackend : public CAlarmBackend {
+public:
+	CFailBackend() : fail(true), chunk(1000), fail_chunk(-1) {}
+	const char* Name() const { return "fail"; }
+	bool Write(const vector<AlarmRecord>& Records, vector<AlarmRecord>& Failed, string& err)
+	{
+		if(fail)
+		{
+			err = "backend down";
+			Failed.insert(Failed.end(), Records.begin(), Records.end());
+			return false;
+		}
+		bool ok = true;
+		for(size_t begin = 0; begin < Records.size(); begin += chunk)
+		{
+			size_t end = begin + chunk < Records.size() ? begin + chunk : Records.size();
+			if((int)(begin / chunk) == fail_chunk)
+			{
+				err = "chunk failed";
+				ok = false;
+				Failed.insert(Failed.end(), Records.begin() + begin, Records.begin() + end);
+				continue;
+			}
+			rows.insert(rows.end(), Records.begin() + begin, Records.begin() + end);
+		}
+		return ok;
+	}
+
+	bool fail;
+	size_t chunk;
+	int fail_chunk;
+	vector<AlarmRecord> rows;
+};
+
+//ͬһ澯(++)ںֻһ
+static bool NoDuplicate(const vector<AlarmRecord>& Rows)
+{
+	std::set<AlarmKey> keys;
+	for(size_t i = 0; i < Rows.size(); ++i)
+	{
+		AlarmKey key;
+		key.ServiceName = Rows[i].ServiceName;
+		key.AttrName = Rows[i].AttrName;
+		key.AlarmTime = Rows[i].AlarmTime;
+		key.Type = Rows[i].Type;
+		if(!keys.insert(key).second)
+			return false;
+	}
+	return true;
+}
+
+int main()
+{
+	CFailBackend* backend = new CFailBackend;
+	CAlarmSink& sink = CAlarmSink::GetInstance();
+	//дֻ߳Stopʱд, ɱԵFlush
+	CHECK(sink.Init(backend, 1000000, 0xFFFFFFFF));
+
+	sink.Add("svc", "attr1", 600, AT_MAX, 10, 5);
+	sink.Add("svc", "attr2", 600, AT_MIN, 1, 5);
+	CHECK(sink.GetPendingSize() == 2);
+
+	//дʧ: ȫŻشд
+	sink.Flush();
+	CHECK(backend->rows.empty());
+	CHECK(sink.GetPendingSize() == 2);
+
+	//ǰͬһ澯, ϲһ, ֵ
+	sink.Add("svc", "attr1", 600, AT_MAX, 12, 5);
+	CHECK(sink.GetPendingSize() == 2);
+
+	//˻ָ: д, ȥضʧ
+	backend->fail = false;
+	sink.Flush();
+	CHECK(backend->rows.size() == 2);
+	CHECK(sink.GetPendingSize() == 0);
+	for(size_t i = 0; i < backend->rows.size(); ++i)
+	{
+		const AlarmRecord& r = backend->rows[i];
+		if(r.AttrName == "attr1")
+		{
+			CHECK(r.Value == 12);
+			CHECK(r.Count == 2);
+		}
+	}
+
+	//дɹͬһ澯ȥ
+	sink.Add("svc", "attr2", 600, AT_MIN, 2, 5);
+	sink.Flush();
+	CHECK(backend->rows.size() == 2);
+
+	//3д, ֻмһʧ: ֻмһ, ǰ鲻ظд
+	backend->chunk = 2;
+	backend->fail_chunk = 1;
+	const char* attrs[] = {"a1", "a2", "a3", "a4", "a5", "a6"};
+	for(size_t i = 0; i < sizeof(attrs)/sizeof(attrs[0]); ++i)
+		sink.Add("svc", attrs[i], 660, AT_MAX, 10, 5);
+	sink.Flush();
+	CHECK(backend->rows.size() == 2 + 4);
+	CHECK(sink.GetPendingSize() == 2);
+
+	backend->fail_chunk = -1;
+	sink.Flush();
+	CHECK(backend->rows.size() == 2 + 6);
+	CHECK(sink.GetPendingSize() == 0);
+	CHECK(NoDuplicate(backend->rows));
+
+	sink.Stop();
+	printf("test_alarm_sink ok\n");
+	return 0;
+}
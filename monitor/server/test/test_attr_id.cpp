@@ -0,0 +1,104 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License"); 
+ * you may not use this file except in compliance with the License. You may 
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the 
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+//ID: MD5ʽǨ, ̭IDڵд
+#include "test_env.h"
+#include "attr_id.h"
+
+#define DATE1	20161001
+
+static uint32_t IP1 = 0x0100007F;
+
+//ɸʽ: MD5(svc + 0x03 + attr) + [ dwIP ] + dwDay, 16ֽڴMD5
+static bool AddOldData(char Seed, const string& ServiceName, const string& AttrName, uint32_t IP, uint32_t Date)
+{
+	string key(16, Seed);
+	if(IP != 0)
+		key.append((char*)&IP, sizeof(uint32_t));
+	key.append((char*)&Date, sizeof(uint32_t));
+	string value(value_fixed_len, '\0');
+	value.replace(0, ServiceName.size(), ServiceName);
+	value.replace(128, AttrName.size(), AttrName);
+	value[256] = 7;
+	return DataShm.SetNode(key, value) == 0;
+}
+
+static string IdNodeKey(uint32_t Id)
+{
+	string key(ATTR_ID_NODE_PREFIX);
+	key.append((char*)&Id, sizeof(uint32_t));
+	return key;
+}
+
+int main()
+{
+	CHECK(InitTestShm());
+	CHECK(AddOldData('x', "svcA", "attr1", 0, DATE1));
+	CHECK(AddOldData('x', "svcA", "attr1", IP1, DATE1));
+	CHECK(AddOldData('y', "svcB", "attr2", IP1, DATE1));
+
+	CAttrIdMgr& idmgr = CAttrIdMgr::GetInstance();
+	CHECK(idmgr.Init());
+	CHECK(idmgr.GetEpoch() != 0);
+
+	uint32_t id1 = idmgr.Find("svcA", "attr1");
+	uint32_t id2 = idmgr.Find("svcB", "attr2");
+	CHECK(id1 != ATTR_ID_NONE && id2 != ATTR_ID_NONE && id1 != id2);
+
+	//keyȫǨΪIDʽ, ԭ
+	string key;
+	char data[value_fixed_len];
+	int data_len = sizeof(data);
+	key = CAttrIdMgr::DataKey(id1, 0, DATE1);
+	CHECK(DataShm.GetNode(key, data, data_len) == 0 && data_len == value_fixed_len && data[256] == 7);
+	key = CAttrIdMgr::DataKey(id1, IP1, DATE1);
+	CHECK(DataShm.HasKey(key));
+	key = CAttrIdMgr::DataKey(id2, IP1, DATE1);
+	CHECK(DataShm.HasKey(key));
+	for(char seed = 'x'; seed <= 'y'; seed++)
+	{
+		string oldkey(16, seed);
+		oldkey.append((char*)&IP1, sizeof(uint32_t));
+		uint32_t day = DATE1;
+		oldkey.append((char*)&day, sizeof(uint32_t));
+		CHECK(!DataShm.HasKey(oldkey));
+	}
+
+	//ServiceShm̭˱ͷIDڵ, вӰ, Repairд
+	string hkey(ATTR_ID_HEAD_KEY);
+	string nkey(IdNodeKey(id1));
+	CHECK(ServiceShm.EraseNode(hkey) == 0);
+	CHECK(ServiceShm.EraseNode(nkey) == 0);
+	string svc, attr;
+	CHECK(idmgr.GetName(id1, svc, attr) && svc == "svcA" && attr == "attr1");
+	CHECK(idmgr.Repair() == 2);
+	CHECK(ServiceShm.HasKey(hkey) && ServiceShm.HasKey(nkey));
+	CHECK(idmgr.Repair() == 0);
+
+	//¼غIDepoch
+	uint32_t epoch = idmgr.GetEpoch();
+	CHECK(idmgr.Init());
+	CHECK(idmgr.GetEpoch() == epoch);
+	CHECK(idmgr.Find("svcA", "attr1") == id1 && idmgr.Find("svcB", "attr2") == id2);
+	CHECK(idmgr.Intern("svcC", "attr3") > id2);
+
+	FiniTestShm();
+	printf("test_attr_id ok\n");
+	return 0;
+}
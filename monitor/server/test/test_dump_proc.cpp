@@ -0,0 +1,125 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License"); 
+ * you may not use this file except in compliance with the License. You may 
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the 
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+//dumpʧܺ, ʧڼ޸Ĳ, ճ
+#include "test_env.h"
+#include "dump_proc_center.h"
+#include "attr_id.h"
+#include <fstream>
+#include <sys/stat.h>
+
+#define TEST_DUMP_DIR	"./test_dump"
+#define TEST_DUMP_PATH	TEST_DUMP_DIR "/monitor.dump"
+#define DATE1	20161001
+
+static bool SetValue(const string& AttrName, uint32_t Value)
+{
+	uint32_t id = CAttrIdMgr::GetInstance().Intern("svcA", AttrName);
+	if(id == ATTR_ID_NONE)
+		return false;
+	string key(CAttrIdMgr::DataKey(id, 0x0100007F, DATE1));
+	string value(value_fixed_len, '\0');
+	value.replace(0, 4, "svcA");
+	value.replace(128, AttrName.size(), AttrName);
+	memcpy(&value[256], &Value, sizeof(uint32_t));
+	if(DataShm.SetNode(key, value) != 0)
+		return false;
+	CDumpProcCenter::GetInstance().MarkDirty(key);
+	return true;
+}
+
+//ļкAttrName, Ϊ"#gen N"ʱȡ
+static int CountLines(const string& Path, const string& AttrName, uint32_t* Gen = NULL)
+{
+	ifstream fin(Path.c_str());
+	if(!fin)
+		return -1;
+	string line;
+	int count = 0;
+	while(getline(fin, line))
+	{
+		if(Gen != NULL && line.compare(0, strlen(DUMP_GEN_HEAD), DUMP_GEN_HEAD) == 0)
+			*Gen = strtoul(line.c_str() + strlen(DUMP_GEN_HEAD), NULL, 10);
+		if(line.find(" " + AttrName + " ") != string::npos)
+			++count;
+	}
+	return count;
+}
+
+static void CleanDir()
+{
+	unlink(TEST_DUMP_PATH);
+	unlink(TEST_DUMP_PATH DUMP_DELTA_SUFFIX);
+	rmdir(TEST_DUMP_PATH ".new");
+	rmdir(TEST_DUMP_DIR);
+}
+
+int main()
+{
+	CHECK(InitTestShm());
+	CHECK(CAttrIdMgr::GetInstance().Init());
+	CleanDir();
+
+	CDumpProcCenter& dump = CDumpProcCenter::GetInstance();
+	CHECK(dump.Init(TEST_DUMP_PATH, 1, 1000000));
+	CHECK(SetValue("attr1", 1));
+
+	//Ŀ¼, ״ȫʧ, ֮
+	CHECK(dump.Start());
+	sleep(2);
+	CHECK(access(TEST_DUMP_PATH, F_OK) != 0);
+	CHECK(mkdir(TEST_DUMP_DIR, 0755) == 0);
+	sleep(3);
+	uint32_t gen = 0;
+	CHECK(CountLines(TEST_DUMP_PATH, "attr1", &gen) == 1);
+	CHECK(gen == 1);
+	CHECK(CountLines(TEST_DUMP_PATH DUMP_DELTA_SUFFIX, "attr1") == 0);
+
+	//
+	CHECK(SetValue("attr2", 2));
+	sleep(3);
+	CHECK(CountLines(TEST_DUMP_PATH DUMP_DELTA_SUFFIX, "attr2") == 1);
+
+	//ȫʧ(.newռ), ȡ޸ķŻ, д
+	CHECK(mkdir(TEST_DUMP_PATH ".new", 0755) == 0);
+	CHECK(SetValue("attr3", 3));
+	dump.SetDumpOn();
+	sleep(3);
+	gen = 0;
+	CHECK(CountLines(TEST_DUMP_PATH, "attr3", &gen) == 0);
+	CHECK(gen == 1);
+	CHECK(CountLines(TEST_DUMP_PATH DUMP_DELTA_SUFFIX, "attr3") == 1);
+	CHECK(SetValue("attr4", 4));
+	sleep(3);
+	CHECK(CountLines(TEST_DUMP_PATH DUMP_DELTA_SUFFIX, "attr4") == 1);
+
+	//ָԳɹ, ȫ, ؽ
+	CHECK(rmdir(TEST_DUMP_PATH ".new") == 0);
+	sleep(3);
+	gen = 0;
+	CHECK(CountLines(TEST_DUMP_PATH, "attr4", &gen) == 1);
+	CHECK(gen == 2);
+	CHECK(CountLines(TEST_DUMP_PATH DUMP_DELTA_SUFFIX, "attr4") == 0);
+
+	dump.Stop();
+	CleanDir();
+	FiniTestShm();
+	printf("test_dump_proc ok\n");
+	return 0;
+}
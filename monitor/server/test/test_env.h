@@ -0,0 +1,91 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License"); 
+ * you may not use this file except in compliance with the License. You may 
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the 
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+//ԪԹ: serverȫֶͲùڴ, ֻڲԵmainļаһ
+#ifndef __TEST_ENV_H__
+#define __TEST_ENV_H__
+
+#include <stdio.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "shm_mgr.h"
+#include "proc_def.h"
+#include "log_def.h"
+
+tce::CFileLog msg_log;
+tce::CFileLog err_log;
+SConfig stConfig;
+CShmMgr ServiceShm;
+CShmMgr DataShm;
+
+#define TEST_SERVICE_SHM_KEY	0x7E5E0001
+#define TEST_DATA_SHM_KEY		0x7E5E0002
+
+#define CHECK(exp) do { if(!(exp)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #exp); fflush(stdout); return 1; } } while(0)
+
+static void RemoveShm(key_t Key)
+{
+	int id = shmget(Key, 0, 0);
+	if(id >= 0)
+		shmctl(id, IPC_RMID, NULL);
+}
+
+static void FiniTestShm()
+{
+	RemoveShm(TEST_SERVICE_SHM_KEY);
+	RemoveShm(TEST_DATA_SHM_KEY);
+}
+
+//½յServiceShmDataShm, InitShmͬ
+static bool InitTestShm()
+{
+	FiniTestShm();
+
+	bool created = false;
+	MhtInitParam param_service;
+	memset((char*)&param_service, 0, sizeof(MhtInitParam));
+	param_service.cMaxKeyLen = 16;
+	param_service.ddwShmKey = TEST_SERVICE_SHM_KEY;
+	param_service.ddwBufferSize = 16*1024*1024;
+	param_service.dwExpiryRatio = 95;
+	int ret = ServiceShm.Init(param_service, true, created);
+	if(ret != 0)
+	{
+		printf("init service shm failed|%d|%s\n", ret, ServiceShm.GetErrorMsg());
+		return false;
+	}
+
+	MhtInitParam param_data;
+	memset((char*)&param_data, 0, sizeof(MhtInitParam));
+	param_data.cMaxKeyLen = 24;
+	param_data.ddwShmKey = TEST_DATA_SHM_KEY;
+	param_data.ddwBufferSize = 32*1024*1024;
+	param_data.dwIndexRatio = 100;
+	param_data.ddwBlockSize = value_fixed_len+8;
+	param_data.dwExpiryRatio = 95;
+	ret = DataShm.Init(param_data, false, created);
+	if(ret != 0)
+	{
+		printf("init data shm failed|%d|%s\n", ret, DataShm.GetErrorMsg());
+		return false;
+	}
+	return true;
+}
+
+#endif
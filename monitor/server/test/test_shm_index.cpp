@@ -0,0 +1,201 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License"); 
+ * you may not use this file except in compliance with the License. You may 
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the 
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+//ServiceShm: DataShmؽ, , , , ڵ㱻̭ؽ
+#include "test_env.h"
+#include "shm_index.h"
+#include "attr_id.h"
+#include "judge_proc_center.h"
+
+#define DATE1	20161001
+#define DATE2	20161002
+
+static uint32_t IP1 = 0x0100007F;
+
+static bool AddData(const string& ServiceName, const string& AttrName, uint32_t IP, uint32_t Date)
+{
+	uint32_t id = CAttrIdMgr::GetInstance().Intern(ServiceName, AttrName);
+	if(id == ATTR_ID_NONE)
+		return false;
+	string key(CAttrIdMgr::DataKey(id, IP, Date));
+	string value(value_fixed_len, '\0');
+	value.replace(0, ServiceName.size(), ServiceName);
+	value.replace(128, AttrName.size(), AttrName);
+	return DataShm.SetNode(key, value) == 0;
+}
+
+static bool EraseIndexNode(const string& Key)
+{
+	string key(Key);
+	return ServiceShm.EraseNode(key) == 0;
+}
+
+static bool HasAttr(const std::vector<string>& Attrs, const string& AttrName)
+{
+	for(size_t i = 0; i < Attrs.size(); i++)
+	{
+		if(Attrs[i] == AttrName)
+			return true;
+	}
+	return false;
+}
+
+int main()
+{
+	CHECK(InitTestShm());
+	CHECK(CAttrIdMgr::GetInstance().Init());
+
+	//svcattrDataShmи128ֽ, IPƿɴ257ֽ
+	string longsvc(127, 's');
+	string longattr(128, 'a');
+
+	CHECK(AddData("svcA", "attr1", 0, DATE1));
+	CHECK(AddData("svcA", "attr1", IP1, DATE1));
+	CHECK(AddData("svcA", "attr2", 0, DATE2));
+	CHECK(AddData("svcA", "attr2", IP1, DATE2));
+	CHECK(AddData("svcB", "attr1", 0, DATE1));
+	CHECK(AddData("svcB", "attr1", IP1, DATE1));
+	CHECK(AddData(longsvc, longattr, 0, DATE1));
+	CHECK(AddData(longsvc, longattr, IP1, DATE1));
+
+	//ûбڵ, DataShmؽ
+	CShmIndex& index = CShmIndex::GetInstance();
+	CHECK(index.Init(0));
+
+	std::vector<string> services;
+	CHECK(index.GetServiceList(services) == 0);
+	CHECK(services.size() == 3);
+	CHECK(services[0] == longsvc && services[1] == "svcA" && services[2] == "svcB");
+
+	std::vector<uint32_t> days;
+	std::vector<string> attrs;
+	std::vector<uint32_t> ips;
+	CHECK(index.GetService("svcA", days, attrs, ips) == 0);
+	CHECK(attrs.size() == 2 && attrs[0] == "attr1" && attrs[1] == "attr2");
+	CHECK(ips.size() == 1 && ips[0] == IP1);
+
+	attrs.clear();
+	ips.clear();
+	days.push_back(DATE2);
+	CHECK(index.GetService("svcA", days, attrs, ips) == 0);
+	CHECK(attrs.size() == 1 && attrs[0] == "attr2");
+
+	//ƲIP, ¼
+	std::vector<std::pair<string, std::vector<string> > > ipsvcs;
+	days.clear();
+	CHECK(index.GetIP(IP1, days, ipsvcs) == 0);
+	CHECK(ipsvcs.size() == 2);
+	CHECK(ipsvcs[0].first == "svcA" && ipsvcs[0].second.size() == 2);
+	CHECK(ipsvcs[1].first == "svcB" && ipsvcs[1].second.size() == 1);
+
+	//˺ûԵservice
+	ipsvcs.clear();
+	days.push_back(DATE2);
+	CHECK(index.GetIP(IP1, days, ipsvcs) == 0);
+	CHECK(ipsvcs.size() == 1);
+	CHECK(ipsvcs[0].first == "svcA" && ipsvcs[0].second.size() == 1 && ipsvcs[0].second[0] == "attr2");
+
+	//: нڵ, ±
+	index.AddAttrDay("svcA", "attr0", IP1, DATE2);
+	index.AddAttrDay("svcC", "attr1", 0, DATE2);
+	index.AddAttrDay(longsvc, longattr, IP1, DATE2);
+
+	ipsvcs.clear();
+	CHECK(index.GetIP(IP1, days, ipsvcs) == 0);
+	CHECK(ipsvcs.size() == 1);
+	CHECK(ipsvcs[0].second.size() == 2);
+	CHECK(ipsvcs[0].second[0] == "attr0" && ipsvcs[0].second[1] == "attr2");
+
+	attrs.clear();
+	ips.clear();
+	CHECK(index.GetService("svcC", days, attrs, ips) == 0);
+	CHECK(HasAttr(attrs, "attr1"));
+
+	services.clear();
+	CHECK(index.GetServiceList(services) == 0);
+	CHECK(services.size() == 4 && services[3] == "svcC");
+
+	//ϲ: ͬһڵĶһд, ʱм¼ֻλͼ
+	char name[32];
+	for(int i = 0; i < 300; i++)
+	{
+		snprintf(name, sizeof(name), "attr%03d", 299 - i);
+		index.AddAttrDay("svcD", name, 0, DATE1);
+		index.AddAttrDay("svcD", name, IP1, DATE1);
+	}
+	for(int i = 0; i < 300; i += 2)
+	{
+		snprintf(name, sizeof(name), "attr%03d", i);
+		index.AddAttrDay("svcD", name, 0, DATE2);
+	}
+	attrs.clear();
+	ips.clear();
+	days.clear();
+	CHECK(index.GetService("svcD", days, attrs, ips) == 0);
+	CHECK(attrs.size() == 300 && attrs[0] == "attr000" && attrs[299] == "attr299");
+	CHECK(ips.size() == 1 && ips[0] == IP1);
+	attrs.clear();
+	ips.clear();
+	days.push_back(DATE2);
+	CHECK(index.GetService("svcD", days, attrs, ips) == 0);
+	CHECK(attrs.size() == 150 && attrs[1] == "attr002");
+	days.clear();
+
+	//ѯʱserviceڵ㱻̭(б): DataShmؽ
+	string svcakey("svcA");
+	svcakey.append(1u, 0x4);
+	CHECK(EraseIndexNode(tce::TC_MD5::md5bin(svcakey)));
+	attrs.clear();
+	ips.clear();
+	CHECK(index.GetService("svcA", days, attrs, ips) == 0);
+	CHECK(attrs.size() == 2 && attrs[0] == "attr1" && attrs[1] == "attr2");
+	CHECK(ips.size() == 1 && ips[0] == IP1);
+
+	//IPڵ㱻̭(биIP)ͬؽ
+	string ipkey((char*)&IP1, sizeof(uint32_t));
+	ipkey.append(1u, 0x4);
+	CHECK(EraseIndexNode(ipkey));
+	ipsvcs.clear();
+	CHECK(index.GetIP(IP1, days, ipsvcs) == 0);
+	CHECK(ipsvcs.size() == 2 && ipsvcs[0].first == "svcA" && ipsvcs[1].first == "svcB");
+
+	//ûбеIP鲻, ؽ
+	ipsvcs.clear();
+	CHECK(index.GetIP(0x0200007F, days, ipsvcs) == 1);
+
+	//дʱ½Ľڵб: ڵ㱻̭, ؽһԭ
+	string svcbkey("svcB");
+	svcbkey.append(1u, 0x4);
+	CHECK(EraseIndexNode(tce::TC_MD5::md5bin(svcbkey)));
+	CHECK(AddData("svcB", "attr3", 0, DATE2));
+	index.AddAttrDay("svcB", "attr3", 0, DATE2);
+	index.Flush();
+	int len = SHM_INDEX_MAX_LEN;
+	std::vector<char> buf(len);
+	string svcbindex(tce::TC_MD5::md5bin(svcbkey));
+	CHECK(ServiceShm.GetNode(svcbindex, &buf[0], len) == 0 && len > 0);
+	attrs.clear();
+	ips.clear();
+	CHECK(index.GetService("svcB", days, attrs, ips) == 0);
+	CHECK(attrs.size() == 2 && attrs[0] == "attr1" && attrs[1] == "attr3");
+
+	FiniTestShm();
+	printf("test_shm_index ok\n");
+	return 0;
+}
@@ -217,6 +217,54 @@ void swap_server_info(struct server_info *server1, struct server_info *server2)
     memcpy(server2, &server_tmp, sizeof(struct server_info));
 }
 
+/**
+ * @brief  查找服务器在多阶hash中的位置
+ * @info   按calc_servers_hash的插入顺序逐阶查找下标为idx的槽位
+ * @return 槽位地址，没有找到返回NULL
+ */
+uint32_t *get_server_hash_slot(struct shm_servers *servers, uint32_t ip, uint32_t idx)
+{
+    uint32_t i, base = 0;
+    uint32_t *slot;
+
+    for (i = 0; i < servers->mhash_order; i++) {
+        slot = &servers->mhash_idx[base + ip%servers->mhash_mods[i]];
+        if (*slot == idx) {
+            return slot;
+        }
+
+        base += servers->mhash_mods[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 交换两个服务器的位置
+ * @info  同时修改多阶hash中这两个服务器的下标，不需要重新计算整个hash
+ */
+void swap_servers(struct shm_servers *servers, uint32_t idx1, uint32_t idx2)
+{
+    uint32_t *slot1, *slot2;
+
+    if (idx1 == idx2) {
+        return;
+    }
+
+    slot1 = get_server_hash_slot(servers, servers->svrs[idx1].server_ip, idx1);
+    slot2 = get_server_hash_slot(servers, servers->svrs[idx2].server_ip, idx2);
+
+    swap_server_info(&servers->svrs[idx1], &servers->svrs[idx2]);
+
+    if (slot1) {
+        *slot1 = idx2;
+    }
+
+    if (slot2) {
+        *slot2 = idx1;
+    }
+}
+
 /**
  * @brief 计算服务器的权重信息
  */
@@ -273,7 +321,7 @@ void _shaping_servers(struct shm_servers *servers, double success_ratio_base, bo
         if (!single_req_total) {
             if (server->dead_time) {
                 server->weight_dynamic = 0;
-                swap_server_info(server, &servers->svrs[end]);
+                swap_servers(servers, begin, end);
                 end--;
             } else {
                 begin++;
@@ -314,7 +362,7 @@ void _shaping_servers(struct shm_servers *servers, double success_ratio_base, bo
             }
 
             server->weight_dynamic  = 0;
-            swap_server_info(server, &servers->svrs[end]);
+            swap_servers(servers, begin, end);
             end--;
             continue;
         }
@@ -335,7 +383,7 @@ void _shaping_servers(struct shm_servers *servers, double success_ratio_base, bo
                 server->dead_time = get_time_ms();
             }
 
-            swap_server_info(server, &servers->svrs[end]);
+            swap_servers(servers, begin, end);
             end--;
             continue;
         }
@@ -545,6 +593,11 @@ void copy_servers(struct shm_servers *dst_svrs, struct shm_servers *src_svrs, ui
         dst_svrs->weight_low_num        = src_svrs->weight_low_num;
     }
 
+    /* 多阶hash直接拷贝，shaping时交换服务器位置再增量修改 */
+    dst_svrs->mhash_order = src_svrs->mhash_order;
+    memcpy(dst_svrs->mhash_mods, src_svrs->mhash_mods, sizeof(dst_svrs->mhash_mods));
+    memcpy(dst_svrs->mhash_idx, src_svrs->mhash_idx, sizeof(dst_svrs->mhash_idx));
+
     for (i = 0; i < svr_num; i++) {
         dst_svr = &dst_svrs->svrs[i];
         src_svr = &src_svrs->svrs[i];
@@ -807,6 +860,67 @@ void dumpinfo(struct agent_local_rdata *rdata)
 }
 
 
+/**
+ * @brief 检查新计算的服务器顺序是否和共享内存中一致
+ * @info  一致时只有权重和死机信息变化，可以原地更新
+ */
+bool check_servers_order(const struct shm_servers *servers, const struct shm_servers *shm_servers)
+{
+    uint32_t i;
+
+    if (servers->server_num != shm_servers->server_num) {
+        return false;
+    }
+
+    for (i = 0; i < servers->server_num; i++) {
+        if (servers->svrs[i].server_ip != shm_servers->svrs[i].server_ip) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 原地更新当前寻址的服务器数据
+ * @info  只写有变化的权重和死机信息，API读的时候用顺序锁检查是否读到更新中的数据；
+ *        统计数据在copy_servers时已经原子清零，不需要合并
+ */
+void update_servers_inplace(struct shm_servers *shm_servers, const struct shm_servers *servers)
+{
+    uint32_t i;
+    struct server_info *dst_svr;
+    const struct server_info *src_svr;
+
+    seq_write_begin(&shm_servers->seq);
+
+    shm_servers->cost_total         = servers->cost_total;
+    shm_servers->success_total      = servers->success_total;
+    shm_servers->fail_total         = servers->fail_total;
+    shm_servers->dead_num           = servers->dead_num;
+    shm_servers->dead_retry_times   = servers->dead_retry_times;
+    shm_servers->weight_total       = servers->weight_total;
+    shm_servers->weight_dead_base   = servers->weight_dead_base;
+    shm_servers->weight_low_num     = servers->weight_low_num;
+
+    for (i = 0; i < servers->server_num; i++) {
+        dst_svr = &shm_servers->svrs[i];
+        src_svr = &servers->svrs[i];
+
+        if ((dst_svr->weight_base == src_svr->weight_base)
+            && (dst_svr->weight_dynamic == src_svr->weight_dynamic)
+            && (dst_svr->dead_time == src_svr->dead_time)) {
+            continue;
+        }
+
+        dst_svr->weight_base    = src_svr->weight_base;
+        dst_svr->weight_dynamic = src_svr->weight_dynamic;
+        dst_svr->dead_time      = src_svr->dead_time;
+    }
+
+    seq_write_end(&shm_servers->seq);
+}
+
 /**
  * @brief 更新业务配置
  * @param new_shm_servers --> 新加载的服务器信息
@@ -839,6 +953,9 @@ int32_t update_config(struct agent_local_rdata *rdata, struct shm_servers *new_s
         data_len    = sizeof(struct shm_servers) + sizeof(struct server_info) * server_num;
         meta->mtime = mtime;
         copy_specified_servers(servers, cur_shm_servers, servers->shaping_request_min);
+
+        /* 新配置需要计算hash，处理节点事件和shaping时要用hash */
+        calc_servers_hash(servers);
     } else {
         server_num  = cur_shm_servers->server_num;
         data_len    = sizeof(struct shm_servers) + sizeof(struct server_info) * server_num;
@@ -850,7 +967,7 @@ int32_t update_config(struct agent_local_rdata *rdata, struct shm_servers *new_s
             return -1;
         }
 
-        /* 拷贝所有共享内存服务器信息到私有内存，同时计算统计信息 */
+        /* 拷贝所有共享内存服务器信息到私有内存，同时计算统计信息，hash也一起拷贝 */
         copy_servers(servers, cur_shm_servers, servers->shaping_request_min);
         if (!servers->server_num) {
             free(servers);
@@ -858,11 +975,8 @@ int32_t update_config(struct agent_local_rdata *rdata, struct shm_servers *new_s
         }
     }
 
-    /* 处理节点事件 */
+    /* 处理节点事件(死机和恢复) */
     if (!list_empty(event_list)) {
-        /* 计算hash，处理节点事件时，需要用hash做查找 */
-        calc_servers_hash(servers);
-        /* 处理节点事件(死机和恢复) */
         handle_node_events(servers, &rdata->event_list);
     }
 
@@ -875,8 +989,15 @@ int32_t update_config(struct agent_local_rdata *rdata, struct shm_servers *new_s
     /* 统一计算每一个服务器的权重基数，以及死机机器的权重 */
     calc_servers_weight(servers);
 
-    /* 计算多阶hash */
-    calc_servers_hash(servers);
+    /* 服务器顺序没变，只有权重变化，直接原地更新当前数据，不用整个拷贝到备用文件
+     * 老版本数据需要走一次完整更新，把新版本的参数写进去 */
+    if ((NULL == new_shm_servers) && (cur_shm_servers->version == NLB_SHM_VERSION1)
+        && check_servers_order(servers, cur_shm_servers)) {
+        update_servers_inplace(cur_shm_servers, servers);
+        free(servers);
+        NLOG_DEBUG("update service [%s] config inplace end", rdata->name);
+        return 0;
+    }
 
     /* 拷贝新服务器数据到共享内存 */
     memcpy(next_shm_servers, servers, data_len);
@@ -22,7 +22,7 @@
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/time.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -31,6 +31,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <errno.h>
 #include "log.h"
 #include "config.h"
 #include "nlbapi.h"
@@ -43,6 +44,8 @@
 /* 网络管理数据结构 */
 struct netmng {
     uint64_t timeout;
+    int32_t  epfd;
+    int32_t  zk_fd;
     int32_t  zk_revents;
     int32_t  listen_fd;
     int32_t  listen_revents;
@@ -50,6 +53,8 @@ struct netmng {
 
 static struct netmng net_mng = {
     .timeout        = 10,        /* 默认10毫秒超时 */
+    .epfd           = -1,        /* epoll fd */
+    .zk_fd          = -1,        /* 已注册到epoll的ZK fd */
     .zk_revents     = 0,         /* ZK fd事件 */
     .listen_fd      = -1,        /* agent监听fd */
     .listen_revents = 0,         /* 监听fd事件 */
@@ -69,6 +74,14 @@ int32_t network_init(void)
 {
     int32_t  ret;
     int32_t  fd;
+    struct epoll_event ev;
+
+    /* zookeeper和路由请求fd都用epoll监听 */
+    net_mng.epfd = epoll_create(4);
+    if (net_mng.epfd < 0) {
+        NLOG_ERROR("Create epoll fd failed, [%m]");
+        return -4;
+    }
 
     /* 初始化zookeeper */
     ret = nlb_zk_init(get_zk_host(), get_zk_timeout());
@@ -96,26 +109,72 @@ int32_t network_init(void)
         return -3;
     }
 
+    memset(&ev, 0, sizeof(ev));
+    ev.events  = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(net_mng.epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        NLOG_ERROR("Add listen fd to epoll failed, [%m]");
+        return -5;
+    }
+
     net_mng.listen_fd = fd;
 
     return 0;
 }
 
+/**
+ * @brief 更新zookeeper fd在epoll中的关注事件
+ * @info  zookeeper断线重连时会关闭旧fd，新fd可能复用同一个fd号，而close时epoll里的
+ *        注册已经自动删除，所以每次都先MOD，不存在时再ADD
+ */
+static int32_t network_update_zk(int32_t zkfd, int32_t zk_events)
+{
+    struct epoll_event ev;
+
+    /* fd变了，删除旧的注册，旧fd可能已经关闭，不判断返回值 */
+    if ((net_mng.zk_fd != -1) && (net_mng.zk_fd != zkfd)) {
+        epoll_ctl(net_mng.epfd, EPOLL_CTL_DEL, net_mng.zk_fd, NULL);
+        net_mng.zk_fd = -1;
+    }
+
+    if (zkfd == -1) {
+        return 0;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.data.fd = zkfd;
+    if (zk_events & NLB_POLLIN) {
+        ev.events |= EPOLLIN;
+    }
+
+    if (zk_events & NLB_POLLOUT) {
+        ev.events |= EPOLLOUT;
+    }
+
+    if (epoll_ctl(net_mng.epfd, EPOLL_CTL_MOD, zkfd, &ev) < 0) {
+        if ((errno != ENOENT)
+            || (epoll_ctl(net_mng.epfd, EPOLL_CTL_ADD, zkfd, &ev) < 0)) {
+            NLOG_ERROR("Update zookeeper fd [%d] in epoll failed, [%m]", zkfd);
+            return -1;
+        }
+    }
+
+    net_mng.zk_fd = zkfd;
+
+    return 0;
+}
+
 /**
  * @brief  监听网络事件
  * @info   监听zookeeper和路由请求
  */
 int32_t network_poll(void)
 {
-    int32_t  ret;
-    int32_t  maxfd, zkfd, listen_fd = net_mng.listen_fd;
+    int32_t  ret, i, nfds;
+    int32_t  zkfd, listen_fd = net_mng.listen_fd;
     int32_t  zk_events, listen_events;
     uint64_t zk_timeout, timeout;
-    fd_set   rfds, wfds;
-    struct timeval tv;
-
-    FD_ZERO(&rfds);
-    FD_ZERO(&wfds);
+    struct epoll_event events[4];
 
     /* 获取zookeeper关注事件 */
     ret = nlb_zk_poll_events(&zkfd, &zk_events, &zk_timeout);
@@ -124,39 +183,24 @@ int32_t network_poll(void)
         return -1;
     }
 
-    if (zkfd != -1) {
-        if (zk_events & NLB_POLLIN) {
-            FD_SET(zkfd, &rfds);
-        }
-
-        if (zk_events & NLB_POLLOUT) {
-            FD_SET(zkfd, &wfds);
-        }
-    }
-
-    if (listen_fd != -1) {
-        FD_SET(listen_fd, &rfds);
-    }
+    network_update_zk(zkfd, zk_events);
 
     listen_events = 0;
     zk_events = 0;
-    maxfd     = max(listen_fd, zkfd) + 1;
     timeout   = min(zk_timeout, net_mng.timeout);
-    covert_ms_2_tv(timeout, &tv);
 
     /* 监听事件 */
-    if (select(maxfd, &rfds, &wfds, NULL, &tv) > 0) {
-        if (zkfd != -1) {
-            if (FD_ISSET(zkfd, &rfds)) {
+    nfds = epoll_wait(net_mng.epfd, events, sizeof(events)/sizeof(events[0]), (int)timeout);
+    for (i = 0; i < nfds; i++) {
+        if ((zkfd != -1) && (events[i].data.fd == zkfd)) {
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
                 zk_events |= NLB_POLLIN;
             }
 
-            if (FD_ISSET(zkfd, &wfds)) {
+            if (events[i].events & EPOLLOUT) {
                 zk_events |= NLB_POLLOUT;
             }
-        }
-
-        if ((listen_fd != -1) && FD_ISSET(listen_fd, &rfds)) {
+        } else if ((listen_fd != -1) && (events[i].data.fd == listen_fd)) {
             listen_events |= NLB_POLLIN;
         }
     }
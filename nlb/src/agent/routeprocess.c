@@ -20,6 +20,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/uio.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -42,6 +43,9 @@
 
 #define NLB_ROUTE_TASK_MAX      100  /* 单个业务最大路由请求数 */
 #define NLB_ROUTE_TASK_HASHLEN  17   /* hash查找 */
+#define NLB_ROUTE_BATCH         64   /* 单次recvmmsg/sendmmsg处理的包数 */
+#define NLB_ROUTE_PKG_LEN       1024 /* 路由请求包最大长度 */
+#define NLB_ROUTE_RSP_LEN       32   /* 路由回复包最大长度 */
 
 /* 路由任务hash链表 */
 static struct list_head route_task_hash[NLB_ROUTE_TASK_HASHLEN];
@@ -57,6 +61,76 @@ struct route_task
     struct sockaddr_in addr[NLB_ROUTE_TASK_MAX];
 };
 
+/* 路由回复批量发送缓存 */
+struct route_rsp_batch
+{
+    uint32_t           num;
+    struct mmsghdr     msgs[NLB_ROUTE_BATCH];
+    struct iovec       iovs[NLB_ROUTE_BATCH];
+    struct sockaddr_in addrs[NLB_ROUTE_BATCH];
+    char               buffs[NLB_ROUTE_BATCH][NLB_ROUTE_RSP_LEN];
+};
+
+/* 路由请求批量接收缓存 */
+struct route_req_batch
+{
+    struct mmsghdr     msgs[NLB_ROUTE_BATCH];
+    struct iovec       iovs[NLB_ROUTE_BATCH];
+    struct sockaddr_in addrs[NLB_ROUTE_BATCH];
+    char               buffs[NLB_ROUTE_BATCH][NLB_ROUTE_PKG_LEN];
+};
+
+static struct route_rsp_batch route_rsp;
+static struct route_req_batch route_req;
+
+/**
+ * @brief 发送缓存的所有路由回复
+ * @info  sendmmsg可能只发出一部分，剩下的继续发；出错的那个包丢弃，API会超时重试
+ */
+static void flush_route_response(int32_t fd, struct route_rsp_batch *rsp)
+{
+    int32_t  ret;
+    uint32_t sent = 0;
+
+    while (sent < rsp->num) {
+        ret = sendmmsg(fd, &rsp->msgs[sent], rsp->num - sent, 0);
+        if (ret <= 0) {
+            NLOG_ERROR("sendmmsg route response failed, [127.0.0.1:%u] [%m]",
+                       ntohs(rsp->addrs[sent].sin_port));
+            sent++;
+            continue;
+        }
+
+        sent += ret;
+    }
+
+    rsp->num = 0;
+}
+
+/**
+ * @brief 缓存一个路由回复，缓存满了先发送
+ */
+static void add_route_response(int32_t fd, struct route_rsp_batch *rsp, int32_t result,
+                               const struct routeid *id, const struct sockaddr_in *addr)
+{
+    uint32_t idx;
+
+    if (rsp->num >= NLB_ROUTE_BATCH) {
+        flush_route_response(fd, rsp);
+    }
+
+    idx = rsp->num++;
+    memcpy(&rsp->addrs[idx], addr, sizeof(*addr));
+    rsp->iovs[idx].iov_base = rsp->buffs[idx];
+    rsp->iovs[idx].iov_len  = serialize_route_response(result, id, rsp->buffs[idx], NLB_ROUTE_RSP_LEN);
+
+    memset(&rsp->msgs[idx], 0, sizeof(rsp->msgs[idx]));
+    rsp->msgs[idx].msg_hdr.msg_name    = &rsp->addrs[idx];
+    rsp->msgs[idx].msg_hdr.msg_namelen = sizeof(rsp->addrs[idx]);
+    rsp->msgs[idx].msg_hdr.msg_iov     = &rsp->iovs[idx];
+    rsp->msgs[idx].msg_hdr.msg_iovlen  = 1;
+}
+
 /**
  * @brief  获取指定业务的路由请求
  * @return 返回路由请求信息
@@ -176,79 +250,89 @@ int32_t get_random_route(const char *name, struct routeid *id)
  * @brief 处理路由请求
  * @info  路由请求都是从API发送过来
  *        每个业务暂时最多只支持100个路由请求，如果超过，直接回复错误
+ *        用recvmmsg批量收包，回复攒到一起用sendmmsg发送，冷启动时大量请求只需要少量系统调用
  */
 void process_route_request(int32_t listen_fd)
 {
-    int32_t ret;
-    int32_t len;
-    char    buff[1024];
-    char    service_name[NLB_SERVICE_NAME_LEN];
+    int32_t  ret;
+    int32_t  num, loop;
+    char     service_name[NLB_SERVICE_NAME_LEN];
     struct routeid id;
-    struct sockaddr_in addr;
-    socklen_t addr_len = sizeof(addr);
+    struct route_req_batch *req = &route_req;
+    struct route_rsp_batch *rsp = &route_rsp;
 
     while (true) {
-        /* 接收路由请求包 */
-        len = recvfrom(listen_fd, buff, sizeof(buff), 0, &addr, &addr_len);
-        if (len == -1) {
-            NLOG_DEBUG("recv route request failed, [%m]");
-            /* 不判断错误码，如果EAGAIN,EINTR错误，等待下次处理 */
-            return;
-        }
-
-        /* 解路由请求包 */
-        ret = deserialize_route_request(buff, len, service_name, sizeof(service_name));
-        if (ret < 0) {
-            NLOG_ERROR("Invalid route request package");
-            continue;
+        /* 批量接收路由请求包 */
+        for (loop = 0; loop < NLB_ROUTE_BATCH; loop++) {
+            req->iovs[loop].iov_base = req->buffs[loop];
+            req->iovs[loop].iov_len  = NLB_ROUTE_PKG_LEN;
+            memset(&req->msgs[loop], 0, sizeof(req->msgs[loop]));
+            req->msgs[loop].msg_hdr.msg_name    = &req->addrs[loop];
+            req->msgs[loop].msg_hdr.msg_namelen = sizeof(req->addrs[loop]);
+            req->msgs[loop].msg_hdr.msg_iov     = &req->iovs[loop];
+            req->msgs[loop].msg_hdr.msg_iovlen  = 1;
         }
 
-        NLOG_DEBUG("recevice service (%s) route request", service_name);
-
-        /* 试着从本地获取路由，如果有，直接回复路由信息 */
-        ret = get_random_route(service_name, &id);
-        if (!ret) {
-            ret = serialize_route_response(0, &id, buff, sizeof(buff));
-            sendto(listen_fd, buff, ret, 0, &addr, addr_len);
-            NLOG_DEBUG("send service (%s) route response", service_name);
-            continue;
+        num = recvmmsg(listen_fd, req->msgs, NLB_ROUTE_BATCH, 0, NULL);
+        if (num <= 0) {
+            NLOG_DEBUG("recv route request failed, [%m]");
+            /* 不判断错误码，如果EAGAIN,EINTR错误，等待下次处理 */
+            break;
         }
 
-        /* 创建路由请求任务 */
-        ret = create_route_task(service_name, &addr);
-        if (ret < 0) {
-            NLOG_ERROR("create route request task failed");
-            ret = serialize_route_response(1, NULL, buff, sizeof(buff));
-            sendto(listen_fd, buff, ret, 0, &addr, addr_len);
-            continue;
+        for (loop = 0; loop < num; loop++) {
+            /* 解路由请求包 */
+            ret = deserialize_route_request(req->buffs[loop], req->msgs[loop].msg_len,
+                                            service_name, sizeof(service_name));
+            if (ret < 0) {
+                NLOG_ERROR("Invalid route request package");
+                continue;
+            }
+
+            NLOG_DEBUG("recevice service (%s) route request", service_name);
+
+            /* 试着从本地获取路由，如果有，直接回复路由信息 */
+            ret = get_random_route(service_name, &id);
+            if (!ret) {
+                add_route_response(listen_fd, rsp, 0, &id, &req->addrs[loop]);
+                NLOG_DEBUG("send service (%s) route response", service_name);
+                continue;
+            }
+
+            /* 创建路由请求任务 */
+            ret = create_route_task(service_name, &req->addrs[loop]);
+            if (ret < 0) {
+                NLOG_ERROR("create route request task failed");
+                add_route_response(listen_fd, rsp, 1, NULL, &req->addrs[loop]);
+                continue;
+            }
+
+            /* 该业务的路由请求已经满了，直接回复 */
+            if (ret == 1) {
+                add_route_response(listen_fd, rsp, 1, NULL, &req->addrs[loop]);
+                continue;
+            }
         }
 
-        /* 创建路由请求task成功 */
-        if (!ret) {
-            continue;
-        } 
-
-        /* 该业务的路由请求已经满了，直接回复 */
-        if (ret == 1) {
-            ret = serialize_route_response(1, NULL, buff, sizeof(buff));
-            sendto(listen_fd, buff, ret, 0, &addr, addr_len);
-            continue;
+        /* 没收满说明已经收完了 */
+        if (num < NLB_ROUTE_BATCH) {
+            break;
         }
     }
+
+    flush_route_response(listen_fd, rsp);
 }
 
 /**
  * @brief  处理某个业务的路由任务
- * @info   在新获取到路由配置时调用
+ * @info   在新获取到路由配置时调用，所有等待的请求一起用sendmmsg回复
  */
 void process_route_task(const char *name)
 {
     int32_t  ret;
     uint32_t loop;
-    char     buff[64*1024];
     struct routeid id;
     struct route_task *task;
-    struct sockaddr_in *addr;
 
     task = get_route_task(name);
     if (NULL == task) {
@@ -257,22 +341,16 @@ void process_route_task(const char *name)
 
     /* 循环所有路由请求 */
     for (loop = 0; loop < task->request_num; loop++) {
-        addr = &task->addr[loop];
         ret = get_random_route(name, &id);
         if (ret < 0) {
-            ret = serialize_route_response(1, NULL, buff, sizeof(buff));
-            continue;
+            add_route_response(get_listen_fd(), &route_rsp, 1, NULL, &task->addr[loop]);
         } else {
-            ret = serialize_route_response(0, &id, buff, sizeof(buff));
-        }
-
-        ret = sendto(get_listen_fd(), buff, ret, 0, (struct sockaddr *)addr, sizeof(struct sockaddr_in));
-        if (ret == -1) {
-            NLOG_ERROR("sendto request response failed, [127.0.0.1:%u] [%m]", ntohs(addr->sin_port));
-            continue;
+            add_route_response(get_listen_fd(), &route_rsp, 0, &id, &task->addr[loop]);
         }
     }
 
+    flush_route_response(get_listen_fd(), &route_rsp);
+
     list_del(&task->list_node);
     free(task);
 }
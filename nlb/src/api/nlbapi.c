@@ -48,8 +48,12 @@
 #include "atomic.h"
 #include "version.h"
 #include "nlbrand.h"
+#include "nlbtime.h"
 
 #define NLB_ROUTE_DATA_HASHLEN 107
+#define NLB_SEQ_RETRY_MAX      100  /* 读到agent正在更新的数据时最多重试次数 */
+#define NLB_HANDLE_MAGIC       0x4e4c4248  /* 路由句柄magic: "NLBH" */
+#define NLB_AGENT_RETRY_MS     1000        /* 异步路由请求超时重发时间，毫秒 */
 
 /* 一个后台服务的路由相关数据 */
 struct api_routedata
@@ -58,6 +62,19 @@ struct api_routedata
     char name[NLB_SERVICE_NAME_LEN];         /* 业务名     */
     struct shm_meta *route_meta;             /* 元数据信息 */
     struct shm_servers *servers_data[2];     /* 服务器信息 */
+    dev_t    meta_dev;                       /* 映射时元数据文件的设备号和inode，文件被替换后会变 */
+    ino_t    meta_ino;
+    uint64_t check_time;                     /* 上次检查元数据文件的时间，秒 */
+};
+
+/* 业务路由句柄: 缓存路由数据指针，查找时不再计算业务名hash和比较字符串 */
+struct nlb_handle
+{
+    uint32_t magic;                          /* 句柄有效标记 */
+    int32_t  fd;                             /* 异步向agent请求路由的socket */
+    uint64_t req_time;                       /* 上次发送路由请求的时间，毫秒 */
+    struct api_routedata *route_data;        /* 缓存的路由数据 */
+    char name[NLB_SERVICE_NAME_LEN];         /* 业务名     */
 };
 
 /* API所有业务路由数据，使用hash建索引，快速查找 */
@@ -65,39 +82,71 @@ static struct slist_head route_data_hash[NLB_ROUTE_DATA_HASHLEN];
 
 
 /**
- * @brief 更新服务器和统计数据
+ * @brief 获取业务元数据文件的设备号和inode
+ */
+static int32_t stat_meta_file(const char *name, dev_t *dev, ino_t *ino)
+{
+    char path[256];
+    struct stat st;
+
+    if (get_naming_meta_path(name, path, sizeof(path)) < 0 || stat(path, &st) < 0) {
+        return -1;
+    }
+
+    *dev = st.st_dev;
+    *ino = st.st_ino;
+    return 0;
+}
+
+/**
+ * @brief 重新映射元数据、服务器和统计数据
+ * @info  agent在原文件上更新数据，映射一直有效；只有文件被替换(如数据目录被重建)时才需要重新映射。
+ *        旧的映射不释放: 同进程的其它线程可能正在读，文件替换很少发生，泄漏有限
  * @param rdata: 路由数据保存数据结构
  */
-int32_t update_route_data(struct api_routedata *rdata)
+int32_t update_route_data(struct api_routedata *rdata, dev_t dev, ino_t ino)
 {
     int32_t  result;
-    uint32_t maplen0;
-    uint32_t maplen1;
+    uint32_t maplen, maplen0, maplen1;
 
-    struct shm_meta *meta = rdata->route_meta;
+    struct shm_meta *meta = NULL;
     void *server_data0 = NULL;
     void *server_data1 = NULL;
 
+    meta = load_meta_data(rdata->name, &maplen);
+    if (NULL == meta) {
+        result = -1;
+        goto EXIT_LABEL;
+    }
+
     /* 加载服务器数据 */
-    server_data0 = load_server_data(meta->name, 0, &maplen0);
+    server_data0 = load_server_data(rdata->name, 0, &maplen0);
     if (NULL == server_data0) {
-        result = -1;
+        result = -2;
         goto EXIT_LABEL;
     }
 
-    server_data1 = load_server_data(meta->name, 1, &maplen1);
+    server_data1 = load_server_data(rdata->name, 1, &maplen1);
     if (NULL == server_data1) {
-        result = -2;
+        result = -3;
         goto EXIT_LABEL;
     }
 
-    /* 更新路由数据 */
+    /* 先换服务器数据再换元数据，读者按元数据的index取服务器数据 */
     rdata->servers_data[0] = server_data0;
     rdata->servers_data[1] = server_data1;
+    __sync_synchronize();
+    rdata->route_meta      = meta;
+    rdata->meta_dev        = dev;
+    rdata->meta_ino        = ino;
 
     return 0;
 
 EXIT_LABEL:
+    if (NULL != meta) {
+        munmap(meta, maplen);
+    }
+
     if (NULL != server_data0) {
         munmap(server_data0, maplen0);
     }
@@ -183,14 +232,12 @@ float calc_success_ratio(struct shm_servers *shm_servers, struct server_info *se
  *        2. 死机服务器如果有dead_retrys,会尝试dead_retrys次
  * @return <0 失败 =0 成功
  */
-int32_t search_route(struct api_routedata *route_data, struct routeid *route)
+static int32_t _search_route(struct shm_servers *servers_data, struct routeid *route)
 {
     uint32_t high, mid, low = 0;
     uint32_t weight_rand, weight_total;
     uint32_t server_num, dead_num, dead_base;
-    uint32_t index = route_data->route_meta->index;
 
-    struct shm_servers *servers_data = route_data->servers_data[index];
     struct server_info *servers      = servers_data->svrs;
     struct server_info *server;
 
@@ -254,6 +301,27 @@ FOUND_ROUTE:
     return 0;
 }
 
+/**
+ * @brief 查找路由服务器
+ * @info  agent会原地更新权重，读到更新中的数据时重新查找；
+ *        更新中的数据下标都是合法的，重试有上限，防止agent更新时退出导致一直重试
+ * @return <0 失败 =0 成功
+ */
+int32_t search_route(struct api_routedata *route_data, struct routeid *route)
+{
+    int32_t  ret, retry = 0;
+    uint32_t seq;
+    uint32_t index = route_data->route_meta->index;
+    struct shm_servers *servers_data = route_data->servers_data[index];
+
+    do {
+        seq = seq_read_begin(&servers_data->seq);
+        ret = _search_route(servers_data, route);
+    } while (seq_read_retry(&servers_data->seq, seq) && (++retry < NLB_SEQ_RETRY_MAX));
+
+    return ret;
+}
+
 /**
  * @brief 加载路由服务器数据
  */
@@ -298,6 +366,8 @@ struct api_routedata *load_route_data(const char *name)
     route_data->route_meta      = meta;
     route_data->servers_data[0] = servers0;
     route_data->servers_data[1] = servers1;
+    route_data->check_time      = get_time_s();
+    stat_meta_file(name, &route_data->meta_dev, &route_data->meta_ino);
 
     /* 加入单向链表 */
     hash = gen_hash_key(name);
@@ -318,6 +388,31 @@ EXIT_LABEL:
     return NULL;
 }
 
+/**
+ * @brief 检查路由文件是否被替换
+ * @info  每秒最多stat一次元数据文件，设备号或inode变化时重新映射；
+ *        文件不存在或重新映射失败时继续使用旧的映射，下次再试
+ */
+void check_route_data(struct api_routedata *rdata)
+{
+    dev_t    dev;
+    ino_t    ino;
+    uint64_t now = get_time_s();
+
+    if (now == rdata->check_time) {
+        return;
+    }
+    rdata->check_time = now;
+
+    if (stat_meta_file(rdata->name, &dev, &ino) < 0) {
+        return;
+    }
+
+    if (dev != rdata->meta_dev || ino != rdata->meta_ino) {
+        update_route_data(rdata, dev, ino);
+    }
+}
+
 /**
  * @brief  通过业务名到Agent获取路由
  * @return <0 失败  0 成功
@@ -419,33 +514,20 @@ int32_t getroutebyname(const char *name, struct routeid *route)
         return get_route_from_agent(name, route);
     }
 
+    check_route_data(route_data);
+
     return search_route(route_data, route);
 }
 
 /**
- * @brief 更新路由统计数据
- * @info  每次收发结束后，需要将成功与否、时延数据更新到统计数据
- * @para  name:  输入参数，业务名字符串  "Login.ptlogin"
- *        ip:    输入参数，IPV4地址
- *        failed:输入参数，>=1:失败次数 0->成功
- *        cost:  输入参数，时延
+ * @brief 更新指定路由数据中某个服务器的统计数据
  */
-int32_t updateroute(const char *name, uint32_t ip, int32_t failed, int32_t cost)
+static int32_t update_route_stat(struct api_routedata *route_data, uint32_t ip, int32_t failed, int32_t cost)
 {
     uint32_t idx;
-    struct api_routedata *route_data;
     struct shm_servers *svrs;
     struct server_info *server;
 
-    if (!check_service_name(name)) {
-        return NLB_ERR_INVALID_PARA;
-    }
-
-    route_data = get_route_data(name);
-    if (NULL == route_data) {
-        return NLB_ERR_NO_ROUTEDATA;
-    }
-
     idx     = route_data->route_meta->index;
     svrs    = route_data->servers_data[idx];
     server  = get_server_by_ip(svrs, ip);
@@ -466,3 +548,208 @@ int32_t updateroute(const char *name, uint32_t ip, int32_t failed, int32_t cost)
     return 0;
 }
 
+/**
+ * @brief 更新路由统计数据
+ * @info  每次收发结束后，需要将成功与否、时延数据更新到统计数据
+ * @para  name:  输入参数，业务名字符串  "Login.ptlogin"
+ *        ip:    输入参数，IPV4地址
+ *        failed:输入参数，>=1:失败次数 0->成功
+ *        cost:  输入参数，时延
+ */
+int32_t updateroute(const char *name, uint32_t ip, int32_t failed, int32_t cost)
+{
+    struct api_routedata *route_data;
+
+    if (!check_service_name(name)) {
+        return NLB_ERR_INVALID_PARA;
+    }
+
+    route_data = get_route_data(name);
+    if (NULL == route_data) {
+        return NLB_ERR_NO_ROUTEDATA;
+    }
+
+    return update_route_stat(route_data, ip, failed, cost);
+}
+
+/**
+ * @brief  异步向agent请求路由
+ * @info   先收之前请求的回复，没有回复且请求超时(或还没发过)时发送请求，不阻塞
+ * @return 0 成功  NLB_ERR_IN_PROGRESS 请求已发出，等待agent回复  others: 失败
+ */
+static int32_t get_route_from_agent_async(struct nlb_handle *handle, struct routeid *route)
+{
+    int32_t  ret, len, result = 0;
+    uint64_t now;
+    char     buff[1024];
+    struct   sockaddr_in server_addr;
+
+    /* 创建UDP socket，并设置非阻塞 */
+    if (handle->fd < 0) {
+        handle->fd = create_udp_socket();
+        if (handle->fd < 0) {
+            handle->fd = -1;
+            return NLB_ERR_CREATE_SOCKET_FAIL;
+        }
+        handle->req_time = 0;
+    }
+
+    /* 接收之前路由请求的应答 */
+    len = recvfrom(handle->fd, buff, sizeof(buff), 0, NULL, NULL);
+    if (len > 0) {
+        /* 收到应答后允许马上重新请求 */
+        handle->req_time = 0;
+
+        ret = deserialize_route_response(buff, len, &result, route);
+        if (ret < 0) {
+            return NLB_ERR_INVALID_RSP;
+        }
+
+        /* agent回复错误码 */
+        if (result) {
+            return NLB_ERR_AGENT_ERR;
+        }
+
+        return 0;
+    }
+
+    /* 请求还没超时，继续等待 */
+    now = get_time_ms();
+    if (handle->req_time && (now < handle->req_time + NLB_AGENT_RETRY_MS)) {
+        return NLB_ERR_IN_PROGRESS;
+    }
+
+    /* 组包并发送路由请求 */
+    make_inet_addr("127.0.0.1", (uint16_t)NLB_AGENT_LISTEN_PORT, &server_addr);
+    len = serialize_route_request(handle->name, buff, sizeof(buff));
+    ret = udp_send(handle->fd, &server_addr, buff, len);
+    if (ret < 0) {
+        return NLB_ERR_SEND_FAIL;
+    }
+
+    handle->req_time = now;
+
+    return NLB_ERR_IN_PROGRESS;
+}
+
+/**
+ * @brief 打开业务路由句柄
+ * @para  name:  输入参数，业务名字符串  "Login.ptlogin"
+ * @return NULL: 失败  others: 路由句柄
+ */
+struct nlb_handle *nlb_open(const char *name)
+{
+    struct nlb_handle *handle;
+
+    if (!check_service_name(name)) {
+        return NULL;
+    }
+
+    handle = calloc(1, sizeof(struct nlb_handle));
+    if (NULL == handle) {
+        return NULL;
+    }
+
+    handle->magic = NLB_HANDLE_MAGIC;
+    handle->fd    = -1;
+    strncpy(handle->name, name, NLB_SERVICE_NAME_LEN - 1);
+
+    /* 本地已有路由数据时直接缓存，没有时在第一次查找路由时异步请求agent */
+    handle->route_data = get_route_data(name);
+    if (NULL == handle->route_data) {
+        handle->route_data = load_route_data(name);
+    }
+
+    return handle;
+}
+
+/**
+ * @brief 通过路由句柄获取路由信息
+ * @info  本地还没有路由数据时，异步向agent请求，不阻塞；
+ *        返回NLB_ERR_IN_PROGRESS时，可以等nlb_route_fd可读或稍后再调用
+ * @para  handle: 输入参数，nlb_open返回的句柄
+ * @      route:  输出参数，路由信息(ip地址，端口，端口类型)
+ * @return  0: 成功  others: 失败
+ */
+int32_t nlb_route(struct nlb_handle *handle, struct routeid *route)
+{
+    struct api_routedata *route_data;
+
+    if (NULL == handle || handle->magic != NLB_HANDLE_MAGIC || NULL == route) {
+        return NLB_ERR_INVALID_PARA;
+    }
+
+    route_data = handle->route_data;
+    if (NULL == route_data) {
+        /* 其它句柄或getroutebyname可能已经加载了 */
+        route_data = get_route_data(handle->name);
+        if (NULL == route_data) {
+            route_data = load_route_data(handle->name);
+        }
+
+        if (NULL == route_data) {
+            return get_route_from_agent_async(handle, route);
+        }
+
+        /* 已经有本地路由数据，不再需要向agent请求 */
+        handle->route_data = route_data;
+        if (handle->fd >= 0) {
+            close(handle->fd);
+            handle->fd = -1;
+        }
+    }
+
+    check_route_data(route_data);
+
+    return search_route(route_data, route);
+}
+
+/**
+ * @brief 通过路由句柄更新路由统计数据
+ * @para  handle:输入参数，nlb_open返回的句柄
+ *        其它参数同updateroute
+ */
+int32_t nlb_update(struct nlb_handle *handle, uint32_t ip, int32_t failed, int32_t cost)
+{
+    if (NULL == handle || handle->magic != NLB_HANDLE_MAGIC) {
+        return NLB_ERR_INVALID_PARA;
+    }
+
+    if (NULL == handle->route_data) {
+        return NLB_ERR_NO_ROUTEDATA;
+    }
+
+    return update_route_stat(handle->route_data, ip, failed, cost);
+}
+
+/**
+ * @brief 获取路由句柄正在等待agent应答的socket
+ * @return -1: 没有等待中的请求  others: socket fd
+ */
+int32_t nlb_route_fd(struct nlb_handle *handle)
+{
+    if (NULL == handle || handle->magic != NLB_HANDLE_MAGIC) {
+        return -1;
+    }
+
+    return handle->fd;
+}
+
+/**
+ * @brief 关闭路由句柄
+ * @info  路由数据仍然保留在进程缓存中，供getroutebyname和其它句柄使用
+ */
+void nlb_close(struct nlb_handle *handle)
+{
+    if (NULL == handle || handle->magic != NLB_HANDLE_MAGIC) {
+        return;
+    }
+
+    if (handle->fd >= 0) {
+        close(handle->fd);
+    }
+
+    handle->magic = 0;
+    free(handle);
+}
+
@@ -56,8 +56,12 @@ enum {
     NLB_ERR_RECV_FAIL          = -12, // 接收路由请求失败
     NLB_ERR_INVALID_RSP        = -13, // 路由请求回复报文无效
     NLB_ERR_AGENT_ERR          = -14, // Agent回复路由请求失败
+    NLB_ERR_IN_PROGRESS        = -15, // 路由请求已发给Agent，等待回复
 };
 
+/* 业务路由句柄，由nlb_open创建 */
+struct nlb_handle;
+
 /**
  * @brief 通过业务名获取路由信息
  * @para  name:  输入参数，业务名字符串  "Login.ptlogin"
@@ -76,6 +80,42 @@ int32_t getroutebyname(const char *name, struct routeid *route);
  */
 int32_t updateroute(const char *name, uint32_t ip, int32_t failed, int32_t cost);
 
+/**
+ * @brief 打开业务路由句柄
+ * @info  句柄缓存该业务的路由数据，后续查找不需要再按业务名查找
+ * @para  name:  输入参数，业务名字符串  "Login.ptlogin"
+ * @return NULL: 失败  others: 路由句柄
+ */
+struct nlb_handle *nlb_open(const char *name);
+
+/**
+ * @brief 通过路由句柄获取路由信息
+ * @info  本地还没有该业务路由数据时，异步向Agent请求，不阻塞，返回NLB_ERR_IN_PROGRESS；
+ *        微线程可以等nlb_route_fd可读后再次调用
+ * @para  handle: 输入参数，nlb_open返回的句柄
+ * @      route:  输出参数，路由信息(ip地址，端口，端口类型)
+ * @return  0: 成功  others: 失败
+ */
+int32_t nlb_route(struct nlb_handle *handle, struct routeid *route);
+
+/**
+ * @brief 通过路由句柄更新路由统计数据
+ * @para  handle:输入参数，nlb_open返回的句柄
+ *        ip/failed/cost同updateroute
+ */
+int32_t nlb_update(struct nlb_handle *handle, uint32_t ip, int32_t failed, int32_t cost);
+
+/**
+ * @brief 获取路由句柄正在等待Agent应答的socket
+ * @return -1: 没有等待中的请求  others: socket fd
+ */
+int32_t nlb_route_fd(struct nlb_handle *handle);
+
+/**
+ * @brief 关闭路由句柄
+ */
+void nlb_close(struct nlb_handle *handle);
+
 #ifdef __cplusplus
 }
 #endif
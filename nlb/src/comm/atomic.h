@@ -70,6 +70,36 @@ static inline int32_t compare_and_swap_l(long *ptr, long o, long n)
 }
 
 #define mb() __asm__ __volatile__("mfence": : :"memory")
+#define barrier() __asm__ __volatile__("": : :"memory")
+
+/**
+ * seqlock: only one writer (the agent), an odd sequence means writing.
+ * x86 does not reorder loads with loads, so readers only need a compiler barrier.
+ */
+static inline void seq_write_begin(volatile uint32_t *seq)
+{
+    (*seq)++;
+    mb();
+}
+
+static inline void seq_write_end(volatile uint32_t *seq)
+{
+    mb();
+    (*seq)++;
+}
+
+static inline uint32_t seq_read_begin(const volatile uint32_t *seq)
+{
+    uint32_t s = *seq;
+    barrier();
+    return s;
+}
+
+static inline int32_t seq_read_retry(const volatile uint32_t *seq, uint32_t s)
+{
+    barrier();
+    return (s & 1) || (*seq != s);
+}
 
 #endif
 
@@ -109,7 +109,8 @@ struct shm_servers
     float    weight_low_ratio;      // 低权重机器总数低于该值，不降低权重，只给大于平均成功率的机器加权重
     float    weight_incr_ratio;     // 每次增加权重的比例
 
-    uint32_t reserved[88];                     /* 保留字段     */
+    volatile uint32_t seq;                     /* 原地更新权重的顺序锁，奇数表示正在更新 */
+    uint32_t reserved[87];                     /* 保留字段     */
 ///
     struct server_info svrs[0];                /* 所有服务器信息 */
 };
@@ -40,6 +40,23 @@
 #define MT_THREAD_NUM  "mt_thread_num"
 #define MT_MSG_NUM     "mt_msg_num"
 
+//mt prof statobj
+#define MT_SWITCH_NUM   "mt_switch_num"
+#define MT_SLICE_AVG    "mt_slice_avg"
+#define MT_SLICE_MAX    "mt_slice_max"
+#define MT_RUNQ_AVG     "mt_runq_avg"
+#define MT_IOWAIT_AVG   "mt_iowait_avg"
+#define MT_SLEEP_AVG    "mt_sleep_avg"
+#define MT_LOOP_AVG     "mt_loop_avg"
+#define MT_LOOP_MAX     "mt_loop_max"
+#define MT_STACK_MAX    "mt_stack_max"
+
+//backend concurrency limit statobj
+#define SRPC_LIMIT_REJECT       "srpc_limit_reject"
+#define SRPC_LIMIT_INFLIGHT     "srpc_limit_inflight"
+#define SRPC_LIMIT_MIN          "srpc_limit_min"
+#define SRPC_LIMIT_THROTTLED    "srpc_limit_throttled"
+
 namespace spp
 {
 
@@ -72,6 +89,21 @@ typedef enum DefaultWorkerStatObjIndex
     
     WIDX_MT_THREAD_NUM,	        // 4
     WIDX_MT_MSG_NUM,            // 5
+
+    WIDX_MT_SWITCH_NUM,         // 6
+    WIDX_MT_SLICE_AVG,          // 7
+    WIDX_MT_SLICE_MAX,          // 8
+    WIDX_MT_RUNQ_AVG,           // 9
+    WIDX_MT_IOWAIT_AVG,         // 10
+    WIDX_MT_SLEEP_AVG,          // 11
+    WIDX_MT_LOOP_AVG,           // 12
+    WIDX_MT_LOOP_MAX,           // 13
+    WIDX_MT_STACK_MAX,          // 14
+
+    WIDX_SRPC_LIMIT_REJECT,     // 15
+    WIDX_SRPC_LIMIT_INFLIGHT,   // 16
+    WIDX_SRPC_LIMIT_MIN,        // 17
+    WIDX_SRPC_LIMIT_THROTTLED,  // 18
 } worker_stat_index;
 }
 }
@@ -546,6 +546,67 @@ int ConfigLoader::Init(const char *path)
         SetDefaultProcnum();
     }
 
+    // 读取微线程调度剖析配置
+    if (ini.hasKey(SPP_GROUP, "mt_prof"))
+    {
+        ret = ini.getValue(SPP_GROUP, "mt_prof", str);
+        if (ret != RET_OK)
+        {
+            printf("\nLoad mt_prof (%s) failed\n", path);
+            return -13;
+        }
+
+        config_.mt_prof = atoi(str.c_str());
+    }
+
+    if (ini.hasKey(SPP_GROUP, "mt_prof_sample"))
+    {
+        ret = ini.getValue(SPP_GROUP, "mt_prof_sample", str);
+        if (ret != RET_OK)
+        {
+            printf("\nLoad mt_prof_sample (%s) failed\n", path);
+            return -14;
+        }
+
+        config_.mt_prof_sample = atoi(str.c_str());
+    }
+
+    if (ini.hasKey(SPP_GROUP, "procnum_max"))
+    {
+        ret = ini.getValue(SPP_GROUP, "procnum_max", str);
+        if (ret != RET_OK)
+        {
+            printf("\nLoad procnum_max (%s) failed\n", path);
+            return -15;
+        }
+
+        config_.procnum_max = atoi(str.c_str());
+    }
+
+    if (ini.hasKey(SPP_GROUP, "delay_slo"))
+    {
+        ret = ini.getValue(SPP_GROUP, "delay_slo", str);
+        if (ret != RET_OK)
+        {
+            printf("\nLoad delay_slo (%s) failed\n", path);
+            return -16;
+        }
+
+        config_.delay_slo = atoi(str.c_str());
+    }
+
+    if (ini.hasKey(SPP_GROUP, "prefork"))
+    {
+        ret = ini.getValue(SPP_GROUP, "prefork", str);
+        if (ret != RET_OK)
+        {
+            printf("\nLoad prefork (%s) failed\n", path);
+            return -17;
+        }
+
+        config_.prefork = atoi(str.c_str());
+    }
+
     // 获取业务名
     ret = GetServiceName(config_.service);
     if (ret < 0)
@@ -72,8 +72,13 @@ struct Config
     int  shmsize;                   // 共享内存大小
     int  heartbeat;                 // 心跳时间
     int  reload;                    // 热加载标记
+    int  mt_prof;                   // 微线程调度剖析开关
+    int  mt_prof_sample;            // 剖析切片明细采样间隔, 0 只记录慢切片
+    int  procnum_max;               // 最大进程数, 大于procnum时按负载自动伸缩
+    int  delay_slo;                 // 自动伸缩的共享内存队列排队时延目标(ms)
+    int  prefork;                   // 自动伸缩时预留的空闲进程数
 
-    Config(): module("./msec.so"), timeout(60), msg_timeout(800), global(1), procnum(4), shmsize(16), heartbeat(60), reload(0) {}
+    Config(): module("./msec.so"), timeout(60), msg_timeout(800), global(1), procnum(4), shmsize(16), heartbeat(60), reload(0), mt_prof(0), mt_prof_sample(0), procnum_max(0), delay_slo(20), prefork(1) {}
 };
 
 // 配置读取类
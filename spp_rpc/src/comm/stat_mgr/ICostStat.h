@@ -43,6 +43,7 @@ class ICostStat
          * @param code     返回码, 范围[0, 29] 
          * @param timecost 花费时间, 单位毫秒
          * 时间区间为 1-100ms 步长为20ms, 100-500ms 步长为50ms, >500ms,  
+         * 同时按命令字记入时延直方图, cost_stat_tool -p 查看分位数
          * @param codedesc 返回码描述信息, 可为空, 上报不会把描述信息上报 
          *
          * @return : 成功；=0：<0: 失败
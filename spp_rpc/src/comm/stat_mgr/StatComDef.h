@@ -34,6 +34,13 @@ BEGIN_SPP_STAT_NS
 #define MAX_DESC_BUF_SIZE 32
 #define MAX_TIMEMAP_SIZE 14
 
+// 时延直方图: [0, 16)ms每1ms一个桶, 之后每个2的幂区间再均分为16个桶, 误差不超过1/16
+#define HIST_SUB_BITS 4
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 20    // 超过2^20ms的记入最后一个桶
+#define MAX_HIST_BUCKET ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+#define MAX_HIST_SLAB_NUM 32 // 每进程直方图slab个数
+
 #define STAT_MGR_MAGICNUM 0x32fa4190
 
 #define MIN_PLUGIN_CMD_NUM 0
@@ -59,6 +66,7 @@ enum enumErrno
     EStatMgr_EvalidCmdID = -7,
     EStatMgr_EvalidCodeID= -8,
     EStatMgr_CmdObjNotInit = -9,
+    EStatMgr_FileSize   = -10,
 };
 
 struct CodeObj
@@ -78,10 +86,25 @@ struct CmdObj
     char     _desc[MAX_DESC_BUF_SIZE]; 
     CodeObj _codeobjs[MAX_CODE_NUM];
 };
+struct HistObj
+{
+    atomic_t _count;
+    atomic_t _buckets[MAX_HIST_BUCKET];
+};
+
+// 进程私有的直方图slab, 读的时候把各slab相加
+struct HistSlab
+{
+    int      _owner; // 占用slab的进程ID, 0表示空闲
+    char     _pad[60];
+    HistObj  _hists[MAX_CMD_NUM];
+} __attribute__((aligned(64)));
+
 struct StatMgrPool
 {
     int    _magic; 
     CmdObj _cmdobjs[MAX_CMD_NUM];
+    HistSlab _slabs[MAX_HIST_SLAB_NUM];
 };
 #define GET_MGR_POOL_SIZE sizeof(StatMgrPool)
 
@@ -91,6 +114,69 @@ struct StatMgrPool
 #define STATMGR_VAL_SET(val, lv)    atomic_set(&(val), lv)
 #define STATMGR_VAL_READ(val)       atomic_read(&(val))
 
+// 时延(ms)对应的直方图桶下标
+static inline int getHistIndex(unsigned timecost)
+{
+    if (timecost < HIST_SUB_COUNT)
+        return timecost;
+    if (timecost >= (1u << HIST_MAX_BITS))
+        return MAX_HIST_BUCKET - 1;
+
+    int shift = 31 - __builtin_clz(timecost) - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB_COUNT + (int)(timecost >> shift) - HIST_SUB_COUNT;
+}
+
+// 直方图桶的时延上界(ms)
+static inline unsigned getHistValue(int index)
+{
+    if (index < HIST_SUB_COUNT)
+        return index;
+
+    int shift = index / HIST_SUB_COUNT - 1;
+    unsigned low = (unsigned)(HIST_SUB_COUNT + index % HIST_SUB_COUNT) << shift;
+    return low + (1u << shift) - 1;
+}
+
+// 合并各进程slab中命令字的直方图, 返回总次数
+static inline unsigned mergeHist(const StatMgrPool* pool, unsigned cmdid, unsigned* buckets)
+{
+    unsigned count = 0;
+    memset(buckets, 0, sizeof(unsigned) * MAX_HIST_BUCKET);
+    for (int i = 0; i < MAX_HIST_SLAB_NUM; ++i)
+    {
+        const HistSlab* slab = &pool->_slabs[i];
+        if (slab->_owner == 0)
+            continue;
+
+        const HistObj* hist = &slab->_hists[cmdid];
+        count += (unsigned)STATMGR_VAL_READ(hist->_count);
+        for (int j = 0; j < MAX_HIST_BUCKET; ++j)
+            buckets[j] += (unsigned)STATMGR_VAL_READ(hist->_buckets[j]);
+    }
+    return count;
+}
+
+// 按比例(如0.99)取分位数时延(ms)
+static inline unsigned getHistPercentile(const unsigned* buckets, unsigned count, double ratio)
+{
+    if (count == 0)
+        return 0;
+
+    double want = count * ratio;
+    unsigned target = (unsigned)want;
+    if (target < want || target == 0)
+        target++;
+
+    unsigned sum = 0;
+    for (int i = 0; i < MAX_HIST_BUCKET; ++i)
+    {
+        sum += buckets[i];
+        if (sum >= target)
+            return getHistValue(i);
+    }
+    return getHistValue(MAX_HIST_BUCKET - 1);
+}
+
 
 END_SPP_STAT_NS
 #endif
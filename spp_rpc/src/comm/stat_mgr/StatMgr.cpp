@@ -18,8 +18,10 @@
 
 
 #include "StatMgr.h"
+#include "tslab.h"
 #include <sys/file.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #if !__GLIBC_PREREQ(2, 3)
 #define __builtin_expect(x, expected_value) (x)
 #endif
@@ -36,6 +38,7 @@ USING_SPP_STAT_NS;
 CStatMgr::CStatMgr()
 {
     _pool = NULL; 
+    _slab = NULL;
 }
 CStatMgr::~CStatMgr()
 {
@@ -48,6 +51,7 @@ void CStatMgr::fini()
         ::munmap(_pool, GET_MGR_POOL_SIZE); 
     }                                   
     _pool = NULL;
+    _slab = NULL;
 }
 int CStatMgr::checkStatPool()
 {
@@ -136,6 +140,13 @@ int CStatMgr::readStatPool(const char* filepath)
     {
         return EStatMgr_OpenFile;
     }
+    // 旧版本文件没有直方图区, worker重启扩展文件后才能读
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || st.st_size < (off_t)GET_MGR_POOL_SIZE)
+    {
+        ::close(fd);
+        return EStatMgr_FileSize;
+    }
     _pool = (StatMgrPool*) ::mmap(NULL, GET_MGR_POOL_SIZE, PROT_READ , MAP_SHARED, fd, 0); 
     if (unlikely(MAP_FAILED == _pool))
     {
@@ -270,9 +281,21 @@ int CStatMgr::stepItem(const unsigned& cmdid,
     STATMGR_VAL_INC(codeobj->_count);
     STATMGR_VAL_ADD(codeobj->_tmcostsum, timecost);
     STATMGR_VAL_INC(codeobj->_timecost[getTimeIndex(timecost)]);
+
+    HistSlab* slab = likely(_slab != NULL) ? _slab : allocSlab();
+    HistObj* hist = &slab->_hists[cmdid];
+    STATMGR_VAL_INC(hist->_count);
+    STATMGR_VAL_INC(hist->_buckets[getHistIndex(timecost)]);
     return 0;
 
 }
+HistSlab* CStatMgr::allocSlab()
+{
+    // 回收已退出进程的slab时累计值保留, 继续累加不影响按间隔求差
+    int i = tbase::claim_slab(&_pool->_slabs[0]._owner, MAX_HIST_SLAB_NUM, sizeof(HistSlab), getpid());
+    _slab = &_pool->_slabs[i];
+    return _slab;
+}
 int CStatMgr::getTimeIndex(const unsigned& timecost)
 {
     if (timecost >= 500)
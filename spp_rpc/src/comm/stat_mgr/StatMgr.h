@@ -82,6 +82,7 @@ class CStatMgr
          * @param code     返回码, 范围[0, 29] 
          * @param timecost 花费时间, 单位毫秒
          * 时间区间为 1-100ms 步长为20ms, 100-500ms 步长为50ms, >500ms,  
+         * 同时按命令字记入时延直方图, 用于查看分位数
          * @param codedesc 返回码描述信息, 可为空, 上报不会把描述信息上报 
          *
          * @return : 成功；=0：<0: 失败
@@ -118,6 +119,7 @@ class CStatMgr
        int stepItem(const unsigned& cmdid,const unsigned& code, const unsigned& timecost, const char* codedesc = NULL);
        void initCmdCodeItem(unsigned cmdid, unsigned code);
        inline int getTimeIndex(const unsigned& timecost);
+       HistSlab* allocSlab();
        void fini();
        void newStatPool();
        int checkStatPool();
@@ -126,6 +128,7 @@ class CStatMgr
 
     private:
        StatMgrPool* _pool;
+       HistSlab* _slab; // 本进程的直方图slab, 首次统计时分配
 };
 END_SPP_STAT_NS
 #endif
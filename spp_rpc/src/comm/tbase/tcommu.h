@@ -59,6 +59,8 @@ namespace tbase
             CT_DISCONNECT = 0,  //断开连接（组件相关）
             CT_CLOSE,			//清理资源（组件相关）
             CT_STAT,			//统计信息（组件相关）
+            CT_QDELAY,			//上报消息排队时延（共享内存组件），arg1指向int毫秒数
+            CT_MSGCOUNT,		//取接收队列中待处理的消息数（共享内存组件），arg1指向int
         } ctrl_type;
 
         //回调函数类型
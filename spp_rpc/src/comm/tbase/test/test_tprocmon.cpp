@@ -0,0 +1,183 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include "tprocmon.h"
+#include "monitor.h"
+
+using namespace tbase::tprocmon;
+
+#define CHECK(exp) do { if(!(exp)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #exp); fflush(stdout); return 1; } } while(0)
+
+namespace spp
+{
+namespace comm
+{
+CMonitorBase* _spp_g_monitor = NULL;
+}
+}
+
+#define TEST_SLO        100
+#define TEST_MINPROC    2
+#define TEST_MAXPROC    20
+#define TEST_PREFORK    1
+
+//直接填充负载窗口，调用伸缩策略，不需要真实的进程组和消息队列
+class CTestProcMon : public CTProcMonSrv
+{
+public:
+    //num个采样周期，每个周期delay_cnt个消息、平均时延delay(ms)、进程组CPU之和cpu(%)
+    void fill(int groupid, int num, int delay, int cpu, int delay_cnt = 100)
+    {
+        TGroupLoad* load = &group_load_[groupid];
+        memset(load, 0x0, sizeof(TGroupLoad));
+        for (int i = 0; i < num; ++i)
+        {
+            load->delay_sum_[i] = delay * delay_cnt;
+            load->delay_cnt_[i] = delay_cnt;
+            load->cpu_[i] = cpu;
+        }
+        load->num_ = num;
+        load->pos_ = num % LOAD_WINDOW_SIZE;
+    }
+
+    //修改最近一个采样周期
+    void set_last(int groupid, int delay, int stall)
+    {
+        TGroupLoad* load = &group_load_[groupid];
+        int last = (load->pos_ + LOAD_WINDOW_SIZE - 1) % LOAD_WINDOW_SIZE;
+        load->delay_sum_[last] = delay * load->delay_cnt_[last];
+        load->stall_[last] = stall;
+    }
+
+    int check(TGroupInfo* group, int curprocnum)
+    {
+        return check_groupslo(group, curprocnum);
+    }
+};
+
+static void InitGroup(TGroupInfo* group)
+{
+    memset(group, 0x0, sizeof(TGroupInfo));
+    group->groupid_ = 0;
+    group->delay_slo_ = TEST_SLO;
+    group->minprocnum_ = TEST_MINPROC;
+    group->maxprocnum_ = TEST_MAXPROC;
+    group->prefork_ = TEST_PREFORK;
+}
+
+//时延超过目标时至少扩容1/4，即使按CPU估算不需要这么多进程
+static int TestScaleUp()
+{
+    CTestProcMon mon;
+    TGroupInfo group;
+    InitGroup(&group);
+
+    CHECK(mon.check(&group, 8) == 0);   //没有采样时不调整
+
+    //CPU估算需要ceil(400/70)+1=7个进程，时延超标按8+8/4=10
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO + 50, 8 * 50);
+    CHECK(mon.check(&group, 8) == 2);
+
+    //进程数少于4个时至少扩容1个
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO + 50, 0);
+    CHECK(mon.check(&group, 3) == 1);
+
+    //CPU估算需要更多进程时按CPU扩容：ceil(800/70)+1=13
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO + 50, 8 * 100);
+    CHECK(mon.check(&group, 8) == 5);
+
+    //窗口平均未超标，但最近一个周期超过2倍目标
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO / 4, 8 * 50);
+    mon.set_last(0, TEST_SLO * 2 + 1, 0);
+    CHECK(mon.check(&group, 8) == 2);
+
+    //最近一个周期队列有积压但没有消息出队
+    mon.fill(0, LOAD_WINDOW_SIZE, 0, 8 * 50);
+    mon.set_last(0, 0, 1);
+    CHECK(mon.check(&group, 8) == 2);
+
+    return 0;
+}
+
+//时延在目标的1/2到目标之间时，CPU再低也不缩容；时延低时按CPU缩容
+static int TestScaleDown()
+{
+    CTestProcMon mon;
+    TGroupInfo group;
+    InitGroup(&group);
+
+    //CPU估算只需要ceil(100/70)+1=3个进程
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO / 2 + 10, 100);
+    CHECK(mon.check(&group, 8) == 0);
+
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO, 100);
+    CHECK(mon.check(&group, 8) == 0);
+
+    //时延接近目标但CPU需要更多进程时仍按CPU扩容：ceil(700/70)+1=11
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO / 2 + 10, 700);
+    CHECK(mon.check(&group, 8) == 3);
+
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO / 2, 100);
+    CHECK(mon.check(&group, 8) == -5);
+
+    mon.fill(0, LOAD_WINDOW_SIZE, 10, 100);
+    CHECK(mon.check(&group, 8) == -5);
+
+    //窗口未满时按已有采样计算
+    mon.fill(0, 3, 10, 100);
+    CHECK(mon.check(&group, 8) == -5);
+
+    return 0;
+}
+
+//调整结果限制在[minprocnum_, maxprocnum_]之内
+static int TestClamp()
+{
+    CTestProcMon mon;
+    TGroupInfo group;
+    InitGroup(&group);
+
+    //需要ceil(1620/70)+1=25个进程，最多扩到TEST_MAXPROC
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO * 3, 18 * 90);
+    CHECK(mon.check(&group, 18) == TEST_MAXPROC - 18);
+    CHECK(mon.check(&group, TEST_MAXPROC) == 0);
+
+    //空闲时只需prefork_个进程，最少缩到TEST_MINPROC
+    mon.fill(0, LOAD_WINDOW_SIZE, 0, 0);
+    CHECK(mon.check(&group, 4) == TEST_MINPROC - 4);
+    CHECK(mon.check(&group, TEST_MINPROC) == 0);
+
+    //当前进程数超出范围时拉回范围内
+    CHECK(mon.check(&group, TEST_MAXPROC + 3) == TEST_MINPROC - TEST_MAXPROC - 3);
+    mon.fill(0, LOAD_WINDOW_SIZE, TEST_SLO * 3, 0);
+    CHECK(mon.check(&group, 1) == TEST_MINPROC - 1);
+
+    return 0;
+}
+
+int main()
+{
+    if (TestScaleUp() || TestScaleDown() || TestClamp())
+        return 1;
+
+    printf("test_tprocmon ok\n");
+    return 0;
+}
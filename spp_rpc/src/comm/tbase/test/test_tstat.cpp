@@ -0,0 +1,171 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "tstat.h"
+
+using namespace tbase::tstat;
+
+#define CHECK(exp) do { if(!(exp)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #exp); fflush(stdout); return 1; } } while(0)
+
+#define STAT_FILE   "./test_tstat.dat"
+
+static long QueryValue(CTStat& stat, const char* id, long* count = NULL)
+{
+    TStatObjWrapper wrapper;
+    if (stat.query(id, &wrapper) != 1)
+        return -1;
+
+    if (count)
+        *count = STATVAL_READ(*wrapper.count_);
+    return STATVAL_READ(wrapper.value_[0]);
+}
+
+//同一ID只解析一次，复合类型的句柄覆盖每个统计对象
+static int TestHandle()
+{
+    CTStat* stat = new CTStat;
+    CHECK(stat->init_statpool(NULL) == 0);
+    CHECK(stat->init_statobj("req", STAT_TYPE_SUM) == 0);
+    CHECK(stat->init_statobj("cost", STAT_TYPE_SUM | STAT_TYPE_MAX) == 0);
+
+    int h_req = stat->get_handle("req");
+    int h_cost = stat->get_handle("cost");
+    CHECK(h_req >= 0 && h_cost >= 0 && h_req != h_cost);
+    CHECK(stat->get_handle("req") == h_req);
+    CHECK(stat->get_handle("none") == ERR_STAT_NONE);
+    CHECK(stat->op_handle(h_cost + 1, 1) == ERR_STAT_NONE);
+
+    CHECK(stat->op_handle(h_cost, 5) == 0);
+    CHECK(stat->op_handle(h_cost, 3) == 0);
+
+    //Sum进slab，Max走共享对象，result两者都能看到
+    char buff[STAT_BUFF_SIZE];
+    char* pbuff = buff;
+    int len = 0;
+    stat->result(&pbuff, &len, sizeof(buff));
+    CHECK(strstr(buff, "cost                |Sum     |2       |8       |") != NULL);
+    CHECK(strstr(buff, "cost                |Max     |2       |5       |") != NULL);
+
+    delete stat;
+    return 0;
+}
+
+//query/queryindex合并slab中的累加值，reset同时清空slab
+static int TestQueryFold()
+{
+    CTStat* stat = new CTStat;
+    CHECK(stat->init_statpool(NULL) == 0);
+    CHECK(stat->init_statobj_frame("frame_req", STAT_TYPE_SUM, 0) == 0);
+    CHECK(stat->init_statobj("user_req", STAT_TYPE_SUM) == 0);
+
+    int h = stat->get_handle("user_req");
+    CHECK(h >= 0);
+    for (int i = 0; i < 10; ++i)
+    {
+        CHECK(stat->op_handle(h, 2) == 0);
+        CHECK(stat->op(0, 3) == 0);
+    }
+
+    long count = 0;
+    CHECK(QueryValue(*stat, "user_req", &count) == 20);
+    CHECK(count == 10);
+
+    TStatObjWrapper wrapper;
+    CHECK(stat->queryindex(0, &wrapper) == 1);
+    CHECK(STATVAL_READ(wrapper.value_[0]) == 30);
+    CHECK(STATVAL_READ(*wrapper.count_) == 10);
+
+    stat->reset();
+    CHECK(QueryValue(*stat, "user_req", &count) == 0);
+    CHECK(count == 0);
+    CHECK(stat->queryindex(0, &wrapper) == 1);
+    CHECK(STATVAL_READ(wrapper.value_[0]) == 0);
+
+    CHECK(stat->op_handle(h, 7) == 0);
+    CHECK(QueryValue(*stat, "user_req") == 7);
+
+    delete stat;
+    return 0;
+}
+
+//多个进程共用统计文件，各自累加到自己的slab，query看到总和
+static int TestProcessSlabs()
+{
+    unlink(STAT_FILE);
+
+    CTStat* stat = new CTStat;
+    CHECK(stat->init_statpool(STAT_FILE) == 0);
+    CHECK(stat->init_statobj("shared_req", STAT_TYPE_SUM) == 0);
+
+    const int PROC_NUM = 4;
+    for (int p = 0; p < PROC_NUM; ++p)
+    {
+        pid_t pid = fork();
+        CHECK(pid >= 0);
+        if (pid == 0)
+        {
+            CTStat* child = new CTStat;
+            if (child->init_statpool(STAT_FILE) != 0)
+                _exit(1);
+            int h = child->get_handle("shared_req");
+            if (h < 0)
+                _exit(1);
+            for (int i = 0; i < 1000; ++i)
+                child->op_handle(h, 1);
+            _exit(0);
+        }
+    }
+
+    for (int p = 0; p < PROC_NUM; ++p)
+    {
+        int status = 0;
+        CHECK(wait(&status) > 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    int h = stat->get_handle("shared_req");
+    CHECK(stat->op_handle(h, 1) == 0);
+    CHECK(QueryValue(*stat, "shared_req") == PROC_NUM * 1000 + 1);
+
+    //统计工具只读映射，同样合并slab
+    CTStat* reader = new CTStat;
+    CHECK(reader->read_statpool(STAT_FILE) == 0);
+    CHECK(QueryValue(*reader, "shared_req") == PROC_NUM * 1000 + 1);
+
+    stat->reset();
+    CHECK(QueryValue(*reader, "shared_req") == 0);
+
+    delete reader;
+    delete stat;
+    unlink(STAT_FILE);
+    return 0;
+}
+
+int main()
+{
+    if (TestHandle() || TestQueryFold() || TestProcessSlabs())
+        return 1;
+
+    printf("test_tstat ok\n");
+    return 0;
+}
@@ -109,6 +109,8 @@ public:
     //level:		新的日志级别
     //返回值:		老的日志级别
     int log_level(int level);
+    //取日志存放目录
+    const char* log_path() const { return log_path_; }
     //打印格式化日志
     void log_i(int flag, int log_level, const char *fmt, ...);
     void log_i_va(int flag, int log_level, const char* fmt, va_list va);
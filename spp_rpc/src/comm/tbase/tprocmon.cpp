@@ -26,6 +26,7 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/shm.h>
+#include <sys/time.h>
 #include <libgen.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -123,6 +124,9 @@ int CMQCommu::send(TProcMonMsg* msg)
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 #define ADJUST_PROC_DELAY 15			//进程调整的延迟时间
+#define ADJUST_PROC_UP_DELAY 3			//按负载扩容的延迟时间
+#define LOAD_SAMPLE_INTERVAL 900		//负载采样最小间隔(ms)
+#define LOAD_CPU_TARGET 70				//单进程CPU使用率目标(%)
 #define ADJUST_PROC_CYCLE 1200			//进程调整周期
 #define MIN_NOTIFY_TIME_CYCLE	30		//进程告警最小间隔时间
 
@@ -170,6 +174,7 @@ CTProcMonSrv::CTProcMonSrv(): commu_(NULL)
 {
     cur_group_ = 0;
     memset(proc_groups_, 0x0, sizeof(TProcGroupObj) * MAX_PROC_GROUP_NUM);
+    memset(group_load_, 0x0, sizeof(group_load_));
 
     for (int i = 0; i < MAX_PROC_GROUP_NUM; ++i)
         proc_groups_[i].curprocnum_ = GROUP_UNUSED;
@@ -493,16 +498,14 @@ bool CTProcMonSrv::reload_check_group_dead(int groupid)
     return true;
 }
 
-bool CTProcMonSrv::check_groupbusy(int groupid)
+//attach进程组接收队列的统计信息，失败返回NULL
+static Q_STATINFO* attach_qstat(TGroupInfo* group)
 {
-    TProcGroupObj* groupobj = &proc_groups_[groupid];
-    TGroupInfo* group = &(groupobj->groupinfo_);
-
     if ((Q_STATINFO*)group->q_recv_pstat == NULL)
     {
         if (group->groupid_ == 0)
         {
-            return false;
+            return NULL;
         }
 
         key_t key = pwdtok(group->groupid_ * 2);
@@ -512,12 +515,12 @@ bool CTProcMonSrv::check_groupbusy(int groupid)
 
         if ((shmid_ = shmget(key, 0, 0)) == -1)
         {
-            return false;
+            return NULL;
         }
 
         if (shmid_ < 0)
         {
-            return false;
+            return NULL;
         }
 
         pinfo = (void*) shmat(shmid_, NULL, 0);
@@ -527,13 +530,63 @@ bool CTProcMonSrv::check_groupbusy(int groupid)
         }
         else
         {
-            return false;
+            return NULL;
         }
 
         group->q_recv_pstat = pinfo;
     }
 
-    Q_STATINFO* q_recv_pstat = (Q_STATINFO*)group->q_recv_pstat;
+    return (Q_STATINFO*)group->q_recv_pstat;
+}
+
+//读取/proc/<pid>/stat中的utime+stime，失败返回0
+static uint64_t read_proc_cpu(int pid)
+{
+    char path[64];
+    char buf[512];
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0)
+    {
+        return 0;
+    }
+    buf[len] = '\0';
+
+    //进程名可能含空格，从最后一个')'之后开始解析
+    char* p = strrchr(buf, ')');
+    if (p == NULL)
+    {
+        return 0;
+    }
+
+    unsigned long utime = 0, stime = 0;
+    if (sscanf(p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+    {
+        return 0;
+    }
+
+    return (uint64_t)utime + stime;
+}
+
+bool CTProcMonSrv::check_groupbusy(int groupid)
+{
+    TProcGroupObj* groupobj = &proc_groups_[groupid];
+    TGroupInfo* group = &(groupobj->groupinfo_);
+
+    Q_STATINFO* q_recv_pstat = attach_qstat(group);
+    if (q_recv_pstat == NULL)
+    {
+        return false;
+    }
+
     int msg_count;
     msg_count = atomic_read(&(q_recv_pstat->msg_count));
 
@@ -556,6 +609,123 @@ bool CTProcMonSrv::check_groupbusy(int groupid)
 
 }
 
+void CTProcMonSrv::sample_groupload(TProcGroupObj* groupobj)
+{
+    TGroupInfo* group = &groupobj->groupinfo_;
+    TGroupLoad* load = &group_load_[group->groupid_];
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t now_ms = tv.tv_sec * 1000LL + tv.tv_usec / 1000;
+
+    if (now_ms - load->last_ms_ < LOAD_SAMPLE_INTERVAL)
+    {
+        return;
+    }
+
+    Q_STATINFO* q_recv_pstat = attach_qstat(group);
+    if (q_recv_pstat == NULL)
+    {
+        return;
+    }
+
+    //各进程的CPU时间增量，新进程第一次只记录基准值
+    uint64_t ticks = 0;
+    TProcObj* proc = NULL;
+    for (int i = 0; i < BUCKET_SIZE; ++i)
+    {
+        list_for_each_entry(proc, &groupobj->bucket_[i], list_)
+        {
+            uint64_t cur = read_proc_cpu(proc->procinfo_.procid_);
+            if (cur == 0)
+            {
+                continue;
+            }
+
+            if (proc->cpu_ticks_ > 0 && cur > proc->cpu_ticks_)
+            {
+                ticks += cur - proc->cpu_ticks_;
+            }
+            proc->cpu_ticks_ = cur;
+        }
+    }
+
+    int delay_sum = atomic_clear(&q_recv_pstat->delay_sum);
+    int delay_cnt = atomic_clear(&q_recv_pstat->delay_cnt);
+    int msg_count = atomic_read(&q_recv_pstat->msg_count);
+
+    if (load->last_ms_ == 0)
+    {
+        load->last_ms_ = now_ms;
+        return;
+    }
+
+    static long clk_tck = sysconf(_SC_CLK_TCK);
+    int64_t elapsed = now_ms - load->last_ms_;
+
+    load->delay_sum_[load->pos_] = delay_sum;
+    load->delay_cnt_[load->pos_] = delay_cnt;
+    load->cpu_[load->pos_] = (int)(ticks * 1000 * 100 / (clk_tck * elapsed));
+    load->stall_[load->pos_] = (delay_cnt == 0 && msg_count > 0);
+    load->pos_ = (load->pos_ + 1) % LOAD_WINDOW_SIZE;
+    if (load->num_ < LOAD_WINDOW_SIZE)
+    {
+        load->num_++;
+    }
+    load->last_ms_ = now_ms;
+}
+
+int CTProcMonSrv::check_groupslo(TGroupInfo* group, int curprocnum)
+{
+    TGroupLoad* load = &group_load_[group->groupid_];
+
+    if (load->num_ == 0)
+    {
+        return 0;
+    }
+
+    int64_t delay_sum = 0, delay_cnt = 0, cpu_sum = 0;
+    for (int i = 0; i < load->num_; ++i)
+    {
+        delay_sum += load->delay_sum_[i];
+        delay_cnt += load->delay_cnt_[i];
+        cpu_sum += load->cpu_[i];
+    }
+
+    int last = (load->pos_ + LOAD_WINDOW_SIZE - 1) % LOAD_WINDOW_SIZE;
+    int avg_delay = delay_cnt > 0 ? (int)(delay_sum / delay_cnt) : 0;
+    int last_delay = load->delay_cnt_[last] > 0 ? load->delay_sum_[last] / load->delay_cnt_[last] : 0;
+    int slo = (int)group->delay_slo_;
+
+    //按CPU估算需要的进程数，再预留prefork_个空闲进程应对突发
+    int need = (int)((cpu_sum / load->num_ + LOAD_CPU_TARGET - 1) / LOAD_CPU_TARGET) + (int)group->prefork_;
+
+    if (avg_delay > slo || last_delay > 2 * slo || load->stall_[last])
+    {
+        //排队时延超标，至少扩容1/4
+        int step = curprocnum / 4 > 0 ? curprocnum / 4 : 1;
+        if (need < curprocnum + step)
+        {
+            need = curprocnum + step;
+        }
+    }
+    else if (avg_delay * 2 > slo && need < curprocnum)
+    {
+        //时延接近目标时不缩容
+        need = curprocnum;
+    }
+
+    if (need > (int)group->maxprocnum_)
+    {
+        need = (int)group->maxprocnum_;
+    }
+    if (need < (int)group->minprocnum_)
+    {
+        need = (int)group->minprocnum_;
+    }
+
+    return need - curprocnum;
+}
+
 bool CTProcMonSrv::do_check()
 {		
     TProcObj* proc = NULL;
@@ -727,6 +897,7 @@ int CTProcMonSrv::add_proc(int groupid, const TProcInfo* procinfo)
 
     memcpy(&proc->procinfo_, procinfo, sizeof(TProcInfo));
     proc->status_ = PROCMON_STATUS_OK;
+    proc->cpu_ticks_ = 0;
     INIT_LIST_HEAD(&proc->list_);
 
     TProcGroupObj* group = &proc_groups_[groupid];
@@ -838,8 +1009,37 @@ void CTProcMonSrv::check_group(TGroupInfo* group, int curprocnum)
 {
     int event = 0;
     int procdiff = 0;
+    int slodiff = 0;
     time_t now = time(NULL);
 
+    if (group->delay_slo_ > 0)
+    {
+        TGroupLoad* load = &group_load_[group->groupid_];
+        sample_groupload(&proc_groups_[group->groupid_]);
+
+        //扩容后新进程上报心跳前，按扩容目标计算，避免重复fork
+        int procnum = curprocnum;
+        if (load->up_time_ + ADJUST_PROC_DELAY > now && load->up_target_ > procnum)
+        {
+            procnum = load->up_target_;
+        }
+
+        slodiff = check_groupslo(group, procnum);
+        if (slodiff > 0 && group->adjust_proc_time + ADJUST_PROC_UP_DELAY <= now)
+        {
+            DO_LOG_PROCMON(LOG_FATAL, "group[%d] queue delay or cpu over target, fork [%d] processes. current proc#[%d]\n",
+                    group->groupid_, slodiff, curprocnum);
+            load->up_target_ = procnum + slodiff;
+            load->up_time_ = now;
+            //清空窗口，之后按扩容后的负载判断
+            load->num_ = 0;
+            load->pos_ = 0;
+            group->adjust_proc_time = now;
+            do_event(PROCMON_EVENT_PROCDOWN, (void*)&slodiff, (void*)group);
+            return;
+        }
+    }
+
     if (group->adjust_proc_time + ADJUST_PROC_DELAY > now)
     {
         return;
@@ -857,6 +1057,16 @@ void CTProcMonSrv::check_group(TGroupInfo* group, int curprocnum)
                 group->groupid_, curprocnum, procdiff);
         event |= PROCMON_EVENT_PROCUP;
     }
+    else if (group->delay_slo_ > 0)
+    {
+        if (slodiff < 0)
+        {
+            DO_LOG_PROCMON(LOG_FATAL, "group[%d] queue delay and cpu under target, kill one process. current proc#[%d]\n",
+                    group->groupid_, curprocnum);
+            event |= PROCMON_EVENT_PROCUP;
+            procdiff = 1;
+        }
+    }
     else
     {
         if (!check_groupbusy(group->groupid_))
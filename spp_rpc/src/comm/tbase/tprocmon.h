@@ -43,6 +43,7 @@
 #define MSG_SRC_SERVER      0x00		//发送者为SERVER
 #define MSG_SRC_CLIENT		0x01		//发送者为CLIENT
 #define DEFAULT_MQ_KEY		0x800100  	//默认管道key, 8388864
+#define LOAD_WINDOW_SIZE    10          //进程组负载滑动窗口的采样个数
 
 #define EXCEPTION_STARTBIT  20
 #define EXCEPTION_TYPE(msg_srctype__)   (msg_srctype__ >> EXCEPTION_STARTBIT)
@@ -108,6 +109,8 @@ typedef struct
     unsigned affinity_;
     unsigned reload_;
 	time_t reload_time;
+    unsigned delay_slo_;                //排队时延目标(ms)，0表示按队列积压调整进程数
+    unsigned prefork_;                  //按负载伸缩时预留的空闲进程数
 } TGroupInfo;//进程组信息
 
 typedef struct
@@ -191,8 +194,22 @@ typedef struct
     TProcInfo procinfo_;		//进程信息
     int status_;				//进程状态
     list_head_t list_;
+    uint64_t cpu_ticks_;		//上次采样时的CPU时间(utime+stime)，0表示未采样
 } TProcObj;//进程对象
 
+typedef struct
+{
+    int delay_sum_[LOAD_WINDOW_SIZE];   //各采样周期出队消息的排队时延之和(ms)
+    int delay_cnt_[LOAD_WINDOW_SIZE];   //各采样周期出队消息数
+    int cpu_[LOAD_WINDOW_SIZE];         //各采样周期进程组CPU使用率之和(%)
+    int stall_[LOAD_WINDOW_SIZE];       //各采样周期队列有积压但没有消息出队
+    int pos_;                           //下一个采样位置
+    int num_;                           //有效采样个数
+    int64_t last_ms_;                   //上次采样时间，0表示还未采样
+    int up_target_;                     //最近一次扩容后的目标进程数
+    time_t up_time_;                    //最近一次扩容时间
+} TGroupLoad;//进程组负载窗口
+
 /////////////////////////////////服务器端接口///////////////////////////////////////
 typedef void (*monsrv_cb)(const TGroupInfo* groupinfo /*发出事件的进程所属进程组对象*/,
                           const TProcInfo* procinfo   /*发出事件的进程对象*/,
@@ -254,6 +271,7 @@ protected:
     CCommu* commu_;
 
     TProcGroupObj proc_groups_[MAX_PROC_GROUP_NUM];
+    TGroupLoad group_load_[MAX_PROC_GROUP_NUM];
     int cur_group_;
     TProcMonMsg msg_[2]; //0-收，1-发
     std::map<int,std::map<int,int> > reload_tag;
@@ -277,6 +295,10 @@ protected:
     virtual void do_kill(int procid, int signo = SIGKILL);
     virtual void do_order(int groupid, int procid, int eventno, int cmd, int arg1 = 0, int arg2 = 0);
     bool check_groupbusy(int groupid);
+    //采集进程组的队列排队时延和CPU使用率，存入滑动窗口
+    void sample_groupload(TProcGroupObj* groupobj);
+    //按排队时延目标和CPU使用率计算进程数调整量：>0需要fork的进程数，<0可以缩容
+    virtual int check_groupslo(TGroupInfo* group, int curprocnum);
     int set_affinity(const uint64_t mask);
 
 };
@@ -921,6 +921,12 @@ int CTShmCommu::ctrl(unsigned flow, ctrl_type type, void* arg1, void* arg2)
                          mq.shmid_, mq.shmsize_, mq.totallen_, mq.usedlen_, mq.freelen_);
         break;
     }
+    case CT_QDELAY:
+        comsumer_->mq_->add_delay(*(int*)arg1);
+        break;
+    case CT_MSGCOUNT:
+        *(int*)arg1 = get_msg_count();
+        break;
     case CT_DISCONNECT:
     case CT_CLOSE:
         break;
@@ -931,9 +937,5 @@ int CTShmCommu::ctrl(unsigned flow, ctrl_type type, void* arg1, void* arg2)
 
 int CTShmCommu::get_msg_count()
 {
-    /*
-    TMQStat mq;
-    comsumer_->getstat(mq);
-    return mq.totallen_;*/
-    return 0;
+    return comsumer_->mq_->msg_count();
 }
@@ -73,6 +73,8 @@ typedef struct qstatinfo {
     atomic_t process_count; // processed count last interval
     atomic_t flag;          // need_notify flag
     atomic_t curflow;       // current flow
+    atomic_t delay_sum;     // queue delay(ms) sum of dequeued msgs, reset by controller
+    atomic_t delay_cnt;     // msg count of delay_sum
 } Q_STATINFO;
 
 //共享内存管道
@@ -109,6 +111,18 @@ public:
         return pstat_->msg_count == 0;
     }
 
+    inline int msg_count()
+    {
+        return atomic_read(&(pstat_->msg_count));
+    }
+
+    //累加消息排队时延，controller据此调整进程数
+    inline void add_delay(int delay)
+    {
+        atomic_add(delay, &(pstat_->delay_sum));
+        atomic_inc(&(pstat_->delay_cnt));
+    }
+
 protected:
     int shmkey_;
     int shmsize_;
@@ -0,0 +1,56 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+#ifndef _TBASE_TSLAB_H_
+#define _TBASE_TSLAB_H_
+#include <stddef.h>
+#include <signal.h>
+#include <errno.h>
+
+namespace tbase
+{
+//在共享内存的count个进程私有slab中为pid认领一个，返回slab下标
+//先找空闲的slab，再回收已退出进程的slab（累计值保留，继续累加不影响结果），
+//都没有时按pid与其他进程共用（累加仍是原子操作）
+//owners:	第一个slab的占用进程字段，0表示空闲
+//stride:	相邻slab占用进程字段的字节间隔
+inline int claim_slab(int* owners, int count, size_t stride, int pid)
+{
+    int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        int* owner = (int*)((char*)owners + i * stride);
+        if (__sync_bool_compare_and_swap(owner, 0, pid))
+            return i;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        int* owner = (int*)((char*)owners + i * stride);
+        int old = *(volatile int*)owner;
+        if (kill(old, 0) == -1 && errno == ESRCH
+            && __sync_bool_compare_and_swap(owner, old, pid))
+            return i;
+    }
+
+    return pid % count;
+}
+}
+#endif
@@ -25,8 +25,11 @@
 #include <sys/file.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <signal.h>
+#include <errno.h>
 #include <sys/syscall.h>
 #include "tstat.h"
+#include "tslab.h"
 #include "misc.h"
 
 //Macro for compiler optimization
@@ -78,7 +81,7 @@ typedef struct
     int  size;
 } cdata;
 
-CTStat::CTStat() : statpool_(NULL), policy_num_(0), mapfile_(false)
+CTStat::CTStat() : statpool_(NULL), policy_num_(0), mapfile_(false), slab_(NULL), handle_num_(0)
 {
     memset(policy_, 0x0, STAT_TYPE_NUM * sizeof(long));
     memset(policy_no_, 0x0, STAT_TYPE_NUM * sizeof(int));
@@ -131,7 +134,10 @@ int CTStat::init_statpool(const char* mapfilepath)
     if (!mapfilepath)
     {
         mapfile_ = false;
-        statpool_ = (TStatPool*)malloc(sizeof(TStatPool));
+        void* pool = NULL;
+        if (posix_memalign(&pool, 64, sizeof(TStatPool)) != 0)
+            return ERR_STAT_FULL;
+        statpool_ = (TStatPool*)pool;
         newpool();	//初始化统计池
         //否则使用文件映射的共享内存
     }
@@ -210,6 +216,14 @@ int CTStat::read_statpool(const char* mapfilepath)
     if (unlikely(fd < 0))
         return ERR_STAT_OPENFILE;
 
+    //旧版本的统计文件没有slab区，等进程重启扩展文件后再读
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(TStatPool))
+    {
+        close(fd);
+        return STAT_ERR_SIZE;
+    }
+
     statpool_ = (TStatPool*)mmap(NULL, sizeof(TStatPool), PROT_READ , MAP_SHARED, fd, 0);
 
     if (unlikely(MAP_FAILED == statpool_))
@@ -359,19 +373,94 @@ int CTStat::init_statobj_frame(const char* id, int type, int index, const char*
     return 0;
 }
 
+TStatSlab* CTStat::alloc_slab()
+{
+    int i = claim_slab(&statpool_->slabs_[0].owner_, STAT_SLAB_NUM, sizeof(TStatSlab), getpid());
+    slab_ = &statpool_->slabs_[i];
+    return slab_;
+}
+
+void CTStat::step_statobj(TStatObj* obj, long val, int val_idx)
+{
+    if ((obj->type_ & STAT_TYPE_SLAB) && val_idx >= 1 && val_idx <= obj->val_size_)
+    {
+        TStatSlab* slab = likely(slab_ != NULL) ? slab_ : alloc_slab();
+        STATVAL_ADD(slab->statvals_[obj->val_offset_ + val_idx - 1], val);
+
+        if (val_idx == obj->val_size_)
+            STATVAL_INC(slab->count_[obj - statpool_->statobjs_]);
+
+        return;
+    }
+
+    TStatObjWrapper wrapper;
+    int policy_no = policy_type_[obj->type_];
+    OBJ_WRAPPER(obj, wrapper);
+    policy_[policy_no]->__step__(&wrapper, val, val_idx);
+}
+
 //step0的性能优化版
 int CTStat::op(int index, long val, int val_idx)
 {
     TStatObj* obj = NULL;
-    TStatObjWrapper wrapper;
-    int policy_no = 0;
 
     obj = get_statindex(index);
     if (obj)
     {
-        policy_no = policy_type_[obj->type_];
-        OBJ_WRAPPER(obj, wrapper);
-        policy_[policy_no]->__step__(&wrapper, val, val_idx);
+        step_statobj(obj, val, val_idx);
+    }
+
+    return 0;
+}
+
+int CTStat::get_handle(const char* id)
+{
+    TStatObj* obj = NULL;
+    int i;
+
+    //同一ID重复解析返回同一个句柄
+    for (i = 0; i < handle_num_; ++i)
+    {
+        OBJ_ENTRY(obj, handles_[i].objs_[0]);
+        if (!strcmp(obj->id_, id))
+            return i;
+    }
+
+    if (handle_num_ >= STAT_MAX_HANDLE)
+        return ERR_STAT_FULL;
+
+    TStatHandle* handle = &handles_[handle_num_];
+    handle->num_ = 0;
+
+    int choice = find_statobj(id);
+
+    while (choice != INVALID_HANDLE && handle->num_ < STAT_TYPE_NUM)
+    {
+        OBJ_ENTRY(obj, choice);
+
+        if (strcmp(obj->id_, id))
+            break;
+
+        handle->objs_[handle->num_++] = choice;
+        choice = obj->next_;
+    }
+
+    if (handle->num_ == 0)
+        return ERR_STAT_NONE;
+
+    return handle_num_++;
+}
+
+int CTStat::op_handle(int handle, long val, int val_idx)
+{
+    if (unlikely(handle < 0 || handle >= handle_num_))
+        return ERR_STAT_NONE;
+
+    TStatHandle* h = &handles_[handle];
+
+    for (int i = 0; i < h->num_; ++i)
+    {
+        step_statobj(&statpool_->statobjs_[h->objs_[i]], val, val_idx);
     }
 
     return 0;
@@ -380,9 +469,7 @@ int CTStat::op(int index, long val, int val_idx)
 int CTStat::step(const char** ids, int num, long val, int val_idx)
 {
     TStatObj* obj = NULL;
-    TStatObjWrapper wrapper;
     int choice = INVALID_HANDLE;
-    int policy_no = 0;
 
     for (int i = 0; i < num; ++i)
     {
@@ -394,9 +481,7 @@ int CTStat::step(const char** ids, int num, long val, int val_idx)
 
             if (!strcmp(obj->id_, ids[i]))
             {
-                policy_no = policy_type_[obj->type_];
-                OBJ_WRAPPER(obj, wrapper);
-                policy_[policy_no]->__step__(&wrapper, val, val_idx);
+                step_statobj(obj, val, val_idx);
                 choice = obj->next_;
             }
             else
@@ -436,6 +521,7 @@ int CTStat::query(const char* id, TStatObjWrapper* wrapper)
         TStatObj* obj = NULL;
         OBJ_ENTRY(obj, choice);
         OBJ_WRAPPER(obj, (*wrapper));
+        fold_slab(obj, wrapper, &query_count_, query_values_);
         return 1;
     }
     else
@@ -448,6 +534,7 @@ int CTStat::queryindex(int index, TStatObjWrapper* wrapper)
     if (likely(obj))
     {
         OBJ_WRAPPER(obj, (*wrapper));
+        fold_slab(obj, wrapper, &query_count_, query_values_);
         return 1;
     }
     else
@@ -484,6 +571,18 @@ void CTStat::do_reset(TStatObj* obj, void* data)
     policy_no = policy_type_[obj->type_];
     OBJ_WRAPPER(obj, wrapper);
     policy_[policy_no]->__reset__(&wrapper);
+
+    if (obj->type_ & STAT_TYPE_SLAB)
+    {
+        int choice = obj - statpool_->statobjs_;
+        for (int i = 0; i < STAT_SLAB_NUM; ++i)
+        {
+            TStatSlab* slab = &statpool_->slabs_[i];
+            for (int j = 0; j < obj->val_size_; ++j)
+                STATVAL_SET(slab->statvals_[obj->val_offset_ + j], 0);
+            STATVAL_SET(slab->count_[choice], 0);
+        }
+    }
 }
 
 void CTStat::do_result(TStatObj* obj, void* data)
@@ -499,11 +598,41 @@ void CTStat::do_result(TStatObj* obj, void* data)
     policy_no = policy_type_[obj->type_];
     TStatObjWrapper wrapper;
     OBJ_WRAPPER(obj, wrapper);
+
+    TStatVal slab_count;
+    TStatVal slab_values[STAT_MAX_VALSIZE];
+    fold_slab(obj, &wrapper, &slab_count, slab_values);
+
     count = policy_[policy_no]->__result__(&wrapper, values, &val_size);
 //	output_statobj(obj, count, values, val_size, buffer, len);
     output_statobj(obj, count, values, val_size, buff->buffer, buff->len, buff->size);
 }
 
+void CTStat::fold_slab(TStatObj* obj, TStatObjWrapper* wrapper, TStatVal* count, TStatVal* values)
+{
+    if (!(obj->type_ & STAT_TYPE_SLAB) || obj->val_size_ > STAT_MAX_VALSIZE)
+        return;
+
+    int choice = obj - statpool_->statobjs_;
+    STATVAL_SET(*count, STATVAL_READ(obj->count_));
+    for (int j = 0; j < obj->val_size_; ++j)
+        STATVAL_SET(values[j], STATVAL_READ(wrapper->value_[j]));
+
+    for (int i = 0; i < STAT_SLAB_NUM; ++i)
+    {
+        TStatSlab* slab = &statpool_->slabs_[i];
+        if (slab->owner_ == 0)
+            continue;
+
+        STATVAL_ADD(*count, STATVAL_READ(slab->count_[choice]));
+        for (int j = 0; j < obj->val_size_; ++j)
+            STATVAL_ADD(values[j], STATVAL_READ(slab->statvals_[obj->val_offset_ + j]));
+    }
+
+    wrapper->count_ = count;
+    wrapper->value_ = values;
+}
+
 int CTStat::find_statobj(const char* id, int type, TStatObj **pobj)
 {
     int bucketid  = hashid(id);
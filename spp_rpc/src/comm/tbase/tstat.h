@@ -32,6 +32,7 @@
 #define STAT_TYPE_SET     1<<5			//设置操作, add by jeremy
 
 #define STAT_TYPE_ALL	  -1			//通配	
+#define STAT_TYPE_SLAB	  (STAT_TYPE_SUM | STAT_TYPE_AVG | STAT_TYPE_COUNT)	//可按进程分slab累加的类型
 //modified by jeremy
 #define STAT_TYPE_NUM     6				//统计策略个数
 
@@ -42,6 +43,8 @@
 #define DEFAULT_STATVAL_NUM  (DEFAULT_STATOBJ_NUM*1)  //统计值总个数（一个统计对象至少有一个统计值）
 #define STAT_BUFF_SIZE	  1<<18  		//统计报表缓冲区大小
 #define STAT_MAX_VALSIZE  10            //统计值最大维数
+#define STAT_SLAB_NUM     64            //每进程统计slab个数
+#define STAT_MAX_HANDLE   DEFAULT_STATOBJ_NUM	//统计句柄最大个数
 #define INVALID_HANDLE	  -1
 
 #define ERR_STAT_EXIST    	-2000       //统计对象已经存在
@@ -70,6 +73,21 @@ typedef struct
     int next_;							//下一个TStatObj
 } TStatObj; //统计对象
 
+///////////////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+    int owner_;                         //占用slab的进程ID，0表示空闲
+    char pad_[60];                      //统计值从新的cache line开始
+    TStatVal count_[DEFAULT_STATOBJ_NUM];   //次数，按TStatObj下标
+    TStatVal statvals_[DEFAULT_STATVAL_NUM];//统计值，按val_offset_
+} __attribute__((aligned(64))) TStatSlab; //进程私有统计slab，避免多进程累加同一cache line
+
+typedef struct
+{
+    int objs_[STAT_TYPE_NUM];           //同一统计ID的各个TStatObj下标
+    int num_;
+} TStatHandle; //统计句柄
+
 ///////////////////////////////////////////////////////////////////////////////////
 typedef struct
 {
@@ -82,6 +100,7 @@ typedef struct
     TStatObj statobjs_[DEFAULT_STATOBJ_NUM];  //TStatObj数组
     int statvals_used_;                  	  //使用的TStatVal数目
     TStatVal statvals_[DEFAULT_STATVAL_NUM];  //TStatVal数组
+    TStatSlab slabs_[STAT_SLAB_NUM];          //各进程的统计slab, 出报表时与上面的统计值合并
 } TStatPool; //统计对象池
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -134,6 +153,7 @@ public:
     void reset();
 
     //查询统计对象信息
+    //Sum/Avg/Count类型返回合并各进程slab后的值，在下次query/queryindex前有效
     //id:       统计ID
     //wrapper:  统计对象信息
     int query(const char* id, TStatObjWrapper* wrapper);
@@ -152,11 +172,22 @@ public:
     //value_idx:统计值维度
     int op(int index, long val, int val_idx = 1);
 
-    //查询统计对象信息（性能优化版）
+    //查询统计对象信息（性能优化版），slab合并同query
     //index:    统计索引
     //wrapper:  统计对象信息
     int queryindex(int index, TStatObjWrapper* wrapper);
 
+    //把统计ID解析为句柄，之后用op_handle统计，不再按字符串查找
+    //id:	统计ID（须已init_statobj）
+    //返回值: >=0句柄，否则失败
+    int get_handle(const char* id);
+
+    //一次统计（句柄版），Sum/Avg/Count类型无锁累加到本进程的slab
+    //handle:	get_handle返回的句柄
+    //val: 		统计值分量
+    //value_idx:统计值维度
+    int op_handle(int handle, long val, int val_idx = 1);
+
 protected:
     CTStatPolicy* policy_[STAT_TYPE_NUM];
     int policy_no_[STAT_TYPE_NUM];
@@ -165,6 +196,11 @@ protected:
     int policy_num_;
     bool mapfile_;
     TStatObj* statindex_[DEFAULT_STATOBJ_NUM];
+    TStatSlab* slab_;                   //本进程的slab，首次使用时分配
+    TStatHandle handles_[STAT_MAX_HANDLE];
+    int handle_num_;
+    TStatVal query_count_;              //query/queryindex合并slab后的次数
+    TStatVal query_values_[STAT_MAX_VALSIZE];   //query/queryindex合并slab后的统计值
 
     //JS Hash算法，把字符串hash为32位整数
     inline unsigned hashid(const char* id)
@@ -191,6 +227,12 @@ protected:
     void travel(visit_func visitor, void* data = NULL);
     void do_reset(TStatObj* obj, void* data = NULL);
     void do_result(TStatObj* obj, void* data = NULL);
+    //合并各进程slab中的累加值，wrapper改为指向count/values中的合并结果
+    void fold_slab(TStatObj* obj, TStatObjWrapper* wrapper, TStatVal* count, TStatVal* values);
+    //对一个统计对象做一次统计
+    void step_statobj(TStatObj* obj, long val, int val_idx);
+    //分配本进程的slab
+    TStatSlab* alloc_slab();
 
     //把TStatObj指针数组按index赋值
     //index:	索引/下标
@@ -190,7 +190,8 @@ void CDefaultCtrl::realrun(int argc, char* argv[])
         loop();
 
         dump_pid();
-        sleep(3);
+        // 1s一个周期，限定突发流量下扩容的反应时间
+        sleep(1);
     }
 
     flog_.LOG_P_PID(LOG_FATAL, "controller stopped!\n");
@@ -288,6 +289,13 @@ int CDefaultCtrl::initconf(bool reload)
     groupinfo.maxprocnum_       = config.procnum;
     groupinfo.minprocnum_       = config.procnum;
     groupinfo.heartbeat_        = config.heartbeat;
+    // procnum_max大于procnum时按排队时延和CPU在[procnum, procnum_max]间伸缩
+    if (config.procnum_max > config.procnum)
+    {
+        groupinfo.maxprocnum_   = config.procnum_max;
+        groupinfo.delay_slo_    = config.delay_slo > 0 ? config.delay_slo : 1;
+        groupinfo.prefork_      = config.prefork > 0 ? config.prefork : 0;
+    }
     groupinfo.affinity_         = -1;
 
     snprintf(groupinfo.basepath_, (sizeof(groupinfo.basepath_) - 1), ".");
@@ -417,6 +425,13 @@ int CDefaultCtrl::reloadconf()
     groupinfo.maxprocnum_       = config.procnum;
     groupinfo.minprocnum_       = config.procnum;
     groupinfo.heartbeat_        = config.heartbeat;
+    // procnum_max大于procnum时按排队时延和CPU在[procnum, procnum_max]间伸缩
+    if (config.procnum_max > config.procnum)
+    {
+        groupinfo.maxprocnum_   = config.procnum_max;
+        groupinfo.delay_slo_    = config.delay_slo > 0 ? config.delay_slo : 1;
+        groupinfo.prefork_      = config.prefork > 0 ? config.prefork : 0;
+    }
     groupinfo.affinity_         = -1;
 
     snprintf(groupinfo.basepath_, (sizeof(groupinfo.basepath_) - 1), ".");
@@ -19,6 +19,14 @@
 
 import traceback
 
+# True: req_data is a read-only memoryview over the request buffer (no copy).
+# It is only valid during the call; use req_data.tobytes() to keep it.
+# Taking a new view of it after the call raises BufferError, and a view kept
+# past the call turns zero copy off for later requests.
+# process_batch always gets copies. Enable only if all service methods
+# accept buffer objects.
+ZERO_COPY_REQUEST = False
+
 def init(config):
     print "service::init"
     return 0
@@ -76,6 +84,16 @@ def process(full_method_name, req_data, is_json):
 
     return (-21, errmsg)
 
+# Batch entry: when defined, requests queued in the worker are passed in one call
+# as [(full_method_name, req_data, is_json), ...], and must return
+# [(ret, rsp_data), ...] in the same order.
+# Log options inside a batch belong to its last request.
+# To enable: process_batch = process_all
+process_batch = None
+
+def process_all(reqs):
+    return [process(full_method_name, req_data, is_json) for (full_method_name, req_data, is_json) in reqs]
+
 if __name__ == "__main__":
     import echo_pb2
     request = echo_pb2.EchoRequest()
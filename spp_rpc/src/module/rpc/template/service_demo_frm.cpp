@@ -295,10 +295,15 @@ extern "C" int spp_handle_process(unsigned flow, void* arg1, void* arg2)
     }
     
     // 3. 派发消息, 等待被调度
+    struct timeval time_rcv;
+    time_rcv.tv_sec  = extinfo->recvtime_;
+    time_rcv.tv_usec = extinfo->tv_usec;
+
     msg->SetServerBase(base);
     msg->SetTCommu(commu);
     msg->SetFlow(flow);
     msg->SetMsgTimeout(1000);
+    msg->SetRcvTimestamp(time_rcv);     // 调用方剩余超时从proxy接收时间开始计算
     msg->SetReqPkg(blob->data, blob->len);
     msg->GetLogOption().Set("ReqID", rpc_head.flow_id());
     msg->GetLogOption().Set("ClientIP", inet_ntoa(*(struct in_addr*)&extinfo->remoteip_));
@@ -54,6 +54,12 @@ static uint64_t g_loadfile_time;
 
 PyObject*  g_entry_module = NULL;
 
+// entry.py中的函数, 载入时取一次, 请求处理时不再按名字查找
+static PyObject* g_py_process       = NULL;
+static PyObject* g_py_process_batch = NULL;     // 可选
+static PyObject* g_py_loop          = NULL;
+static bool      g_py_zero_copy     = false;    // ZERO_COPY_REQUEST, 请求以memoryview传入
+
 // python全局析构函数
 void srpc_py_handle_fini(void)
 {
@@ -79,17 +85,10 @@ void srpc_py_handle_fini(void)
 // python全局析构函数
 void srpc_py_handle_loop(void)
 {
-    if (g_entry_module == NULL)
-        return;
-    
-    PyObject* py_func = PyObject_GetAttrString(g_entry_module, "loop"); //这里是要调用的函数名  
-    if (py_func == NULL)
-    {   
-        NGLOG_ERROR("No function named 'fini' in entry.py");
+    if (g_py_loop == NULL)
         return;
-    }
 
-    PyObject* py_ret = PyEval_CallObject(py_func, NULL);
+    PyObject* py_ret = PyEval_CallObject(g_py_loop, NULL);
     if (py_ret == NULL)
     {
         NGLOG_ERROR("Call function 'loop' exception in entry.py");
@@ -136,53 +135,328 @@ int srpc_py_handler_init(const char *config)
     return ret;
 }
 
+// ZERO_COPY_REQUEST时memoryview的属主, 引用请求内存
+// memoryview及其切片都从属主取buffer, process返回后属主失效, 不能再取
+typedef struct
+{
+    PyObject_HEAD
+    const char* buf;        // 请求内存, 失效后为NULL
+    Py_ssize_t  len;
+    int         exports;    // 已取出未释放的buffer数
+} py_reqbuf_t;
+
+static int srpc_py_reqbuf_getbuffer(PyObject *obj, Py_buffer *view, int flags)
+{
+    py_reqbuf_t *reqbuf = (py_reqbuf_t *)obj;
+
+    if (reqbuf->buf == NULL)
+    {
+        PyErr_SetString(PyExc_BufferError, "req_data is only valid during process()");
+        return -1;
+    }
+
+    if (PyBuffer_FillInfo(view, obj, (void *)reqbuf->buf, reqbuf->len, 1, flags) < 0)
+    {
+        return -1;
+    }
+
+    reqbuf->exports++;
+    return 0;
+}
+
+static void srpc_py_reqbuf_releasebuffer(PyObject *obj, Py_buffer *view)
+{
+    ((py_reqbuf_t *)obj)->exports--;
+}
+
+static void srpc_py_reqbuf_dealloc(PyObject *obj)
+{
+    PyObject_Del(obj);
+}
+
+static PyBufferProcs g_reqbuf_as_buffer = {
+    0,                              /* bf_getreadbuffer */
+    0,                              /* bf_getwritebuffer */
+    0,                              /* bf_getsegcount */
+    0,                              /* bf_getcharbuffer */
+    srpc_py_reqbuf_getbuffer,       /* bf_getbuffer */
+    srpc_py_reqbuf_releasebuffer,   /* bf_releasebuffer */
+};
+
+static PyTypeObject g_reqbuf_type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                              /* ob_size */
+    "srpc.RequestBuffer",           /* tp_name */
+    sizeof(py_reqbuf_t),            /* tp_basicsize */
+    0,                              /* tp_itemsize */
+    srpc_py_reqbuf_dealloc,         /* tp_dealloc */
+    0,                              /* tp_print */
+    0,                              /* tp_getattr */
+    0,                              /* tp_setattr */
+    0,                              /* tp_compare */
+    0,                              /* tp_repr */
+    0,                              /* tp_as_number */
+    0,                              /* tp_as_sequence */
+    0,                              /* tp_as_mapping */
+    0,                              /* tp_hash */
+    0,                              /* tp_call */
+    0,                              /* tp_str */
+    0,                              /* tp_getattro */
+    0,                              /* tp_setattro */
+    &g_reqbuf_as_buffer,            /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, /* tp_flags */
+    "SRPC request buffer",          /* tp_doc */
+};
+
+// process返回后请求内存会被下一个请求覆盖, 属主置为失效
+// 回包引用请求内存的一份在发送后才释放, 除此之外还有未释放的buffer说明python保留了req_data,
+// 之后的请求改为复制
+static void srpc_py_release_request(PyObject *owner, const py_response_t *rsp)
+{
+    if (owner == NULL)
+        return;
+
+    py_reqbuf_t *reqbuf = (py_reqbuf_t *)owner;
+    int held = (rsp != NULL && rsp->view != NULL && ((Py_buffer *)rsp->view)->obj == owner) ? 1 : 0;
+
+    reqbuf->buf = NULL;
+    reqbuf->len = 0;
+    if (reqbuf->exports > held)
+    {
+        NGLOG_ERROR("req_data is still referenced after process() returned, ZERO_COPY_REQUEST disabled");
+        g_py_zero_copy = false;
+    }
+
+    Py_DECREF(owner);
+}
+
+// 构造process的参数(method, req_data, is_json)
+// owner非NULL且ZERO_COPY_REQUEST为True时, req_data是引用请求内存的只读memoryview,
+// 属主由*owner返回, 调用结束后用srpc_py_release_request释放; 否则复制为str
+static PyObject* srpc_py_build_args(const string &method, int type, const char *req, int req_len, PyObject **owner)
+{
+    PyObject *py_req = NULL;
+
+    if (owner != NULL)
+    {
+        *owner = NULL;
+    }
+
+    if (owner != NULL && g_py_zero_copy)
+    {
+        py_reqbuf_t *reqbuf = PyObject_New(py_reqbuf_t, &g_reqbuf_type);
+        if (reqbuf != NULL)
+        {
+            reqbuf->buf     = req;
+            reqbuf->len     = req_len;
+            reqbuf->exports = 0;
+
+            py_req = PyMemoryView_FromObject((PyObject *)reqbuf);
+            if (py_req != NULL)
+            {
+                *owner = (PyObject *)reqbuf;
+            }
+            else
+            {
+                Py_DECREF(reqbuf);
+            }
+        }
+        PyErr_Clear();
+    }
+
+    if (py_req == NULL)
+    {
+        py_req = PyString_FromStringAndSize(req, req_len);
+        if (py_req == NULL)
+        {
+            PyErr_Clear();
+            return NULL;
+        }
+    }
+
+    PyObject *py_args = Py_BuildValue("(sNi)", method.c_str(), py_req, (type == 2));
+    if (py_args == NULL && owner != NULL && *owner != NULL)
+    {
+        PyErr_Clear();
+        srpc_py_release_request(*owner, NULL);
+        *owner = NULL;
+    }
+
+    return py_args;
+}
+
+// 解析python返回的(ret, rsp_data), rsp_data支持buffer协议时直接引用其内存
+static int srpc_py_parse_response(PyObject *py_ret, py_response_t *rsp)
+{
+    PyObject *py_data = NULL;
+    char *rsp_ptr = NULL;
+    int  rsp_len = 0;
+    int  ret = -1;
+
+    memset(rsp, 0, sizeof(*rsp));
+
+    if (py_ret == NULL || !PyArg_ParseTuple(py_ret, "iO", &ret, &py_data))
+    {
+        PyErr_Clear();
+        NGLOG_ERROR("Illegal return value for 'process' function in entry.py");
+        return SRPC_ERR_PYTHON_FAILED;
+    }
+
+    if (ret != 0)
+    {
+        NGLOG_ERROR("process failed %d in entry.py, errmsg: %s", ret,
+                    PyString_Check(py_data) ? PyString_AS_STRING(py_data) : "");
+        return SRPC_ERR_PYTHON_FAILED;
+    }
+
+    if (PyObject_CheckBuffer(py_data))
+    {
+        Py_buffer *view = new Py_buffer;
+        if (PyObject_GetBuffer(py_data, view, PyBUF_SIMPLE) == 0)
+        {
+            rsp->data = (const char *)view->buf;
+            rsp->len  = (int)view->len;
+            rsp->view = view;
+            return SRPC_SUCCESS;
+        }
+
+        delete view;
+        PyErr_Clear();
+    }
+
+    // unicode等不支持buffer协议的对象仍按"s#"转换, 内存归对象所有
+    if (!PyArg_Parse(py_data, "s#", &rsp_ptr, &rsp_len))
+    {
+        PyErr_Clear();
+        NGLOG_ERROR("Illegal return value for 'process' function in entry.py");
+        return SRPC_ERR_PYTHON_FAILED;
+    }
+
+    Py_INCREF(py_data);
+    rsp->data  = rsp_ptr;
+    rsp->len   = rsp_len;
+    rsp->owner = py_data;
+
+    return SRPC_SUCCESS;
+}
+
 // 处理函数
 int srpc_py_handler_process(const string &method,  void* extInfo, int type,
-                             const string &request, string &response)
+                             const char *req, int req_len, py_response_t *rsp)
 {    
     if (g_entry_module == NULL)
         return -1;
     
-    PyObject* py_func = PyObject_GetAttrString(g_entry_module, "process");
-    if (py_func == NULL)
+    if (g_py_process == NULL)
     {   
         NGLOG_ERROR("No function named 'process' in entry.py");
         return SRPC_ERR_PYTHON_FAILED;
     }
 
-    PyObject *py_args = PyTuple_New(3);
-    PyTuple_SetItem(py_args, 0, Py_BuildValue("s", method.c_str())); 
-    PyTuple_SetItem(py_args, 1, Py_BuildValue("s#", request.c_str(), request.length()));
-    PyTuple_SetItem(py_args, 2, Py_BuildValue("i", (type == 2)));
-    PyObject* py_ret = PyEval_CallObject(py_func, py_args); //调用函数,NULL表示参数为空
+    PyObject *py_owner = NULL;
+    PyObject *py_args = srpc_py_build_args(method, type, req, req_len, &py_owner);
+    if (py_args == NULL)
+    {
+        NGLOG_ERROR("Build args for 'process' function failed");
+        return SRPC_ERR_PYTHON_FAILED;
+    }
 
-    char*  rsp_ptr = NULL;
-    int  rsp_len = 0;  
-    int  ret = -1;
-    if (py_ret && PyArg_ParseTuple(py_ret, "is#", &ret, &rsp_ptr, &rsp_len))
+    PyObject* py_ret = PyEval_CallObject(g_py_process, py_args);
+    Py_DECREF(py_args);
+
+    // 回包对象由rsp持有, py_ret可以先释放
+    int ret = srpc_py_parse_response(py_ret, rsp);
+    Py_XDECREF(py_ret);
+    srpc_py_release_request(py_owner, rsp);
+
+    return ret;
+}
+
+// 释放回包持有的python对象
+void srpc_py_release_response(py_response_t *rsp)
+{
+    if (rsp->view != NULL)
     {
-        if (ret == 0)
-        {
-            response.assign(rsp_ptr, rsp_len);
-            Py_DECREF(py_ret);
-            Py_DECREF(py_args);
-            return 0;
-        }
-        else
+        PyBuffer_Release((Py_buffer *)rsp->view);
+        delete (Py_buffer *)rsp->view;
+    }
+
+    Py_XDECREF((PyObject *)rsp->owner);
+    memset(rsp, 0, sizeof(*rsp));
+}
+
+// entry.py是否提供了批量处理函数process_batch
+bool srpc_py_batch_enabled(void)
+{
+    return (g_py_process_batch != NULL);
+}
+
+// 批量处理函数: process_batch([(method, req_data, is_json), ...]) 返回 [(ret, rsp_data), ...]
+// 攒批的包体在flush后清空, req_data总是复制为str, 不受ZERO_COPY_REQUEST影响
+int srpc_py_handler_process_batch(py_request_t *reqs, int num)
+{
+    PyObject *py_list = NULL;
+    PyObject *py_ret  = NULL;
+    PyObject *py_seq  = NULL;
+    int i;
+
+    for (i = 0; i < num; i++)
+    {
+        reqs[i].ret = SRPC_ERR_PYTHON_FAILED;
+        memset(&reqs[i].rsp, 0, sizeof(reqs[i].rsp));
+    }
+
+    if (g_py_process_batch == NULL)
+    {
+        NGLOG_ERROR("No function named 'process_batch' in entry.py");
+        return SRPC_ERR_PYTHON_FAILED;
+    }
+
+    py_list = PyList_New(num);
+    if (py_list == NULL)
+    {
+        PyErr_Clear();
+        return SRPC_ERR_PYTHON_FAILED;
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        PyObject *py_args = srpc_py_build_args(*reqs[i].method, reqs[i].type, reqs[i].req, reqs[i].req_len, NULL);
+        if (py_args == NULL)
         {
-            NGLOG_ERROR("process failed %d in entry.py, errmsg: %s", ret, response.c_str());
-            Py_DECREF(py_ret);
-            Py_DECREF(py_args);
+            NGLOG_ERROR("Build args for 'process_batch' function failed");
+            Py_DECREF(py_list);
             return SRPC_ERR_PYTHON_FAILED;
         }
+        PyList_SET_ITEM(py_list, i, py_args);
     }
-    else
+
+    py_ret = PyObject_CallFunctionObjArgs(g_py_process_batch, py_list, NULL);
+    Py_DECREF(py_list);
+
+    if (py_ret != NULL)
     {
-        NGLOG_ERROR("Illegal return value for 'process' function in entry.py");
+        py_seq = PySequence_Fast(py_ret, "");
+    }
+
+    if (py_seq == NULL || PySequence_Fast_GET_SIZE(py_seq) != num)
+    {
+        PyErr_Clear();
+        NGLOG_ERROR("Illegal return value for 'process_batch' function in entry.py");
+        Py_XDECREF(py_seq);
         Py_XDECREF(py_ret);
-        Py_DECREF(py_args);
         return SRPC_ERR_PYTHON_FAILED;
     }
+
+    for (i = 0; i < num; i++)
+    {
+        reqs[i].ret = srpc_py_parse_response(PySequence_Fast_GET_ITEM(py_seq, i), &reqs[i].rsp);
+    }
+
+    Py_DECREF(py_seq);
+    Py_DECREF(py_ret);
+
+    return SRPC_SUCCESS;
 }
 
 int srpc_py_init(void)
@@ -203,6 +477,20 @@ int srpc_py_init(void)
     return 0;
 }
 
+// 取入口模块中的函数, 不存在或不可调用时返回NULL
+static PyObject* srpc_py_get_func(const char *name)
+{
+    PyObject* py_func = PyObject_GetAttrString(g_entry_module, name);
+    if (py_func == NULL || !PyCallable_Check(py_func))
+    {
+        Py_XDECREF(py_func);
+        PyErr_Clear();
+        return NULL;
+    }
+
+    return py_func;
+}
+
 // 加载python入口文件
 int srpc_py_load_file(void)
 {
@@ -226,6 +514,14 @@ int srpc_py_load_file(void)
 
     g_loadfile_time = (uint64_t)buf.st_mtime;
 
+    // 3. ZERO_COPY_REQUEST用的请求内存属主类型
+    if (PyType_Ready(&g_reqbuf_type) < 0)
+    {
+        PyErr_Clear();
+        LOG_SCREEN(LOG_ERROR, "Init request buffer type failed");
+        return -4;
+    }
+
     PyObject* moduleName = PyString_FromString(PY_ENTRY); //模块名，不是文件名
     PyObject* pModule = PyImport_Import(moduleName);
     if (!pModule)
@@ -235,12 +531,33 @@ int srpc_py_load_file(void)
     }
 
     g_entry_module = pModule;
+
+    // 4. 取入口函数, process_batch与ZERO_COPY_REQUEST可选
+    g_py_process       = srpc_py_get_func("process");
+    g_py_process_batch = srpc_py_get_func("process_batch");
+    g_py_loop          = srpc_py_get_func("loop");
+
+    PyObject* py_flag = PyObject_GetAttrString(pModule, "ZERO_COPY_REQUEST");
+    g_py_zero_copy = (py_flag != NULL && PyObject_IsTrue(py_flag) == 1);
+    Py_XDECREF(py_flag);
+    PyErr_Clear();
+
+    if (g_py_process == NULL)
+    {
+        LOG_SCREEN(LOG_ERROR, "No function named 'process' in entry.py");
+    }
+
     return ret;
 }
 
 
 void srpc_py_end(void)
 {
+    Py_CLEAR(g_py_process);
+    Py_CLEAR(g_py_process_batch);
+    Py_CLEAR(g_py_loop);
+    Py_CLEAR(g_entry_module);
+
     Py_Finalize();
 }
 
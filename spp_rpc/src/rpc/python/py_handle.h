@@ -24,6 +24,26 @@
 
 using namespace std;
 
+// python回包: 直接引用python返回对象的内存(buffer协议), 用完调用srpc_py_release_response
+typedef struct
+{
+    const char* data;
+    int         len;
+    void*       owner;      // 持有的python对象
+    void*       view;       // Py_buffer, 不支持buffer协议的对象为NULL
+} py_response_t;
+
+// 批量处理的请求
+typedef struct
+{
+    const string*   method;
+    int             type;
+    const char*     req;
+    int             req_len;
+    int             ret;        // [出参]处理结果
+    py_response_t   rsp;        // [出参]ret为0时有效
+} py_request_t;
+
 // python全局析构函数
 void srpc_py_handle_fini(void);
 
@@ -33,8 +53,17 @@ int srpc_py_handler_init(const char *config);
 // python loop函数
 void srpc_py_handle_loop(void);
 
-// 处理函数
-int srpc_py_handler_process(const string &method,  void* extInfo, int type, const string &request, string &response);
+// 处理函数, 请求只在调用期间有效; 成功时rsp需要调用srpc_py_release_response释放
+int srpc_py_handler_process(const string &method,  void* extInfo, int type, const char *req, int req_len, py_response_t *rsp);
+
+// 释放回包持有的python对象
+void srpc_py_release_response(py_response_t *rsp);
+
+// entry.py是否提供了批量处理函数process_batch
+bool srpc_py_batch_enabled(void);
+
+// 批量处理函数, 一次调用python处理num个请求, 结果写回reqs[i].ret/rsp
+int srpc_py_handler_process_batch(py_request_t *reqs, int num);
 
 // 初始化python引擎, 开发者可以自己上传php.ini
 int srpc_py_init(void);
@@ -25,6 +25,7 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <fcntl.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -62,6 +63,33 @@ static char *g_original_config;
 
 #define PY_STDOUT_STDERR_FILE "../log/stdout_stderr.log"
 
+#define PY_BATCH_MAX    32      // 一次交给process_batch的最大请求数
+#define PY_BATCH_WAIT   2       // 队列一直不空时, 批次最多等待的毫秒数
+
+// 等待批量处理的请求
+typedef struct
+{
+    unsigned    flow;
+    CTCommu*    commu;
+    void*       server;
+    CRpcHead    head;
+    int         offset;         // 包体在g_batch_body中的偏移
+    int         len;
+} py_batch_item_t;
+
+// blob在spp_handle_process返回后会被覆盖, 攒批的包体需要复制一份
+static py_batch_item_t  g_batch_items[PY_BATCH_MAX];
+static int              g_batch_num;
+static string           g_batch_body;
+static uint64_t         g_batch_start;  // 本批第一个请求的入队时间(ms)
+
+static uint64_t py_batch_now_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
 int redirect_output(void)
 {
     int fd = open(PY_STDOUT_STDERR_FILE, O_CREAT | O_WRONLY | O_APPEND, 0666);
@@ -99,6 +127,112 @@ void check_output(void)
 
 extern "C" void spp_handle_fini(void* arg1, void* arg2);
 
+/**
+ * @brief 组包并回包给前端, ret非SRPC_SUCCESS时只回包头
+ * @return 0 回包成功, 其它为组包失败
+ */
+static int send_response(unsigned flow, CTCommu* commu, void* server, CRpcHead* head,
+                         int32_t ret, const char* body, int32_t body_len)
+{
+    blob_type resblob;
+    int32_t msg_len;
+    char*   rsp_buff;
+
+    if (ret != SRPC_SUCCESS)
+    {
+        head->set_err(ret);
+        ret = SrpcPackPkgNoBody(&rsp_buff, &msg_len, head);
+    }
+    else
+    {
+        ret = SrpcPackPkg(&rsp_buff, &msg_len, head, body, body_len);
+    }
+
+    if (ret != SRPC_SUCCESS)
+    {
+        RPC_REPORT(errmsg(ret));
+        NGLOG_ERROR("pack package failed: %s",  errmsg(ret));
+        return -1;
+    }
+
+    resblob.data = rsp_buff;
+    resblob.len  = msg_len;
+    commu->sendto(flow, &resblob, server);
+
+    free(rsp_buff);
+
+    return 0;
+}
+
+/**
+ * @brief 把攒下的请求一次交给process_batch处理并逐个回包
+ */
+static void py_batch_flush(void)
+{
+    py_request_t reqs[PY_BATCH_MAX];
+    int num = g_batch_num;
+    int i;
+
+    if (num == 0)
+    {
+        return;
+    }
+
+    // 包体都复制完才取地址, g_batch_body扩容会移动内存
+    for (i = 0; i < num; i++)
+    {
+        reqs[i].method  = &g_batch_items[i].head.method_name();
+        reqs[i].type    = 1;
+        reqs[i].req     = g_batch_body.data() + g_batch_items[i].offset;
+        reqs[i].req_len = g_batch_items[i].len;
+    }
+
+    srpc_py_handler_process_batch(reqs, num);
+
+    for (i = 0; i < num; i++)
+    {
+        py_batch_item_t* item = &g_batch_items[i];
+        if (reqs[i].ret != SRPC_SUCCESS)
+        {
+            RPC_REPORT(errmsg(reqs[i].ret));
+            NGLOG_ERROR("%s", errmsg(reqs[i].ret));
+        }
+
+        send_response(item->flow, item->commu, item->server, &item->head,
+                      reqs[i].ret, reqs[i].rsp.data, reqs[i].rsp.len);
+        if (reqs[i].ret == SRPC_SUCCESS)
+        {
+            srpc_py_release_response(&reqs[i].rsp);
+        }
+    }
+
+    g_batch_num = 0;
+    g_batch_body.clear();
+}
+
+/**
+ * @brief 主循环每轮调用: 接收队列已空、攒满或等待超时才处理本批
+ * @info  worker每轮只收一个请求, 队列里还有请求时留给下一轮加入本批
+ *        队列是worker组共享的, 被其它worker取走时靠超时兜底
+ */
+static void py_batch_check(void)
+{
+    if (g_batch_num == 0)
+    {
+        return;
+    }
+
+    int pending = 0;
+    g_batch_items[0].commu->ctrl(g_batch_items[0].flow, CT_MSGCOUNT, &pending, NULL);
+    if ((pending > 0) && (g_batch_num < PY_BATCH_MAX)
+        && (py_batch_now_ms() < g_batch_start + PY_BATCH_WAIT))
+    {
+        return;
+    }
+
+    py_batch_flush();
+}
+
 /**
  * @brief 业务模块初始化插件接口(proxy,worker)
  * @param conf -业务配置文件信息
@@ -223,7 +357,7 @@ extern "C" int process_http(unsigned flow, void* arg1, void* arg2)
     CHttpHelper http_helper(HTTP_HELPER_TYPE_WORKER);
     std::string method_name;
     std::string body;
-    std::string rsp_body;
+    py_response_t rsp;
     char *pkg = NULL;
     int pkg_len = 0;
     int err = SRPC_SUCCESS;
@@ -278,7 +412,7 @@ extern "C" int process_http(unsigned flow, void* arg1, void* arg2)
     // 6. 调用处理函数
     //TODO
     //srpc_py_set_header(&rpc_head);
-    ret = srpc_py_handler_process(rpc_head.method_name(), extinfo, 2, body, rsp_body);
+    ret = srpc_py_handler_process(rpc_head.method_name(), extinfo, 2, body.data(), (int)body.size(), &rsp);
     if (ret != SRPC_SUCCESS)
     {
         RPC_REPORT(errmsg(ret));
@@ -287,14 +421,18 @@ extern "C" int process_http(unsigned flow, void* arg1, void* arg2)
         goto EXIT_LABEL;
     }
 
-    pkg = (char *)rsp_body.c_str();
-    pkg_len = (int)rsp_body.size();
+    pkg = (char *)rsp.data;
+    pkg_len = rsp.len;
 
 EXIT_LABEL:
     blob_type resblob;
     string response;
 
     CHttpHelper::GenJsonResponse(err, pkg, pkg_len, response);
+    if (pkg != NULL)
+    {
+        srpc_py_release_response(&rsp);
+    }
     resblob.data = (char *)response.data();
     resblob.len  = (int)response.size();
     commu->sendto(flow, &resblob, arg2);
@@ -314,11 +452,9 @@ extern "C" int spp_handle_process(unsigned flow, void* arg1, void* arg2)
     CTCommu* commu          = (CTCommu*)blob->owner;
     TConnExtInfo* extinfo   = (TConnExtInfo*)blob->extdata;
     CServerBase* base       = (CServerBase*)arg2;
-    blob_type resblob;
-    string req_body;
-    string rsp_body;
-    int32_t msg_len;
-    char*   rsp_buff;
+    const char* req_body    = NULL;
+    int32_t req_len         = 0;
+    py_response_t rsp;
     char attr[256];
 
     NGLOG_DEBUG("spp_handle_process flow:%d, buffer len:%d, client ip:%s",
@@ -364,63 +500,64 @@ extern "C" int spp_handle_process(unsigned flow, void* arg1, void* arg2)
     set_log_option_long("Coloring", (int64_t)rpc_head.coloring());
 
 
-    // 3. 获取包体
-    ret = SrpcGetPkgBodyString((char*)blob->data, blob->len, req_body);
+    // 3. 获取包体, 不复制, 指向blob内部
+    ret = SrpcGetPkgBody((char*)blob->data, blob->len, &req_body, &req_len);
     if (ret != SRPC_SUCCESS)
     {
         RPC_REPORT(errmsg(ret));
-        rpc_head.set_err(ret);
         msec_log_error(errmsg(ret));
         goto EXIT_LABEL;
     }
 
-    // 4. 调用处理函数
-    ret = srpc_py_handler_process(rpc_head.method_name(), extinfo, 1, req_body, rsp_body);
+    // 4. entry.py提供了process_batch时先攒批, 由spp_handle_loop在队列空、攒满或超时时交给python
+    //    批量处理时python中的日志选项为本批最后一个请求的
+    if (srpc_py_batch_enabled())
+    {
+        if (g_batch_num == 0)
+        {
+            g_batch_start = py_batch_now_ms();
+        }
+
+        py_batch_item_t* item = &g_batch_items[g_batch_num++];
+        item->flow   = flow;
+        item->commu  = commu;
+        item->server = arg2;
+        item->head   = rpc_head;
+        item->offset = (int)g_batch_body.size();
+        item->len    = req_len;
+        g_batch_body.append(req_body, req_len);
+
+        if (g_batch_num >= PY_BATCH_MAX)
+        {
+            py_batch_flush();
+        }
+
+        reset_log_option();
+        return 0;
+    }
+
+    // 5. 调用处理函数
+    ret = srpc_py_handler_process(rpc_head.method_name(), extinfo, 1, req_body, req_len, &rsp);
     if (ret != SRPC_SUCCESS)
     {
         RPC_REPORT(errmsg(ret));
-        rpc_head.set_err(ret);
         msec_log_error(errmsg(ret));
         goto EXIT_LABEL;
     }
 
-    // 5. 回包给前端
-    SrpcPackPkg(&rsp_buff, &msg_len, &rpc_head, rsp_body);
-    if (ret != SRPC_SUCCESS) {
-        RPC_REPORT(errmsg(ret));
-        msec_log_error(errmsg(ret));
-        reset_log_option();
-        return -1; 
-    }   
-
-    resblob.data = rsp_buff;
-    resblob.len  = msg_len;
-    commu->sendto(flow, &resblob, arg2);
-
-    free(rsp_buff);
+    // 6. 回包给前端, 包体直接从python对象拷入回包
+    ret = send_response(flow, commu, arg2, &rpc_head, SRPC_SUCCESS, rsp.data, rsp.len);
+    srpc_py_release_response(&rsp);
     reset_log_option();
 
-    return 0;
+    return ret;
 
 EXIT_LABEL:
 
-    // 6. 处理失败，组包并回包
+    // 7. 处理失败，组包并回包
     reset_log_option();
 
-    ret = SrpcPackPkgNoBody(&rsp_buff, &msg_len, &rpc_head);
-    if (ret != SRPC_SUCCESS) {
-        RPC_REPORT(errmsg(ret));
-        NGLOG_ERROR("pack package failed: %s",  errmsg(ret));
-        return -1;
-    }
-
-    resblob.data = rsp_buff;
-    resblob.len  = msg_len;
-    commu->sendto(flow, &resblob, arg2);
-
-    free(rsp_buff);
-
-    return 0;  // 只要成功回包, 都返回0
+    return send_response(flow, commu, arg2, &rpc_head, ret, NULL, 0);  // 只要成功回包, 都返回0
 }
 
 
@@ -434,6 +571,9 @@ extern "C" void spp_handle_fini(void* arg1, void* arg2)
 
     if (base->servertype() == SERVER_TYPE_WORKER )
     {
+        // 攒下的请求先处理完
+        py_batch_flush();
+
         // 调用析构函数
         srpc_py_handle_fini();
 
@@ -443,6 +583,9 @@ extern "C" void spp_handle_fini(void* arg1, void* arg2)
 
 extern "C" void spp_handle_loop(void *arg)
 {
+    // 在下一次收包前决定本批是否处理, 队列里还有请求时继续攒
+    py_batch_check();
+
     srpc_py_handle_loop();
 }
 
@@ -85,6 +85,10 @@ const char *errmsg(int32_t err)
             return "php error";
         case SRPC_ERR_PYTHON_FAILED:
             return "python error";
+        case SRPC_ERR_CONCURRENCY_LIMIT:
+            return "backend concurrency limit reached";
+        case SRPC_ERR_DEADLINE_EXCEEDED:
+            return "caller deadline exceeded";
         default:
             return "unkown error";
     }
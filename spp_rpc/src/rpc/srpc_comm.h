@@ -50,6 +50,8 @@ enum SRPC_RETCODE
     SRPC_ERR_BACKEND                = -19,
     SRPC_ERR_PHP_FAILED             = -20,
     SRPC_ERR_PYTHON_FAILED          = -21,
+    SRPC_ERR_CONCURRENCY_LIMIT      = -22,
+    SRPC_ERR_DEADLINE_EXCEEDED      = -23,
 };
 
 /**
@@ -22,13 +22,18 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <sys/types.h>
 #include <sys/time.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
 #include <string>
+#include <map>
+#include <utility>
+#include <algorithm>
 #include "srpc.pb.h"
 #include "nlbapi.h"
 #include "srpc_intf.h"
@@ -44,6 +49,449 @@ using namespace NS_MICRO_THREAD;
 namespace srpc
 {
 
+// 后端并发限制参数: AIMD, 平滑时延明显超过窗口最小时延或超时就乘性减小上限
+// 上限从最大值开始，只在后端真正拥塞时收紧，默认关闭，见SetConcurrencyLimit
+#define CONCURRENCY_LIMIT_MIN       1       // 最小并发上限
+#define CONCURRENCY_LIMIT_MAX       1000    // 最大并发上限，也是初始上限
+#define CONCURRENCY_DEC_RATIO       0.9     // 每次减小的比例
+#define CONCURRENCY_DEC_INTERVAL    100     // 两次减小的最小间隔(ms)，同一次拥塞的一批超时只减一次
+#define CONCURRENCY_RTT_TOLERANCE   2       // 平滑时延超过最小时延的倍数认为后端拥塞
+#define CONCURRENCY_RTT_SLACK       5       // 额外的绝对容忍时延(ms)，避免毫秒取整的小时延误判
+#define CONCURRENCY_RTT_SMOOTH      0.125   // 平滑时延的新样本权重
+#define CONCURRENCY_RTT_WINDOW      200     // 最小时延的统计窗口(样本数)
+
+/**
+ * @brief 单个后端(业务, ip:port)的并发限制状态
+ */
+struct SDestLimit
+{
+    double   limit;             // 当前并发上限
+    int32_t  inflight;          // 在途请求数
+    int32_t  min_rtt;           // 上个窗口的最小时延(ms)，-1表示第一个窗口还没结束
+    double   srtt;              // 平滑时延(ms)，-1表示还没有样本
+    int32_t  win_min_rtt;       // 当前窗口的最小时延(ms)
+    int32_t  win_samples;       // 当前窗口样本数
+    uint64_t last_dec;          // 上次减小上限的时间(ms)
+    int32_t  rejected;          // 快速失败数，获取统计后清零
+
+    SDestLimit(): limit(CONCURRENCY_LIMIT_MAX), inflight(0), min_rtt(-1), srtt(-1),
+                  win_min_rtt(-1), win_samples(0), last_dec(0), rejected(0) {}
+};
+
+typedef std::pair<string, uint64_t> DestKey;    // endpoint, ip<<16|port
+typedef std::map<DestKey, SDestLimit> DestLimitMap;
+
+// 进程内所有后端的并发限制状态，同一进程的微线程共享
+static DestLimitMap g_dest_limits;
+
+static inline DestKey MakeDestKey(const string &endpoint, const struct sockaddr_in &addr)
+{
+    return DestKey(endpoint, ((uint64_t)addr.sin_addr.s_addr << 16) | addr.sin_port);
+}
+
+static inline uint64_t NowMs(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec*1000 + tv.tv_usec/1000;
+}
+
+/**
+ * @brief 乘性减小并发上限
+ */
+static void DecreaseLimit(SDestLimit &dest)
+{
+    uint64_t now = NowMs();
+    if (now < dest.last_dec + CONCURRENCY_DEC_INTERVAL)
+    {
+        return;
+    }
+
+    dest.limit    = max(dest.limit * CONCURRENCY_DEC_RATIO, (double)CONCURRENCY_LIMIT_MIN);
+    dest.last_dec = now;
+}
+
+/**
+ * @brief 用一次回包结果调整并发上限
+ */
+static void UpdateLimit(SDestLimit &dest, int32_t failed, int32_t cost)
+{
+    if (failed)
+    {
+        DecreaseLimit(dest);
+        return;
+    }
+
+    // 窗口最小时延作为后端无负载时延，窗口结束时更新，允许基线随后端变化
+    if (dest.win_min_rtt < 0 || cost < dest.win_min_rtt)
+    {
+        dest.win_min_rtt = cost;
+    }
+
+    if (++dest.win_samples >= CONCURRENCY_RTT_WINDOW)
+    {
+        dest.min_rtt     = dest.win_min_rtt;
+        dest.win_min_rtt = -1;
+        dest.win_samples = 0;
+    }
+
+    // 用平滑时延判断，单个慢请求不会触发减小
+    if (dest.srtt < 0)
+    {
+        dest.srtt = cost;
+    }
+    else
+    {
+        dest.srtt += (cost - dest.srtt) * CONCURRENCY_RTT_SMOOTH;
+    }
+
+    // 第一个窗口结束前没有可靠的基线，只靠超时收紧
+    if ((dest.min_rtt >= 0)
+        && (dest.srtt > dest.min_rtt * CONCURRENCY_RTT_TOLERANCE + CONCURRENCY_RTT_SLACK))
+    {
+        DecreaseLimit(dest);
+        return;
+    }
+
+    // 只有并发用到一半以上才加性增大，避免空闲时上限无限增长
+    if ((dest.inflight + 1) * 2 >= (int32_t)dest.limit)
+    {
+        dest.limit = min(dest.limit + 1.0/dest.limit, (double)CONCURRENCY_LIMIT_MAX);
+    }
+}
+
+/**
+ * @brief 获取后端并发限制汇总状态，rejected获取后清零
+ */
+void GetConcurrencyStat(SConcurrencyStat &stat)
+{
+    memset(&stat, 0, sizeof(stat));
+
+    DestLimitMap::iterator it;
+    for (it = g_dest_limits.begin(); it != g_dest_limits.end(); ++it)
+    {
+        SDestLimit &dest = it->second;
+        int32_t limit    = (int32_t)dest.limit;
+
+        if (stat.dest_num == 0 || limit < stat.min_limit)
+        {
+            stat.min_limit = limit;
+        }
+
+        if (limit < CONCURRENCY_LIMIT_MAX)
+        {
+            stat.throttled++;
+        }
+
+        stat.dest_num++;
+        stat.inflight += dest.inflight;
+        stat.rejected += dest.rejected;
+        dest.rejected  = 0;
+    }
+}
+
+// 获取上游调用方剩余超时的函数，服务端框架设置
+static RemainTimeFunc g_remain_time_func = NULL;
+
+/**
+ * @brief 设置获取上游调用方剩余超时的函数
+ */
+void SetRemainTimeFunc(RemainTimeFunc func)
+{
+    g_remain_time_func = func;
+}
+
+/**
+ * @brief 超时不超过上游调用方的剩余时间
+ * @return false 上游调用方已经超时，不再往下调用
+ */
+static bool CapTimeout(int32_t &timeout)
+{
+    int32_t remain;
+
+    if (NULL == g_remain_time_func)
+    {
+        return true;
+    }
+
+    remain = g_remain_time_func();
+    if (remain == 0)
+    {
+        return false;
+    }
+
+    if ((remain > 0) && (remain < timeout))
+    {
+        timeout = remain;
+    }
+
+    return true;
+}
+
+// 对冲请求参数: 超过方法近期p95时延还没有回包，向另一个路由再发一份
+#define HEDGE_SAMPLE_NUM            128     // 计算p95的时延样本环大小
+#define HEDGE_MIN_SAMPLES           32      // 样本不足时不对冲
+#define HEDGE_CALC_INTERVAL         16      // 每多少个样本重新计算一次p95
+#define HEDGE_ROUTE_RETRY           3       // 获取与首发不同路由的尝试次数
+
+/**
+ * @brief 单个方法(endpoint/method)的近期时延
+ */
+struct SMethodLatency
+{
+    int32_t  samples[HEDGE_SAMPLE_NUM];     // 成功请求的时延环(ms)
+    uint32_t count;                         // 累计样本数
+    int32_t  p95;                           // 近期p95时延，-1表示样本不足
+
+    SMethodLatency(): count(0), p95(-1) {}
+};
+
+typedef std::map<string, SMethodLatency> MethodLatencyMap;
+
+// 开启对冲的方法的时延统计
+static MethodLatencyMap g_method_latency;
+
+/**
+ * @brief 记录一次成功请求的时延，定期重算p95
+ */
+static void AddLatencySample(const string &key, int32_t cost)
+{
+    SMethodLatency &lat = g_method_latency[key];
+
+    lat.samples[lat.count % HEDGE_SAMPLE_NUM] = cost;
+    lat.count++;
+    if ((lat.count < HEDGE_MIN_SAMPLES) || (lat.count % HEDGE_CALC_INTERVAL))
+    {
+        return;
+    }
+
+    int32_t  sorted[HEDGE_SAMPLE_NUM];
+    uint32_t num = min(lat.count, (uint32_t)HEDGE_SAMPLE_NUM);
+    uint32_t idx = num * 95 / 100;
+
+    memcpy(sorted, lat.samples, num * sizeof(int32_t));
+    std::nth_element(sorted, sorted + idx, sorted + num);
+    lat.p95 = sorted[idx];
+}
+
+/**
+ * @brief 对冲请求的共享上下文
+ * @info  调用方拿到结果就返回，落后的请求在子微线程里继续收完，最后一个引用者释放
+ */
+struct SHedgeCtx
+{
+    int32_t     refs;           // 引用计数: 调用方 + 未结束的子微线程
+    int32_t     pending;        // 未结束的请求数
+    int32_t     notify[2];      // 结果通知管道，唤醒等待的调用方
+    bool        done;           // 已经有结果
+    int32_t     ret;            // 结果
+    char       *rsp;            // 回包，调用方取走后置空
+    int32_t     rsp_len;        // 回包长度
+    char       *req;            // 请求报文副本
+    int32_t     req_len;        // 请求报文长度
+    string      key;            // 时延统计key
+    CheckPkgLenFunc check_cb;   // 检查报文完整性函数
+    CProxyBase  proxy;          // 路由统计与并发配额
+};
+
+/**
+ * @brief 对冲请求的单个子微线程任务
+ */
+struct SHedgeTask
+{
+    SHedgeCtx          *ctx;
+    struct sockaddr_in  dst;
+    int32_t             type;
+    int32_t             timeout;
+    char               *req;        // 本任务的请求报文，NULL时用ctx->req
+    int32_t             req_len;
+};
+
+/**
+ * @brief 向指定路由收发一次报文，并更新路由统计
+ * @info  调用前需要AcquireRoute占用并发配额，返回前会释放
+ */
+static int32_t SendRecvRoute(CProxyBase &proxy, struct sockaddr_in &dst, int32_t type,
+                             const char *request, int32_t req_len, char* &response, int32_t &rsp_len,
+                             int32_t timeout, CheckPkgLenFunc check_cb, int32_t &cost)
+{
+    int32_t ret;
+    struct timeval begin, end;
+
+    // 1. 网络收发包
+    char *rsp = NULL;
+    gettimeofday(&begin, NULL);
+    if (type == PORT_TYPE_UDP)
+    {
+        rsp = (char *)malloc(64*1024);
+        if (NULL == rsp)
+        {
+            proxy.ReleaseRoute(dst);
+            return SRPC_ERR_NO_MEMORY;
+        }
+
+        rsp_len = 64*1024;
+        ret = mt_udpsendrcv(&dst, (void *)request, req_len, rsp, rsp_len, timeout);
+    }
+    else
+    {
+        ret = mt_tcpsendrcv_v2(&dst, (void *)request, req_len, (void **)&rsp, rsp_len, timeout, check_cb);
+    }
+
+    // 2. 回包统计
+    if (ret)
+    {
+        if (rsp)
+            free(rsp);
+
+        // 超时更新路由状态
+        if (ret == -3 && errno == ETIME)
+        {
+            proxy.UpdateRoute(dst, 1, 0);
+            return SRPC_ERR_RECV_TIMEOUT;
+        }
+        proxy.ReleaseRoute(dst);
+        return SRPC_ERR_SEND_RECV_FAILED;
+    }
+
+    gettimeofday(&end, NULL);
+    cost = (int32_t)((end.tv_sec*1000 + end.tv_usec/1000) - (begin.tv_sec*1000 + begin.tv_usec/1000));
+    proxy.UpdateRoute(dst, 0, cost);
+    response = rsp;
+
+    return SRPC_SUCCESS;
+}
+
+static SHedgeCtx *CreateHedgeCtx(const CProxyBase &proxy, const char *request, int32_t req_len)
+{
+    SHedgeCtx *ctx = new SHedgeCtx;
+
+    ctx->req = (char *)malloc(req_len);
+    if (NULL == ctx->req)
+    {
+        delete ctx;
+        return NULL;
+    }
+
+    if (pipe(ctx->notify) < 0)
+    {
+        free(ctx->req);
+        delete ctx;
+        return NULL;
+    }
+    fcntl(ctx->notify[1], F_SETFL, fcntl(ctx->notify[1], F_GETFL) | O_NONBLOCK);
+
+    memcpy(ctx->req, request, req_len);
+    ctx->req_len  = req_len;
+    ctx->refs     = 1;
+    ctx->pending  = 0;
+    ctx->done     = false;
+    ctx->ret      = SRPC_ERR_RECV_TIMEOUT;
+    ctx->rsp      = NULL;
+    ctx->rsp_len  = 0;
+    ctx->check_cb = NULL;
+    ctx->proxy    = proxy;
+
+    return ctx;
+}
+
+static void ReleaseHedgeCtx(SHedgeCtx *ctx)
+{
+    if (--ctx->refs > 0)
+    {
+        return;
+    }
+
+    close(ctx->notify[0]);
+    close(ctx->notify[1]);
+    if (ctx->rsp)
+        free(ctx->rsp);
+    free(ctx->req);
+    delete ctx;
+}
+
+/**
+ * @brief 对冲请求子微线程入口
+ */
+static void HedgeTaskEntry(void *arg)
+{
+    SHedgeTask *task    = (SHedgeTask *)arg;
+    SHedgeCtx  *ctx     = task->ctx;
+    char       *rsp     = NULL;
+    int32_t     rsp_len = 0;
+    int32_t     cost    = 0;
+    int32_t     ret;
+
+    if (task->req)
+    {
+        ret = SendRecvRoute(ctx->proxy, task->dst, task->type, task->req, task->req_len,
+                            rsp, rsp_len, task->timeout, ctx->check_cb, cost);
+        free(task->req);
+    }
+    else
+    {
+        ret = SendRecvRoute(ctx->proxy, task->dst, task->type, ctx->req, ctx->req_len,
+                            rsp, rsp_len, task->timeout, ctx->check_cb, cost);
+    }
+    if (ret == SRPC_SUCCESS)
+    {
+        AddLatencySample(ctx->key, cost);
+    }
+
+    // 先到的成功回包作为结果; 全部失败时以最后一个失败为结果
+    ctx->pending--;
+    if (!ctx->done && ((ret == SRPC_SUCCESS) || (ctx->pending == 0)))
+    {
+        ctx->done    = true;
+        ctx->ret     = ret;
+        ctx->rsp     = rsp;
+        ctx->rsp_len = rsp_len;
+        rsp          = NULL;
+
+        ssize_t n = write(ctx->notify[1], "1", 1);
+        (void)n;
+    }
+
+    if (rsp)
+        free(rsp);
+
+    delete task;
+    ReleaseHedgeCtx(ctx);
+}
+
+/**
+ * @brief 启动子微线程向指定路由发送请求
+ * @info  req为本任务单独的请求报文(malloc申请，由任务释放)，NULL时发送ctx->req
+ *        失败时释放dst的并发配额和req
+ */
+static bool StartHedgeTask(SHedgeCtx *ctx, struct sockaddr_in &dst, int32_t type, int32_t timeout,
+                           char *req = NULL, int32_t req_len = 0)
+{
+    SHedgeTask *task = new SHedgeTask;
+
+    task->ctx     = ctx;
+    task->dst     = dst;
+    task->type    = type;
+    task->timeout = timeout;
+    task->req     = req;
+    task->req_len = req_len;
+
+    ctx->refs++;
+    ctx->pending++;
+    if (NULL == mt_start_thread((void *)HedgeTaskEntry, task))
+    {
+        ctx->refs--;
+        ctx->pending--;
+        if (req)
+            free(req);
+        delete task;
+        ctx->proxy.ReleaseRoute(dst);
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * @brief 构造与析构函数
  */
@@ -52,6 +500,7 @@ CProxyBase::CProxyBase(const string &endpoint)
     m_type      = ENDPOINT_TYPE_UNKOWN;
     m_endpoint  = endpoint;
     m_port_type = PORT_TYPE_ALL;
+    m_concurrency_limit = false;
     ParseEndpoint(endpoint);
 
     return;
@@ -174,6 +623,14 @@ int32_t CProxyBase::GetRoute(struct sockaddr_in &addr, int32_t &type)
     return 0;
 }
 
+/**
+ * @brief 设置是否限制后端并发
+ */
+void CProxyBase::SetConcurrencyLimit(bool limit)
+{
+    m_concurrency_limit = limit;
+}
+
 /**
  * @brief 更新路由信息(回包统计)
  */
@@ -183,6 +640,61 @@ void CProxyBase::UpdateRoute(struct sockaddr_in &addr, int32_t failed, int32_t c
     {
         updateroute(m_service_name.c_str(), addr.sin_addr.s_addr, failed, cost);
     }
+
+    if (!m_concurrency_limit)
+    {
+        return;
+    }
+
+    DestLimitMap::iterator it = g_dest_limits.find(MakeDestKey(m_endpoint, addr));
+    if (it != g_dest_limits.end())
+    {
+        UpdateLimit(it->second, failed, cost);
+        if (it->second.inflight > 0)
+        {
+            it->second.inflight--;
+        }
+    }
+}
+
+/**
+ * @brief 占用后端的一个并发配额
+ * @info  超过上限直接失败，不再给已经拥塞的后端增加请求
+ */
+bool CProxyBase::AcquireRoute(struct sockaddr_in &addr)
+{
+    if (!m_concurrency_limit)
+    {
+        return true;
+    }
+
+    SDestLimit &dest = g_dest_limits[MakeDestKey(m_endpoint, addr)];
+
+    if (dest.inflight >= (int32_t)dest.limit)
+    {
+        dest.rejected++;
+        return false;
+    }
+
+    dest.inflight++;
+    return true;
+}
+
+/**
+ * @brief 释放并发配额，不计入时延统计
+ */
+void CProxyBase::ReleaseRoute(struct sockaddr_in &addr)
+{
+    if (!m_concurrency_limit)
+    {
+        return;
+    }
+
+    DestLimitMap::iterator it = g_dest_limits.find(MakeDestKey(m_endpoint, addr));
+    if ((it != g_dest_limits.end()) && (it->second.inflight > 0))
+    {
+        it->second.inflight--;
+    }
 }
 
 // 解析endpoint地址信息
@@ -236,6 +748,9 @@ CSrpcProxy::CSrpcProxy(const string &endpoint):CProxyBase(endpoint)
     m_check_cb = SrpcCheckPkgLen;
     m_coloring = false;
     m_sequence = 0;
+    m_hedge    = false;
+    m_timeout  = 0;
+    m_request  = NULL;
 }
 
 CSrpcProxy::~CSrpcProxy()
@@ -258,6 +773,14 @@ void CSrpcProxy::SetColoring(bool coloring)
     m_coloring = coloring;
 }
 
+/**
+ * @brief 设置是否对冲请求
+ */
+void CSrpcProxy::SetHedge(bool hedge)
+{
+    m_hedge = hedge;
+}
+
 /**
  * @brief 获取调用结果
  */
@@ -313,6 +836,10 @@ int32_t CSrpcProxy::Serialize(char* &pkg, int32_t &len, uint64_t &sequence, cons
     req_head.set_flow_id(color_id ^ m_sequence);
     req_head.set_caller(this->GetCaller());
     req_head.set_method_name(m_method_name);
+    if (m_timeout > 0)
+    {
+        req_head.set_timeout(m_timeout);
+    }
 
     return SrpcPackPkg(&pkg, &len, &req_head, &request);
 }
@@ -415,9 +942,25 @@ int32_t CSrpcProxy::CallMethod(const char *request, int32_t req_len, char* &resp
     int32_t ret;
     int32_t type;
     int32_t cost;
-    struct timeval begin, end;
+    int32_t delay;
     struct sockaddr_in dst;
 
+    // 超时不超过上游调用方的剩余时间
+    if (!CapTimeout(timeout))
+    {
+        return SRPC_ERR_DEADLINE_EXCEEDED;
+    }
+
+    // 有近期时延样本时走对冲方式
+    if (m_hedge)
+    {
+        delay = GetHedgeDelay();
+        if ((delay > 0) && (delay < timeout))
+        {
+            return HedgeCallMethod(request, req_len, response, rsp_len, timeout, delay);
+        }
+    }
+
     // 1. 获取目标地址
     ret = GetRoute(dst, type);
     if (ret < 0)
@@ -425,46 +968,146 @@ int32_t CSrpcProxy::CallMethod(const char *request, int32_t req_len, char* &resp
         return SRPC_ERR_GET_ROUTE_FAILED;
     }
 
-    // 2. 网络收发包
-    char *rsp = NULL;
-    gettimeofday(&begin, NULL);
-    if (type == PORT_TYPE_UDP)
+    // 后端在途请求超过并发上限，快速失败
+    if (!AcquireRoute(dst))
     {
-        rsp = (char *)malloc(64*1024);
-        if (NULL == rsp)
-        {
-            return SRPC_ERR_NO_MEMORY;
-        }
+        return SRPC_ERR_CONCURRENCY_LIMIT;
+    }
 
-        rsp_len = 64*1024;
-        ret = mt_udpsendrcv(&dst, (void *)request, req_len, rsp, rsp_len, timeout);
+    // 2. 网络收发包，回包统计
+    ret = SendRecvRoute(*this, dst, type, request, req_len, response, rsp_len, timeout, m_check_cb, cost);
+    if (m_hedge && (ret == SRPC_SUCCESS))
+    {
+        AddLatencySample(GetEndPoint() + "/" + m_method_name, cost);
     }
-    else
+
+    return ret;
+}
+
+/**
+ * @brief 获取对冲请求的延迟(该方法近期p95时延)
+ */
+int32_t CSrpcProxy::GetHedgeDelay(void)
+{
+    MethodLatencyMap::iterator it = g_method_latency.find(GetEndPoint() + "/" + m_method_name);
+    if ((it == g_method_latency.end()) || (it->second.p95 < 0))
     {
-        ret = mt_tcpsendrcv_v2(&dst, (void *)request, req_len, (void **)&rsp, rsp_len, timeout, m_check_cb);
+        return -1;
     }
 
-    // 3. 回包统计
-    if (ret)
+    return max(it->second.p95, 1);
+}
+
+/**
+ * @brief 对冲方式调用
+ * @info  首发请求和对冲请求都在子微线程中收发，调用方等待先到的成功回包
+ */
+int32_t CSrpcProxy::HedgeCallMethod(const char *request, int32_t req_len, char* &response, int32_t &rsp_len, int32_t timeout, int32_t delay)
+{
+    int32_t ret;
+    int32_t type, hedge_type;
+    int32_t remain;
+    int32_t i;
+    uint64_t begin;
+    struct sockaddr_in dst, hedge_dst;
+
+    // 1. 首发请求
+    ret = GetRoute(dst, type);
+    if (ret < 0)
     {
-        if (rsp)
-            free(rsp);
+        return SRPC_ERR_GET_ROUTE_FAILED;
+    }
 
-        // 超时更新路由状态
-        if (ret == -3 && errno == ETIME)
+    if (!AcquireRoute(dst))
+    {
+        return SRPC_ERR_CONCURRENCY_LIMIT;
+    }
+
+    SHedgeCtx *ctx = CreateHedgeCtx(*this, request, req_len);
+    if (NULL == ctx)
+    {
+        ReleaseRoute(dst);
+        return SRPC_ERR_NO_MEMORY;
+    }
+    ctx->key      = GetEndPoint() + "/" + m_method_name;
+    ctx->check_cb = m_check_cb;
+
+    begin = NowMs();
+    if (!StartHedgeTask(ctx, dst, type, timeout))
+    {
+        ReleaseHedgeCtx(ctx);
+        return SRPC_ERR_SEND_RECV_FAILED;
+    }
+
+    // 2. 超过p95时延还没有结果，向另一个路由再发一份
+    mt_wait_events(ctx->notify[0], EPOLLIN, delay);
+    if (!ctx->done)
+    {
+        for (i = 0; i < HEDGE_ROUTE_RETRY; i++)
         {
-            UpdateRoute(dst, 1, 0);
-            return SRPC_ERR_RECV_TIMEOUT;
+            if (GetRoute(hedge_dst, hedge_type) < 0)
+            {
+                i = HEDGE_ROUTE_RETRY;
+                break;
+            }
+
+            if ((hedge_dst.sin_addr.s_addr != dst.sin_addr.s_addr) || (hedge_dst.sin_port != dst.sin_port))
+            {
+                break;
+            }
+        }
+
+        remain = timeout - (int32_t)(NowMs() - begin);
+        if ((i < HEDGE_ROUTE_RETRY) && (remain > 0) && AcquireRoute(hedge_dst))
+        {
+            // SRPC请求按剩余时间重新打包，被调方看到的超时不超过调用方还在等的时间
+            char   *hedge_req = NULL;
+            int32_t hedge_len = 0;
+            if (m_request)
+            {
+                uint64_t seq   = m_sequence;
+                int32_t  saved = m_timeout;
+
+                m_timeout = remain;
+                if (Serialize(hedge_req, hedge_len, seq, *m_request) != SRPC_SUCCESS)
+                {
+                    hedge_req = NULL;
+                }
+                m_timeout = saved;
+            }
+
+            if (!m_request || hedge_req)
+            {
+                StartHedgeTask(ctx, hedge_dst, hedge_type, remain, hedge_req, hedge_len);
+            }
+            else
+            {
+                ReleaseRoute(hedge_dst);
+            }
         }
-        return SRPC_ERR_SEND_RECV_FAILED;
     }
 
-    gettimeofday(&end, NULL);
-    cost = (int32_t)((end.tv_sec*1000 + end.tv_usec/1000) - (begin.tv_sec*1000 + begin.tv_usec/1000));
-    UpdateRoute(dst, 0, cost);
-    response = rsp;
+    // 3. 等待先到的结果
+    while (!ctx->done)
+    {
+        remain = timeout - (int32_t)(NowMs() - begin);
+        if (remain <= 0)
+        {
+            break;
+        }
+        mt_wait_events(ctx->notify[0], EPOLLIN, remain);
+    }
 
-    return SRPC_SUCCESS;
+    ret = ctx->ret;
+    if (ctx->done && (ret == SRPC_SUCCESS))
+    {
+        response = ctx->rsp;
+        rsp_len  = ctx->rsp_len;
+        ctx->rsp = NULL;
+    }
+
+    ReleaseHedgeCtx(ctx);
+    return ret;
 }
 
 
@@ -486,13 +1129,22 @@ int32_t CSrpcProxy::CallMethod(const Message &request, Message &response, int32_
     char *  req_pkg = NULL;
     char *  rsp_pkg = NULL;
 
+    // 超时不超过上游调用方的剩余时间，打包时带给被调方
+    if (!CapTimeout(timeout))
+    {
+        return SRPC_ERR_DEADLINE_EXCEEDED;
+    }
+
+    m_timeout = timeout;
     ret = Serialize(req_pkg, req_len, oseq, request);
     if (ret != SRPC_SUCCESS)
     {
         return ret;
     }
 
+    m_request = &request;
     ret = this->CallMethod(req_pkg, req_len, rsp_pkg, rsp_len, timeout);
+    m_request = NULL;
     if (ret != SRPC_SUCCESS)
     {
         goto EXIT;
@@ -54,7 +54,7 @@ class CProxyBase
 {
 public:
     CProxyBase(const string &endpoint); // "Login.ptlogin"  or "127.0.0.1:8888@udp"
-    CProxyBase() {}
+    CProxyBase(): m_concurrency_limit(false) {}
     virtual ~CProxyBase();
 
     void SetEndPoint(const string &endpoint);
@@ -81,6 +81,12 @@ public:
      */
     int GetProtoType(void);
 
+    /**
+     * @brief 设置是否限制后端并发，默认不限制
+     * @info  开启后每个后端(ip:port)按回包时延自适应调整并发上限，超过上限的请求直接失败
+     */
+    void SetConcurrencyLimit(bool limit);
+
     /**
      * @brief 获取路由
      */
@@ -88,9 +94,21 @@ public:
 
     /**
      * @brief 更新路由信息(回包统计)
+     * @info  开启并发限制时，同时释放AcquireRoute占用的并发配额，并用时延调整并发上限
      */
     void UpdateRoute(struct sockaddr_in &addr, int32_t failed, int32_t cost);
 
+    /**
+     * @brief 占用后端的一个并发配额
+     * @return true 成功或未开启并发限制; false 超过后端当前并发上限，应直接失败
+     */
+    bool AcquireRoute(struct sockaddr_in &addr);
+
+    /**
+     * @brief 释放并发配额，不计入时延统计(网络错误等)
+     */
+    void ReleaseRoute(struct sockaddr_in &addr);
+
 private:
     /**
      * @brief 解析endpoint地址信息
@@ -105,8 +123,38 @@ private:
     string  m_caller;               // 本地业务名
     string  m_service_name;         // NLB方式业务名
     struct sockaddr_in m_address;   // ADDR方式地址
+    bool    m_concurrency_limit;    // 是否限制后端并发
 };
 
+/**
+ * @brief 后端并发限制汇总状态
+ */
+struct SConcurrencyStat
+{
+    int32_t dest_num;       // 后端(业务, ip:port)个数
+    int32_t throttled;      // 并发上限已经收紧(低于最大值)的后端个数
+    int32_t min_limit;      // 所有后端中最小的并发上限
+    int32_t inflight;       // 在途请求总数
+    int32_t rejected;       // 上次获取以来快速失败的请求数
+};
+
+/**
+ * @brief 获取后端并发限制汇总状态，rejected获取后清零
+ * @info  框架定期调用，写入统计文件
+ */
+void GetConcurrencyStat(SConcurrencyStat &stat);
+
+/**
+ * @brief 获取上游调用方剩余超时(毫秒)的函数，<0表示没有限制，0表示已经超时
+ */
+typedef int32_t (*RemainTimeFunc)(void);
+
+/**
+ * @brief 设置获取上游调用方剩余超时的函数
+ * @info  服务端框架启动时设置，CSrpcProxy调用的超时不超过上游剩余时间
+ */
+void SetRemainTimeFunc(RemainTimeFunc func);
+
 /**
  * @brief 检测报文是否接收完整的回调函数定义
  * @param buf 报文保存缓冲区
@@ -122,7 +170,7 @@ class CSrpcProxy: public CProxyBase
 {
 public:
     CSrpcProxy(const string &endpoint);
-    CSrpcProxy() {}
+    CSrpcProxy(): m_hedge(false), m_timeout(0), m_request(NULL) {}
     ~CSrpcProxy();
 
     /**
@@ -135,6 +183,13 @@ public:
      */
     void SetColoring(bool coloring);
 
+    /**
+     * @brief 设置是否对冲请求
+     * @info  开启后，超过该方法近期p95时延还没有回包，向另一个NLB路由再发一份，取先到的回包
+     *        只对能取到不同路由的NLB后端生效
+     */
+    void SetHedge(bool hedge);
+
     /**
      * @brief 获取调用结果
      */
@@ -246,6 +301,18 @@ public:
      */
     int32_t CallMethod(const Message &request, Message &response, int32_t timeout);
 
+private:
+    /**
+     * @brief 获取对冲请求的延迟(该方法近期p95时延)
+     * @return >0 延迟毫秒数; <0 样本不足，不对冲
+     */
+    int32_t GetHedgeDelay(void);
+
+    /**
+     * @brief 对冲方式调用，首发请求delay毫秒后还没有结果，向另一个路由再发一份
+     */
+    int32_t HedgeCallMethod(const char *request, int32_t req_len, char* &response, int32_t &rsp_len, int32_t timeout, int32_t delay);
+
 private:
 
     string   m_method_name;     // SRPC方法名
@@ -255,6 +322,9 @@ private:
     uint64_t reserved;          // 回复报文sequence存放
     char     m_errtext[128];    // 错误描述信息
     CheckPkgLenFunc m_check_cb; // 第三方协议检查报文函数
+    bool     m_hedge;           // 是否对冲请求
+    int32_t  m_timeout;         // 本次调用超时，打包时带给被调方
+    const Message *m_request;   // 本次调用的SRPC请求，对冲副本按剩余时间重新打包
 };
 
 
@@ -104,6 +104,7 @@ void CRpcNetAdpt::InitReqHead()
     m_req_head.set_color_id(gen_colorid(m_method_name.c_str()));
     m_req_head.set_method_name(m_method_name);
     m_req_head.set_caller(SrpcServiceName());
+    m_req_head.set_timeout(m_timeout > 0 ? m_timeout : 0);  // 被调方据此丢弃本端已放弃的请求
     //*(m_req_head.add_caller_stack()) = m_service_name;
     if (!m_req_head.has_flow_id() || !m_req_head.flow_id()) { // 如果客户端没有设置flow id，就默认使用当前的seq作为flow id
         m_req_head.set_flow_id(m_seq);
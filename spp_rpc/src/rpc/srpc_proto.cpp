@@ -121,18 +121,34 @@ int32_t SrpcPackPkg(char** pkg, int32_t *len, const CRpcHead *head, const Messag
  * @       !=SRPC_SUCCESS   打包失败
  */
 int32_t SrpcPackPkg(char** pkg, int32_t *len, const CRpcHead *head, const string& body)
+{
+    return SrpcPackPkg(pkg, len, head, body.data(), (int32_t)body.size());
+}
+
+/**
+ * @brief  SRPC报文打包函数
+ * @info   [注意] 打包后的报文为出参，函数内部分配内存，调用者需要free
+ *         [注意] 包体为二进制, 直接从调用者的内存拷入报文
+ * @param  pkg      [出参]打包完后报文的buffer
+ *         len      [出参]打包完后，报文的长度
+ *         head     [入参]报文头,PB格式
+ *         body     [入参]报文体,二进制
+ *         body_len [入参]报文体长度
+ * @return =SRPC_SUCCESS    打包成功
+ * @       !=SRPC_SUCCESS   打包失败
+ */
+int32_t SrpcPackPkg(char** pkg, int32_t *len, const CRpcHead *head, const char *body, int32_t body_len)
 {
     char *buf;
 
     // 参数检查
-    if (NULL == head || NULL == pkg || NULL == len)
+    if (NULL == head || NULL == pkg || NULL == len || body_len < 0 || (body_len && NULL == body))
     {
         return SRPC_ERR_PARA_ERROR;
     }
 
     // 初始化报文长度
     int32_t head_len = head->ByteSize();
-    int32_t body_len = body.size();
     int32_t msg_len  = PROTO_HEAD_MIN_LEN + head_len + body_len;
 
     // 检查包头是否初始化
@@ -168,7 +184,7 @@ int32_t SrpcPackPkg(char** pkg, int32_t *len, const CRpcHead *head, const string
     // 序列化包体
     if (body_len)
     {
-        memcpy(pos, body.data(), body_len);
+        memcpy(pos, body, body_len);
     }
     pos += body_len;
     *pos = PROTO_RPC_ETX;
@@ -254,7 +270,34 @@ int32_t SrpcPackPkgNoBody(char** pkg, int32_t *len, const CRpcHead *head)
  */
 int32_t SrpcGetPkgBodyString(const char *buff, int32_t len, string &body)
 {
-    if (NULL == buff || len <= 0)
+    const char *body_ptr = NULL;
+    int32_t body_len = 0;
+
+    int32_t ret = SrpcGetPkgBody(buff, len, &body_ptr, &body_len);
+    if (ret != SRPC_SUCCESS)
+    {
+        return ret;
+    }
+
+    body.assign(body_ptr, body_len);
+
+    return SRPC_SUCCESS;
+}
+
+/**
+ * @brief  SRPC报文解包函数
+ * @info   [注意] 必须为完整的一个包才能调用
+ *         [注意] 不拷贝包体, body指向buff内部, 与buff的生命期相同
+ * @param  buff     报文buffer
+ *         len      报文长度
+ *         body     [出参]包体起始地址
+ *         body_len [出参]包体长度
+ * @return !=SRPC_SUCCESS   解包失败
+ * @       =SRPC_SUCCESS    解包成功
+ */
+int32_t SrpcGetPkgBody(const char *buff, int32_t len, const char **body, int32_t *body_len)
+{
+    if (NULL == buff || len <= 0 || NULL == body || NULL == body_len)
     {
         return SRPC_ERR_PARA_ERROR;
     }
@@ -268,16 +311,17 @@ int32_t SrpcGetPkgBodyString(const char *buff, int32_t len, string &body)
     }
 
     int32_t head_len = htonl(*(int *)(buff + PROTO_HEAD_LEN_OFFSET));
-    int32_t body_len = htonl(*(int *)(buff + PROTO_BODY_LEN_OFFSET));
-    int32_t msg_len  = head_len + body_len + PROTO_HEAD_MIN_LEN;
+    int32_t blen     = htonl(*(int *)(buff + PROTO_BODY_LEN_OFFSET));
+    int32_t msg_len  = head_len + blen + PROTO_HEAD_MIN_LEN;
 
     // 报文合法性检查
-    if (body_len < 0 || head_len <= 0 || msg_len != len)
+    if (blen < 0 || head_len <= 0 || msg_len != len)
     {
         return SRPC_ERR_INVALID_PKG;
     }
 
-    body.assign(buff + PROTO_HEAD_OFFSET + head_len, body_len);
+    *body     = buff + PROTO_HEAD_OFFSET + head_len;
+    *body_len = blen;
 
     return SRPC_SUCCESS;
 }
@@ -82,6 +82,20 @@ int32_t SrpcPackPkgNoBody(char** pkg, int32_t *len, const CRpcHead *head);
  */
 int32_t SrpcPackPkg(char** pkg, int32_t *len, const CRpcHead *head, const string& body);
 
+/**
+ * @brief  SRPC报文打包函数
+ * @info   [注意] 打包后的报文为出参，函数内部分配内存，调用者需要free
+ *         [注意] 包体为二进制, 直接从调用者的内存拷入报文
+ * @param  pkg      [出参]打包完后报文的buffer
+ *         len      [出参]打包完后，报文的长度
+ *         head     [入参]报文头,PB格式
+ *         body     [入参]报文体,二进制
+ *         body_len [入参]报文体长度
+ * @return =SRPC_SUCCESS    打包成功
+ * @       !=SRPC_SUCCESS   打包失败
+ */
+int32_t SrpcPackPkg(char** pkg, int32_t *len, const CRpcHead *head, const char *body, int32_t body_len);
+
 
 /**
  * @brief  SRPC报文解包函数
@@ -95,6 +109,19 @@ int32_t SrpcPackPkg(char** pkg, int32_t *len, const CRpcHead *head, const string
  */
 int32_t SrpcGetPkgBodyString(const char *buff, int32_t len, string &body);
 
+/**
+ * @brief  SRPC报文解包函数
+ * @info   [注意] 必须为完整的一个包才能调用
+ *         [注意] 不拷贝包体, body指向buff内部, 与buff的生命期相同
+ * @param  buff     报文buffer
+ *         len      报文长度
+ *         body     [出参]包体起始地址
+ *         body_len [出参]包体长度
+ * @return !=SRPC_SUCCESS   解包失败
+ * @       =SRPC_SUCCESS    解包成功
+ */
+int32_t SrpcGetPkgBody(const char *buff, int32_t len, const char **body, int32_t *body_len);
+
 /**
  * @brief  SRPC报文解包函数
  * @info   [注意] 必须为完整的一个包才能调用
@@ -21,6 +21,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <stdint.h>
+#include <sys/time.h>
 #include <string>
 #include <google/protobuf/service.h>
 #include <google/protobuf/descriptor.h>
@@ -71,19 +72,35 @@ int32_t CallMethod(const std::string &service_name,
                    int32_t proto)
 {
     int32_t  ret;
+    int32_t  remain;
     CRpcHead head;
     std::string attr;
 
+    // 上报
+    attr = "call [" + service_name + ":" + method_name + "]";
+    RPC_REPORT(attr.c_str());
+
     // 获取当前的上下文环境
     CSyncMsg *msg = CSyncFrame::Instance()->GetCurrentMsg();
     if (msg)
     {
         head = ((CRpcMsgBase *)msg)->GetRpcHead();
-    }
 
-    // 上报
-    attr = "call [" + service_name + ":" + method_name + "]";
-    RPC_REPORT(attr.c_str());
+        // 超时不超过上游调用方的剩余时间，调用方已经放弃的请求不再往下调用
+        remain = ((CRpcMsgBase *)msg)->GetRemainTime();
+        if (remain == 0)
+        {
+            attr = attr + " fail:" + errmsg(SRPC_ERR_DEADLINE_EXCEEDED);
+            RPC_REPORT(attr.c_str());
+            NGLOG_ERROR("caller deadline exceeded, skip call");
+            return SRPC_ERR_DEADLINE_EXCEEDED;
+        }
+
+        if ((remain > 0) && (remain < timeout))
+        {
+            timeout = remain;
+        }
+    }
 
     // RPC网络收发
     CRpcNetAdpt handler(service_name, method_name, head, (Message *)&request, (Message *)&response, timeout, proto);
@@ -104,6 +121,20 @@ int32_t CallMethod(const std::string &service_name,
     return ret;
 }
 
+/**
+ * @brief  获取当前处理中请求的调用方剩余超时(毫秒)
+ */
+int32_t GetCallerRemainTime(void)
+{
+    CSyncMsg *msg = CSyncFrame::Instance()->GetCurrentMsg();
+    if (NULL == msg)
+    {
+        return -1;
+    }
+
+    return ((CRpcMsgBase *)msg)->GetRemainTime();
+}
+
 // msg基类构造函数
 CRpcMsgBase::CRpcMsgBase()
 {
@@ -139,6 +170,36 @@ int CRpcMsgBase::GetProtoType(void)
     return m_proto_type;
 }
 
+// 获取调用方剩余超时(毫秒), 从proxy收到请求开始计算
+int32_t CRpcMsgBase::GetRemainTime(void)
+{
+    int64_t cost;
+    struct timeval rcv, now;
+
+    if (!m_head.timeout())
+    {
+        return -1;
+    }
+
+    GetRcvTimestamp(rcv);
+    if (rcv.tv_sec == 0)    // 没有设置接收时间, 从msg创建开始计算
+    {
+        cost = GetMsgCost();
+    }
+    else
+    {
+        gettimeofday(&now, NULL);
+        cost = (int64_t)(now.tv_sec - rcv.tv_sec) * 1000 + (now.tv_usec - rcv.tv_usec) / 1000;
+    }
+
+    if (cost >= (int64_t)m_head.timeout())
+    {
+        return 0;
+    }
+
+    return (int32_t)(m_head.timeout() - cost);
+}
+
 
 // 消息处理过程
 int CRpcMsgBase::HandleProcess()
@@ -176,6 +237,15 @@ int CRpcMsgBase::HandleProcess()
 
     GetLogOption().Set("Coloring", m_head.coloring());
 
+    // 调用方已经超时放弃的请求不再处理
+    if (GetRemainTime() == 0)
+    {
+        RPC_REPORT(errmsg(SRPC_ERR_DEADLINE_EXCEEDED));
+        m_head.set_err(SRPC_ERR_DEADLINE_EXCEEDED);
+        NGLOG_ERROR("caller deadline exceeded, method %s", m_method_info->m_method->full_name().c_str());
+        goto EXIT_LABEL;
+    }
+
     NGLOG_DEBUG("process request: %s", m_request->DebugString().c_str());
 
     // 4. 回调处理
@@ -54,6 +54,13 @@ int32_t CallMethod(const std::string &service_name,
                    Message &response,
                    int32_t timeout=800,
                    int32_t proto=PORT_TYPE_ALL);
+
+/**
+ * @brief  获取当前处理中请求的调用方剩余超时(毫秒)
+ * @info   框架启动时通过SetRemainTimeFunc设置给CSrpcProxy
+ * @return <0 没有当前请求或调用方未设置超时; 0 已经超时; >0 剩余毫秒数
+ */
+int32_t GetCallerRemainTime(void);
 enum {
     PROTO_TYPE_PB   = 1,
     PROTO_TYPE_JSON = 2,
@@ -100,6 +107,9 @@ public:
         m_head = head;
     }
 
+    // 获取调用方剩余超时(毫秒), 调用方未设置返回-1
+    int32_t GetRemainTime(void);
+
 public:
     CLogOption      m_log_options;
     CRpcHead        m_head;
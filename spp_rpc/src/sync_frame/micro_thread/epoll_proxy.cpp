@@ -37,12 +37,13 @@ EpollProxy::EpollProxy()
     _epfd = -1;
     _evtlist = NULL;
     _eprefs = NULL;
+    _uring = NULL;
 }
 
 /**
  *  @brief epoll初始化, 申请动态内存等
  */
-int EpollProxy::InitEpoll(int max_num)
+int EpollProxy::InitEpoll(int max_num, int backend)
 {
     int rc = 0;
     if (max_num > _maxfd)   // 如果设置的数目较大, 则调整最大fd数目
@@ -86,6 +87,18 @@ int EpollProxy::InitEpoll(int max_num)
         } 
     }
 
+    // io_uring按需开启, 初始化失败不影响epoll, 直接回退
+    if (MT_IO_BACKEND_URING == backend)
+    {
+        _uring = new UringPoller;
+        if (_uring->Init(MT_URING_ENTRIES) < 0)
+        {
+            MTLOG_ERROR("io_uring not supported, fallback to epoll");
+            delete _uring;
+            _uring = NULL;
+        }
+    }
+
 EXIT_LABEL:
 
     if (rc < 0)
@@ -118,6 +131,13 @@ void EpollProxy::TermEpoll()
         delete []_eprefs;
         _eprefs = NULL;
     }
+
+    if (_uring != NULL)
+    {
+        delete _uring;
+        _uring = NULL;
+    }
+    _rearm_fds.clear();
 }
 
 /**
@@ -208,10 +228,7 @@ bool EpollProxy::EpollCtrlAdd(int fd, int events)
     }
 
     int op = old_events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
-    EpEvent ev;
-    ev.events = new_events;
-    ev.data.fd = fd;
-    if ((epoll_ctl(_epfd, op, fd, &ev) < 0) && !(op == EPOLL_CTL_ADD && errno == EEXIST))
+    if (!EpollCtrlSys(fd, item, op, new_events) && !(op == EPOLL_CTL_ADD && errno == EEXIST))
     {
         MT_ATTR_API(320850, 1); // epoll error
         MTLOG_ERROR("epoll ctrl failed, fd: %d, op: %d, errno: %d", fd, op, errno);
@@ -225,6 +242,40 @@ bool EpollProxy::EpollCtrlAdd(int fd, int events)
 
 }
 
+/**
+ * @brief 监听事件变化时的内核调用, io_uring后端只排队请求, 在调度时统一提交
+ */
+bool EpollProxy::EpollCtrlSys(int fd, FdRef* item, int op, int new_events)
+{
+    if (NULL == _uring)
+    {
+        EpEvent ev;
+        ev.events = new_events;
+        ev.data.fd = fd;
+        return (epoll_ctl(_epfd, op, fd, &ev) == 0);
+    }
+
+    // 先取消在途的poll, 序号变化后旧的完成事件会被丢弃
+    if (item->GetArmedEvents() != 0)
+    {
+        _uring->PollRemove(MT_URING_DATA(fd, item->GetSeq()));
+        item->SetArmedEvents(0);
+    }
+
+    unsigned int seq = item->NextSeq();
+    if (new_events != 0)
+    {
+        if (!_uring->PollAdd(fd, new_events, MT_URING_DATA(fd, seq)))
+        {
+            errno = EBUSY;
+            return false;
+        }
+        item->SetArmedEvents(new_events);
+    }
+
+    return true;
+}
+
 /**
  * @brief 单个epfd更新epctrl, 成功需要更新当前监听事件值
  */
@@ -269,10 +320,7 @@ bool EpollProxy::EpollCtrlDelRef(int fd, int events, bool use_ref)
     }
     
     int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
-    EpEvent ev;
-    ev.events = new_events;
-    ev.data.fd = fd;
-    if ((epoll_ctl(_epfd, op, fd, &ev) < 0) && !(op == EPOLL_CTL_DEL && errno == ENOENT))
+    if (!EpollCtrlSys(fd, item, op, new_events) && !(op == EPOLL_CTL_DEL && errno == ENOENT))
     {
         MT_ATTR_API(320850, 1); // epoll error
         MTLOG_ERROR("epoll ctrl failed, fd: %d, op: %d, errno: %d", fd, op, errno);
@@ -419,6 +467,12 @@ void EpollProxy::EpollRcvEventList(int evtfdnum)
  */
 void EpollProxy::EpollDispath()
 {
+    if (_uring != NULL)
+    {
+        UringDispath();
+        return;
+    }
+
     int wait_time = EpollGetTimeout();
     int nfd = epoll_wait(_epfd, _evtlist, _maxfd, wait_time);
     if (nfd <= 0) {
@@ -429,6 +483,69 @@ void EpollProxy::EpollDispath()
 }
 
 
+/**
+ *  @brief io_uring后端的等待与分发, poll为单次触发, 仍在监听的fd下一轮重新提交
+ */
+void EpollProxy::UringDispath()
+{
+    FdRef* item = NULL;
+    for (unsigned int i = 0; i < _rearm_fds.size(); i++)
+    {
+        int osfd = _rearm_fds[i];
+        item = FdRefGet(osfd);
+        if (item && item->GetListenEvents() && !item->GetArmedEvents())
+        {
+            unsigned int seq = item->NextSeq();
+            if (_uring->PollAdd(osfd, item->GetListenEvents(), MT_URING_DATA(osfd, seq))) {
+                item->SetArmedEvents(item->GetListenEvents());
+            }
+        }
+    }
+    _rearm_fds.clear();
+
+    int wait_time = EpollGetTimeout();
+    if (_uring->Wait(wait_time) < 0)
+    {
+        MT_ATTR_API(MONITOR_MT_EPOLL_ERR, 1);
+        MTLOG_ERROR("io_uring enter failed, errno: %d", errno);
+        return;
+    }
+
+    int nfd = 0;
+    int res = 0;
+    uint64_t data = 0;
+    while ((nfd < _maxfd) && _uring->PeekCqe(data, res))
+    {
+        if (data == UringPoller::INNER_TAG) {
+            continue;
+        }
+
+        int osfd = (int)(data & 0xFFFFFFFF);
+        item = FdRefGet(osfd);
+        if ((NULL == item) || (item->GetSeq() != (unsigned int)(data >> 32))) {
+            continue;   // 已取消或重新提交过的请求
+        }
+
+        // poll已完成, 无论成败下一轮都要重新提交; 失败按EPOLLERR通知等待者
+        item->SetArmedEvents(0);
+        _rearm_fds.push_back(osfd);
+        if (res < 0)
+        {
+            MT_ATTR_API(MONITOR_MT_EPOLL_FD_ERR, 1);
+            MTLOG_DEBUG("io_uring poll failed, fd: %d, res: %d", osfd, res);
+            res = EPOLLERR;
+        }
+        _evtlist[nfd].events  = (unsigned int)res;
+        _evtlist[nfd].data.fd = osfd;
+        nfd++;
+    }
+
+    if (nfd > 0) {
+        EpollRcvEventList(nfd);
+    }
+}
+
+
 /**
  *  @brief 可读事件通知接口, 考虑通知处理可能会破坏环境, 可用返回值区分
  *  @return 0 该fd可继续处理其它事件; !=0 该fd需跳出回调处理
@@ -42,6 +42,7 @@
 
 #include <set>
 #include <vector>
+#include "mt_uring.h"
 using std::set;
 using std::vector;
 
@@ -232,6 +233,8 @@ private:
     int _events;             ///< 当前正在侦听的事件列表
     int _revents;            ///< 当前该fd收到的事件信息, 仅在epoll_wait后处理中有效
     EpollerObj* _epobj;      ///< 单独注册调度器对象，一个fd关联一个对象
+    int _armed;              ///< io_uring后端已提交的poll事件, 单次触发后清零
+    unsigned int _seq;       ///< io_uring后端poll请求的序号, 过滤过期的完成事件
 
 public:
 
@@ -244,6 +247,8 @@ public:
         _events  = 0;
         _revents = 0;
         _epobj   = NULL;
+        _armed   = 0;
+        _seq     = 0;
     };
     ~FdRef(){};
 
@@ -300,6 +305,22 @@ public:
      */
     int ReadRefCnt() { return _rd_ref; };
     int WriteRefCnt() { return _wr_ref; };
+
+    /**
+     * @brief io_uring后端的poll请求状态
+     */
+    void SetArmedEvents(int events) {
+        _armed = events;
+    };
+    int GetArmedEvents() {
+        return _armed;
+    };
+    unsigned int NextSeq() {
+        return ++_seq;
+    };
+    unsigned int GetSeq() {
+        return _seq;
+    };
     
 };
 
@@ -317,6 +338,8 @@ private:
     int                 _maxfd;                     ///< 最大的文件句柄数    
     EpEvent*            _evtlist;                   ///< epoll返回给用户的事件列表指针
     FdRef*              _eprefs;                    ///< 用户监听的事件本地管理数组
+    UringPoller*        _uring;                     ///< io_uring后端, NULL 表示使用epoll
+    vector<int>         _rearm_fds;                 ///< io_uring单次poll触发后待重新提交的fd
     
 public:  
 
@@ -329,10 +352,18 @@ public:
     /**
      *  @brief epoll初始化与终止处理, 申请动态内存等
      *  @param max_num 最大可管理的fd数目
+     *  @param backend 事件后端, io_uring不可用时自动回退epoll
      */
-    int InitEpoll(int max_num);
+    int InitEpoll(int max_num, int backend = MT_IO_BACKEND_EPOLL);
     void TermEpoll(void);
 
+    /**
+     *  @brief 当前实际使用的事件后端
+     */
+    int GetIoBackend(void) {
+        return _uring ? MT_IO_BACKEND_URING : MT_IO_BACKEND_EPOLL;
+    };
+
     /**
      *  @brief epoll_wait 获取最大等待时间接口
      *  @return 目前需要等待的时间, 单位MS
@@ -426,6 +457,21 @@ protected:
      */
     void EpollRcvEventList(int evtfdnum);
 
+    /**
+     *  @brief 监听事件变化时的内核调用, epoll_ctl或排队io_uring请求
+     *  @param fd 操作的文件句柄
+     *  @param item 本地引用结构
+     *  @param op epoll的操作类型
+     *  @param new_events 变更后的监听事件
+     *  @return true 成功, false 失败
+     */
+    bool EpollCtrlSys(int fd, FdRef* item, int op, int new_events);
+
+    /**
+     *  @brief io_uring后端的等待与分发, 一轮调度一次io_uring_enter
+     */
+    void UringDispath(void);
+
 };
 }//NAMESPCE
 
@@ -28,6 +28,8 @@
 #include "mt_sys_hook.h"
 #include "valgrind.h"
 #include <assert.h>
+#include <limits.h>
+#include <string.h>
 
 using namespace NS_MICRO_THREAD;
 
@@ -240,6 +242,24 @@ bool Thread::CheckStackHealth(char *esp)
 		return false;
 }
 
+/**
+ * @brief 栈使用的最高水位, mmap的栈初始全零, 从栈底找第一个非零字
+ */
+unsigned int Thread::GetStackUsed()
+{
+    if (!_stack) {
+        return 0;
+    }
+
+    long* pos = (long*)_stack->_stk_bottom;
+    long* end = (long*)_stack->_stk_top;
+    while ((pos < end) && (*pos == 0)) {
+        pos++;
+    }
+
+    return (unsigned int)((char*)end - (char*)pos);
+}
+
 /**
  * @brief 微线程构造, 默认是普通线程
  * @param type 类型, 默认普通
@@ -255,6 +275,8 @@ MicroThread::MicroThread(ThreadType type)
     _start = NULL;
     _args = NULL;
     _parent = NULL;
+    _wait_stamp = 0;
+    _run_stamp = 0;
 }
 
 /**
@@ -270,6 +292,8 @@ void MicroThread::CleanState()
     _start = NULL;
     _args = NULL;
     _parent = NULL;
+    _wait_stamp = 0;
+    _run_stamp = 0;
 }
 
 /**
@@ -352,7 +376,7 @@ void MicroThread::RemoveSubThread(MicroThread* sub)
 /**
  * @brief 单例类访问句柄入口
  */
-ScheduleObj *ScheduleObj::_instance = NULL;     ///< 静态句柄初始化
+__thread ScheduleObj *ScheduleObj::_instance = NULL;     ///< 静态句柄初始化
 inline ScheduleObj* ScheduleObj::Instance()
 {
     if (NULL == _instance)
@@ -451,6 +475,7 @@ void ScheduleObj::ScheduleReclaim()
         return;
     }
 
+    frame->ProfReclaim(thread);
     frame->FreeThread(thread);
 }
 
@@ -600,7 +625,7 @@ int ThreadPool::GetUsedNum(void)
 /**
  * @brief 微线程框架类, 全局实例获取
  */
-MtFrame *MtFrame::_instance = NULL;
+__thread MtFrame *MtFrame::_instance = NULL;
 inline MtFrame* MtFrame::Instance ()
 {
     if (NULL == _instance )
@@ -622,12 +647,12 @@ void MtFrame::SetHookFlag() {
 /**
  * @brief 框架初始化, 默认不带日志运行
  */
-bool MtFrame::InitFrame(LogAdapter* logadpt, int max_thread_num)
+bool MtFrame::InitFrame(LogAdapter* logadpt, int max_thread_num, int io_backend)
 {
     _log_adpt = logadpt;
 
     // 设置最大允许的线程数目, 尝试调节epoll监控的fd数目
-    if ((this->InitEpoll(max_thread_num) < 0) || !this->InitialPool(max_thread_num))
+    if ((this->InitEpoll(max_thread_num, io_backend) < 0) || !this->InitialPool(max_thread_num))
     {
         MTLOG_ERROR("Init epoll or thread pool failed");
         this->Destroy();
@@ -785,6 +810,7 @@ void MtFrame::DaemonRun(void* args)
         mtframe->SetLastClock(mtframe->GetSystemMS());
         mtframe->WakeupTimeout(); 
         mtframe->CheckExpired();
+        mtframe->_prof.Report(mtframe->GetLastClock());
         daemon->SwitchContext();
     }
 }
@@ -830,6 +856,7 @@ void MtFrame::ThreadSchdule()
 {
     MicroThread* thread = NULL;    
     MtFrame* mtframe = MtFrame::Instance();
+    bool from_runq = false;
     
     if (mtframe->_runlist.empty())
     {
@@ -839,6 +866,12 @@ void MtFrame::ThreadSchdule()
     {
         thread = mtframe->_runlist.front();
         mtframe->RemoveRunable(thread);
+        from_runq = true;
+    }
+
+    mtframe->_prof.AddSwitch();
+    if (mtframe->_prof.IsOn()) {
+        mtframe->ProfSwitch(mtframe->GetActiveThread(), thread, from_runq);
     }
 
     this->SetActiveThread(thread);
@@ -851,7 +884,7 @@ void MtFrame::ThreadSchdule()
  */
 void MtFrame::CheckExpired()
 {
-    static utime64_t check_time = 0;
+    static __thread utime64_t check_time = 0;
     
     if (_timer != NULL)
     {
@@ -929,6 +962,7 @@ inline void MtFrame::InsertSleep(MicroThread* thread)
 
     thread->SetFlag(MicroThread::SLEEP_LIST);
     thread->SetState(MicroThread::SLEEPING);
+    ProfWaitBegin(thread);
     int rc = _sleeplist.HeapPush(thread);
     if (rc < 0)
     {
@@ -945,6 +979,7 @@ inline void MtFrame::RemoveSleep(MicroThread* thread)
 {
     ASSERT(thread->HasFlag(MicroThread::SLEEP_LIST));
     thread->UnsetFlag(MicroThread::SLEEP_LIST);
+    ProfWaitEnd(thread, MicroThread::SLEEP_LIST);
 
     int rc = _sleeplist.HeapDelete(thread);
     if (rc < 0)
@@ -975,6 +1010,7 @@ void MtFrame::RemoveIoWait(MicroThread* thread)
     ASSERT(thread->HasFlag(MicroThread::IO_LIST));
     thread->UnsetFlag(MicroThread::IO_LIST);
     TAILQ_REMOVE(&_iolist, thread, _entry);
+    ProfWaitEnd(thread, MicroThread::IO_LIST);
 
     RemoveSleep(thread);
 }
@@ -989,6 +1025,7 @@ void MtFrame::InsertRunable(MicroThread* thread)
     thread->SetFlag(MicroThread::RUN_LIST);
 
     thread->SetState(MicroThread::RUNABLE);
+    ProfWaitBegin(thread);
     _runlist.push(thread);
     _waitnum++;
 }
@@ -1018,6 +1055,7 @@ void MtFrame::InsertPend(MicroThread* thread)
     thread->SetFlag(MicroThread::PEND_LIST);
     TAILQ_INSERT_TAIL(&_pend_list, thread, _entry);
     thread->SetState(MicroThread::PENDING);    
+    ProfWaitBegin(thread);
 }
 
 /**
@@ -1029,6 +1067,85 @@ void MtFrame::RemovePend(MicroThread* thread)
     ASSERT(thread->HasFlag(MicroThread::PEND_LIST));
     thread->UnsetFlag(MicroThread::PEND_LIST);
     TAILQ_REMOVE(&_pend_list, thread, _entry);
+    ProfWaitEnd(thread, MicroThread::PEND_LIST);
+}
+
+/**
+ * @brief 剖析处理, 切换时结算上一个线程的切片与下一个线程的排队时间
+ *        守护线程的运行时间单独累计, 守护线程两次运行之间的间隔即为调度循环时延
+ */
+void MtFrame::ProfSwitch(MicroThread* prev, MicroThread* next, bool from_runq)
+{
+    utime64_t now = MtProfiler::NowUS();
+
+    if (prev && prev->GetRunStamp())
+    {
+        utime64_t cost = now - prev->GetRunStamp();
+        if (prev->IsDaemon()) {
+            _prof.AddDaemon(cost);
+            _loop_stamp = now;
+        } else {
+            _prof.AddSlice((void*)prev->GetStartFunc(), cost, now);
+        }
+        prev->SetRunStamp(0);
+    }
+
+    if (from_runq && next->GetWaitStamp())
+    {
+        _prof.AddRunq(now - next->GetWaitStamp());
+        next->SetWaitStamp(0);
+    }
+
+    if (next->IsDaemon() && _loop_stamp) {
+        _prof.AddLoop(now - _loop_stamp, now);
+    }
+    next->SetRunStamp(now);
+}
+
+/**
+ * @brief 剖析处理, 线程结束前结算最后一个切片并采样栈水位
+ */
+void MtFrame::ProfReclaim(MicroThread* thread)
+{
+    if (!_prof.IsOn()) {
+        return;
+    }
+
+    if (thread->GetRunStamp())
+    {
+        utime64_t now = MtProfiler::NowUS();
+        _prof.AddSlice((void*)thread->GetStartFunc(), now - thread->GetRunStamp(), now);
+        thread->SetRunStamp(0);
+    }
+
+    if (_prof.NeedStackSample()) {
+        _prof.AddStack(thread->GetStackUsed());
+    }
+}
+
+/**
+ * @brief 剖析处理, 线程离开等待状态时结算等待时间
+ */
+void MtFrame::ProfWaitEnd(MicroThread* thread, MicroThread::ThreadFlag flag)
+{
+    if (!_prof.IsOn() || !thread->GetWaitStamp()) {
+        return;
+    }
+
+    utime64_t cost = MtProfiler::NowUS() - thread->GetWaitStamp();
+    thread->SetWaitStamp(0);
+    switch (flag)
+    {
+        case MicroThread::IO_LIST:
+            _prof.AddIoWait(cost);
+            break;
+        case MicroThread::PEND_LIST:
+            _prof.AddPend(cost);
+            break;
+        default:
+            _prof.AddSleep(cost);
+            break;
+    }
 }
 
 /**
@@ -1550,6 +1667,266 @@ ssize_t MtFrame::send(int fd, const void *buf, size_t nbyte, int flags, int time
 
 
 
+/**
+ * @brief 微线程包裹的系统IO函数 readv
+ * @param fd 系统socket信息
+ * @param iov 接收缓冲区向量
+ * @param iovcnt 缓冲区个数
+ * @param timeout 最长等待时间, 毫秒
+ * @return >0 成功接收长度, <0 失败
+ */
+ssize_t MtFrame::readv(int fd, const struct iovec *iov, int iovcnt, int timeout)
+{
+    MtFrame* mtframe = MtFrame::Instance();
+    utime64_t start = mtframe->GetLastClock();
+    MicroThread* thread = mtframe->GetActiveThread();
+    utime64_t now = 0;
+
+    ssize_t n = 0;
+    mt_hook_syscall(readv);
+    while (true)
+    {
+        now = mtframe->GetLastClock();
+        if ((int)(now - start) > timeout)
+        {
+            errno = ETIME;
+            return -1;
+        }
+
+        EpollerObj epfd;
+        epfd.SetOsfd(fd);
+        epfd.EnableInput();
+        epfd.SetOwnerThread(thread);
+        if (!mtframe->EpollSchedule(NULL, &epfd, timeout)) {
+            return -2;
+        }
+
+        n = mt_real_func(readv)(fd, iov, iovcnt);
+        if (n < 0)
+        {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                MTLOG_ERROR("readv failed, errno: %d", errno);
+                return -3;
+            }
+        }
+
+        break;
+    }
+
+    return n;
+}
+
+/**
+ * @brief 微线程包裹的系统IO函数 writev, 部分写入时在向量副本上推进, 不修改调用者的向量
+ * @param fd 系统socket信息
+ * @param iov 待发送的缓冲区向量
+ * @param iovcnt 缓冲区个数
+ * @param timeout 最长等待时间, 毫秒
+ * @return >0 成功发送长度, <0 失败
+ */
+ssize_t MtFrame::writev(int fd, const struct iovec *iov, int iovcnt, int timeout)
+{
+    MtFrame* mtframe = MtFrame::Instance();
+    utime64_t start = mtframe->GetLastClock();
+    MicroThread* thread = mtframe->GetActiveThread();
+    utime64_t now = 0;
+
+    if ((iovcnt < 0) || (iovcnt > IOV_MAX)) {
+        errno = EINVAL;
+        return -2;
+    }
+
+    size_t nbyte = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        nbyte += iov[i].iov_len;
+    }
+
+    struct iovec stack_iov[MT_IOV_STACK_NUM];
+    struct iovec* vec = stack_iov;
+    if (iovcnt > MT_IOV_STACK_NUM)
+    {
+        vec = (struct iovec*)malloc(iovcnt * sizeof(struct iovec));
+        if (NULL == vec) {
+            errno = ENOMEM;
+            return -2;
+        }
+    }
+    memcpy(vec, iov, iovcnt * sizeof(struct iovec));
+
+    ssize_t ret = nbyte;
+    struct iovec* curr = vec;
+    int left_cnt = iovcnt;
+    size_t send_len = 0;
+    mt_hook_syscall(writev);
+    while (send_len < nbyte)
+    {
+        now = mtframe->GetLastClock();
+        if ((int)(now - start) > timeout)
+        {
+            errno = ETIME;
+            ret = -1;
+            break;
+        }
+
+        ssize_t n = mt_real_func(writev)(fd, curr, left_cnt);
+        if (n < 0)
+        {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                MTLOG_ERROR("writev failed, errno: %d", errno);
+                ret = -2;
+                break;
+            }
+        }
+        else
+        {
+            send_len += n;
+            if (send_len >= nbyte) {
+                break;
+            }
+
+            // 跳过已经写完的向量, 截短写了一部分的向量
+            while ((left_cnt > 0) && ((size_t)n >= curr->iov_len))
+            {
+                n -= curr->iov_len;
+                curr++;
+                left_cnt--;
+            }
+            curr->iov_base = (char*)curr->iov_base + n;
+            curr->iov_len -= n;
+            continue;
+        }
+
+        EpollerObj epfd;
+        epfd.SetOsfd(fd);
+        epfd.EnableOutput();
+        epfd.SetOwnerThread(thread);
+        if (!mtframe->EpollSchedule(NULL, &epfd, timeout)) {
+            ret = -3;
+            break;
+        }
+    }
+
+    if (vec != stack_iov) {
+        free(vec);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief 微线程包裹的系统IO函数 recvmsg
+ * @param fd 系统socket信息
+ * @param msg 接收消息头, 含缓冲区向量与来源地址
+ * @param timeout 最长等待时间, 毫秒
+ * @return >0 成功接收长度, <0 失败
+ */
+ssize_t MtFrame::recvmsg(int fd, struct msghdr *msg, int flags, int timeout)
+{
+    MtFrame* mtframe = MtFrame::Instance();
+    utime64_t start = mtframe->GetLastClock();
+    MicroThread* thread = mtframe->GetActiveThread();
+    utime64_t now = 0;
+
+    if (timeout <= -1)
+    {
+        timeout = 0x7fffffff;
+    }
+
+    while (true)
+    {
+        now = mtframe->GetLastClock();
+        if ((int)(now - start) > timeout)
+        {
+            errno = ETIME;
+            return -1;
+        }
+
+        EpollerObj epfd;
+        epfd.SetOsfd(fd);
+        epfd.EnableInput();
+        epfd.SetOwnerThread(thread);
+        if (!mtframe->EpollSchedule(NULL, &epfd, timeout))
+        {
+            MTLOG_DEBUG("epoll schedule failed, errno: %d", errno);
+            return -2;
+        }
+
+        mt_hook_syscall(recvmsg);
+        ssize_t n = mt_real_func(recvmsg)(fd, msg, flags);
+        if (n < 0)
+        {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+            {
+                MTLOG_ERROR("recvmsg failed, errno: %d", errno);
+                return -3;
+            }
+        }
+        else
+        {
+            return n;
+        }
+    }
+}
+
+/**
+ * @brief 微线程包裹的系统IO函数 sendmsg, 与sendto一致, 一次成功即返回
+ * @param fd 系统socket信息
+ * @param msg 待发送的消息头
+ * @param timeout 最长等待时间, 毫秒
+ * @return >0 成功发送长度, <0 失败
+ */
+ssize_t MtFrame::sendmsg(int fd, const struct msghdr *msg, int flags, int timeout)
+{
+    MtFrame* mtframe = MtFrame::Instance();
+    utime64_t start = mtframe->GetLastClock();
+    MicroThread* thread = mtframe->GetActiveThread();
+    utime64_t now = 0;
+
+    ssize_t n = 0;
+    mt_hook_syscall(sendmsg);
+    while ((n = mt_real_func(sendmsg)(fd, msg, flags)) < 0)
+    {
+        now = mtframe->GetLastClock();
+        if ((int)(now - start) > timeout)
+        {
+            errno = ETIME;
+            return -1;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+            MTLOG_ERROR("sendmsg failed, errno: %d", errno);
+            return -2;
+        }
+
+        EpollerObj epfd;
+        epfd.SetOsfd(fd);
+        epfd.EnableOutput();
+        epfd.SetOwnerThread(thread);
+        if (!mtframe->EpollSchedule(NULL, &epfd, timeout)) {
+            return -3;
+        }
+    }
+
+    return n;
+}
+
+
 /**
  * @brief 微线程主动sleep接口, 单位ms
  */
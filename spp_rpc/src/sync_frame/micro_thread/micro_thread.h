@@ -47,6 +47,7 @@
 #include "heap.h"
 #include "epoll_proxy.h"
 #include "heap_timer.h"
+#include "mt_prof.h"
 
 using std::vector;
 using std::set;
@@ -58,6 +59,7 @@ namespace NS_MICRO_THREAD {
 #define MEM_PAGE_SIZE       4096        ///< 内存页默认大小
 #define DEFAULT_STACK_SIZE  128*1024    ///< 默认栈大小128K
 #define DEFAULT_THREAD_NUM  2000        ///< 默认2000个初始线程
+#define MT_IOV_STACK_NUM    16          ///< writev在栈上复制的向量数, 超过则动态申请
 
 typedef unsigned long long  utime64_t;  ///< 64位的时间定义
 typedef void (*ThreadStart)(void*);      ///< 微线程入口函数定义
@@ -110,7 +112,7 @@ public:
     void ScheduleStartRun(void);
 
 private:
-    static ScheduleObj* _instance;   // 私有句柄 
+    static __thread ScheduleObj* _instance;   // 私有句柄, 每个调度线程独立
 };
 
 
@@ -222,6 +224,13 @@ public:
      */
     bool CheckStackHealth(char *esp);
 
+    /**
+     * @brief 栈使用的最高水位, 从栈底向上找第一个被写过的位置
+     *        栈内存复用, 结果为该栈历次使用中的最高水位
+     * @return 已使用的字节数, 无独立栈返回0
+     */
+    unsigned int GetStackUsed(void);
+
 protected: 
 
     /**
@@ -408,6 +417,26 @@ public:
     void* GetThreadArgs() {
         return _args;
     }
+
+    ThreadStart GetStartFunc() {
+        return _start;
+    }
+
+    /**
+     * @breif 剖析用的时间戳, 进入等待状态的时间与本次开始运行的时间
+     */
+    void SetWaitStamp(utime64_t stamp) {
+        _wait_stamp = stamp;
+    };
+    utime64_t GetWaitStamp(void) {
+        return _wait_stamp;
+    };
+    void SetRunStamp(utime64_t stamp) {
+        _run_stamp = stamp;
+    };
+    utime64_t GetRunStamp(void) {
+        return _run_stamp;
+    };
     
 protected: 
 
@@ -425,6 +454,8 @@ private:
     MicroThread* _parent;       ///< 二级线程的父线程
     ThreadStart _start;         ///< 微线程注册函数
     void* _args;                ///< 微线程注册参数
+    utime64_t _wait_stamp;      ///< 进入等待状态的时间, 微秒, 仅剖析打开时有效
+    utime64_t _run_stamp;       ///< 本次开始运行的时间, 微秒, 仅剖析打开时有效
 
 };
 typedef std::set<MicroThread*> ThreadSet;       ///< 微线程set管理结构
@@ -467,6 +498,11 @@ public:
     virtual void AttrReportAdd(const char *attr, int iValue){};
     virtual void AttrReportSet(const char *attr, int iValue){};
 
+    /**
+     * @brief 调度剖析周期统计上报接口
+     */
+    virtual void SchedStatReport(const MtSchedStat& stat){};
+
 };
 
 
@@ -537,7 +573,7 @@ typedef TAILQ_HEAD(__ThreadTailq, MicroThread) ThreadTailq;  ///< 微线程队
 class MtFrame : public EpollProxy, public ThreadPool
 {
 private:
-    static MtFrame* _instance;          ///< 单例指针
+    static __thread MtFrame* _instance; ///< 单例指针, 每个调度线程独立
     LogAdapter*     _log_adpt;          ///< 日志接口
 	ThreadList      _runlist;           ///< 可运行queue, 无优先级
 	ThreadTailq     _iolist;            ///< 等待队列，可随机脱离队列 
@@ -549,6 +585,8 @@ private:
 	utime64_t       _last_clock;        ///< 全局时间戳, 每次idle获取一次
     int             _waitnum;           ///< 等待运行的总线程数, 可调节调度的节奏
     CTimerMng*      _timer;             ///< TCP保活专用的timer定时器
+    MtProfiler      _prof;              ///< 调度剖析统计
+    utime64_t       _loop_stamp;        ///< 守护线程上次让出CPU的时间, 微秒
 
 public:
     friend class ScheduleObj;           ///< 调度器对象, 是框架类的门面模式, 友元处理
@@ -644,6 +682,44 @@ public:
      */
     static ssize_t send(int fd, const void *buf, size_t nbyte, int flags, int timeout);
 
+    /**
+     * @brief 微线程包裹的系统IO函数 readv
+     * @param fd 系统socket信息
+     * @param iov 接收缓冲区向量
+     * @param iovcnt 缓冲区个数
+     * @param timeout 最长等待时间, 毫秒
+     * @return >0 成功接收长度, <0 失败
+     */
+    static ssize_t readv(int fd, const struct iovec *iov, int iovcnt, int timeout);
+
+    /**
+     * @brief 微线程包裹的系统IO函数 writev, 全部写完才返回
+     * @param fd 系统socket信息
+     * @param iov 待发送的缓冲区向量
+     * @param iovcnt 缓冲区个数
+     * @param timeout 最长等待时间, 毫秒
+     * @return >0 成功发送长度, <0 失败
+     */
+    static ssize_t writev(int fd, const struct iovec *iov, int iovcnt, int timeout);
+
+    /**
+     * @brief 微线程包裹的系统IO函数 recvmsg
+     * @param fd 系统socket信息
+     * @param msg 接收消息头, 含缓冲区向量与来源地址
+     * @param timeout 最长等待时间, 毫秒
+     * @return >0 成功接收长度, <0 失败
+     */
+    static ssize_t recvmsg(int fd, struct msghdr *msg, int flags, int timeout);
+
+    /**
+     * @brief 微线程包裹的系统IO函数 sendmsg
+     * @param fd 系统socket信息
+     * @param msg 待发送的消息头
+     * @param timeout 最长等待时间, 毫秒
+     * @return >0 成功发送长度, <0 失败
+     */
+    static ssize_t sendmsg(int fd, const struct msghdr *msg, int flags, int timeout);
+
 
     /**
      * @brief 微线程主动sleep接口, 单位ms
@@ -680,8 +756,10 @@ public:
 
     /**
      * @brief 框架初始化, 默认不带日志运行
+     * @param io_backend 事件后端, 见MT_IO_BACKEND, io_uring不可用时回退epoll
      */
-    bool InitFrame(LogAdapter* logadpt = NULL, int max_thread_num = 50000);
+    bool InitFrame(LogAdapter* logadpt = NULL, int max_thread_num = 50000,
+                   int io_backend = MT_IO_BACKEND_EPOLL);
 
     /**
      * @brief HOOK系统api的设置
@@ -740,6 +818,13 @@ public:
         return _timer;
     };
 
+    /**
+     * @brief 获取调度剖析器
+     */
+    MtProfiler* GetProfiler(void) {
+        return &_prof;
+    };
+
     /**
      * @brief 框架调用epoll wait前, 判定等待时间信息
      */
@@ -790,7 +875,7 @@ private:
     /**
      * @brief 微线程私有构造
      */
-    MtFrame(){ _curr_thread = NULL; }; 
+    MtFrame(){ _curr_thread = NULL; _loop_stamp = 0; }; 
 
     /**
      * @brief 微线程私有获取守护线程
@@ -861,6 +946,36 @@ private:
      */
     void RemoveRunable(MicroThread* thread);    
 
+    /**
+     * @brief 剖析处理, 切换时结算上一个线程的切片与下一个线程的排队时间
+     * @param prev 让出CPU的线程
+     * @param next 即将运行的线程
+     * @param from_runq 下一个线程是否来自可运行队列
+     */
+    void ProfSwitch(MicroThread* prev, MicroThread* next, bool from_runq);
+
+    /**
+     * @brief 剖析处理, 线程结束前结算最后一个切片并采样栈水位
+     * @param thread 结束的微线程
+     */
+    void ProfReclaim(MicroThread* thread);
+
+    /**
+     * @brief 剖析处理, 线程离开等待状态时结算等待时间
+     * @param thread 微线程对象
+     * @param flag 离开的等待队列标记
+     */
+    void ProfWaitEnd(MicroThread* thread, MicroThread::ThreadFlag flag);
+
+    /**
+     * @brief 剖析处理, 线程进入等待或可运行状态时打点
+     */
+    void ProfWaitBegin(MicroThread* thread) {
+        if (_prof.IsOn()) {
+            thread->SetWaitStamp(MtProfiler::NowUS());
+        }
+    };
+
 };
 
 /**
@@ -27,6 +27,8 @@
 #include "mt_connection.h"
 #include "mt_api.h"
 #include "mt_monitor.h"
+#include "mt_sched_group.h"
+#include "mt_dns.h"
 
 namespace NS_MICRO_THREAD {
 
@@ -874,7 +876,17 @@ void* mt_get_msg_private()
  */
 bool mt_init_frame(void)
 {
-    return MtFrame::Instance()->InitFrame();
+    return mt_init_frame(0);
+}
+
+/**
+ * @brief  微线程框架初始化, 指定事件后端
+ * @param  io_backend 事件后端, 0 epoll, 1 io_uring
+ * @return false:初始化失败  true:初始化成功
+ */
+bool mt_init_frame(int io_backend)
+{
+    return MtFrame::Instance()->InitFrame(NULL, 50000, io_backend);
 }
 
 /**
@@ -886,6 +898,54 @@ void mt_set_stack_size(unsigned int bytes)
     ThreadPool::SetDefaultStackSize(bytes);
 }
 
+/**
+ * @brief  微线程M:N模式初始化
+ */
+bool mt_init_frame_mn(int worker_num, int max_thread_num, int io_backend)
+{
+    return MtSchedGroup::Instance()->Start(worker_num, max_thread_num, io_backend);
+}
+
+/**
+ * @brief  M:N模式下投递微线程任务
+ */
+bool mt_start_thread_mn(void* entry, void* args)
+{
+    return MtSchedGroup::Instance()->Submit((ThreadStart)entry, args);
+}
+
+/**
+ * @brief  停止M:N模式
+ */
+void mt_stop_frame_mn(void)
+{
+    MtSchedGroup::Destroy();
+}
+
+/**
+ * @brief  打开或关闭当前调度线程的调度剖析
+ */
+void mt_prof_enable(bool on, int sample)
+{
+    MtFrame::Instance()->GetProfiler()->Enable(on, sample);
+}
+
+/**
+ * @brief  获取当前调度线程的剖析统计
+ */
+void mt_prof_stat(MtSchedStat& stat, bool reset)
+{
+    MtFrame::Instance()->GetProfiler()->Snapshot(stat, reset);
+}
+
+/**
+ * @brief  切片明细落地文件
+ */
+int mt_prof_dump(const char* file)
+{
+    return MtFrame::Instance()->GetProfiler()->DumpTrace(file);
+}
+
 /**
  * @brief 微线程包裹的系统IO函数 recvfrom
  * @param fd 系统socket信息
@@ -995,6 +1055,55 @@ ssize_t mt_send(int fd, const void *buf, size_t nbyte, int flags, int timeout)
     return MtFrame::send(fd, buf, nbyte, flags, timeout);
 }
 
+/**
+ * @brief 微线程包裹的系统IO函数 readv
+ */
+ssize_t mt_readv(int fd, const struct iovec *iov, int iovcnt, int timeout)
+{
+    return MtFrame::readv(fd, iov, iovcnt, timeout);
+}
+
+/**
+ * @brief 微线程包裹的系统IO函数 writev
+ */
+ssize_t mt_writev(int fd, const struct iovec *iov, int iovcnt, int timeout)
+{
+    return MtFrame::writev(fd, iov, iovcnt, timeout);
+}
+
+/**
+ * @brief 微线程包裹的系统IO函数 recvmsg
+ */
+ssize_t mt_recvmsg(int fd, struct msghdr *msg, int flags, int timeout)
+{
+    return MtFrame::recvmsg(fd, msg, flags, timeout);
+}
+
+/**
+ * @brief 微线程包裹的系统IO函数 sendmsg
+ */
+ssize_t mt_sendmsg(int fd, const struct msghdr *msg, int flags, int timeout)
+{
+    return MtFrame::sendmsg(fd, msg, flags, timeout);
+}
+
+/**
+ * @brief 微线程域名解析
+ */
+int mt_getaddrinfo(const char *node, const char *service,
+                   const struct addrinfo *hints, struct addrinfo **res, int timeout)
+{
+    return MtDnsResolver::Instance()->GetAddrInfo(node, service, hints, res, timeout);
+}
+
+/**
+ * @brief 设置域名解析缓存时间
+ */
+void mt_set_dns_ttl(int ttl, int neg_ttl)
+{
+    MtDnsResolver::Instance()->SetTTL(ttl, neg_ttl);
+}
+
 /**
  * @brief 微线程主动sleep接口, 单位ms
  */
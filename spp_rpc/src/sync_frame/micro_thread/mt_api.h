@@ -26,7 +26,10 @@
 #define __MT_API_H__
  
 #include <netinet/in.h>
+#include <netdb.h>
+#include <sys/uio.h>
 #include <vector>
+#include "mt_prof.h"
 
 using std::vector;
 
@@ -246,12 +249,63 @@ void* mt_get_msg_private();
  */
 bool mt_init_frame(void);
 
+/**
+ * @brief  微线程框架初始化, 指定事件后端
+ * @param  io_backend 事件后端, 0 epoll, 1 io_uring, 内核不支持io_uring时回退epoll
+ * @return false:初始化失败  true:初始化成功
+ */
+bool mt_init_frame(int io_backend);
+
 /**
  * @brief 设置微线程独立栈空间大小
  * @info  非必须设置，默认大小为128K
  */
 void mt_set_stack_size(unsigned int bytes);
 
+/**
+ * @brief  微线程M:N模式初始化, 每个OS线程一个独立的调度器与epoll
+ * @info   新任务由空闲的调度线程窃取运行, 任务启动后固定在该调度线程上,
+ *         其内部的mt_*接口用法不变; 调用前设置的HOOK标记会被调度线程继承
+ * @param  worker_num 调度线程数, <=0 时按cpu核数
+ * @param  max_thread_num 每个调度线程的最大微线程数
+ * @return false:初始化失败  true:初始化成功
+ */
+bool mt_init_frame_mn(int worker_num, int max_thread_num = 50000, int io_backend = 0);
+
+/**
+ * @brief  M:N模式下投递微线程任务, 可在任意OS线程调用
+ * @param  entry   入口函数指针，类型见ThreadStart
+ * @param  args    入口函数参数
+ * @return false:投递失败  true:投递成功
+ */
+bool mt_start_thread_mn(void* entry, void* args);
+
+/**
+ * @brief  停止M:N模式, 等待所有调度线程退出, 未启动的任务丢弃
+ */
+void mt_stop_frame_mn(void);
+
+/**
+ * @brief  打开或关闭当前调度线程的调度剖析, 统计定时以属性方式上报
+ * @param  on      是否打开
+ * @param  sample  切片明细采样间隔, 每sample个切片记录一个, 0 只记录慢切片
+ */
+void mt_prof_enable(bool on, int sample = 0);
+
+/**
+ * @brief  获取当前调度线程的剖析统计
+ * @param  stat    输出的统计, 时间单位微秒
+ * @param  reset   读取后是否清零, 清零会影响定时上报的值
+ */
+void mt_prof_stat(MtSchedStat& stat, bool reset = false);
+
+/**
+ * @brief  将当前调度线程的切片明细追加到文件, 输出后清空
+ * @param  file    文件名, 每行: 时间(微秒) 类型 入口函数地址 耗时(微秒)
+ * @return >=0 输出的记录数, <0 失败
+ */
+int mt_prof_dump(const char* file);
+
 /**
  * @brief 微线程包裹的系统IO函数 recvfrom
  * @param fd 系统socket信息
@@ -337,6 +391,60 @@ ssize_t mt_recv(int fd, void *buf, int len, int flags, int timeout);
  */
 ssize_t mt_send(int fd, const void *buf, size_t nbyte, int flags, int timeout);
 
+/**
+ * @brief 微线程包裹的系统IO函数 readv
+ * @param fd 系统socket信息
+ * @param iov 接收缓冲区向量
+ * @param iovcnt 缓冲区个数
+ * @param timeout 最长等待时间, 毫秒
+ * @return >0 成功接收长度, <0 失败
+ */
+ssize_t mt_readv(int fd, const struct iovec *iov, int iovcnt, int timeout);
+
+/**
+ * @brief 微线程包裹的系统IO函数 writev, 全部写完才返回
+ * @param fd 系统socket信息
+ * @param iov 待发送的缓冲区向量
+ * @param iovcnt 缓冲区个数
+ * @param timeout 最长等待时间, 毫秒
+ * @return >0 成功发送长度, <0 失败
+ */
+ssize_t mt_writev(int fd, const struct iovec *iov, int iovcnt, int timeout);
+
+/**
+ * @brief 微线程包裹的系统IO函数 recvmsg
+ * @param fd 系统socket信息
+ * @param msg 接收消息头
+ * @param timeout 最长等待时间, 毫秒
+ * @return >0 成功接收长度, <0 失败
+ */
+ssize_t mt_recvmsg(int fd, struct msghdr *msg, int flags, int timeout);
+
+/**
+ * @brief 微线程包裹的系统IO函数 sendmsg
+ * @param fd 系统socket信息
+ * @param msg 待发送的消息头
+ * @param timeout 最长等待时间, 毫秒
+ * @return >0 成功发送长度, <0 失败
+ */
+ssize_t mt_sendmsg(int fd, const struct msghdr *msg, int flags, int timeout);
+
+/**
+ * @brief 微线程域名解析, 由后台线程执行系统getaddrinfo, 结果按TTL缓存
+ * @info  返回的链表由系统freeaddrinfo释放; 数字地址直接转换不等待
+ * @param timeout 最长等待时间, 毫秒, 超时返回EAI_AGAIN
+ * @return 0 成功, 其它为EAI_*错误码
+ */
+int mt_getaddrinfo(const char *node, const char *service,
+                   const struct addrinfo *hints, struct addrinfo **res, int timeout);
+
+/**
+ * @brief 设置域名解析缓存时间, 秒, 设置后清空缓存
+ * @param ttl 解析成功的缓存时间, 0 不缓存
+ * @param neg_ttl 域名不存在的缓存时间, 0 不缓存
+ */
+void mt_set_dns_ttl(int ttl, int neg_ttl);
+
 
 /**
  * @brief 微线程等待epoll事件的包裹函数
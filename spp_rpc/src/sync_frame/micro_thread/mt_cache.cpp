@@ -210,6 +210,106 @@ void recycle_sk_buffer(TSkBuffMng* mng, uint32_t now)
 }
 
 
+/**
+ * @brief 分级池各级的块大小, 从小到大
+ */
+static const uint32_t g_sk_class_size[SK_BUFF_CLASS_NUM] = {
+    512, 4*1024, 16*1024, SK_DFLT_BUFF_SIZE
+};
+
+/**
+ * @brief  分级池的初始化接口
+ * @param  cls -分级池的指针
+ * @param  expired -保活的时间, 单位秒
+ */
+void sk_buffer_class_init(TSkBuffClass* cls, uint32_t expired)
+{
+    for (uint32_t i = 0; i < SK_BUFF_CLASS_NUM; i++)
+    {
+        sk_buffer_mng_init(&cls->pools[i], expired, g_sk_class_size[i]);
+    }
+}
+
+/**
+ * @brief  分级池的销毁接口
+ * @param  cls -分级池的指针
+ */
+void sk_buffer_class_destroy(TSkBuffClass* cls)
+{
+    for (uint32_t i = 0; i < SK_BUFF_CLASS_NUM; i++)
+    {
+        sk_buffer_mng_destroy(&cls->pools[i]);
+    }
+}
+
+/**
+ * @brief  获取能容纳指定大小的最小一级管理池
+ * @param  cls -分级池的指针
+ * @param  size -需要的有效数据区大小
+ * @return 管理池指针, 超过最大级别返回NULL
+ */
+TSkBuffMng* sk_buffer_class_pool(TSkBuffClass* cls, uint32_t size)
+{
+    for (uint32_t i = 0; i < SK_BUFF_CLASS_NUM; i++)
+    {
+        if (size <= cls->pools[i].size) {
+            return &cls->pools[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief  按大小申请或复用一块buff
+ * @param  cls -分级池的指针
+ * @param  size -需要的有效数据区大小
+ * @return 非NULL为成功获取的buff块指针
+ */
+TSkBuffer* alloc_sk_class_buffer(TSkBuffClass* cls, uint32_t size)
+{
+    TSkBuffMng* mng = sk_buffer_class_pool(cls, size);
+    if (NULL == mng) {
+        return new_sk_buffer(size);
+    }
+
+    return alloc_sk_buffer(mng);
+}
+
+/**
+ * @brief  释放分级申请的buff块
+ * @param  cls -分级池的指针
+ * @param  buff -待释放的buff指针
+ */
+void free_sk_class_buffer(TSkBuffClass* cls, TSkBuffer* buff)
+{
+    if (NULL == buff) {
+        return;
+    }
+
+    TSkBuffMng* mng = sk_buffer_class_pool(cls, buff->size);
+    if ((NULL == mng) || (mng->size != buff->size)) {
+        delete_sk_buffer(buff);
+        return;
+    }
+
+    free_sk_buffer(mng, buff);
+}
+
+/**
+ * @brief  回收各级过期的buff块
+ * @param  cls -分级池的指针
+ * @param  now -当前的时间, 秒级别
+ */
+void recycle_sk_class_buffer(TSkBuffClass* cls, uint32_t now)
+{
+    for (uint32_t i = 0; i < SK_BUFF_CLASS_NUM; i++)
+    {
+        recycle_sk_buffer(&cls->pools[i], now);
+    }
+}
+
+
 /**
  * @brief Cache管理链初始化
  * @param cache -管理块指针
@@ -364,6 +464,37 @@ TSkBuffer* cache_skip_first_buffer(TRWCache* cache)
 }
 
 
+/**
+ * @brief Cache头部取出指定长度数据, 作为独立的块返回
+ * @param cache -管理块指针
+ * @param cls -分级池指针, 拷贝时使用
+ * @param len -取出的长度
+ * @return 非NULL为取出的块
+ */
+TSkBuffer* cache_take_data(TRWCache* cache, TSkBuffClass* cls, uint32_t len)
+{
+    if ((NULL == cache) || (len == 0) || (len > cache->len)) {
+        return NULL;
+    }
+
+    // 1. 恰好是完整的首块, 直接摘链交出
+    TSkBuffer* first = TAILQ_FIRST(&cache->list);
+    if ((first != NULL) && (first->data_len == len))
+    {
+        return cache_skip_first_buffer(cache);
+    }
+
+    // 2. 首块的一部分或跨多块, 按实际长度取合适的块, 一次拷贝
+    TSkBuffer* buff = alloc_sk_class_buffer(cls, len);
+    if (NULL == buff) {
+        return NULL;
+    }
+    buff->data_len = cache_copy_out(cache, buff->data, len);
+
+    return buff;
+}
+
+
 /**
  * @brief Cache追加指定长度数据
  * @param cache -管理块指针
@@ -38,6 +38,9 @@ namespace NS_MICRO_THREAD {
 
 #define SK_ERR_NEED_CLOSE   10000
 
+// 分级buff池的级数, 各级大小见mt_cache.cpp
+#define SK_BUFF_CLASS_NUM   4
+
 /**
  * @brief  用户态 buffer 结构定义
  */
@@ -127,6 +130,59 @@ void free_sk_buffer(TSkBuffMng* mng, TSkBuffer* buff);
 void recycle_sk_buffer(TSkBuffMng* mng, uint32_t now);
 
 
+/**
+ * @brief  按大小分级的buffer cache, 每级一个定长的管理池
+ *         小应答使用小块, 避免每个应答都占用64K
+ */
+typedef struct _sk_buff_class_tag
+{
+    TSkBuffMng                  pools[SK_BUFF_CLASS_NUM];   // 各级的管理池, 从小到大
+} TSkBuffClass;
+
+/**
+ * @brief  分级池的初始化接口
+ * @param  cls -分级池的指针
+ * @param  expired -保活的时间, 单位秒
+ */
+void sk_buffer_class_init(TSkBuffClass* cls, uint32_t expired);
+
+/**
+ * @brief  分级池的销毁接口
+ * @param  cls -分级池的指针
+ */
+void sk_buffer_class_destroy(TSkBuffClass* cls);
+
+/**
+ * @brief  获取能容纳指定大小的最小一级管理池
+ * @param  cls -分级池的指针
+ * @param  size -需要的有效数据区大小
+ * @return 管理池指针, 超过最大级别返回NULL
+ */
+TSkBuffMng* sk_buffer_class_pool(TSkBuffClass* cls, uint32_t size);
+
+/**
+ * @brief  按大小申请或复用一块buff, 超过最大级别时单独申请
+ * @param  cls -分级池的指针
+ * @param  size -需要的有效数据区大小
+ * @return 非NULL为成功获取的buff块指针
+ */
+TSkBuffer* alloc_sk_class_buffer(TSkBuffClass* cls, uint32_t size);
+
+/**
+ * @brief  释放分级申请的buff块, 按块大小归还对应的池, 非分级大小直接释放
+ * @param  cls -分级池的指针
+ * @param  buff -待释放的buff指针
+ */
+void free_sk_class_buffer(TSkBuffClass* cls, TSkBuffer* buff);
+
+/**
+ * @brief  回收各级过期的buff块
+ * @param  cls -分级池的指针
+ * @param  now -当前的时间, 秒级别
+ */
+void recycle_sk_class_buffer(TSkBuffClass* cls, uint32_t now);
+
+
 /**
  * @brief 原始的 buffer cache 定义
  */
@@ -165,6 +221,16 @@ void cache_skip_data(TRWCache* cache, uint32_t len);
  */
 TSkBuffer* cache_skip_first_buffer(TRWCache* cache);
 
+/**
+ * @brief Cache头部取出指定长度数据, 作为独立的块返回
+ *        数据恰好占满首块时直接摘链返回, 不拷贝; 否则按长度从分级池取块, 拷贝一次
+ * @param cache -管理块指针
+ * @param cls -分级池指针, 拷贝时使用
+ * @param len -取出的长度, 需不大于cache的数据长度
+ * @return 非NULL为取出的块, 由调用者按分级池释放
+ */
+TSkBuffer* cache_take_data(TRWCache* cache, TSkBuffClass* cls, uint32_t len);
+
 
 /**
  * @brief Cache追加指定长度数据
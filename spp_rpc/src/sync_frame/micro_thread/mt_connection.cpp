@@ -810,7 +810,7 @@ int UdpSessionConn::RecvData()
  * @brief session全局管理句柄
  * @return 全局句柄指针
  */
-ConnectionMgr* ConnectionMgr::_instance = NULL;
+__thread ConnectionMgr* ConnectionMgr::_instance = NULL;
 ConnectionMgr* ConnectionMgr::Instance (void)
 {
     if (NULL == _instance)
@@ -550,7 +550,7 @@ private:
      */
     ConnectionMgr();
 
-    static ConnectionMgr * _instance;         ///< 单例类句柄 
+    static __thread ConnectionMgr * _instance;         ///< 单例类句柄 
 
     UdpShortQueue  _udp_short_queue;          ///< 短连接的队列池 
     UdpSessionQueue  _udp_session_queue;      ///< udp session 连接池
@@ -0,0 +1,443 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/**
+ *  @file mt_dns.cpp
+ *  @info 微线程域名解析实现
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include "micro_thread.h"
+#include "mt_monitor.h"
+#include "mt_sys_hook.h"
+#include "mt_dns.h"
+
+using namespace NS_MICRO_THREAD;
+
+MtDnsResolver* MtDnsResolver::_instance = NULL;
+pthread_once_t MtDnsResolver::_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief 单例初始化, 各调度线程可能同时首次使用
+ */
+void MtDnsResolver::InitInstance()
+{
+    _instance = new MtDnsResolver;
+}
+
+MtDnsResolver* MtDnsResolver::Instance()
+{
+    pthread_once(&_once, MtDnsResolver::InitInstance);
+    return _instance;
+}
+
+/**
+ * @brief 构造与析构函数
+ */
+MtDnsResolver::MtDnsResolver()
+{
+    _ttl     = MT_DNS_DFLT_TTL;
+    _neg_ttl = MT_DNS_NEG_TTL;
+    _pid     = 0;
+    pthread_mutex_init(&_cache_lock, NULL);
+    pthread_mutex_init(&_queue_lock, NULL);
+    pthread_cond_init(&_queue_cond, NULL);
+}
+
+MtDnsResolver::~MtDnsResolver()
+{
+    pthread_cond_destroy(&_queue_cond);
+    pthread_mutex_destroy(&_queue_lock);
+    pthread_mutex_destroy(&_cache_lock);
+}
+
+/**
+ * @brief 设置缓存时间
+ */
+void MtDnsResolver::SetTTL(int ttl, int neg_ttl)
+{
+    pthread_mutex_lock(&_cache_lock);
+    _ttl     = (ttl > 0) ? ttl : 0;
+    _neg_ttl = (neg_ttl > 0) ? neg_ttl : 0;
+    _cache.clear();
+    pthread_mutex_unlock(&_cache_lock);
+}
+
+/**
+ * @brief 清空缓存
+ */
+void MtDnsResolver::ClearCache()
+{
+    pthread_mutex_lock(&_cache_lock);
+    _cache.clear();
+    pthread_mutex_unlock(&_cache_lock);
+}
+
+/**
+ * @brief 启动解析线程, 调用方持有队列锁
+ */
+bool MtDnsResolver::StartThreads()
+{
+    pid_t pid = getpid();
+    if (_pid == pid) {
+        return true;
+    }
+
+    // fork前投递的请求属于父进程, 子进程中不再有解析线程处理
+    _queue.clear();
+
+    for (int i = 0; i < MT_DNS_THREAD_NUM; i++)
+    {
+        pthread_t tid;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        int ret = pthread_create(&tid, &attr, MtDnsResolver::ThreadEntry, this);
+        pthread_attr_destroy(&attr);
+        if (ret != 0)
+        {
+            MTLOG_ERROR("dns thread create failed, ret %d", ret);
+            return (i > 0);
+        }
+    }
+
+    _pid = pid;
+    return true;
+}
+
+/**
+ * @brief 解析线程入口, 该线程未设置HOOK标记, 系统解析库内部的socket调用走原始接口
+ */
+void* MtDnsResolver::ThreadEntry(void* args)
+{
+    MtDnsResolver* resolver = (MtDnsResolver*)args;
+    resolver->ThreadLoop();
+    return NULL;
+}
+
+/**
+ * @brief 解析线程主循环
+ */
+void MtDnsResolver::ThreadLoop()
+{
+    mt_hook_syscall(getaddrinfo);
+
+    while (true)
+    {
+        pthread_mutex_lock(&_queue_lock);
+        while (_queue.empty()) {
+            pthread_cond_wait(&_queue_cond, &_queue_lock);
+        }
+        MtDnsReq* req = _queue.front();
+        _queue.pop_front();
+        pthread_mutex_unlock(&_queue_lock);
+
+        req->result = NULL;
+        req->rc = mt_real_func(getaddrinfo)(req->has_node ? req->node.c_str() : NULL,
+                                            req->has_service ? req->service.c_str() : NULL,
+                                            req->has_hints ? &req->hints : NULL,
+                                            &req->result);
+        __sync_synchronize();
+        req->done = 1;
+        eventfd_write(req->evfd, 1);
+
+        ReleaseReq(req);
+    }
+
+    return;
+}
+
+/**
+ * @brief 释放请求的一个引用, 最后一个引用释放全部资源
+ */
+void MtDnsResolver::ReleaseReq(MtDnsReq* req)
+{
+    if (__sync_sub_and_fetch(&req->ref, 1) != 0) {
+        return;
+    }
+
+    mt_hook_syscall(close);
+    mt_real_func(close)(req->evfd);
+    if (req->result) {
+        freeaddrinfo(req->result);
+    }
+    delete req;
+}
+
+/**
+ * @brief 缓存键, hints中影响结果的字段都参与
+ */
+std::string MtDnsResolver::MakeKey(const char* node, const char* service, const struct addrinfo* hints)
+{
+    char tail[64];
+    if (hints) {
+        snprintf(tail, sizeof(tail), "|%d|%d|%d|%d", hints->ai_flags, hints->ai_family,
+                 hints->ai_socktype, hints->ai_protocol);
+    } else {
+        snprintf(tail, sizeof(tail), "|-");
+    }
+
+    std::string key(node);
+    key.append("|");
+    if (service) {
+        key.append(service);
+    }
+    key.append(tail);
+    return key;
+}
+
+/**
+ * @brief 查找缓存, 命中时构造结果
+ */
+bool MtDnsResolver::Lookup(const std::string& key, struct addrinfo** res, int& rc)
+{
+    bool hit = false;
+    pthread_mutex_lock(&_cache_lock);
+    std::map<std::string, MtDnsEntry>::iterator it = _cache.find(key);
+    if (it != _cache.end())
+    {
+        if (it->second.expire > time(NULL))
+        {
+            rc = (it->second.rc == 0) ? BuildAddrInfo(it->second, res) : it->second.rc;
+            hit = true;
+        }
+        else
+        {
+            _cache.erase(it);
+        }
+    }
+    pthread_mutex_unlock(&_cache_lock);
+
+    return hit;
+}
+
+/**
+ * @brief 更新缓存, 只缓存成功与域名不存在两类确定的结果
+ */
+void MtDnsResolver::Store(const std::string& key, int rc, const struct addrinfo* result)
+{
+    MtDnsEntry entry;
+    entry.rc = rc;
+    if (rc == 0)
+    {
+        for (const struct addrinfo* ai = result; ai != NULL; ai = ai->ai_next)
+        {
+            if ((NULL == ai->ai_addr) || (ai->ai_addrlen > sizeof(struct sockaddr_storage))) {
+                continue;
+            }
+
+            MtDnsAddr addr;
+            addr.family   = ai->ai_family;
+            addr.socktype = ai->ai_socktype;
+            addr.protocol = ai->ai_protocol;
+            addr.addrlen  = ai->ai_addrlen;
+            memcpy(&addr.addr, ai->ai_addr, ai->ai_addrlen);
+            entry.addrs.push_back(addr);
+
+            if (ai->ai_canonname && entry.canon.empty()) {
+                entry.canon = ai->ai_canonname;
+            }
+        }
+    }
+    else if ((rc != EAI_NONAME) && (rc != EAI_NODATA))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&_cache_lock);
+    int ttl = (rc == 0) ? _ttl : _neg_ttl;
+    if (ttl > 0)
+    {
+        time_t now = time(NULL);
+        if (_cache.size() >= MT_DNS_CACHE_MAX)
+        {
+            std::map<std::string, MtDnsEntry>::iterator it = _cache.begin();
+            while (it != _cache.end())
+            {
+                if (it->second.expire <= now) {
+                    _cache.erase(it++);
+                } else {
+                    ++it;
+                }
+            }
+            if (_cache.size() >= MT_DNS_CACHE_MAX) {
+                _cache.clear();
+            }
+        }
+
+        entry.expire = now + ttl;
+        _cache[key] = entry;
+    }
+    pthread_mutex_unlock(&_cache_lock);
+}
+
+/**
+ * @brief 由缓存条目构造addrinfo链表
+ *        每个节点与地址在同一块内存, 规范名单独申请, 与glibc布局一致, 可由freeaddrinfo释放
+ */
+int MtDnsResolver::BuildAddrInfo(const MtDnsEntry& entry, struct addrinfo** res)
+{
+    struct addrinfo* head = NULL;
+    struct addrinfo** tail = &head;
+    for (unsigned int i = 0; i < entry.addrs.size(); i++)
+    {
+        const MtDnsAddr& addr = entry.addrs[i];
+        struct addrinfo* ai = (struct addrinfo*)calloc(1, sizeof(struct addrinfo) + addr.addrlen);
+        if (NULL == ai)
+        {
+            if (head) {
+                freeaddrinfo(head);
+            }
+            return EAI_MEMORY;
+        }
+
+        ai->ai_family   = addr.family;
+        ai->ai_socktype = addr.socktype;
+        ai->ai_protocol = addr.protocol;
+        ai->ai_addrlen  = addr.addrlen;
+        ai->ai_addr     = (struct sockaddr*)(ai + 1);
+        memcpy(ai->ai_addr, &addr.addr, addr.addrlen);
+        if ((0 == i) && !entry.canon.empty()) {
+            ai->ai_canonname = strdup(entry.canon.c_str());
+        }
+
+        *tail = ai;
+        tail = &ai->ai_next;
+    }
+
+    if (NULL == head) {
+        return EAI_NONAME;
+    }
+
+    *res = head;
+    return 0;
+}
+
+/**
+ * @brief 判断是否为数字地址, 数字地址由系统接口直接转换, 不会阻塞
+ */
+static bool mt_dns_is_numeric(const char* node)
+{
+    unsigned char buf[sizeof(struct in6_addr)];
+    return (inet_pton(AF_INET, node, buf) == 1) || (inet_pton(AF_INET6, node, buf) == 1);
+}
+
+/**
+ * @brief 异步的getaddrinfo
+ */
+int MtDnsResolver::GetAddrInfo(const char* node, const char* service,
+                               const struct addrinfo* hints, struct addrinfo** res, int timeout)
+{
+    mt_hook_syscall(getaddrinfo);
+    if ((NULL == node) || ((hints != NULL) && (hints->ai_flags & AI_NUMERICHOST))
+        || mt_dns_is_numeric(node))
+    {
+        return mt_real_func(getaddrinfo)(node, service, hints, res);
+    }
+
+    int rc = 0;
+    std::string key = MakeKey(node, service, hints);
+    if (Lookup(key, res, rc))
+    {
+        MT_ATTR_API(MONITOR_MT_DNS_CACHE_HIT, 1);
+        return rc;
+    }
+
+    MtDnsReq* req = new MtDnsReq;
+    req->evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (req->evfd < 0)
+    {
+        delete req;
+        return EAI_SYSTEM;
+    }
+    req->node        = node;
+    req->has_node    = true;
+    req->has_service = (service != NULL);
+    if (service) {
+        req->service = service;
+    }
+    req->has_hints   = (hints != NULL);
+    if (hints) {
+        memset(&req->hints, 0, sizeof(req->hints));
+        req->hints.ai_flags    = hints->ai_flags;
+        req->hints.ai_family   = hints->ai_family;
+        req->hints.ai_socktype = hints->ai_socktype;
+        req->hints.ai_protocol = hints->ai_protocol;
+    }
+    req->done   = 0;
+    req->ref    = 2;
+    req->rc     = EAI_AGAIN;
+    req->result = NULL;
+
+    pthread_mutex_lock(&_queue_lock);
+    bool started = StartThreads();
+    if (started) {
+        _queue.push_back(req);
+        pthread_cond_signal(&_queue_cond);
+    }
+    pthread_mutex_unlock(&_queue_lock);
+
+    if (!started)
+    {
+        req->ref = 1;
+        ReleaseReq(req);
+        return mt_real_func(getaddrinfo)(node, service, hints, res);
+    }
+
+    MT_ATTR_API(MONITOR_MT_DNS_RESOLVE, 1);
+    if (timeout <= 0) {
+        timeout = MT_DNS_DFLT_TIMEOUT;
+    }
+
+    utime64_t start = MtFrame::Instance()->GetLastClock();
+    while (!req->done)
+    {
+        int left = timeout - (int)(MtFrame::Instance()->GetLastClock() - start);
+        if ((left <= 0) || (MtFrame::WaitEvents(req->evfd, EPOLLIN, left) <= 0)) {
+            break;
+        }
+    }
+
+    if (!req->done)
+    {
+        MT_ATTR_API(MONITOR_MT_DNS_TIMEOUT, 1);
+        MTLOG_ERROR("dns resolve %s timeout %d ms", node, timeout);
+        ReleaseReq(req);
+        return EAI_AGAIN;
+    }
+
+    __sync_synchronize();
+    rc = req->rc;
+    Store(key, rc, req->result);
+    if (rc == 0)
+    {
+        *res = req->result;     // 系统申请的链表直接交给调用者
+        req->result = NULL;
+    }
+    ReleaseReq(req);
+
+    return rc;
+}
+
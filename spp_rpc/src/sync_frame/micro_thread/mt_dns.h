@@ -0,0 +1,170 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/**
+ *  @file mt_dns.h
+ *  @info 微线程域名解析, 系统getaddrinfo会阻塞整个调度线程
+ *        解析请求投递给后台解析线程执行, 微线程在eventfd上等待结果
+ *        结果按TTL缓存在进程内, 失败结果按较短的TTL缓存, 各调度线程共享
+ */
+
+#ifndef __MT_DNS_H__
+#define __MT_DNS_H__
+
+#include <time.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+namespace NS_MICRO_THREAD {
+
+#define MT_DNS_THREAD_NUM       2           ///< 后台解析线程数
+#define MT_DNS_DFLT_TIMEOUT     5000        ///< HOOK接口的解析超时, 毫秒
+#define MT_DNS_DFLT_TTL         60          ///< 解析成功的缓存时间, 秒
+#define MT_DNS_NEG_TTL          5           ///< 域名不存在的缓存时间, 秒
+#define MT_DNS_CACHE_MAX        4096        ///< 缓存的最大条目数
+
+/**
+ * @brief 缓存的一个地址
+ */
+struct MtDnsAddr
+{
+    int                     family;
+    int                     socktype;
+    int                     protocol;
+    socklen_t               addrlen;
+    struct sockaddr_storage addr;
+};
+
+/**
+ * @brief 缓存条目, 以域名+服务+hints为键
+ */
+struct MtDnsEntry
+{
+    int                     rc;             ///< getaddrinfo返回值
+    time_t                  expire;         ///< 过期时间, 秒
+    std::string             canon;          ///< 规范名, 仅AI_CANONNAME时有效
+    std::vector<MtDnsAddr>  addrs;          ///< 地址列表, 保持系统返回的顺序
+};
+
+/**
+ * @brief 投递给解析线程的请求, 等待方与解析线程各持一个引用
+ *        等待方超时先行离开时, 由解析线程释放
+ */
+struct MtDnsReq
+{
+    std::string             node;
+    std::string             service;
+    bool                    has_node;
+    bool                    has_service;
+    bool                    has_hints;
+    struct addrinfo         hints;
+    int                     evfd;           ///< 完成通知
+    volatile int            done;           ///< 解析完成标记
+    volatile int            ref;            ///< 引用计数
+    int                     rc;             ///< 解析结果
+    struct addrinfo*        result;         ///< 解析结果链表, 系统申请
+};
+
+/**
+ * @brief 域名解析器, 进程内全局单例, 常驻不销毁
+ */
+class MtDnsResolver
+{
+public:
+
+    /**
+     * @brief 单例访问, 可在任意调度线程调用
+     */
+    static MtDnsResolver* Instance(void);
+
+    /**
+     * @brief 异步的getaddrinfo, 语义与系统接口一致
+     * @info  数字地址与无域名的请求直接走系统接口, 不会阻塞
+     *        返回的链表与系统布局一致, 由系统freeaddrinfo释放
+     * @param timeout 等待解析结果的超时, 毫秒, 超时返回EAI_AGAIN
+     * @return 0 成功, 其它为EAI_*错误码
+     */
+    int GetAddrInfo(const char* node, const char* service,
+                    const struct addrinfo* hints, struct addrinfo** res, int timeout);
+
+    /**
+     * @brief 设置缓存时间, 秒, ttl为0时不缓存
+     */
+    void SetTTL(int ttl, int neg_ttl);
+
+    /**
+     * @brief 清空缓存
+     */
+    void ClearCache(void);
+
+private:
+
+    MtDnsResolver();
+    ~MtDnsResolver();
+
+    static void InitInstance(void);
+
+    /**
+     * @brief 解析线程管理, fork后的子进程首次使用时重新启动
+     */
+    bool StartThreads(void);
+    static void* ThreadEntry(void* args);
+    void ThreadLoop(void);
+
+    /**
+     * @brief 释放请求的一个引用
+     */
+    static void ReleaseReq(MtDnsReq* req);
+
+    /**
+     * @brief 缓存的查找与更新
+     */
+    static std::string MakeKey(const char* node, const char* service, const struct addrinfo* hints);
+    bool Lookup(const std::string& key, struct addrinfo** res, int& rc);
+    void Store(const std::string& key, int rc, const struct addrinfo* result);
+
+    /**
+     * @brief 由缓存条目构造addrinfo链表
+     */
+    static int BuildAddrInfo(const MtDnsEntry& entry, struct addrinfo** res);
+
+    static MtDnsResolver*           _instance;      ///< 单例句柄
+    static pthread_once_t           _once;          ///< 单例初始化控制
+
+    pthread_mutex_t                 _cache_lock;    ///< 缓存锁
+    std::map<std::string, MtDnsEntry> _cache;       ///< 解析结果缓存
+    int                             _ttl;           ///< 成功结果的缓存时间
+    int                             _neg_ttl;       ///< 域名不存在的缓存时间
+
+    pthread_mutex_t                 _queue_lock;    ///< 请求队列锁
+    pthread_cond_t                  _queue_cond;    ///< 请求到达通知
+    std::deque<MtDnsReq*>           _queue;         ///< 待解析请求
+    pid_t                           _pid;           ///< 解析线程所属的进程
+};
+
+}
+
+#endif
+
@@ -34,7 +34,7 @@ using namespace NS_MICRO_THREAD;
  * @brief 连接管理全局访问接口
  * @return 全局句柄指针
  */
-MsgBuffPool* MsgBuffPool::_instance = NULL;
+__thread MsgBuffPool* MsgBuffPool::_instance = NULL;
 MsgBuffPool* MsgBuffPool::Instance (void)
 {
     if (NULL == _instance)
@@ -289,7 +289,7 @@ private:
      */
     explicit MsgBuffPool(int max_free = 300);
 
-    static MsgBuffPool * _instance;         ///<  单例类句柄    
+    static __thread MsgBuffPool * _instance;         ///<  单例类句柄    
     int  _max_free;                         ///<  最大保留空闲数目
     HashList* _hash_map;                    ///<  按size hashmap 保存空闲队列
 
@@ -37,6 +37,20 @@
 #define MONITOR_MT_CONNECT_FAIL     "frm.mt connect failed"         // 连接失败
 #define MONITOR_MT_SESSION_EXPIRE   "frm.mt session expired"        // udp session超时
 
+#define MONITOR_MT_PROF_SWITCH      "frm.mt switch count"           // 周期内上下文切换次数
+#define MONITOR_MT_PROF_SLICE_AVG   "frm.mt slice avg us"           // 平均运行切片
+#define MONITOR_MT_PROF_SLICE_MAX   "frm.mt slice max us"           // 最长运行切片
+#define MONITOR_MT_PROF_RUNQ_AVG    "frm.mt runq wait avg us"       // 可运行队列平均等待
+#define MONITOR_MT_PROF_IOWAIT_AVG  "frm.mt io wait avg us"         // IO平均等待
+#define MONITOR_MT_PROF_SLEEP_AVG   "frm.mt sleep avg us"           // sleep平均时长
+#define MONITOR_MT_PROF_LOOP_AVG    "frm.mt loop avg us"            // 调度循环平均间隔
+#define MONITOR_MT_PROF_LOOP_MAX    "frm.mt loop max us"            // 调度循环最长间隔
+#define MONITOR_MT_PROF_STACK_MAX   "frm.mt stack max bytes"        // 栈使用最高水位
+
+#define MONITOR_MT_DNS_RESOLVE      "frm.mt dns resolve"            // 投递后台解析
+#define MONITOR_MT_DNS_CACHE_HIT    "frm.mt dns cache hit"          // 解析缓存命中
+#define MONITOR_MT_DNS_TIMEOUT      "frm.mt dns timeout"            // 解析超时
+
 #endif
 
  
@@ -197,7 +197,7 @@ void CNetHandler::Reset()
 
     // 动态内存销毁
     if (_rsp_buff != NULL) {
-        delete_sk_buffer(_rsp_buff);
+        CNetMgr::Instance()->FreeSkBuffer(_rsp_buff);
         _rsp_buff               = NULL;
     }
 
@@ -218,6 +218,17 @@ void CNetHandler::Reset()
   
 }
 
+// 设置rsp信息, 原有的buff归还分级池
+void CNetHandler::SetRespBuff(TSkBuffer* buff)
+{
+    if (_rsp_buff != NULL) {
+        CNetMgr::Instance()->FreeSkBuffer(_rsp_buff);
+        _rsp_buff = NULL;
+    }
+
+    _rsp_buff = buff;
+}
+
 // 构造函数
 CNetHandler::CNetHandler()
 {
@@ -786,10 +797,7 @@ void CSockLink::RemoveFromList(int32_t type, CNetHandler* item)
 // 通知唤醒线程
 void CSockLink::NotifyThread(CNetHandler* item, int32_t result)
 {
-    static MtFrame* frame = NULL;
-    if (frame == NULL) {
-        frame = MtFrame::Instance();
-    }
+    MtFrame* frame = MtFrame::Instance();
     
     // 设置返回码信息 
     if (result != RC_SUCCESS)
@@ -850,9 +858,10 @@ void CSockLink::Reset()
     rw_cache_destroy(&_recv_cache);
     if (_rsp_buff != NULL)
     {
-        delete_sk_buffer(_rsp_buff);
+        CNetMgr::Instance()->FreeSkBuffer(_rsp_buff);
         _rsp_buff = NULL;
     }
+    _rsp_need       = 0;
 
     // 清理等待队列, 唤醒等待线程
     TAILQ_INIT(&_wait_connect);
@@ -875,6 +884,7 @@ CSockLink::CSockLink()
 {
     rw_cache_init(&_recv_cache, NULL);
     _rsp_buff       = NULL;
+    _rsp_need       = 0;
 
     TAILQ_INIT(&_wait_connect);
     TAILQ_INIT(&_wait_send);
@@ -1258,24 +1268,47 @@ int32_t CSockLink::RecvDispath()
     }
 }
 
-// 尝试接收更多的数据到临时buff
-void CSockLink::ExtendRecvRsp()
+// 应答跨块时, 按期望长度一次聚合到临时buff, 聚合前数据留在接收链上不做拷贝
+bool CSockLink::ExtendRecvRsp()
 {
+    uint32_t want = (_rsp_need < _recv_cache.len) ? _rsp_need : _recv_cache.len;
+    if ((_rsp_buff != NULL) && (_rsp_buff->size < want))
+    {
+        CNetMgr::Instance()->FreeSkBuffer(_rsp_buff);
+        _rsp_buff = NULL;
+    }
+
     if (NULL == _rsp_buff)
     {
-        // buff初次分配, 如果太大, 会导致重复的拷贝; 如果太小, 会导致2次check检查
-        // 权衡一下, 暂定500字节左右, 大部分场景, 可以收全, 浪费不多, 小部分场景
-        // 需要realloc, 但500字节拷贝负担也不大
-        _rsp_buff = new_sk_buffer(512);
+        _rsp_buff = CNetMgr::Instance()->AllocSkBuffer(want);
         if (NULL == _rsp_buff) 
         {
             MTLOG_ERROR("no more memory, error");
-            return;
+            return false;
         }
     }
     
-    _rsp_buff->data_len +=  read_cache_begin(&_recv_cache, _rsp_buff->data_len, 
-        _rsp_buff->data + _rsp_buff->data_len , _rsp_buff->size - _rsp_buff->data_len);
+    _rsp_buff->data_len = read_cache_begin(&_recv_cache, 0, _rsp_buff->data, want);
+    return true;
+}
+
+// 从接收链上取出一个完整应答, 已聚合则复用聚合buff, 否则整块摘链或按长度拷贝一次
+TSkBuffer* CSockLink::TakeRecvRsp(uint32_t len)
+{
+    TSkBuffer* rsp = _rsp_buff;
+    if (rsp != NULL)
+    {
+        cache_skip_data(&_recv_cache, len);
+        rsp->data_len = len;
+        _rsp_buff = NULL;
+    }
+    else
+    {
+        rsp = cache_take_data(&_recv_cache, CNetMgr::Instance()->GetSkBuffClass(), len);
+    }
+    _rsp_need = 0;
+
+    return rsp;
 }
 
 // 或者回调函数, 优先从排队等待中获取, 备份从父节点获取
@@ -1336,18 +1369,37 @@ int32_t CSockLink::DispathTcp()
     uint32_t need_len = 0;
     uint64_t sid = 0;
     int32_t ret = 0;
+    uint8_t* data = NULL;
+    uint32_t data_len = 0;
     while (_recv_cache.len > 0)
     {
-        this->ExtendRecvRsp();
-        if (NULL == _rsp_buff)
+        // 1. 已知期望长度但数据未到齐, 留在接收链上继续等待
+        if (_rsp_need > _recv_cache.len)
         {
-            MTLOG_ERROR("alloc memory, error");
-            _errno = RC_MEM_ERROR;
-            return -3;
+            MTLOG_DEBUG("maybe need wait more data, now %u, need %u", _recv_cache.len, _rsp_need);
+            return 0;
+        }
+
+        // 2. 首块足够时原地解析, 否则按期望长度聚合一次
+        TSkBuffer* first = TAILQ_FIRST(&_recv_cache.list);
+        if ((NULL == _rsp_buff) && (first->data_len >= _rsp_need))
+        {
+            data     = first->data;
+            data_len = first->data_len;
+        }
+        else
+        {
+            if (!this->ExtendRecvRsp())
+            {
+                _errno = RC_MEM_ERROR;
+                return -3;
+            }
+            data     = _rsp_buff->data;
+            data_len = _rsp_buff->data_len;
         }
 
         need_len = 0;
-        ret = check_session(_rsp_buff->data, _rsp_buff->data_len, &sid, &need_len);
+        ret = check_session(data, data_len, &sid, &need_len);
         
         if (ret < 0)
         {
@@ -1358,37 +1410,22 @@ int32_t CSockLink::DispathTcp()
 
         if (ret == 0)
         {
-            // 1. 用户如果不指定长度, 默认2倍扩展, 性能会受影响
-            if ((need_len == 0) && (_rsp_buff->data_len == _rsp_buff->size))
+            // 1. 用户如果不指定长度, 解析范围外还有数据时聚合全部已收数据, 性能会受影响
+            if ((need_len == 0) && (data_len < _recv_cache.len))
             {
-                MTLOG_DEBUG("recv default buff full[%u], but user no set need length", _rsp_buff->size);
-                need_len = _rsp_buff->size * 2;
+                MTLOG_DEBUG("recv data span buff[%u], but user no set need length", data_len);
+                need_len = _recv_cache.len;
             }
         
-            // 2. 若还剩余空间, 则继续等待接收; 期望空间超长, 不予接收
-            if ((need_len <= _rsp_buff->size) || (need_len > 100*1024*1024))
+            // 2. 已解析范围满足期望仍不完整, 则继续等待接收; 期望空间超长, 不予接收
+            if ((need_len <= data_len) || (need_len > 100*1024*1024))
             {
                 MTLOG_DEBUG("maybe need wait more data: %u", need_len);
                 return 0;
             }
 
-            // 3. 扩展buff长度, 准备再尝试一次
-            _rsp_buff = reserve_sk_buffer(_rsp_buff, need_len);
-            if (NULL == _rsp_buff)
-            {
-                MTLOG_ERROR("no more memory, error");
-                _errno = RC_MEM_ERROR;
-                return -3;
-            }
-
-            // 4. 已经无多余的数据信息, 等待继续收包
-            if (_rsp_buff->data_len >= _recv_cache.len)
-            {
-                MTLOG_DEBUG("maybe need wait more data, now %u", _recv_cache.len);
-                return 0;
-            }
-
-            // 5. 继续拷贝数据, 尝试解析
+            // 3. 记录期望长度, 数据到齐后再聚合解析
+            _rsp_need = need_len;
             continue;
         }
 
@@ -1405,18 +1442,26 @@ int32_t CSockLink::DispathTcp()
         {
             MTLOG_DEBUG("session id %llu, find failed, maybe timeout", sid);
             cache_skip_data(&_recv_cache, ret);
-            delete_sk_buffer(_rsp_buff);
-            _rsp_buff = NULL;
+            if (_rsp_buff != NULL)
+            {
+                CNetMgr::Instance()->FreeSkBuffer(_rsp_buff);
+                _rsp_buff = NULL;
+            }
+            _rsp_need = 0;
         }
         else
         {
             MTLOG_DEBUG("session id %llu, find ok, wakeup it", sid);
-            cache_skip_data(&_recv_cache, ret);
+            TSkBuffer* rsp = this->TakeRecvRsp(ret);
+            if (NULL == rsp)
+            {
+                MTLOG_ERROR("no more memory, error");
+                _errno = RC_MEM_ERROR;
+                return -3;
+            }
             this->NotifyThread(session, 0);
             session->SwitchToIdle();
-            _rsp_buff->data_len = ret;  //TCP实际有效的报文长度变更
-            session->SetRespBuff(_rsp_buff);
-            _rsp_buff = NULL;
+            session->SetRespBuff(rsp);
         }
     }
 
@@ -1782,7 +1827,7 @@ void CDestLinks::timer_notify()
  * @brief session全局管理句柄
  * @return 全局句柄指针
  */
-CNetMgr* CNetMgr::_instance = NULL;
+__thread CNetMgr* CNetMgr::_instance = NULL;
 CNetMgr* CNetMgr::Instance (void)
 {
     if (NULL == _instance)
@@ -1923,8 +1968,7 @@ void CNetMgr::DeleteDestLink(CDestLinks* dst)
 // 构造函数实现
 CNetMgr::CNetMgr()
 {
-    sk_buffer_mng_init(&_tcp_pool, 60, 4096);
-    sk_buffer_mng_init(&_udp_pool, 60, SK_DFLT_BUFF_SIZE);
+    sk_buffer_class_init(&_buff_class, 60);
 
     _ip_hash = new HashList(100000);
     _session_hash = new HashList(100000);
@@ -1963,8 +2007,7 @@ CNetMgr::~CNetMgr()
     }
 
     // 回收buff池资源
-    sk_buffer_mng_destroy(&_tcp_pool);
-    sk_buffer_mng_destroy(&_udp_pool);
+    sk_buffer_class_destroy(&_buff_class);
 }
 
 
@@ -1975,8 +2018,7 @@ void CNetMgr::RecycleObjs(uint64_t now)
 {
     uint32_t now_s = (uint32_t)(now / 1000);
     
-    recycle_sk_buffer(&_udp_pool, now_s);
-    recycle_sk_buffer(&_tcp_pool, now_s);
+    recycle_sk_class_buffer(&_buff_class, now_s);
     
     _net_item_pool.RecycleItem(now);
     _sock_link_pool.RecycleItem(now);
@@ -186,15 +186,8 @@ public:
         }
     };
     
-    // 设置rsp信息
-    void SetRespBuff(TSkBuffer* buff) {
-        if (_rsp_buff != NULL) {
-            delete_sk_buffer(_rsp_buff);
-            _rsp_buff = NULL;
-        }
-        
-        _rsp_buff = buff;
-    };
+    // 设置rsp信息, 原有的buff归还分级池
+    void SetRespBuff(TSkBuffer* buff);
 
     // 设置协议的类型, 默认UDP
     void SetProtoType(MT_PROTO_TYPE type) {
@@ -381,8 +374,11 @@ public:
     // tcp发送数据
     int32_t SendCacheTcp(void* data, uint32_t len);
 
-    // 尝试接收更多的数据到临时buff
-    void ExtendRecvRsp();
+    // 应答跨块时, 按期望长度一次聚合到临时buff
+    bool ExtendRecvRsp();
+
+    // 从接收链上取出一个完整应答
+    TSkBuffer* TakeRecvRsp(uint32_t len);
 
     // 数据分发处理过程
     int32_t RecvDispath();
@@ -468,7 +464,8 @@ private:
     uint32_t            _state;
     uint64_t            _last_access;
     TRWCache            _recv_cache;
-    TSkBuffer*          _rsp_buff;
+    TSkBuffer*          _rsp_buff;          ///< 跨块应答的聚合buff
+    uint32_t            _rsp_need;          ///< 当前应答期望的长度, 0 未知
     void*               _parents;
 };
 typedef TAILQ_HEAD(__SocklinkList, CSockLink) TLinkList;  ///< 高效的双链管理 
@@ -681,14 +678,27 @@ public:
         return _dest_ip_pool.FreeItem(item);
     };
 
-    // 获取udp的buff池信息
+    // 获取接收链使用的buff池信息, tcp 4K, udp 64K, 均属于分级池
     TSkBuffMng* GetSkBuffMng(MT_PROTO_TYPE type) {
         if (type == NET_PROTO_TCP) {
-            return &_tcp_pool;
+            return sk_buffer_class_pool(&_buff_class, 4*1024);
         } else {
-            return &_udp_pool;
+            return sk_buffer_class_pool(&_buff_class, SK_DFLT_BUFF_SIZE);
         }
     };
+
+    // 获取分级buff池
+    TSkBuffClass* GetSkBuffClass() {
+        return &_buff_class;
+    };
+
+    // 按大小申请与释放buff, 应答buff统一由此释放
+    TSkBuffer* AllocSkBuffer(uint32_t size) {
+        return alloc_sk_class_buffer(&_buff_class, size);
+    };
+    void FreeSkBuffer(TSkBuffer* buff) {
+        free_sk_class_buffer(&_buff_class, buff);
+    };
     
 
 private:
@@ -697,11 +707,10 @@ private:
      */
     CNetMgr();
 
-    static CNetMgr *    _instance;          ///< 单例类句柄 
+    static __thread CNetMgr * _instance;          ///< 单例类句柄 
     HashList*           _ip_hash;           ///< 目的地址hash
     HashList*           _session_hash;      ///< session id的hash
-    TSkBuffMng          _udp_pool;          ///< udp pool, 64K
-    TSkBuffMng          _tcp_pool;          ///< tcp pool, 4K
+    TSkBuffClass        _buff_class;        ///< 分级buff池, 512B/4K/16K/64K
     TDestPool           _dest_ip_pool;      ///< 目的ip对象池
     TLinkPool           _sock_link_pool;    ///< socket pool
     TNetItemPool        _net_item_pool;     ///< net handle pool
@@ -405,7 +405,7 @@ void TcpKeepNtfy::KeepaliveClose()
  * @brief session全局管理句柄
  * @return 全局句柄指针
  */
-NtfyObjMgr* NtfyObjMgr::_instance = NULL;
+__thread NtfyObjMgr* NtfyObjMgr::_instance = NULL;
 NtfyObjMgr* NtfyObjMgr::Instance (void)
 {
     if (NULL == _instance)
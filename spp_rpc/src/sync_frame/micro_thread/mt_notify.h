@@ -553,7 +553,7 @@ private:
      */
     NtfyObjMgr();
 
-    static NtfyObjMgr * _instance;         ///<  单例类句柄
+    static __thread NtfyObjMgr * _instance;         ///<  单例类句柄
     SessionMap _session_map;               ///<  全局的注册session管理
     NtfyThreadQueue  _fd_ntfy_pool;        ///<  fd通知对象
     NtfySessionQueue _udp_proxy_pool;      ///<  fd通知对象
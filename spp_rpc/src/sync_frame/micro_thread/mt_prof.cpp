@@ -0,0 +1,215 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/**
+ *  @file mt_prof.cpp
+ *  @info 微线程调度剖析实现
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "micro_thread.h"
+#include "mt_monitor.h"
+#include "mt_prof.h"
+
+using namespace NS_MICRO_THREAD;
+
+/**
+ * @brief 构造函数
+ */
+MtProfiler::MtProfiler()
+{
+    _on          = false;
+    _sample      = 0;
+    _sample_cnt  = 0;
+    _stack_cnt   = 0;
+    _report_time = 0;
+    _trace       = NULL;
+    _trace_pos   = 0;
+    memset(&_stat, 0, sizeof(_stat));
+}
+
+/**
+ * @brief 析构函数
+ */
+MtProfiler::~MtProfiler()
+{
+    if (_trace) {
+        free(_trace);
+        _trace = NULL;
+    }
+}
+
+/**
+ * @brief 打开或关闭剖析, 打开时清空上一轮统计
+ */
+void MtProfiler::Enable(bool on, int sample)
+{
+    if (on && !_on)
+    {
+        uint64_t switch_cnt = _stat.switch_cnt;
+        memset(&_stat, 0, sizeof(_stat));
+        _stat.switch_cnt = switch_cnt;
+        _report_time = NowUS() / 1000;
+    }
+
+    _on = on;
+    _sample = (sample > 0) ? (unsigned int)sample : 0;
+    _sample_cnt = 0;
+
+    if (on && (NULL == _trace))
+    {
+        _trace = (MtProfTrace*)calloc(MT_PROF_TRACE_NUM, sizeof(MtProfTrace));
+        _trace_pos = 0;
+    }
+}
+
+/**
+ * @brief 写入一条明细记录
+ */
+void MtProfiler::AddTrace(int type, void* entry, uint64_t cost, uint64_t now)
+{
+    if (NULL == _trace) {
+        return;
+    }
+
+    MtProfTrace* rec = &_trace[_trace_pos % MT_PROF_TRACE_NUM];
+    rec->time_us = now;
+    rec->entry   = entry;
+    rec->cost_us = (cost > 0xFFFFFFFFULL) ? 0xFFFFFFFF : (uint32_t)cost;
+    rec->type    = type;
+    _trace_pos++;
+}
+
+/**
+ * @brief 业务微线程一次运行切片结束
+ */
+void MtProfiler::AddSlice(void* entry, uint64_t cost, uint64_t now)
+{
+    _stat.slice_cnt++;
+    _stat.run_us += cost;
+    if (cost > _stat.slice_max_us)
+    {
+        _stat.slice_max_us    = cost;
+        _stat.slice_max_entry = entry;
+    }
+
+    // 慢切片总是记录, 其余按采样间隔记录
+    if (cost >= MT_PROF_SLOW_SLICE) {
+        AddTrace(MT_PROF_TRACE_SLICE, entry, cost, now);
+    } else if (_sample && ((++_sample_cnt % _sample) == 0)) {
+        AddTrace(MT_PROF_TRACE_SLICE, entry, cost, now);
+    }
+}
+
+/**
+ * @brief 一轮调度循环结束
+ */
+void MtProfiler::AddLoop(uint64_t cost, uint64_t now)
+{
+    _stat.loop_cnt++;
+    _stat.loop_us += cost;
+    if (cost > _stat.loop_max_us) {
+        _stat.loop_max_us = cost;
+    }
+
+    if (cost >= MT_PROF_SLOW_SLICE) {
+        AddTrace(MT_PROF_TRACE_LOOP, NULL, cost, now);
+    }
+}
+
+/**
+ * @brief 获取统计快照
+ */
+void MtProfiler::Snapshot(MtSchedStat& stat, bool reset)
+{
+    stat = _stat;
+    if (reset) {
+        memset(&_stat, 0, sizeof(_stat));
+    }
+}
+
+/**
+ * @brief 定时上报上一周期的统计, 上报后清零
+ */
+void MtProfiler::Report(uint64_t now)
+{
+    if (!_on || ((now - _report_time) < MT_PROF_REPORT_INTERVAL)) {
+        return;
+    }
+    _report_time = now;
+
+    MtSchedStat stat;
+    Snapshot(stat, true);
+
+    MT_ATTR_API_SET(MONITOR_MT_PROF_SWITCH, (int)stat.switch_cnt);
+    MT_ATTR_API_SET(MONITOR_MT_PROF_SLICE_AVG, mt_prof_avg(stat.run_us, stat.slice_cnt));
+    MT_ATTR_API_SET(MONITOR_MT_PROF_SLICE_MAX, (int)stat.slice_max_us);
+    MT_ATTR_API_SET(MONITOR_MT_PROF_RUNQ_AVG, mt_prof_avg(stat.runq_us, stat.runq_cnt));
+    MT_ATTR_API_SET(MONITOR_MT_PROF_IOWAIT_AVG, mt_prof_avg(stat.iowait_us, stat.iowait_cnt));
+    MT_ATTR_API_SET(MONITOR_MT_PROF_SLEEP_AVG, mt_prof_avg(stat.sleep_us, stat.sleep_cnt));
+    MT_ATTR_API_SET(MONITOR_MT_PROF_LOOP_AVG, mt_prof_avg(stat.loop_us, stat.loop_cnt));
+    MT_ATTR_API_SET(MONITOR_MT_PROF_LOOP_MAX, (int)stat.loop_max_us);
+    MT_ATTR_API_SET(MONITOR_MT_PROF_STACK_MAX, (int)stat.stack_max);
+
+    MtFrame* frame = MtFrame::Instance();
+    if (frame->GetLogAdpt()) {
+        frame->GetLogAdpt()->SchedStatReport(stat);
+    }
+
+    if (stat.slice_max_us >= MT_PROF_SLOW_SLICE)
+    {
+        MTLOG_TRACE("slow slice %llu us, entry %p, loop max %llu us",
+                    (unsigned long long)stat.slice_max_us, stat.slice_max_entry,
+                    (unsigned long long)stat.loop_max_us);
+    }
+}
+
+/**
+ * @brief 切片明细落地文件, 按时间先后输出
+ */
+int MtProfiler::DumpTrace(const char* file)
+{
+    if ((NULL == _trace) || (NULL == file)) {
+        return -1;
+    }
+    if (0 == _trace_pos) {
+        return 0;
+    }
+
+    FILE* fp = fopen(file, "a");
+    if (NULL == fp) {
+        return -2;
+    }
+
+    unsigned int num = (_trace_pos > MT_PROF_TRACE_NUM) ? MT_PROF_TRACE_NUM : _trace_pos;
+    unsigned int start = _trace_pos - num;
+    for (unsigned int i = 0; i < num; i++)
+    {
+        MtProfTrace* rec = &_trace[(start + i) % MT_PROF_TRACE_NUM];
+        fprintf(fp, "%llu %s %p %u\n", (unsigned long long)rec->time_us,
+                (rec->type == MT_PROF_TRACE_LOOP) ? "loop" : "slice",
+                rec->entry, rec->cost_us);
+    }
+    fclose(fp);
+
+    _trace_pos = 0;
+    return (int)num;
+}
+
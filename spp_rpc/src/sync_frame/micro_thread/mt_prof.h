@@ -0,0 +1,227 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/**
+ *  @file mt_prof.h
+ *  @info 微线程调度剖析, 统计切换次数, 运行切片, 各等待状态耗时, 调度循环时延, 栈水位
+ *        默认关闭, 关闭时只累加切换次数; 打开后每次状态迁移取一次微秒时钟
+ *        统计结果定时以属性方式上报, 可选按采样记录切片明细, 按需落地文件
+ */
+
+#ifndef __MT_PROF_H__
+#define __MT_PROF_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/time.h>
+
+namespace NS_MICRO_THREAD {
+
+#define MT_PROF_TRACE_NUM       4096        ///< 切片明细环形缓冲的记录数
+#define MT_PROF_SLOW_SLICE      10000       ///< 慢切片阈值, 微秒, 超过则总是记录明细
+#define MT_PROF_STACK_SAMPLE    64          ///< 每回收多少个微线程采样一次栈水位
+#define MT_PROF_REPORT_INTERVAL 1000        ///< 统计上报间隔, 毫秒
+
+/**
+ * @brief 调度统计汇总, 时间单位均为微秒
+ */
+struct MtSchedStat
+{
+    uint64_t    switch_cnt;         ///< 上下文切换次数
+    uint64_t    slice_cnt;          ///< 业务微线程运行切片数
+    uint64_t    run_us;             ///< 业务微线程运行总耗时
+    uint64_t    slice_max_us;       ///< 最长的单次运行切片
+    void*       slice_max_entry;    ///< 最长切片所属微线程的入口函数
+    uint64_t    runq_cnt;           ///< 从可运行队列调度的次数
+    uint64_t    runq_us;            ///< 可运行队列中等待的总耗时
+    uint64_t    iowait_cnt;         ///< IO等待结束的次数
+    uint64_t    iowait_us;          ///< IO等待的总耗时
+    uint64_t    sleep_cnt;          ///< 主动sleep结束的次数
+    uint64_t    sleep_us;           ///< 主动sleep的总耗时
+    uint64_t    pend_cnt;           ///< 等待子线程结束的次数
+    uint64_t    pend_us;            ///< 等待子线程的总耗时
+    uint64_t    loop_cnt;           ///< 调度循环轮次, 即守护线程被调度的次数
+    uint64_t    loop_us;            ///< 两次epoll之间业务占用的总耗时
+    uint64_t    loop_max_us;        ///< 两次epoll之间的最长间隔, 即事件处理的最大时延
+    uint64_t    daemon_us;          ///< 守护线程耗时, 含epoll等待与超时处理
+    uint32_t    stack_max;          ///< 采样到的栈使用最高水位, 字节
+};
+
+/**
+ * @brief 平均值计算, 避免除零
+ */
+static inline int mt_prof_avg(uint64_t total, uint64_t cnt)
+{
+    return cnt ? (int)(total / cnt) : 0;
+}
+
+/**
+ * @brief 切片明细记录类型
+ */
+enum MT_PROF_TRACE_TYPE
+{
+    MT_PROF_TRACE_SLICE     = 1,    ///< 业务微线程运行切片
+    MT_PROF_TRACE_LOOP      = 2,    ///< 调度循环间隔超过慢切片阈值
+};
+
+/**
+ * @brief 切片明细记录
+ */
+struct MtProfTrace
+{
+    uint64_t    time_us;            ///< 记录时间, 微秒
+    void*       entry;              ///< 微线程入口函数, 可用addr2line定位
+    uint32_t    cost_us;            ///< 耗时, 微秒
+    uint32_t    type;               ///< 记录类型, 见MT_PROF_TRACE_TYPE
+};
+
+/**
+ * @brief 调度剖析器, 每个MtFrame一个, 只在所属调度线程内访问
+ */
+class MtProfiler
+{
+public:
+
+    /**
+     * @brief 构造与析构函数
+     */
+    MtProfiler();
+    ~MtProfiler();
+
+    /**
+     * @brief 打开或关闭剖析
+     * @param on 是否打开
+     * @param sample 切片明细采样间隔, 每sample个切片记录一个, 0 只记录慢切片
+     */
+    void Enable(bool on, int sample = 0);
+
+    /**
+     * @brief 是否打开剖析
+     */
+    bool IsOn(void) {
+        return _on;
+    };
+
+    /**
+     * @brief 剖析使用的微秒时钟
+     */
+    static uint64_t NowUS(void) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return (tv.tv_sec * 1000000ULL + tv.tv_usec);
+    };
+
+    /**
+     * @brief 切换计数, 关闭时也累加
+     */
+    void AddSwitch(void) {
+        _stat.switch_cnt++;
+    };
+
+    /**
+     * @brief 各状态耗时的累加
+     */
+    void AddRunq(uint64_t cost) {
+        _stat.runq_cnt++;
+        _stat.runq_us += cost;
+    };
+    void AddIoWait(uint64_t cost) {
+        _stat.iowait_cnt++;
+        _stat.iowait_us += cost;
+    };
+    void AddSleep(uint64_t cost) {
+        _stat.sleep_cnt++;
+        _stat.sleep_us += cost;
+    };
+    void AddPend(uint64_t cost) {
+        _stat.pend_cnt++;
+        _stat.pend_us += cost;
+    };
+    void AddDaemon(uint64_t cost) {
+        _stat.daemon_us += cost;
+    };
+
+    /**
+     * @brief 业务微线程一次运行切片结束
+     * @param entry 微线程入口函数
+     * @param cost 切片耗时
+     * @param now 当前时间
+     */
+    void AddSlice(void* entry, uint64_t cost, uint64_t now);
+
+    /**
+     * @brief 一轮调度循环结束, 守护线程重新获得CPU
+     * @param cost 距上次守护线程让出CPU的间隔
+     * @param now 当前时间
+     */
+    void AddLoop(uint64_t cost, uint64_t now);
+
+    /**
+     * @brief 栈水位采样, 返回是否需要本次采样
+     */
+    bool NeedStackSample(void) {
+        return ((++_stack_cnt % MT_PROF_STACK_SAMPLE) == 0);
+    };
+    void AddStack(uint32_t used) {
+        if (used > _stat.stack_max) {
+            _stat.stack_max = used;
+        }
+    };
+
+    /**
+     * @brief 获取统计快照
+     * @param stat 输出的统计
+     * @param reset 是否在读取后清零
+     */
+    void Snapshot(MtSchedStat& stat, bool reset);
+
+    /**
+     * @brief 定时将上一周期的统计以属性方式上报, 由守护线程驱动
+     * @param now 当前时间, 毫秒
+     */
+    void Report(uint64_t now);
+
+    /**
+     * @brief 切片明细落地文件, 按时间先后输出
+     * @param file 文件名, 追加写入
+     * @return >=0 输出的记录数, <0 失败
+     */
+    int DumpTrace(const char* file);
+
+private:
+
+    /**
+     * @brief 写入一条明细记录, 缓冲满后覆盖最老的
+     */
+    void AddTrace(int type, void* entry, uint64_t cost, uint64_t now);
+
+    bool            _on;            ///< 剖析开关
+    unsigned int    _sample;        ///< 明细采样间隔
+    unsigned int    _sample_cnt;    ///< 采样计数
+    unsigned int    _stack_cnt;     ///< 栈采样计数
+    uint64_t        _report_time;   ///< 上次上报时间, 毫秒
+    MtSchedStat     _stat;          ///< 当前周期的统计
+    MtProfTrace*    _trace;         ///< 明细环形缓冲, 打开采样时按需申请
+    unsigned int    _trace_pos;     ///< 下一个写入位置, 单调递增
+};
+
+}
+
+#endif
+
@@ -0,0 +1,407 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/**
+ *  @file mt_sched_group.cpp
+ *  @info 微线程M:N调度组实现
+ */
+
+#include <sys/eventfd.h>
+#include "mt_sched_group.h"
+#include "mt_sys_hook.h"
+
+using namespace NS_MICRO_THREAD;
+
+/**
+ * @brief 调度线程构造函数
+ */
+MtSchedWorker::MtSchedWorker(MtSchedGroup* group, int index)
+{
+    _group    = group;
+    _index    = index;
+    _started  = false;
+    _evfd     = -1;
+    _ready    = 0;
+    _idle     = 0;
+    _task_num = 0;
+    pthread_mutex_init(&_lock, NULL);
+}
+
+/**
+ * @brief 调度线程析构函数
+ */
+MtSchedWorker::~MtSchedWorker()
+{
+    if (_evfd >= 0) {
+        ::close(_evfd);
+        _evfd = -1;
+    }
+    pthread_mutex_destroy(&_lock);
+}
+
+/**
+ * @brief 启动OS线程
+ */
+bool MtSchedWorker::Start()
+{
+    _evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_evfd < 0) {
+        return false;
+    }
+
+    if (pthread_create(&_tid, NULL, MtSchedWorker::ThreadEntry, this) != 0) {
+        return false;
+    }
+
+    _started = true;
+    while (0 == _ready) {
+        usleep(1000);
+    }
+
+    return (_ready > 0);
+}
+
+/**
+ * @brief 等待OS线程退出
+ */
+void MtSchedWorker::Join()
+{
+    if (_started) {
+        pthread_join(_tid, NULL);
+        _started = false;
+    }
+}
+
+/**
+ * @brief 本线程队尾压入任务
+ */
+void MtSchedWorker::PushTask(const MtSchedTask& task)
+{
+    pthread_mutex_lock(&_lock);
+    _tasks.push_back(task);
+    _task_num++;
+    pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * @brief 本线程从队尾取任务
+ */
+bool MtSchedWorker::PopTask(MtSchedTask& task)
+{
+    if (_task_num <= 0) {       // 无锁预判, 空队列不竞争锁
+        return false;
+    }
+
+    bool ret = false;
+    pthread_mutex_lock(&_lock);
+    if (!_tasks.empty()) {
+        task = _tasks.back();
+        _tasks.pop_back();
+        _task_num--;
+        ret = true;
+    }
+    pthread_mutex_unlock(&_lock);
+
+    return ret;
+}
+
+/**
+ * @brief 其它线程从队首窃取任务, 与本线程取的方向相反, 减少冲突
+ */
+bool MtSchedWorker::StealTask(MtSchedTask& task)
+{
+    if (_task_num <= 0) {
+        return false;
+    }
+
+    bool ret = false;
+    if (pthread_mutex_trylock(&_lock) != 0) {   // 对方忙, 换一个目标
+        return false;
+    }
+    if (!_tasks.empty()) {
+        task = _tasks.front();
+        _tasks.pop_front();
+        _task_num--;
+        ret = true;
+    }
+    pthread_mutex_unlock(&_lock);
+
+    return ret;
+}
+
+/**
+ * @brief 唤醒空闲等待中的调度线程
+ */
+void MtSchedWorker::Wakeup()
+{
+    eventfd_write(_evfd, 1);
+}
+
+/**
+ * @brief OS线程入口, 初始化本线程私有的框架实例
+ */
+void* MtSchedWorker::ThreadEntry(void* args)
+{
+    MtSchedWorker* worker = (MtSchedWorker*)args;
+    MtSchedGroup::_curr_worker = worker;
+
+    MtFrame* frame = MtFrame::Instance();
+    if (!frame->InitFrame(NULL, worker->_group->GetMaxThreadNum(), worker->_group->GetIoBackend()))
+    {
+        MTLOG_ERROR("sched worker %d init frame failed", worker->_index);
+        worker->_ready = -1;
+        return NULL;
+    }
+
+    if (worker->_group->GetHookFlag()) {
+        frame->SetHookFlag();
+    }
+    worker->_ready = 1;
+
+    worker->Loop();
+
+    frame->Destroy();
+    MtSchedGroup::_curr_worker = NULL;
+
+    return NULL;
+}
+
+/**
+ * @brief 调度主循环, 运行在原生微线程上, 每轮启动一批任务后让出CPU
+ */
+void MtSchedWorker::Loop()
+{
+    MtFrame* frame = MtFrame::Instance();
+    MtSchedTask task;
+
+    while (_group->IsRunning())
+    {
+        int num = 0;
+        bool overload = false;
+        while (num < MT_SCHED_BATCH_NUM)
+        {
+            if (!PopTask(task) && !_group->Steal(_index, task)) {
+                break;
+            }
+
+            if (NULL == MtFrame::CreateThread(task.entry, task.args)) {
+                PushTask(task);     // 微线程数已到上限, 放回等待, 可被其它线程窃取
+                overload = true;
+                break;
+            }
+            num++;
+        }
+
+        if ((num > 0) && !overload) {
+            MtFrame::sleep(0);
+            continue;
+        }
+
+        // 无事可做, 在eventfd上等待投递唤醒, 期间其它微线程正常调度
+        _idle = 1;
+        __sync_synchronize();
+        if ((_task_num == 0) || overload) {
+            MtFrame::WaitEvents(_evfd, EPOLLIN, MT_SCHED_IDLE_WAIT);
+        }
+        _idle = 0;
+
+        eventfd_t val;
+        eventfd_read(_evfd, &val);
+    }
+
+    MTLOG_DEBUG("sched worker %d exit, used thread %d", _index, frame->GetUsedNum());
+}
+
+
+/**
+ * @brief 调度组全局句柄
+ */
+MtSchedGroup* MtSchedGroup::_instance = NULL;
+__thread MtSchedWorker* MtSchedGroup::_curr_worker = NULL;
+
+MtSchedGroup* MtSchedGroup::Instance()
+{
+    if (NULL == _instance)
+    {
+        _instance = new MtSchedGroup;
+    }
+
+    return _instance;
+}
+
+/**
+ * @brief 调度组全局销毁接口
+ */
+void MtSchedGroup::Destroy()
+{
+    if (_instance != NULL)
+    {
+        delete _instance;
+        _instance = NULL;
+    }
+}
+
+/**
+ * @brief 构造与析构函数
+ */
+MtSchedGroup::MtSchedGroup()
+{
+    _running        = 0;
+    _rr_index       = 0;
+    _max_thread_num = 50000;
+    _io_backend     = MT_IO_BACKEND_EPOLL;
+    _hook_flag      = false;
+}
+
+MtSchedGroup::~MtSchedGroup()
+{
+    Stop();
+}
+
+/**
+ * @brief 启动调度组
+ */
+bool MtSchedGroup::Start(int worker_num, int max_thread_num, int io_backend)
+{
+    if (_running) {
+        return true;
+    }
+
+    if (worker_num <= 0) {
+        worker_num = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (worker_num <= 0) {
+        worker_num = 1;
+    }
+    if (worker_num > MT_SCHED_MAX_WORKER) {
+        worker_num = MT_SCHED_MAX_WORKER;
+    }
+
+    _max_thread_num = max_thread_num;
+    _io_backend     = io_backend;
+    _hook_flag      = mt_hook_active();
+    _running        = 1;
+
+    // 先建好全部对象再启动, 运行中的调度线程会遍历列表窃取任务
+    for (int i = 0; i < worker_num; i++)
+    {
+        _workers.push_back(new MtSchedWorker(this, i));
+    }
+
+    for (int i = 0; i < worker_num; i++)
+    {
+        if (!_workers[i]->Start())
+        {
+            MTLOG_ERROR("sched worker %d start failed, errno %d", i, errno);
+            Stop();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 停止调度组, 未启动的任务丢弃
+ */
+void MtSchedGroup::Stop()
+{
+    _running = 0;
+    __sync_synchronize();
+
+    for (unsigned int i = 0; i < _workers.size(); i++) {
+        _workers[i]->Wakeup();
+    }
+    for (unsigned int i = 0; i < _workers.size(); i++) {
+        _workers[i]->Join();
+        delete _workers[i];
+    }
+    _workers.clear();
+}
+
+/**
+ * @brief 投递一个微线程任务
+ */
+bool MtSchedGroup::Submit(ThreadStart entry, void* args)
+{
+    if (!_running || _workers.empty()) {
+        return false;
+    }
+
+    MtSchedTask task;
+    task.entry = entry;
+    task.args  = args;
+
+    MtSchedWorker* worker = _curr_worker;
+    if ((NULL == worker) || (worker->_group != this))
+    {
+        unsigned int seed = __sync_fetch_and_add(&_rr_index, 1);
+        worker = _workers[seed % _workers.size()];
+    }
+    worker->PushTask(task);
+
+    // 目标空闲则直接唤醒, 否则积压时找一个空闲的来窃取
+    if ((worker != _curr_worker) && worker->IsIdle()) {
+        worker->Wakeup();
+    } else if (worker->TaskNum() > 1) {
+        WakeupIdle(worker->GetIndex());
+    }
+
+    return true;
+}
+
+/**
+ * @brief 从其它调度线程窃取任务, 从随机位置开始轮询, 避免集中争抢
+ */
+bool MtSchedGroup::Steal(int thief, MtSchedTask& task)
+{
+    int num = (int)_workers.size();
+    if (num <= 1) {
+        return false;
+    }
+
+    int start = (int)(_rr_index + thief) % num;
+    for (int i = 0; i < num; i++)
+    {
+        int victim = (start + i) % num;
+        if (victim == thief) {
+            continue;
+        }
+        if (_workers[victim]->StealTask(task)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief 唤醒一个空闲的调度线程
+ */
+void MtSchedGroup::WakeupIdle(int except)
+{
+    for (unsigned int i = 0; i < _workers.size(); i++)
+    {
+        if (((int)i != except) && _workers[i]->IsIdle()) {
+            _workers[i]->Wakeup();
+            return;
+        }
+    }
+}
+
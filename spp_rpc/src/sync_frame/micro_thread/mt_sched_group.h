@@ -0,0 +1,226 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/**
+ *  @file mt_sched_group.h
+ *  @info 微线程M:N调度组, 每个OS线程一个独立的MtFrame与epoll
+ *        新任务进入本线程的双端队列, 空闲线程从其它线程队首窃取
+ *        已经运行过的微线程绑定在所属调度线程上, 不做迁移
+ */
+
+#ifndef __MT_SCHED_GROUP_H__
+#define __MT_SCHED_GROUP_H__
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+#include "micro_thread.h"
+
+namespace NS_MICRO_THREAD {
+
+#define MT_SCHED_MAX_WORKER     64      ///< 最大调度线程数
+#define MT_SCHED_BATCH_NUM      64      ///< 每轮最多从队列启动的任务数
+#define MT_SCHED_IDLE_WAIT      10      ///< 空闲时等待唤醒的时间, 毫秒
+
+/**
+ * @brief 待启动的任务单元, 启动前不绑定任何调度线程
+ */
+struct MtSchedTask
+{
+    ThreadStart     entry;          ///< 微线程入口函数
+    void*           args;           ///< 微线程入口参数
+};
+
+class MtSchedGroup;
+
+/**
+ * @brief 调度线程, 一个OS线程 + 一个MtFrame + 一个任务队列
+ */
+class MtSchedWorker
+{
+public:
+
+    /**
+     * @brief 构造与析构函数
+     */
+    MtSchedWorker(MtSchedGroup* group, int index);
+    ~MtSchedWorker();
+
+    /**
+     * @brief 启动与等待OS线程, 启动会等待框架初始化完成
+     */
+    bool Start(void);
+    void Join(void);
+
+    /**
+     * @brief 本线程队尾压入任务, 可跨线程调用
+     */
+    void PushTask(const MtSchedTask& task);
+
+    /**
+     * @brief 本线程从队尾取任务, LIFO利于缓存
+     */
+    bool PopTask(MtSchedTask& task);
+
+    /**
+     * @brief 其它线程从队首窃取任务
+     */
+    bool StealTask(MtSchedTask& task);
+
+    /**
+     * @brief 队列中的任务数, 仅作为负载参考
+     */
+    int TaskNum(void) {
+        return _task_num;
+    };
+
+    /**
+     * @brief 是否处于空闲等待状态
+     */
+    bool IsIdle(void) {
+        return _idle != 0;
+    };
+
+    /**
+     * @brief 唤醒空闲等待中的调度线程
+     */
+    void Wakeup(void);
+
+    /**
+     * @brief 调度线程的序号
+     */
+    int GetIndex(void) {
+        return _index;
+    };
+
+private:
+
+    friend class MtSchedGroup;
+
+    /**
+     * @brief OS线程入口与调度主循环, 运行在该线程的原生微线程上
+     */
+    static void* ThreadEntry(void* args);
+    void Loop(void);
+
+    MtSchedGroup*               _group;         ///< 所属调度组
+    int                         _index;         ///< 调度线程序号
+    pthread_t                   _tid;           ///< OS线程id
+    bool                        _started;       ///< 是否已经启动
+    int                         _evfd;          ///< 唤醒用的eventfd
+    volatile int                _ready;         ///< 初始化结果, 0 进行中, 1 成功, -1 失败
+    volatile int                _idle;          ///< 空闲等待标记
+    volatile int                _task_num;      ///< 队列中任务数
+    pthread_mutex_t             _lock;          ///< 队列锁, 仅与窃取方竞争
+    std::deque<MtSchedTask>     _tasks;         ///< 待启动任务队列
+};
+
+
+/**
+ * @brief M:N调度组, 全局单例, 管理所有调度线程
+ */
+class MtSchedGroup
+{
+public:
+
+    /**
+     * @brief 单例访问与销毁
+     */
+    static MtSchedGroup* Instance(void);
+    static void Destroy(void);
+
+    /**
+     * @brief 启动调度组
+     * @param worker_num 调度线程数, <=0 时按cpu核数
+     * @param max_thread_num 每个调度线程的最大微线程数
+     * @param io_backend 每个调度线程的事件后端
+     * @return true 成功, false 失败
+     */
+    bool Start(int worker_num, int max_thread_num, int io_backend = MT_IO_BACKEND_EPOLL);
+
+    /**
+     * @brief 停止调度组, 等待所有调度线程退出
+     */
+    void Stop(void);
+
+    /**
+     * @brief 投递一个微线程任务, 调度线程内投递进本地队列, 否则轮询分配
+     * @return true 成功, false 失败
+     */
+    bool Submit(ThreadStart entry, void* args);
+
+    /**
+     * @brief 从其它调度线程窃取任务
+     * @param thief 窃取方的序号
+     */
+    bool Steal(int thief, MtSchedTask& task);
+
+    /**
+     * @brief 当前OS线程所属的调度线程, 非调度线程返回NULL
+     */
+    static MtSchedWorker* CurrentWorker(void) {
+        return _curr_worker;
+    };
+
+    /**
+     * @brief 调度组运行参数
+     */
+    bool IsRunning(void) {
+        return _running != 0;
+    };
+    int GetMaxThreadNum(void) {
+        return _max_thread_num;
+    };
+    int GetIoBackend(void) {
+        return _io_backend;
+    };
+    bool GetHookFlag(void) {
+        return _hook_flag;
+    };
+    int GetWorkerNum(void) {
+        return (int)_workers.size();
+    };
+
+private:
+
+    friend class MtSchedWorker;
+
+    MtSchedGroup();
+    ~MtSchedGroup();
+
+    /**
+     * @brief 唤醒一个空闲的调度线程去窃取任务
+     */
+    void WakeupIdle(int except);
+
+    static MtSchedGroup*            _instance;          ///< 单例句柄
+    static __thread MtSchedWorker*  _curr_worker;       ///< 当前OS线程的调度线程
+
+    std::vector<MtSchedWorker*>     _workers;           ///< 调度线程列表
+    volatile int                    _running;           ///< 运行标记
+    unsigned int                    _rr_index;          ///< 外部投递的轮询种子
+    int                             _max_thread_num;    ///< 每调度线程微线程上限
+    int                             _io_backend;        ///< 每调度线程的事件后端
+    bool                            _hook_flag;         ///< 是否继承HOOK标记
+};
+
+}
+
+#endif
+
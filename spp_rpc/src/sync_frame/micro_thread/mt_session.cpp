@@ -46,7 +46,7 @@ ISession::~ISession()
  * @brief session全局管理句柄
  * @return 全局句柄指针
  */
-SessionMgr* SessionMgr::_instance = NULL;
+__thread SessionMgr* SessionMgr::_instance = NULL;
 SessionMgr* SessionMgr::Instance (void)
 {
     if (NULL == _instance)
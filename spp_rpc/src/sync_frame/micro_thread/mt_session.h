@@ -175,7 +175,7 @@ private:
      */
     SessionMgr();
 
-    static SessionMgr * _instance;          ///<  单例类句柄
+    static __thread SessionMgr * _instance;          ///<  单例类句柄
     int       _curr_session;                ///<  session种子
     HashList* _hash_map;                    ///<  按sessionid hash存储
 };
@@ -20,7 +20,7 @@
 /**
  *  @filename mt_sys_hook.cpp
  *  @info  微线程hook系统api, 以不用额外编译的优势, 转同步为异步库
- *         只hook socket相关的API, HOOK 部分, 参考pth与libco实现
+ *         只hook socket相关的API与域名解析, HOOK 部分, 参考pth与libco实现
  */
 
 #include <stdio.h>
@@ -39,6 +39,7 @@
 
 #include "micro_thread.h"
 #include "mt_sys_hook.h"
+#include "mt_dns.h"
 
 using namespace NS_MICRO_THREAD;
 
@@ -59,8 +60,8 @@ typedef struct socket_hook_info
 }MtHookFd;
 
 MtSyscallFuncTab       g_mt_syscall_tab;            // 全局符号表
-int                    g_mt_hook_flag;              // 全局控制标记
-static MtHookFd        g_mt_hook_fd_tab[MT_HOOK_MAX_FD];   // 全局fd管理
+__thread int           g_mt_hook_flag;              // 控制标记, 每个调度线程独立
+static __thread MtHookFd* g_mt_hook_fd_tab;         // fd管理, 每个调度线程独立, 首次创建socket时分配
 
 
 /**
@@ -68,7 +69,7 @@ static MtHookFd        g_mt_hook_fd_tab[MT_HOOK_MAX_FD];   // 全局fd管理
  */
 MtHookFd* mt_hook_find_fd(int fd) 
 {
-    if ((fd < 0) || (fd >= MT_HOOK_MAX_FD)) {
+    if ((fd < 0) || (fd >= MT_HOOK_MAX_FD) || (g_mt_hook_fd_tab == NULL)) {
         return NULL;
     }  
 
@@ -89,6 +90,14 @@ void mt_hook_new_fd(int fd)
         return;
     }  
 
+    // socket由创建它的调度线程使用, 微线程启动后不会迁移到其它线程
+    if (g_mt_hook_fd_tab == NULL) {
+        g_mt_hook_fd_tab = (MtHookFd*)calloc(MT_HOOK_MAX_FD, sizeof(MtHookFd));
+        if (g_mt_hook_fd_tab == NULL) {
+            return;
+        }
+    }
+
     MtHookFd* fd_info       = &g_mt_hook_fd_tab[fd];
     fd_info->sock_flag      = MT_FD_FLG_INUSE;
     fd_info->read_timeout   = 500;
@@ -100,7 +109,7 @@ void mt_hook_new_fd(int fd)
  */
 void mt_hook_free_fd(int fd)
 {
-    if ((fd < 0) || (fd >= MT_HOOK_MAX_FD)) {
+    if ((fd < 0) || (fd >= MT_HOOK_MAX_FD) || (g_mt_hook_fd_tab == NULL)) {
         return;
     }  
 
@@ -300,6 +309,102 @@ ssize_t send(int fd, const void *buf, size_t nbyte, int flags)
 }
 
 
+/**
+ * @brief HOOK接口, 初始化mt库后, 接管系统api, 用户已经设置unblock, 跳过
+ */
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    mt_hook_syscall(readv);
+    MtHookFd* hook_fd = mt_hook_find_fd(fd); 
+    if (!mt_hook_active() || !hook_fd)
+    {
+        return mt_real_func(readv)(fd, iov, iovcnt);
+    }
+
+    if (hook_fd->sock_flag & MT_FD_FLG_UNBLOCK) 
+    {
+        return mt_real_func(readv)(fd, iov, iovcnt);
+    }
+    
+    return MtFrame::readv(fd, iov, iovcnt, hook_fd->read_timeout);
+}
+
+/**
+ * @brief HOOK接口, 初始化mt库后, 接管系统api, 用户已经设置unblock, 跳过
+ */
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    mt_hook_syscall(writev);
+    MtHookFd* hook_fd = mt_hook_find_fd(fd); 
+    if (!mt_hook_active() || !hook_fd)
+    {
+        return mt_real_func(writev)(fd, iov, iovcnt);
+    }
+
+    if (hook_fd->sock_flag & MT_FD_FLG_UNBLOCK) 
+    {
+        return mt_real_func(writev)(fd, iov, iovcnt);
+    }
+    
+    return MtFrame::writev(fd, iov, iovcnt, hook_fd->write_timeout);
+}
+
+/**
+ * @brief HOOK接口, 初始化mt库后, 接管系统api, 用户已经设置unblock, 跳过
+ */
+ssize_t recvmsg(int fd, struct msghdr *msg, int flags)
+{
+    mt_hook_syscall(recvmsg);
+    MtHookFd* hook_fd = mt_hook_find_fd(fd); 
+    if (!mt_hook_active() || !hook_fd)
+    {
+        return mt_real_func(recvmsg)(fd, msg, flags);
+    }
+
+    if (hook_fd->sock_flag & MT_FD_FLG_UNBLOCK) 
+    {
+        return mt_real_func(recvmsg)(fd, msg, flags);
+    }
+    
+    return MtFrame::recvmsg(fd, msg, flags, hook_fd->read_timeout);
+}
+
+/**
+ * @brief HOOK接口, 初始化mt库后, 接管系统api, 用户已经设置unblock, 跳过
+ */
+ssize_t sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+    mt_hook_syscall(sendmsg);
+    MtHookFd* hook_fd = mt_hook_find_fd(fd); 
+    if (!mt_hook_active() || !hook_fd)
+    {
+        return mt_real_func(sendmsg)(fd, msg, flags);
+    }
+
+    if (hook_fd->sock_flag & MT_FD_FLG_UNBLOCK) 
+    {
+        return mt_real_func(sendmsg)(fd, msg, flags);
+    }
+    
+    return MtFrame::sendmsg(fd, msg, flags, hook_fd->write_timeout);
+}
+
+/**
+ * @brief HOOK接口, 初始化mt库后, 域名解析转由后台解析线程执行, 微线程等待结果
+ *        结果按TTL缓存在进程内, 返回的链表仍由系统freeaddrinfo释放
+ */
+int getaddrinfo(const char *node, const char *service,
+                const struct addrinfo *hints, struct addrinfo **res)
+{
+    mt_hook_syscall(getaddrinfo);
+    if (!mt_hook_active())
+    {
+        return mt_real_func(getaddrinfo)(node, service, hints, res);
+    }
+
+    return MtDnsResolver::Instance()->GetAddrInfo(node, service, hints, res, MT_DNS_DFLT_TIMEOUT);
+}
+
 /**
  * @brief HOOK接口, 初始化mt库后, 接管系统api, 截获用户设置的超时时间信息
  */
@@ -28,6 +28,9 @@
 
 #include <poll.h>
 #include <dlfcn.h>
+#include <netdb.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
 
 #ifdef  __cplusplus
 extern "C" {
@@ -56,6 +59,12 @@ typedef int (*func_setsockopt)(int socket, int level, int option_name,
 			            const void *option_value, socklen_t option_len);
 typedef int (*func_fcntl)(int fildes, int cmd, ...);
 typedef int (*func_ioctl)(int fildes, int request, ... );
+typedef ssize_t (*func_readv)(int fildes, const struct iovec *iov, int iovcnt);
+typedef ssize_t (*func_writev)(int fildes, const struct iovec *iov, int iovcnt);
+typedef ssize_t (*func_recvmsg)(int socket, struct msghdr *message, int flags);
+typedef ssize_t (*func_sendmsg)(int socket, const struct msghdr *message, int flags);
+typedef int (*func_getaddrinfo)(const char *node, const char *service,
+                        const struct addrinfo *hints, struct addrinfo **res);
 
 typedef unsigned int (*func_sleep)(unsigned int seconds);			            
 
@@ -87,6 +96,12 @@ typedef struct mt_syscall_func_tab
     func_poll               real_poll;              // 暂不支持, 确认需求后实施
 
     func_accept             real_accept;
+
+    func_readv              real_readv;
+    func_writev             real_writev;
+    func_recvmsg            real_recvmsg;
+    func_sendmsg            real_sendmsg;
+    func_getaddrinfo        real_getaddrinfo;       // 转由解析线程执行, 结果按TTL缓存
 }MtSyscallFuncTab;
 
 
@@ -94,7 +109,7 @@ typedef struct mt_syscall_func_tab
 /*         3.  直接调用原始系统api的接口                                      */
 /******************************************************************************/
 extern MtSyscallFuncTab  g_mt_syscall_tab;            // 全局符号表
-extern int               g_mt_hook_flag;              // 全局控制标记
+extern __thread int      g_mt_hook_flag;              // 控制标记, 每个调度线程独立
 
 #define mt_hook_syscall(name)                                                  \
 do  {                                                                          \
@@ -0,0 +1,348 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/**
+ *  @file mt_uring.cpp
+ *  @info io_uring事件后端实现
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "mt_uring.h"
+
+#ifdef MT_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+using namespace NS_MICRO_THREAD;
+
+/**
+ * @brief 构造函数
+ */
+UringPoller::UringPoller()
+{
+    _ring_fd    = -1;
+    _pending    = 0;
+    _sq_ptr     = NULL;
+    _sq_size    = 0;
+    _cq_ptr     = NULL;
+    _cq_size    = 0;
+    _sqes       = NULL;
+    _sqes_size  = 0;
+    _sq_head    = NULL;
+    _sq_tail    = NULL;
+    _sq_mask    = NULL;
+    _sq_array   = NULL;
+    _cq_head    = NULL;
+    _cq_tail    = NULL;
+    _cq_mask    = NULL;
+    _cqes       = NULL;
+    _sq_entries = 0;
+    _ts[0]      = 0;
+    _ts[1]      = 0;
+}
+
+/**
+ * @brief 析构函数
+ */
+UringPoller::~UringPoller()
+{
+    Term();
+}
+
+#ifdef MT_IO_URING
+
+/**
+ * @brief 初始化ring, 映射提交与完成队列
+ */
+int UringPoller::Init(unsigned int entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    _ring_fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (_ring_fd < 0) {
+        return -1;
+    }
+
+    // 老内核不支持计数型timeout与poll批量提交的语义, 不使用
+    if (!(params.features & IORING_FEAT_NODROP)) {
+        Term();
+        return -2;
+    }
+
+    _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        _sq_size = _cq_size = (_sq_size > _cq_size) ? _sq_size : _cq_size;
+    }
+
+    _sq_ptr = mmap(NULL, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   _ring_fd, IORING_OFF_SQ_RING);
+    if (_sq_ptr == MAP_FAILED) {
+        _sq_ptr = NULL;
+        Term();
+        return -3;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        _cq_ptr = _sq_ptr;
+    } else {
+        _cq_ptr = mmap(NULL, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       _ring_fd, IORING_OFF_CQ_RING);
+        if (_cq_ptr == MAP_FAILED) {
+            _cq_ptr = NULL;
+            Term();
+            return -4;
+        }
+    }
+
+    _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    _sqes = mmap(NULL, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 _ring_fd, IORING_OFF_SQES);
+    if (_sqes == MAP_FAILED) {
+        _sqes = NULL;
+        Term();
+        return -5;
+    }
+
+    char* sq = (char*)_sq_ptr;
+    char* cq = (char*)_cq_ptr;
+    _sq_head    = (unsigned int*)(sq + params.sq_off.head);
+    _sq_tail    = (unsigned int*)(sq + params.sq_off.tail);
+    _sq_mask    = (unsigned int*)(sq + params.sq_off.ring_mask);
+    _sq_array   = (unsigned int*)(sq + params.sq_off.array);
+    _cq_head    = (unsigned int*)(cq + params.cq_off.head);
+    _cq_tail    = (unsigned int*)(cq + params.cq_off.tail);
+    _cq_mask    = (unsigned int*)(cq + params.cq_off.ring_mask);
+    _cqes       = cq + params.cq_off.cqes;
+    _sq_entries = params.sq_entries;
+    _pending    = 0;
+
+    return 0;
+}
+
+/**
+ * @brief 释放ring
+ */
+void UringPoller::Term()
+{
+    if (_sqes) {
+        munmap(_sqes, _sqes_size);
+        _sqes = NULL;
+    }
+    if (_cq_ptr && (_cq_ptr != _sq_ptr)) {
+        munmap(_cq_ptr, _cq_size);
+    }
+    _cq_ptr = NULL;
+    if (_sq_ptr) {
+        munmap(_sq_ptr, _sq_size);
+        _sq_ptr = NULL;
+    }
+    if (_ring_fd >= 0) {
+        ::close(_ring_fd);
+        _ring_fd = -1;
+    }
+    _pending = 0;
+}
+
+/**
+ * @brief io_uring_enter封装, EINTR重试
+ */
+int UringPoller::Enter(unsigned int submit, unsigned int wait_nr, unsigned int flags)
+{
+    int ret = 0;
+    do {
+        ret = (int)syscall(__NR_io_uring_enter, _ring_fd, submit, wait_nr, flags, NULL, 0);
+    } while ((ret < 0) && (errno == EINTR) && (wait_nr == 0));
+
+    return ret;
+}
+
+/**
+ * @brief 获取一个空闲的提交项, 队列满时先提交
+ */
+void* UringPoller::GetSqe()
+{
+    unsigned int head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    unsigned int tail = *_sq_tail;
+    if ((tail - head) >= _sq_entries)
+    {
+        int ret = Enter(_pending, 0, 0);
+        if (ret > 0) {
+            _pending -= ((unsigned int)ret > _pending) ? _pending : (unsigned int)ret;
+        }
+        head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        if ((tail - head) >= _sq_entries) {
+            return NULL;
+        }
+    }
+
+    unsigned int index = tail & *_sq_mask;
+    struct io_uring_sqe* sqe = (struct io_uring_sqe*)_sqes + index;
+    memset(sqe, 0, sizeof(*sqe));
+    _sq_array[index] = index;
+    __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    _pending++;
+
+    return sqe;
+}
+
+/**
+ * @brief 排队一个单次poll请求
+ */
+bool UringPoller::PollAdd(int fd, unsigned int events, uint64_t data)
+{
+    struct io_uring_sqe* sqe = (struct io_uring_sqe*)GetSqe();
+    if (NULL == sqe) {
+        return false;
+    }
+
+    sqe->opcode        = IORING_OP_POLL_ADD;
+    sqe->fd            = fd;
+    sqe->poll32_events = events;
+    sqe->user_data     = data;
+
+    return true;
+}
+
+/**
+ * @brief 排队一个poll取消请求
+ */
+bool UringPoller::PollRemove(uint64_t data)
+{
+    struct io_uring_sqe* sqe = (struct io_uring_sqe*)GetSqe();
+    if (NULL == sqe) {
+        return false;
+    }
+
+    sqe->opcode    = IORING_OP_POLL_REMOVE;
+    sqe->fd        = -1;
+    sqe->addr      = data;
+    sqe->user_data = INNER_TAG;
+
+    return true;
+}
+
+/**
+ * @brief 完成队列是否有未取的事件
+ */
+bool UringPoller::HasCqe()
+{
+    return (*_cq_head != __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * @brief 提交所有排队请求, 等待至少一个完成或超时
+ */
+int UringPoller::Wait(int timeout)
+{
+    if ((timeout > 0) && HasCqe()) {
+        timeout = 0;
+    }
+
+    // 计数为1的timeout, 有任一完成或超时即结束, 不会长期滞留在ring中
+    if (timeout > 0)
+    {
+        struct io_uring_sqe* sqe = (struct io_uring_sqe*)GetSqe();
+        if (sqe != NULL)
+        {
+            _ts[0] = timeout / 1000;
+            _ts[1] = (long long)(timeout % 1000) * 1000000LL;
+            sqe->opcode    = IORING_OP_TIMEOUT;
+            sqe->fd        = -1;
+            sqe->addr      = (uint64_t)(uintptr_t)_ts;
+            sqe->len       = 1;
+            sqe->off       = 1;
+            sqe->user_data = INNER_TAG;
+        }
+        else
+        {
+            timeout = 0;
+        }
+    }
+
+    unsigned int flags = (timeout > 0) ? IORING_ENTER_GETEVENTS : 0;
+    int ret = Enter(_pending, (timeout > 0) ? 1 : 0, flags);
+    if (ret < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    _pending -= ((unsigned int)ret > _pending) ? _pending : (unsigned int)ret;
+
+    return ret;
+}
+
+/**
+ * @brief 取出一个完成事件
+ */
+bool UringPoller::PeekCqe(uint64_t& data, int& res)
+{
+    unsigned int head = *_cq_head;
+    if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    struct io_uring_cqe* cqe = (struct io_uring_cqe*)_cqes + (head & *_cq_mask);
+    data = cqe->user_data;
+    res  = cqe->res;
+    __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+#else
+
+/**
+ * @brief 编译环境不支持io_uring, 初始化失败, 由框架回退epoll
+ */
+int UringPoller::Init(unsigned int entries)
+{
+    return -1;
+}
+
+void UringPoller::Term()
+{
+}
+
+bool UringPoller::PollAdd(int fd, unsigned int events, uint64_t data)
+{
+    return false;
+}
+
+bool UringPoller::PollRemove(uint64_t data)
+{
+    return false;
+}
+
+int UringPoller::Wait(int timeout)
+{
+    return -1;
+}
+
+bool UringPoller::PeekCqe(uint64_t& data, int& res)
+{
+    return false;
+}
+
+#endif
+
@@ -0,0 +1,145 @@
+
+/**
+ * Tencent is pleased to support the open source community by making MSEC available.
+ *
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the GNU General Public License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may
+ * obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/GPL-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the
+ * License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+
+
+/**
+ *  @file mt_uring.h
+ *  @info io_uring事件后端, 直接使用系统调用, 不依赖liburing
+ *        只提交poll类请求, 一轮调度的所有注册/注销在一次io_uring_enter中提交
+ *        需要编译时定义MT_IO_URING, 否则初始化总是失败, 框架回退到epoll
+ */
+
+#ifndef __MT_URING_H__
+#define __MT_URING_H__
+
+#include <stdint.h>
+
+namespace NS_MICRO_THREAD {
+
+#define MT_URING_ENTRIES    4096        ///< 提交队列长度, 满时提前提交
+
+/**
+ * @brief poll请求的user_data, 高32位为序号, 低32位为fd
+ */
+#define MT_URING_DATA(fd, seq)  (((uint64_t)(seq) << 32) | (uint32_t)(fd))
+
+/**
+ * @brief 事件后端类型定义
+ */
+enum MT_IO_BACKEND
+{
+    MT_IO_BACKEND_EPOLL     = 0,    ///< 默认epoll后端
+    MT_IO_BACKEND_URING     = 1,    ///< io_uring后端, 内核不支持时回退epoll
+};
+
+/**
+ * @brief io_uring poll请求的封装, 只在所属调度线程内使用
+ */
+class UringPoller
+{
+public:
+    static const uint64_t INNER_TAG = ~0ULL;        ///< 内部请求的user_data, 完成时忽略
+
+    /**
+     * @brief 构造与析构函数
+     */
+    UringPoller();
+    ~UringPoller();
+
+    /**
+     * @brief 初始化ring, 映射提交与完成队列
+     * @param entries 提交队列长度
+     * @return 0 成功, <0 内核或编译环境不支持
+     */
+    int Init(unsigned int entries);
+
+    /**
+     * @brief 释放ring
+     */
+    void Term(void);
+
+    /**
+     * @brief 排队一个单次poll请求, 不立即提交
+     * @param fd 监听的句柄
+     * @param events 监听的事件, 与epoll的IN/OUT值相同
+     * @param data 完成时返回的user_data
+     */
+    bool PollAdd(int fd, unsigned int events, uint64_t data);
+
+    /**
+     * @brief 排队一个poll取消请求, 不立即提交
+     * @param data 待取消请求的user_data
+     */
+    bool PollRemove(uint64_t data);
+
+    /**
+     * @brief 提交所有排队请求, 等待至少一个完成或超时
+     * @param timeout 等待时间, 毫秒, 0 不等待
+     * @return >=0 成功, <0 失败
+     */
+    int Wait(int timeout);
+
+    /**
+     * @brief 取出一个完成事件
+     * @param data 完成请求的user_data
+     * @param res 完成结果, poll请求为收到的事件
+     * @return true 取到, false 完成队列为空
+     */
+    bool PeekCqe(uint64_t& data, int& res);
+
+private:
+
+    /**
+     * @brief 获取一个空闲的提交项, 队列满时先提交
+     */
+    void* GetSqe(void);
+
+    /**
+     * @brief io_uring_enter封装
+     */
+    int Enter(unsigned int submit, unsigned int wait_nr, unsigned int flags);
+
+    /**
+     * @brief 完成队列是否有未取的事件
+     */
+    bool HasCqe(void);
+
+    int             _ring_fd;           ///< ring句柄
+    unsigned int    _pending;           ///< 排队未提交的请求数
+    void*           _sq_ptr;            ///< 提交队列映射地址
+    size_t          _sq_size;           ///< 提交队列映射长度
+    void*           _cq_ptr;            ///< 完成队列映射地址
+    size_t          _cq_size;           ///< 完成队列映射长度
+    void*           _sqes;              ///< 提交项数组
+    size_t          _sqes_size;         ///< 提交项数组长度
+    unsigned int*   _sq_head;           ///< 提交队列头, 内核更新
+    unsigned int*   _sq_tail;           ///< 提交队列尾, 用户更新
+    unsigned int*   _sq_mask;           ///< 提交队列掩码
+    unsigned int*   _sq_array;          ///< 提交队列索引数组
+    unsigned int*   _cq_head;           ///< 完成队列头, 用户更新
+    unsigned int*   _cq_tail;           ///< 完成队列尾, 内核更新
+    unsigned int*   _cq_mask;           ///< 完成队列掩码
+    void*           _cqes;              ///< 完成项数组
+    unsigned int    _sq_entries;        ///< 提交队列长度
+    long long       _ts[2];             ///< 等待超时的timespec, 提交时由内核读取
+};
+
+}
+
+#endif
+
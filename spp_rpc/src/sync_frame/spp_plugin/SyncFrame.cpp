@@ -199,6 +199,24 @@ public:
     virtual void AttrReportSet(const char *attr, int iValue) {
         MONITOR_SET(attr, iValue);
     };
+
+    /**
+     * @brief 调度剖析周期统计, 写入worker统计文件, stat_tool可查看
+     */
+    virtual void SchedStatReport(const MtSchedStat& stat) {
+        if (_base) {
+            CDefaultWorker* worker = (CDefaultWorker*)_base;
+            worker->fstat_.op(WIDX_MT_SWITCH_NUM, (long)stat.switch_cnt);
+            worker->fstat_.op(WIDX_MT_SLICE_AVG, mt_prof_avg(stat.run_us, stat.slice_cnt));
+            worker->fstat_.op(WIDX_MT_SLICE_MAX, (long)stat.slice_max_us);
+            worker->fstat_.op(WIDX_MT_RUNQ_AVG, mt_prof_avg(stat.runq_us, stat.runq_cnt));
+            worker->fstat_.op(WIDX_MT_IOWAIT_AVG, mt_prof_avg(stat.iowait_us, stat.iowait_cnt));
+            worker->fstat_.op(WIDX_MT_SLEEP_AVG, mt_prof_avg(stat.sleep_us, stat.sleep_cnt));
+            worker->fstat_.op(WIDX_MT_LOOP_AVG, mt_prof_avg(stat.loop_us, stat.loop_cnt));
+            worker->fstat_.op(WIDX_MT_LOOP_MAX, (long)stat.loop_max_us);
+            worker->fstat_.op(WIDX_MT_STACK_MAX, (long)stat.stack_max);
+        }
+    };
 };
 
 
@@ -500,4 +518,35 @@ void CSyncFrame::sleep(int ms)
 	MtFrame::Instance()->sleep(ms);
 }
 
+void CSyncFrame::SetProf(bool on, int sample)
+{
+    if (!CSyncFrame::_init_flag)
+    {
+        return;
+    }
+
+    MtProfiler* prof = MtFrame::Instance()->GetProfiler();
+    if (on != prof->IsOn())
+    {
+        SF_LOG(LOG_INFO, "mt prof %s, sample %d", on ? "on" : "off", sample);
+    }
+    prof->Enable(on, sample);
+}
+
+void CSyncFrame::DumpProf()
+{
+    if (!CSyncFrame::_init_flag || !MtFrame::Instance()->GetProfiler()->IsOn())
+    {
+        return;
+    }
+
+    // 与业务日志放在同一目录
+    CServerBase* base = GetServerBase();
+    const char* path = (base && base->log_.log_path()[0]) ? base->log_.log_path() : "../log";
+
+    char file[256];
+    snprintf(file, sizeof(file), "%s/mt_prof_worker%d.trace", path, _iGroupId);
+    MtFrame::Instance()->GetProfiler()->DumpTrace(file);
+}
+
 }
@@ -132,6 +132,18 @@ class CSyncFrame
          */
 		void sleep(int ms);
 
+        /**
+         *  设置调度剖析, 统计项定时写入worker的统计文件
+         *  @param on 是否打开
+         *  @param sample 切片明细采样间隔, 0 只记录慢切片
+         */
+        void SetProf(bool on, int sample);
+
+        /**
+         *  调度剖析的切片明细追加到日志目录, 未打开剖析时不输出
+         */
+        void DumpProf();
+
     protected:
         static CSyncFrame *_s_instance;     ///< 全局单例句柄
         CServerBase *_pServBase;            ///< SPP服务器句柄    
@@ -33,6 +33,7 @@
 
 #include <sys/file.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <dirent.h>
 
 #include <errno.h>
@@ -62,6 +63,7 @@ void usage()
        "      4. ./cost_stat_tool -r [group]              查看worker处理前端请求时延统计信息       \n"
        "      5. ./cost_stat_tool -l [group]              查看该组下所有命令字,以及返回码信息      \n"
        "      6. ./cost_stat_tool -c [group] [cmd]        查看该组该命令字下返回码实时次数统计信息 \n"
+       "      7. ./cost_stat_tool -p [group] [cmd]        查看命令字时延分位数, 不指定cmd时查看全部\n"
        "-------------------------------------------------------------------------------------------\n\n"
          );
     END_COLOR;
@@ -95,6 +97,13 @@ class CFileData
                 printf("can't open cost stat file[%s]\n", file_path);
                 return -1;
             }
+            struct stat st;
+            if (fstat(fd, &st) < 0 || st.st_size < (off_t)GET_MGR_POOL_SIZE)
+            {
+                printf("cost stat file[%s] is from an old version, restart worker first\n", file_path);
+                ::close(fd);
+                return -1;
+            }
             _mappool = (StatMgrPool*) ::mmap(NULL, GET_MGR_POOL_SIZE, PROT_READ , MAP_SHARED, fd, 0);
             if ((MAP_FAILED ==_mappool ))
             {
@@ -322,6 +331,68 @@ void showCodeCount(int cmdid)
     }
     return;
 }
+// 一个间隔内命令字的时延分位数
+// 最后一个桶收的是超过2^HIST_MAX_BITS的时延, 没有上界, 显示为">=2^HIST_MAX_BITS"
+static const char* histValueStr(unsigned value, char* buf, size_t len)
+{
+    if (value >= getHistValue(MAX_HIST_BUCKET - 1))
+        snprintf(buf, len, ">=%u", 1u << HIST_MAX_BITS);
+    else
+        snprintf(buf, len, "%u", value);
+    return buf;
+}
+
+void showPercentileLine(int cmdid)
+{
+    unsigned newHist[MAX_HIST_BUCKET];
+    unsigned oldHist[MAX_HIST_BUCKET];
+    unsigned count = mergeHist(g_data.getCurPoolData(), cmdid, newHist) -
+        mergeHist(g_data.getLastPoolData(), cmdid, oldHist);
+    unsigned max = 0;
+    for (int i = 0; i < MAX_HIST_BUCKET; ++ i)
+    {
+        newHist[i] -= oldHist[i];
+        if (newHist[i] != 0)
+        {
+            max = getHistValue(i);
+        }
+    }
+
+    char p50[16], p90[16], p99[16], p999[16], smax[16];
+    printf("%5d %10u %8s %8s %8s %8s %8s\n", cmdid, count,
+            histValueStr(getHistPercentile(newHist, count, 0.5), p50, sizeof(p50)),
+            histValueStr(getHistPercentile(newHist, count, 0.9), p90, sizeof(p90)),
+            histValueStr(getHistPercentile(newHist, count, 0.99), p99, sizeof(p99)),
+            histValueStr(getHistPercentile(newHist, count, 0.999), p999, sizeof(p999)),
+            histValueStr(max, smax, sizeof(smax)));
+}
+void showPercentile(int cmdid)
+{
+    const StatMgrPool* pool = g_data.getCurPoolData();
+    if (cmdid != -1 && pool->_cmdobjs[cmdid]._used == false)
+    {
+        printf("the cmdid = %d is not init\n", cmdid);
+        return ;
+    }
+    while (1)
+    {
+        sleep(sleep_time);
+        g_data.updatePoolData();
+        pool = g_data.getCurPoolData();
+        printf("------------------------interval = %d(s)--------------------------\n\n", sleep_time);
+        BEGIN_PRINT_GREEN;
+        printf("%5s %10s %8s %8s %8s %8s %8s\n", "cmdid", "count", "p50(ms)", "p90", "p99", "p999", "max");
+        for (int i = 0; i < MAX_CMD_NUM; ++ i)
+        {
+            if ((cmdid == -1 || cmdid == i) && i != FRAME_CODE_STAT_CMD_ID && pool->_cmdobjs[i]._used == true)
+            {
+                showPercentileLine(i);
+            }
+        }
+        END_COLOR;
+    }
+    return;
+}
 int main(int argc, char* const argv[])
 {
     if (argc < 2)
@@ -410,6 +481,25 @@ int main(int argc, char* const argv[])
         }
         showCodeCount(cmdid);
     }
+    else if (!strncmp(argv[1], "-p", 2))
+    {
+        if (argc != 3 && argc != 4)
+        {
+            usage();
+            return -1;
+        }
+        cmdid = -1;
+        if (argc == 4)
+        {
+            cmdid = atoi(argv[3]);
+            if (cmdid <0 || cmdid >= MAX_CMD_NUM)
+            {
+                printf("cmdid must be range in[0, %d]\n", MAX_CMD_NUM - 1);
+                return -1;
+            }
+        }
+        showPercentile(cmdid);
+    }
     else
     {
         usage();
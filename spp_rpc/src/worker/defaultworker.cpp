@@ -47,6 +47,9 @@
 #include "StatMgr.h"
 #include "StatMgrInstance.h"
 #include "srpc_log.h"
+#include "srpc_intf.h"
+#include "srpc_proto.h"
+#include "srpc_service.h"
 #include "SyncFrame.h"
 
 #define WORKER_STAT_BUF_SIZE 1<<14
@@ -138,6 +141,17 @@ int CDefaultWorker::loop()
 
     if (now > (last + 5))
     {
+        // 调度剖析的切片明细定期落地
+        CSyncFrame::Instance()->DumpProf();
+
+        // 后端并发限制状态
+        SConcurrencyStat limit_stat;
+        GetConcurrencyStat(limit_stat);
+        fstat_.op(WIDX_SRPC_LIMIT_REJECT, limit_stat.rejected);
+        fstat_.op(WIDX_SRPC_LIMIT_INFLIGHT, limit_stat.inflight);
+        fstat_.op(WIDX_SRPC_LIMIT_MIN, limit_stat.min_limit);
+        fstat_.op(WIDX_SRPC_LIMIT_THROTTLED, limit_stat.throttled);
+
         int64_t mtime;
         mtime = CMisc::get_file_mtime(ix_->argv_[1]);
         if ((mtime < 0) || (mtime == config_mtime))
@@ -159,6 +173,9 @@ int CDefaultWorker::loop()
         flog_.log_level(config.log.level);
         log_.log_level(config.log.level);
 
+        // 更新调度剖析开关
+        CSyncFrame::Instance()->SetProf(config.mt_prof != 0, config.mt_prof_sample);
+
         // 更新远程日志配置
         CNgLogAdpt *rlog = (CNgLogAdpt *)GetRlog();
         if (rlog->Init(ix_->argv_[1], servicename().c_str()))
@@ -431,6 +448,34 @@ int CDefaultWorker::initconf(bool reload)
     fstat_.init_statobj_frame(MT_MSG_NUM, STAT_TYPE_SET, WIDX_MT_MSG_NUM,
             "微线程消息数");
 
+    fstat_.init_statobj_frame(MT_SWITCH_NUM, STAT_TYPE_SUM, WIDX_MT_SWITCH_NUM,
+            "微线程上下文切换次数");
+    fstat_.init_statobj_frame(MT_SLICE_AVG, STAT_TYPE_SET, WIDX_MT_SLICE_AVG,
+            "微线程平均运行切片/微秒");
+    fstat_.init_statobj_frame(MT_SLICE_MAX, STAT_TYPE_MAX, WIDX_MT_SLICE_MAX,
+            "微线程最长运行切片/微秒");
+    fstat_.init_statobj_frame(MT_RUNQ_AVG, STAT_TYPE_SET, WIDX_MT_RUNQ_AVG,
+            "微线程可运行队列平均等待/微秒");
+    fstat_.init_statobj_frame(MT_IOWAIT_AVG, STAT_TYPE_SET, WIDX_MT_IOWAIT_AVG,
+            "微线程IO平均等待/微秒");
+    fstat_.init_statobj_frame(MT_SLEEP_AVG, STAT_TYPE_SET, WIDX_MT_SLEEP_AVG,
+            "微线程sleep平均时长/微秒");
+    fstat_.init_statobj_frame(MT_LOOP_AVG, STAT_TYPE_SET, WIDX_MT_LOOP_AVG,
+            "调度循环平均间隔/微秒");
+    fstat_.init_statobj_frame(MT_LOOP_MAX, STAT_TYPE_MAX, WIDX_MT_LOOP_MAX,
+            "调度循环最长间隔/微秒");
+    fstat_.init_statobj_frame(MT_STACK_MAX, STAT_TYPE_MAX, WIDX_MT_STACK_MAX,
+            "微线程栈使用最高水位/字节");
+
+    fstat_.init_statobj_frame(SRPC_LIMIT_REJECT, STAT_TYPE_SUM, WIDX_SRPC_LIMIT_REJECT,
+            "后端并发超限快速失败数");
+    fstat_.init_statobj_frame(SRPC_LIMIT_INFLIGHT, STAT_TYPE_SET, WIDX_SRPC_LIMIT_INFLIGHT,
+            "后端在途请求数");
+    fstat_.init_statobj_frame(SRPC_LIMIT_MIN, STAT_TYPE_SET, WIDX_SRPC_LIMIT_MIN,
+            "后端并发上限最小值");
+    fstat_.init_statobj_frame(SRPC_LIMIT_THROTTLED, STAT_TYPE_SET, WIDX_SRPC_LIMIT_THROTTLED,
+            "并发上限已收紧的后端数");
+
     //初始化业务统计
     snprintf(tmp, 255, "../stat/module_stat_srpc_worker%d.dat", groupid_);
     if (stat_.init_statpool(tmp) != 0)
@@ -492,6 +537,10 @@ int CDefaultWorker::initconf(bool reload)
         LOG_SCREEN(LOG_ERROR, "[ERROR] init syncframe failed = %d\n", ret);
         exit(-1);
     }
+    CSyncFrame::Instance()->SetProf(config.mt_prof != 0, config.mt_prof_sample);
+
+    // 下游调用的超时不超过上游调用方的剩余时间
+    SetRemainTimeFunc(GetCallerRemainTime);
 
     if (0 == load_bench_adapter(module_file.c_str(), module_isGlobal))
     {
@@ -536,6 +585,24 @@ int CDefaultWorker::initconf(bool reload)
     return 0;
 }
 
+// SRPC请求头中带了调用方剩余超时, 排队时间已经超过说明调用方已放弃
+static bool caller_gave_up(blob_type* blob, int64_t time_delay)
+{
+    // 排队不到1ms的请求不会超过调用方超时, 不用解析请求头
+    if ((time_delay <= 0) || (blob->len < PROTO_HEAD_MIN_LEN) || (blob->data[0] != PROTO_RPC_STX))
+    {
+        return false;
+    }
+
+    CRpcHead head;
+    if (SrpcUnpackPkgHead(blob->data, blob->len, &head) != SRPC_SUCCESS)
+    {
+        return false;
+    }
+
+    return (head.timeout() > 0) && (time_delay >= (int64_t)head.timeout());
+}
+
 int CDefaultWorker::ator_recvdata_v2(unsigned flow, void* arg1, void* arg2)
 {
     blob_type* blob = (blob_type*)arg1;
@@ -557,30 +624,36 @@ int CDefaultWorker::ator_recvdata_v2(unsigned flow, void* arg1, void* arg2)
         int64_t time_delay = now - recv_ms;
 
         worker->fstat_.op(WIDX_MSG_SHM_TIME, time_delay);
+        // 排队时延累加到共享内存队列统计, controller据此伸缩worker进程数
+        int qdelay = time_delay > 0 ? (int)time_delay : 0;
+        worker->ator_->ctrl(flow, CT_QDELAY, &qdelay, NULL);
         add_memlog(blob->data, blob->len);
 
         if( worker->msg_timeout_ )
         {        
 			shm_delay_stat(time_delay); 
-            if ( time_delay > worker->msg_timeout_ )
+        }
+
+        // 超过配置的排队超时, 或者调用方已经超时放弃, 都不再处理
+        if (( worker->msg_timeout_ && time_delay > worker->msg_timeout_ )
+            || caller_gave_up(blob, time_delay))
+        {
+            MONITOR(MONITOR_WORKER_OVERLOAD_DROP);
+            worker->fstat_.op(WIDX_MSG_TIMEOUT, 1);
+            worker->flog_.LOG_P_PID(LOG_ERROR, "Flow[%u] Msg Timeout! Delay[%d], Drop!\n"
+                , flow, int(time_delay), blob->len);
+
+            if (UDP_SOCKET == ptr->type_)
             {
-                MONITOR(MONITOR_WORKER_OVERLOAD_DROP);
-                worker->fstat_.op(WIDX_MSG_TIMEOUT, 1);
-                worker->flog_.LOG_P_PID(LOG_ERROR, "Flow[%u] Msg Timeout! Delay[%d], Drop!\n"
-                    , flow, int(time_delay), blob->len);
-
-                if (UDP_SOCKET == ptr->type_)
-                {
-                    CTCommu* commu = (CTCommu*)blob->owner;
-                    blob_type rspblob;
-                    rspblob.len = 0;
-                    rspblob.data = NULL;
-                    commu->sendto(flow, &rspblob, NULL);
-                    worker->flog_.LOG_P_FILE(LOG_DEBUG, "close conn, flow:%u\n", flow);
-                }
-
-                return 0;
+                CTCommu* commu = (CTCommu*)blob->owner;
+                blob_type rspblob;
+                rspblob.len = 0;
+                rspblob.data = NULL;
+                commu->sendto(flow, &rspblob, NULL);
+                worker->flog_.LOG_P_FILE(LOG_DEBUG, "close conn, flow:%u\n", flow);
             }
+
+            return 0;
         }
 
         worker->flog_.LOG_P_FILE(LOG_DEBUG, "ator recvdone, flow:%u, blob len:%d\n", flow, blob->len);